@@ -1,465 +1,1602 @@
 #include "ash_components.h"
 
+#include "ash_context.h"
 #include "ash_debug.h"
 #include "ash_misc.h"
 #include "raylib.h"
 
 #include <cstring>
+#include <float.h>
+#include <math.h>
 #include <stdio.h>
 
-void AnimatedSprite_Initialize(AnimatedSprite* animatedSprite)
-{
-    animatedSprite->frameTime        = ANIMATEDSPRITE_DEFAULT_ANIMATION_SPEED;
-    animatedSprite->currentAnimation = NULL;
-    animatedSprite->isPlaying        = false;
-    animatedSprite->repeat           = false;
-    animatedSprite->currentFrame     = 0;
-    Sprite_Initialize(&animatedSprite->sprite);
-}
+#if defined(__SSE2__) || defined(_M_X64)
+#    include <emmintrin.h>
+#    define AABBBATCH_SSE2
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#    define AABBBATCH_AVX
+#endif
 
-void AnimatedSprite_Play(AnimatedSprite* animatedSprite, AnimationData* animation, bool repeat)
+#define SWEEP_PAIR_EMPTY   0
+#define SWEEP_PAIR_LIVE    1
+#define SWEEP_PAIR_DELETED 2
+
+#if defined(AABBBATCH_AVX)
+// ash_components_avx.c
+bool     AabbBatch_AvxBuilt();
+uint32_t AabbBatch_OverlapAvx(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                              uint32_t count, const float box[4], uint32_t* hitMask, uint32_t* outHits);
+#endif
+
+static Vector2Float Transform2D_Apply(const Transform2D* transform, Vector2Float local)
 {
-    animatedSprite->currentAnimation = animation;
-    animatedSprite->repeat           = repeat;
-    animatedSprite->isPlaying        = true;
-    animatedSprite->currentFrame     = 0;
+    float x = (local.x * transform->rotationCos - local.y * transform->rotationSin) * transform->scale;
+    float y = (local.x * transform->rotationSin + local.y * transform->rotationCos) * transform->scale;
+    return (Vector2Float){ transform->position.x + x, transform->position.y + y };
 }
 
-void AnimatedSprite_Stop(AnimatedSprite* animatedSprite)
+static Vector2Float Collider2D_GetWorldPosition(Collider2D* col)
 {
-    animatedSprite->isPlaying = false;
+    if (col->parent == NULL)
+    {
+        return col->position;
+    }
+    return Entity2D_TransformPoint(col->parent, col->position);
 }
 
-void AnimatedSprite_Update(AnimatedSprite* animatedSprite)
+// size is local like the position, so it grows with the parent's world scale
+static Vector2Float Collider2D_GetWorldSize(Collider2D* col)
 {
-    if (animatedSprite->isPlaying && animatedSprite->currentAnimation && Stopwatch_IsZero(&animatedSprite->stopwatch))
+    if (col->parent == NULL)
     {
-        animatedSprite->sprite.currentTexture =
-            &animatedSprite->currentAnimation->animationFrames[animatedSprite->currentFrame++];
-        if (animatedSprite->currentFrame >= animatedSprite->currentAnimation->animationFrameCount)
-        {
-            if (animatedSprite->repeat)
-            {
-                animatedSprite->currentFrame = 0;
-            }
-            else
-            {
-                animatedSprite->isPlaying             = false;
-                animatedSprite->sprite.currentTexture = &animatedSprite->currentAnimation->animationFrames[0];
-            }
-        }
-        Stopwatch_Start(&animatedSprite->stopwatch, animatedSprite->frameTime);
+        return col->size;
     }
+    float scale = Entity2D_GetWorld(col->parent)->scale;
+    return (Vector2Float){ col->size.x * scale, col->size.y * scale };
 }
 
-void AsciiWindow_Initalize(AsciiWindow* window, Texture2D texture)
+static bool AabbBatch_Reserve(AabbBatch* batch, uint32_t capacity)
 {
-    AsciiWindow_Clear(window);
-    for (uint32_t i = 0; i < window->height * window->width; i++)
+    if (capacity <= batch->capacity)
     {
-        Sprite_Initialize(&window->spriteBuffer[i]);
+        return true;
     }
-    window->spriteHeight = window->textureBuffer[0]->size.y;
-    window->spriteWidth  = window->textureBuffer[0]->size.x;
-    for (uint32_t i = 0; i < window->height; i++)
+    float** columns[4] = { &batch->minX, &batch->minY, &batch->maxX, &batch->maxY };
+    for (uint32_t i = 0; i < 4; i++)
     {
-        for (uint32_t j = 0; j < window->width; j++)
+        // columns grown so far are kept, capacity only moves once every column made it
+        float* grown = (float*)realloc(*columns[i], capacity * sizeof(float));
+        if (grown == NULL)
         {
-            window->spriteBuffer[i * window->width + j].position.x = window->textureBuffer[0]->size.x
-                                                                     * window->spriteBuffer[i * window->width + j].scale
-                                                                     * window->entity.scale * j;
-            window->spriteBuffer[i * window->width + j].position.y = window->textureBuffer[0]->size.y
-                                                                     * window->spriteBuffer[i * window->width + j].scale
-                                                                     * window->entity.scale * i;
-            window->spriteBuffer[i * window->width + j].currentTexture = window->textureBuffer[0];
-            window->spriteBuffer[i * window->width + j].parent         = &window->entity;
+            LOG_ERR("AabbBatch: out of memory");
+            return false;
         }
+        *columns[i] = grown;
     }
+    batch->capacity = capacity;
+    return true;
 }
 
-void AsciiWindow_SetCharacter(AsciiWindow* window, uint32_t x, uint32_t y, char c)
+bool AabbBatch_Initialize(AabbBatch* batch, uint32_t capacity)
 {
-    AsciiWindow_SetCell(window, x, y, static_cast<uint32_t>(c) - ASCIIWINDOW_ASCII_START);
+    memset(batch, 0, sizeof(AabbBatch));
+    return AabbBatch_Reserve(batch, capacity);
 }
 
-char AsciiWindow_GetCharacter(AsciiWindow* window, uint32_t x, uint32_t y)
+void AabbBatch_Deinitialize(AabbBatch* batch)
 {
-    return static_cast<char>(AsciiWindow_GetCell(window, x, y) + ASCIIWINDOW_ASCII_START);
+    free(batch->minX);
+    free(batch->minY);
+    free(batch->maxX);
+    free(batch->maxY);
+    memset(batch, 0, sizeof(AabbBatch));
 }
 
-void AsciiWindow_SetCell(AsciiWindow* window, uint32_t x, uint32_t y, uint32_t value)
+void AabbBatch_Clear(AabbBatch* batch)
 {
-    window->windowBuffer[y * window->width + x] = value;
+    batch->count = 0;
 }
 
-uint32_t AsciiWindow_GetCell(AsciiWindow* window, uint32_t x, uint32_t y)
+uint32_t AabbBatch_Add(AabbBatch* batch, Rectangle bounds)
 {
-    return window->windowBuffer[y * window->width + x];
+    if (batch->count == batch->capacity && !AabbBatch_Reserve(batch, batch->capacity == 0 ? 64 : batch->capacity * 2))
+    {
+        return AABBBATCH_NONE;
+    }
+    AabbBatch_Set(batch, batch->count, bounds);
+    return batch->count++;
 }
 
-void AsciiWindow_Clear(AsciiWindow* window)
+uint32_t AabbBatch_AddCollider(AabbBatch* batch, Collider2D* col)
 {
-    for (uint32_t i = 0; i < window->height * window->width; i++)
-    {
-        window->windowBuffer[i] = 0;
-    }
+    return AabbBatch_Add(batch, Collider2D_GetBounds(col));
 }
 
-void AsciiWindow_Draw(AsciiWindow* window)
+void AabbBatch_Set(AabbBatch* batch, uint32_t index, Rectangle bounds)
 {
-    for (uint32_t i = 0; i < window->height; i++)
+    batch->minX[index] = bounds.x;
+    batch->minY[index] = bounds.y;
+    batch->maxX[index] = bounds.x + bounds.width;
+    batch->maxY[index] = bounds.y + bounds.height;
+}
+
+// Same strict test as Collider2D_CheckCollider, one box at a time.
+static uint32_t AabbBatch_OverlapRange(const AabbBatch* batch, Rectangle box, uint32_t* hitMask, uint32_t first)
+{
+    float    boxMaxX = box.x + box.width;
+    float    boxMaxY = box.y + box.height;
+    uint32_t hits    = 0;
+    for (uint32_t i = first; i < batch->count; i++)
     {
-        for (uint32_t j = 0; j < window->width; j++)
+        if (box.x < batch->maxX[i] && boxMaxX > batch->minX[i] && box.y < batch->maxY[i] && boxMaxY > batch->minY[i])
         {
-            uint32_t currentChar                                       = AsciiWindow_GetCell(window, j, i);
-            window->spriteBuffer[i * window->width + j].currentTexture = window->textureBuffer[currentChar];
+            hitMask[i >> 5] |= 1u << (i & 31);
+            hits++;
         }
     }
+    return hits;
 }
 
-void AsciiWindow_DrawBorder(AsciiWindow* window, AsciiWindowBorder border)
+uint32_t AabbBatch_OverlapScalar(const AabbBatch* batch, Rectangle box, uint32_t* hitMask)
 {
-    for (uint32_t i = 0; i < window->height; i++)
+    memset(hitMask, 0, AABBBATCH_MASK_WORDS(batch->count) * sizeof(uint32_t));
+    return AabbBatch_OverlapRange(batch, box, hitMask, 0);
+}
+
+#if defined(AABBBATCH_AVX)
+// cpuid is only asked once, __builtin_cpu_supports also checks that the OS saves the AVX registers
+static bool AabbBatch_UseAvx()
+{
+    static int useAvx = -1;
+    if (useAvx < 0)
     {
-        for (uint32_t j = 0; j < window->width; j++)
-        {
-            if (i == 0 && j == 0)
-            {
-                AsciiWindow_SetCell(window, j, i, border.top[0]);
-            }
-            else if (i == 0 && j == window->width - 1)
-            {
-                AsciiWindow_SetCell(window, j, i, border.top[2]);
-            }
-            else if (i == window->height - 1 && j == 0)
-            {
-                AsciiWindow_SetCell(window, j, i, border.bottom[0]);
-            }
-            else if (i == window->height - 1 && j == window->width - 1)
-            {
-                AsciiWindow_SetCell(window, j, i, border.bottom[2]);
-            }
-            else if (i == 0 && j != 0 && j != window->width - 1)
-            {
-                AsciiWindow_SetCell(window, j, i, border.top[1]);
-            }
-            else if (i == window->height - 1 && j != 0 && j != window->width - 1)
-            {
-                AsciiWindow_SetCell(window, j, i, border.bottom[1]);
-            }
-            else if (j == 0 && i != 0 && i != window->height - 1)
-            {
-                AsciiWindow_SetCell(window, j, i, border.middle[0]);
-            }
-            else if (j == window->width - 1 && i != 0 && i != window->height - 1)
-            {
-                AsciiWindow_SetCell(window, j, i, border.middle[2]);
-            }
-        }
+        __builtin_cpu_init();
+        useAvx = AabbBatch_AvxBuilt() && __builtin_cpu_supports("avx") ? 1 : 0;
     }
+    return useAvx == 1;
 }
+#endif
 
-void AsciiWindow_DrawFill(AsciiWindow* window, uint8_t fill)
+// Sets bit i of hitMask for every box overlapping box, returns the number of hits.
+uint32_t AabbBatch_Overlap(const AabbBatch* batch, Rectangle box, uint32_t* hitMask)
 {
-    for (uint32_t i = 0; i < window->height; i++)
+    memset(hitMask, 0, AABBBATCH_MASK_WORDS(batch->count) * sizeof(uint32_t));
+    uint32_t i    = 0;
+    uint32_t hits = 0;
+#if defined(AABBBATCH_AVX)
+    if (AabbBatch_UseAvx())
     {
-        for (uint32_t j = 0; j < window->width; j++)
-        {
-            AsciiWindow_SetCharacter(window, j, i, fill);
-        }
+        float bounds[4] = { box.x, box.y, box.x + box.width, box.y + box.height };
+        i = AabbBatch_OverlapAvx(batch->minX, batch->minY, batch->maxX, batch->maxY, batch->count, bounds, hitMask,
+                                 &hits);
+    }
+#endif
+#if defined(AABBBATCH_SSE2)
+    __m128 boxMinX = _mm_set1_ps(box.x);
+    __m128 boxMinY = _mm_set1_ps(box.y);
+    __m128 boxMaxX = _mm_set1_ps(box.x + box.width);
+    __m128 boxMaxY = _mm_set1_ps(box.y + box.height);
+    for (; i + 4 <= batch->count; i += 4)
+    {
+        __m128 x = _mm_and_ps(_mm_cmplt_ps(boxMinX, _mm_loadu_ps(batch->maxX + i)),
+                              _mm_cmpgt_ps(boxMaxX, _mm_loadu_ps(batch->minX + i)));
+        __m128 y = _mm_and_ps(_mm_cmplt_ps(boxMinY, _mm_loadu_ps(batch->maxY + i)),
+                              _mm_cmpgt_ps(boxMaxY, _mm_loadu_ps(batch->minY + i)));
+        uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_and_ps(x, y));
+        hitMask[i >> 5] |= bits << (i & 31);
+        hits += __builtin_popcount(bits);
     }
+#endif
+    return hits + AabbBatch_OverlapRange(batch, box, hitMask, i);
 }
 
-void AsciiWindow_DrawString(AsciiWindow* window, uint8_t x, uint8_t y, const char* string)
+// Writes the penetration depth on both axes for every box, 0 on both for boxes that do not overlap, so the result can
+// be fed straight into the same min-axis resolution game2 does for a single pair.
+uint32_t AabbBatch_OverlapDepths(const AabbBatch* batch, Rectangle box, float* depthX, float* depthY)
 {
-    uint32_t position = 0;
-    while (string[position] != '\0')
+    float    boxMaxX = box.x + box.width;
+    float    boxMaxY = box.y + box.height;
+    uint32_t hits    = 0;
+    uint32_t i       = 0;
+#if defined(AABBBATCH_SSE2)
+    __m128 boxMinX4 = _mm_set1_ps(box.x);
+    __m128 boxMinY4 = _mm_set1_ps(box.y);
+    __m128 boxMaxX4 = _mm_set1_ps(boxMaxX);
+    __m128 boxMaxY4 = _mm_set1_ps(boxMaxY);
+    for (; i + 4 <= batch->count; i += 4)
     {
-        AsciiWindow_SetCharacter(window, x, y, string[position]);
-        x++;
-        position++;
-        if (x >= window->width)
+        __m128 dx = _mm_sub_ps(_mm_min_ps(boxMaxX4, _mm_loadu_ps(batch->maxX + i)),
+                               _mm_max_ps(boxMinX4, _mm_loadu_ps(batch->minX + i)));
+        __m128 dy = _mm_sub_ps(_mm_min_ps(boxMaxY4, _mm_loadu_ps(batch->maxY + i)),
+                               _mm_max_ps(boxMinY4, _mm_loadu_ps(batch->minY + i)));
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(boxMinX4, _mm_loadu_ps(batch->maxX + i)),
+                                           _mm_cmpgt_ps(boxMaxX4, _mm_loadu_ps(batch->minX + i))),
+                                _mm_and_ps(_mm_cmplt_ps(boxMinY4, _mm_loadu_ps(batch->maxY + i)),
+                                           _mm_cmpgt_ps(boxMaxY4, _mm_loadu_ps(batch->minY + i))));
+        _mm_storeu_ps(depthX + i, _mm_and_ps(dx, hit));
+        _mm_storeu_ps(depthY + i, _mm_and_ps(dy, hit));
+        hits += __builtin_popcount((uint32_t)_mm_movemask_ps(hit));
+    }
+#endif
+    for (; i < batch->count; i++)
+    {
+        if (box.x < batch->maxX[i] && boxMaxX > batch->minX[i] && box.y < batch->maxY[i] && boxMaxY > batch->minY[i])
         {
-            x = 0;
-            y++;
+            depthX[i] = fminf(boxMaxX, batch->maxX[i]) - fmaxf(box.x, batch->minX[i]);
+            depthY[i] = fminf(boxMaxY, batch->maxY[i]) - fmaxf(box.y, batch->minY[i]);
+            hits++;
         }
-        if (y >= window->height)
+        else
         {
-            break;
+            depthX[i] = 0.0f;
+            depthY[i] = 0.0f;
         }
     }
+    return hits;
 }
 
-bool Audio_Init()
+const char* AabbBatch_GetKernelName()
 {
-    InitAudioDevice();
-    return IsAudioDeviceReady();
+#if defined(AABBBATCH_AVX)
+    if (AabbBatch_UseAvx())
+    {
+        return "AVX";
+    }
+#endif
+#if defined(AABBBATCH_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
 }
 
-void Audio_Deinit()
+static inline float AabbTree_Perimeter(Vector2Float min, Vector2Float max)
 {
-    CloseAudioDevice();
+    return 2.0f * ((max.x - min.x) + (max.y - min.y));
 }
 
-AudioData Audio_LoadAudio(const char* fileName)
+static inline bool AabbTree_IsLeaf(AabbTreeNode* node)
 {
-    if (fileName == NULL)
-    {
-        return (AudioData){ 0 };
-    }
-    Sound     sound = LoadSound(fileName);
-    AudioData audio;
-    audio.sound = sound;
-    return audio;
+    return node->child1 == AABBTREE_NULL;
 }
 
-void Audio_UnloadAudio(AudioData* audio)
+static void AabbTree_Union(AabbTreeNode* target, AabbTreeNode* a, AabbTreeNode* b)
 {
-    UnloadSound(audio->sound);
+    target->min.x = a->min.x < b->min.x ? a->min.x : b->min.x;
+    target->min.y = a->min.y < b->min.y ? a->min.y : b->min.y;
+    target->max.x = a->max.x > b->max.x ? a->max.x : b->max.x;
+    target->max.y = a->max.y > b->max.y ? a->max.y : b->max.y;
 }
 
-void AudioPlayer_Stop(AudioData* audio)
+static uint32_t AabbTree_AllocateNode(AabbTree* tree)
 {
-    StopSound(audio->sound);
+    if (tree->freeList == AABBTREE_NULL)
+    {
+        uint32_t      capacity = tree->nodeCapacity == 0 ? 16 : tree->nodeCapacity * 2;
+        AabbTreeNode* grown    = (AabbTreeNode*)realloc(tree->nodes, capacity * sizeof(AabbTreeNode));
+        if (grown == NULL)
+        {
+            LOG_ERR("AabbTree: out of memory for nodes");
+            return AABBTREE_NULL;
+        }
+        for (uint32_t i = tree->nodeCapacity; i < capacity; i++)
+        {
+            grown[i].parent = i + 1 < capacity ? i + 1 : AABBTREE_NULL;
+            grown[i].height = -1;
+        }
+        tree->freeList     = tree->nodeCapacity;
+        tree->nodes        = grown;
+        tree->nodeCapacity = capacity;
+    }
+    uint32_t      index = tree->freeList;
+    AabbTreeNode* node  = &tree->nodes[index];
+    tree->freeList      = node->parent;
+    node->parent        = AABBTREE_NULL;
+    node->child1        = AABBTREE_NULL;
+    node->child2        = AABBTREE_NULL;
+    node->height        = 0;
+    node->userData      = NULL;
+    tree->nodeCount++;
+    return index;
 }
 
-void AudioPlayer_Start(AudioData* audio)
+static void AabbTree_FreeNode(AabbTree* tree, uint32_t index)
 {
-    PlaySound(audio->sound);
+    tree->nodes[index].parent = tree->freeList;
+    tree->nodes[index].height = -1;
+    tree->freeList            = index;
+    tree->nodeCount--;
 }
 
-void Collider2D_Initialize(Collider2D* col)
+static void AabbTree_Refit(AabbTree* tree, uint32_t index)
 {
-    col->parent     = NULL;
-    col->position.x = 0;
-    col->position.y = 0;
-    col->size.x     = 0;
-    col->size.y     = 0;
-    col->isEnabled  = true;
-    col->id         = 0;
+    AabbTreeNode* node   = &tree->nodes[index];
+    AabbTreeNode* child1 = &tree->nodes[node->child1];
+    AabbTreeNode* child2 = &tree->nodes[node->child2];
+    node->height         = 1 + (child1->height > child2->height ? child1->height : child2->height);
+    AabbTree_Union(node, child1, child2);
 }
 
-void Collider2D_DrawDebug(Collider2D* col)
+// Rotates a grandchild up when one side of the node is more than one level deeper, returns the new subtree root.
+static uint32_t AabbTree_Balance(AabbTree* tree, uint32_t indexA)
 {
-    if (col == NULL)
+    AabbTreeNode* a = &tree->nodes[indexA];
+    if (AabbTree_IsLeaf(a))
     {
-        LOG_ERR("Collider2D: DrawDebug(), collider is nullptr");
-        return;
+        return indexA;
     }
-    if (col->parent == NULL)
+    uint32_t indexB  = a->child1;
+    uint32_t indexC  = a->child2;
+    int32_t  balance = tree->nodes[indexC].height - tree->nodes[indexB].height;
+    if (balance > -2 && balance < 2)
     {
-        DrawRectangleLines(col->position.x, col->position.y, col->size.x, col->size.y, YELLOW);
+        return indexA;
     }
-    else
+    // the deeper child takes the place of a, a keeps the shallower child and the shallower grandchild
+    uint32_t      indexUp   = balance > 1 ? indexC : indexB;
+    AabbTreeNode* up        = &tree->nodes[indexUp];
+    uint32_t      indexDeep = tree->nodes[up->child1].height > tree->nodes[up->child2].height ? up->child1 : up->child2;
+    uint32_t      indexMove = indexDeep == up->child1 ? up->child2 : up->child1;
+    up->child1              = indexA;
+    up->child2              = indexDeep;
+    up->parent              = a->parent;
+    a->parent               = indexUp;
+    if (up->parent == AABBTREE_NULL)
     {
-        DrawRectangleLines(col->parent->position.x + (col->position.x * col->parent->scale),
-                           col->parent->position.y + (col->position.y * col->parent->scale),
-                           col->size.x * col->parent->scale, col->size.y * col->parent->scale, YELLOW);
+        tree->root = indexUp;
     }
-}
-
-bool Collider2D_CheckCollider(Collider2D* a, Collider2D* b)
-{
-    Vector2Float aPos  = { 0, 0 };
-    Vector2Float bPos  = { 0, 0 };
-    Vector2Float aSize = a->size;
-    Vector2Float bSize = b->size;
-    if (a->parent)
+    else if (tree->nodes[up->parent].child1 == indexA)
     {
-        aPos = { a->parent->position.x + (a->position.x * a->parent->scale),
-                 a->parent->position.y + (a->position.y * a->parent->scale) };
+        tree->nodes[up->parent].child1 = indexUp;
     }
     else
     {
-        aPos = a->position;
+        tree->nodes[up->parent].child2 = indexUp;
     }
-    if (b->parent)
+    if (balance > 1)
     {
-        bPos = { b->parent->position.x + (b->position.x * b->parent->scale),
-                 b->parent->position.y + (b->position.y * b->parent->scale) };
+        a->child2 = indexMove;
     }
     else
     {
-        bPos = b->position;
+        a->child1 = indexMove;
     }
-    if (aPos.x < bPos.x + bSize.x && aPos.x + aSize.x > bPos.x && aPos.y < bPos.y + bSize.y
-        && aPos.y + aSize.y > bPos.y)
+    tree->nodes[indexMove].parent = indexA;
+    AabbTree_Refit(tree, indexA);
+    AabbTree_Refit(tree, indexUp);
+    return indexUp;
+}
+
+// Walks up from index, rebalancing and refitting every ancestor.
+static void AabbTree_FixUpwards(AabbTree* tree, uint32_t index)
+{
+    while (index != AABBTREE_NULL)
     {
-        return true;
+        index = AabbTree_Balance(tree, index);
+        AabbTree_Refit(tree, index);
+        index = tree->nodes[index].parent;
     }
-    return false;
 }
 
-bool Collider2D_CheckPoint(Collider2D* a, Vector2 b)
+// Picks the sibling with the lowest perimeter cost, including the growth it causes in the ancestors.
+static void AabbTree_InsertLeaf(AabbTree* tree, uint32_t leaf)
 {
-    Vector2Float aPos  = { 0, 0 };
-    Vector2Float aSize = a->size;
-    if (a->parent)
+    if (tree->root == AABBTREE_NULL)
     {
-        aPos = a->parent->position;
+        tree->root               = leaf;
+        tree->nodes[leaf].parent = AABBTREE_NULL;
+        return;
     }
-    aPos.x += a->position.x;
-    aPos.y += a->position.y;
-    if (aPos.x < b.x && aPos.x + aSize.x > b.x && aPos.y < b.y && aPos.y + aSize.y > b.y)
+    AabbTreeNode leafBox = tree->nodes[leaf];
+    uint32_t     index   = tree->root;
+    while (!AabbTree_IsLeaf(&tree->nodes[index]))
     {
-        return true;
+        AabbTreeNode* node = &tree->nodes[index];
+        AabbTreeNode  combined;
+        AabbTree_Union(&combined, node, &leafBox);
+        float area            = AabbTree_Perimeter(node->min, node->max);
+        float combinedArea    = AabbTree_Perimeter(combined.min, combined.max);
+        float cost            = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+        float childCost[2];
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            AabbTreeNode* child = &tree->nodes[i == 0 ? node->child1 : node->child2];
+            AabbTreeNode  grown;
+            AabbTree_Union(&grown, child, &leafBox);
+            childCost[i] = AabbTree_Perimeter(grown.min, grown.max) + inheritanceCost;
+            if (!AabbTree_IsLeaf(child))
+            {
+                childCost[i] -= AabbTree_Perimeter(child->min, child->max);
+            }
+        }
+        if (cost < childCost[0] && cost < childCost[1])
+        {
+            break;
+        }
+        index = childCost[0] < childCost[1] ? node->child1 : node->child2;
     }
-    return false;
-}
-
-bool Collider2D_CheckRect(Collider2D* a, Rectangle b)
-{
-    Vector2Float aPos  = { 0, 0 };
-    Vector2Float bPos  = { b.x, b.y };
-    Vector2Float aSize = a->size;
-    Vector2Float bSize = { b.width, b.height };
-    if (a->parent)
+    uint32_t sibling   = index;
+    uint32_t newParent = AabbTree_AllocateNode(tree);
+    if (newParent == AABBTREE_NULL)
     {
-        aPos = a->parent->position;
+        return;
     }
-    aPos.x += a->position.x;
-    aPos.y += a->position.y;
-    if (aPos.x < bPos.x + bSize.x && aPos.x + aSize.x > bPos.x && aPos.y < bPos.y + bSize.y
-        && aPos.y + aSize.y > bPos.y)
+    uint32_t oldParent             = tree->nodes[sibling].parent;
+    tree->nodes[newParent].parent  = oldParent;
+    tree->nodes[newParent].child1  = sibling;
+    tree->nodes[newParent].child2  = leaf;
+    tree->nodes[sibling].parent    = newParent;
+    tree->nodes[leaf].parent       = newParent;
+    if (oldParent == AABBTREE_NULL)
     {
-        return true;
+        tree->root = newParent;
     }
-    return false;
+    else if (tree->nodes[oldParent].child1 == sibling)
+    {
+        tree->nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        tree->nodes[oldParent].child2 = newParent;
+    }
+    AabbTree_FixUpwards(tree, newParent);
 }
 
-Collision2D_Collision Collider2D_CheckCollisionSide(Collider2D* a, Collider2D* b)
+static void AabbTree_RemoveLeaf(AabbTree* tree, uint32_t leaf)
 {
-    // calculate on which side the colliders are colliding with each other
-    Vector2Float aPos = { 0, 0 };
-    Vector2Float bPos = { 0, 0 };
-    if (a->parent)
+    if (leaf == tree->root)
     {
-        aPos = { a->parent->position.x + (a->position.x * a->parent->scale),
-                 a->parent->position.y + (a->position.y * a->parent->scale) };
+        tree->root = AABBTREE_NULL;
+        return;
     }
-    else
+    uint32_t parent      = tree->nodes[leaf].parent;
+    uint32_t grandParent = tree->nodes[parent].parent;
+    uint32_t sibling     = tree->nodes[parent].child1 == leaf ? tree->nodes[parent].child2 : tree->nodes[parent].child1;
+    tree->nodes[sibling].parent = grandParent;
+    AabbTree_FreeNode(tree, parent);
+    if (grandParent == AABBTREE_NULL)
     {
-        aPos = a->position;
+        tree->root = sibling;
+        return;
     }
-    if (b->parent)
+    if (tree->nodes[grandParent].child1 == parent)
     {
-        bPos = { b->parent->position.x + (b->position.x * b->parent->scale),
-                 b->parent->position.y + (b->position.y * b->parent->scale) };
+        tree->nodes[grandParent].child1 = sibling;
     }
     else
     {
-        bPos = b->position;
+        tree->nodes[grandParent].child2 = sibling;
     }
-    float aLeft   = aPos.x;
-    float aRight  = aPos.x + a->size.x;
-    float aTop    = aPos.y;
-    float aBottom = aPos.y + a->size.y;
-    float bLeft   = bPos.x;
-    float bRight  = bPos.x + b->size.x;
-    float bTop    = bPos.y;
-    float bBottom = bPos.y + b->size.y;
-    if (aBottom > bTop && aTop < bTop && aRight > bLeft && aLeft < bRight)
+    AabbTree_FixUpwards(tree, grandParent);
+}
+
+static void AabbTree_SetFatBounds(AabbTree* tree, uint32_t leaf, Rectangle bounds, Vector2Float displacement)
+{
+    AabbTreeNode* node = &tree->nodes[leaf];
+    node->min.x        = bounds.x - tree->margin;
+    node->min.y        = bounds.y - tree->margin;
+    node->max.x        = bounds.x + bounds.width + tree->margin;
+    node->max.y        = bounds.y + bounds.height + tree->margin;
+    float dx           = displacement.x * AABBTREE_DISPLACEMENT_MULTIPLIER;
+    float dy           = displacement.y * AABBTREE_DISPLACEMENT_MULTIPLIER;
+    if (dx < 0.0f)
     {
-        return Collision_Top;
+        node->min.x += dx;
     }
-    else if (aTop < bBottom && aBottom > bBottom && aRight > bLeft && aLeft < bRight)
+    else
     {
-        return Collision_Bottom;
+        node->max.x += dx;
     }
-    else if (aRight > bLeft && aLeft < bLeft && aBottom > bTop && aTop < bBottom)
+    if (dy < 0.0f)
     {
-        return Collision_Left;
+        node->min.y += dy;
     }
-    else if (aLeft < bRight && aRight > bRight && aBottom > bTop && aTop < bBottom)
+    else
     {
-        return Collision_Right;
+        node->max.y += dy;
     }
-    return Collision_None;
 }
 
-void Entity2D_Initialize(Entity2D* ent)
+static bool AabbTree_IsValidProxy(AabbTree* tree, uint32_t proxy)
 {
-    ent->id         = 0;
-    ent->position.x = 0;
-    ent->position.y = 0;
-    ent->rotation   = 0;
-    ent->scale      = 1.0f;
+    return proxy < tree->nodeCapacity && tree->nodes[proxy].height == 0;
 }
 
-void Shape2D_Initialize(Shape2D* shape)
+bool AabbTree_Initialize(AabbTree* tree, float margin)
 {
-    shape->parent              = NULL;
-    shape->position            = { 0.0f, 0.0f };
-    shape->scale               = 1.0f;
-    shape->color               = WHITE;
-    shape->type                = SHAPE2D_RECTANGLE;
-    shape->rectangle.width     = 0.0f;
-    shape->rectangle.height    = 0.0f;
-    shape->rectangle.outlineThickness = 1.0f;
+    memset(tree, 0, sizeof(AabbTree));
+    tree->freeList = AABBTREE_NULL;
+    tree->root     = AABBTREE_NULL;
+    tree->margin   = margin;
+    return true;
+}
+
+void AabbTree_Deinitialize(AabbTree* tree)
+{
+    free(tree->nodes);
+    AabbTree_Initialize(tree, tree->margin);
+}
+
+uint32_t AabbTree_Insert(AabbTree* tree, Rectangle bounds, void* userData)
+{
+    uint32_t leaf = AabbTree_AllocateNode(tree);
+    if (leaf == AABBTREE_NULL)
+    {
+        return AABBTREE_NULL;
+    }
+    AabbTree_SetFatBounds(tree, leaf, bounds, (Vector2Float){ 0.0f, 0.0f });
+    tree->nodes[leaf].userData = userData;
+    AabbTree_InsertLeaf(tree, leaf);
+    return leaf;
+}
+
+void AabbTree_Remove(AabbTree* tree, uint32_t proxy)
+{
+    if (!AabbTree_IsValidProxy(tree, proxy))
+    {
+        LOG_WRN("AabbTree: Remove() failed, invalid proxy %u", proxy);
+        return;
+    }
+    AabbTree_RemoveLeaf(tree, proxy);
+    AabbTree_FreeNode(tree, proxy);
+}
+
+// Only touches the tree when the new bounds leave the fat bounds, returns true in that case.
+bool AabbTree_Move(AabbTree* tree, uint32_t proxy, Rectangle bounds, Vector2Float displacement)
+{
+    if (!AabbTree_IsValidProxy(tree, proxy))
+    {
+        LOG_WRN("AabbTree: Move() failed, invalid proxy %u", proxy);
+        return false;
+    }
+    AabbTreeNode* node = &tree->nodes[proxy];
+    if (node->min.x <= bounds.x && node->min.y <= bounds.y && node->max.x >= bounds.x + bounds.width
+        && node->max.y >= bounds.y + bounds.height)
+    {
+        return false;
+    }
+    AabbTree_RemoveLeaf(tree, proxy);
+    AabbTree_SetFatBounds(tree, proxy, bounds, displacement);
+    AabbTree_InsertLeaf(tree, proxy);
+    return true;
+}
+
+void* AabbTree_GetUserData(AabbTree* tree, uint32_t proxy)
+{
+    return AabbTree_IsValidProxy(tree, proxy) ? tree->nodes[proxy].userData : NULL;
+}
+
+int32_t AabbTree_GetHeight(AabbTree* tree)
+{
+    return tree->root == AABBTREE_NULL ? 0 : tree->nodes[tree->root].height;
+}
+
+// Leaves are reported by their fat bounds, the callback does the exact test on its payload.
+void AabbTree_QueryRect(AabbTree* tree, Rectangle rect, bool (*callback)(uint32_t proxy, void* userData, void* context),
+                        void* context)
+{
+    uint32_t stack[AABBTREE_STACK_SIZE];
+    uint32_t stackCount = 0;
+    if (tree->root != AABBTREE_NULL)
+    {
+        stack[stackCount++] = tree->root;
+    }
+    while (stackCount > 0)
+    {
+        uint32_t      index = stack[--stackCount];
+        AabbTreeNode* node  = &tree->nodes[index];
+        if (node->max.x < rect.x || node->min.x > rect.x + rect.width || node->max.y < rect.y
+            || node->min.y > rect.y + rect.height)
+        {
+            continue;
+        }
+        if (AabbTree_IsLeaf(node))
+        {
+            if (!callback(index, node->userData, context))
+            {
+                return;
+            }
+        }
+        else if (stackCount + 2 <= AABBTREE_STACK_SIZE)
+        {
+            stack[stackCount++] = node->child1;
+            stack[stackCount++] = node->child2;
+        }
+        else
+        {
+            LOG_WRN("AabbTree: query stack overflow, tree height %d", AabbTree_GetHeight(tree));
+        }
+    }
+}
+
+void AabbTree_QueryPoint(AabbTree* tree, Vector2Float point,
+                         bool (*callback)(uint32_t proxy, void* userData, void* context), void* context)
+{
+    AabbTree_QueryRect(tree, (Rectangle){ point.x, point.y, 0.0f, 0.0f }, callback, context);
+}
+
+void AabbTree_RayCast(AabbTree* tree, Vector2Float from, Vector2Float to,
+                      float (*callback)(uint32_t proxy, void* userData, Vector2Float from, Vector2Float to,
+                                        float maxFraction, void* context),
+                      void* context)
+{
+    float dx     = to.x - from.x;
+    float dy     = to.y - from.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length <= 0.0f)
+    {
+        return;
+    }
+    // separating axis of the segment: |dot(normal, from - center)| > dot(|normal|, halfExtents) misses the box
+    Vector2Float normal      = { -dy / length, dx / length };
+    Vector2Float normalAbs   = { fabsf(normal.x), fabsf(normal.y) };
+    float        maxFraction = 1.0f;
+    Vector2Float end         = to;
+    uint32_t     stack[AABBTREE_STACK_SIZE];
+    uint32_t     stackCount = 0;
+    if (tree->root != AABBTREE_NULL)
+    {
+        stack[stackCount++] = tree->root;
+    }
+    while (stackCount > 0)
+    {
+        uint32_t      index = stack[--stackCount];
+        AabbTreeNode* node  = &tree->nodes[index];
+        if (node->max.x < fminf(from.x, end.x) || node->min.x > fmaxf(from.x, end.x)
+            || node->max.y < fminf(from.y, end.y) || node->min.y > fmaxf(from.y, end.y))
+        {
+            continue;
+        }
+        Vector2Float center     = { (node->min.x + node->max.x) * 0.5f, (node->min.y + node->max.y) * 0.5f };
+        Vector2Float half       = { (node->max.x - node->min.x) * 0.5f, (node->max.y - node->min.y) * 0.5f };
+        float        separation = fabsf(normal.x * (from.x - center.x) + normal.y * (from.y - center.y))
+                           - (normalAbs.x * half.x + normalAbs.y * half.y);
+        if (separation > 0.0f)
+        {
+            continue;
+        }
+        if (AabbTree_IsLeaf(node))
+        {
+            float value = callback(index, node->userData, from, to, maxFraction, context);
+            if (value == 0.0f)
+            {
+                return;
+            }
+            if (value > 0.0f)
+            {
+                maxFraction = value;
+                end.x       = from.x + dx * maxFraction;
+                end.y       = from.y + dy * maxFraction;
+            }
+        }
+        else if (stackCount + 2 <= AABBTREE_STACK_SIZE)
+        {
+            stack[stackCount++] = node->child1;
+            stack[stackCount++] = node->child2;
+        }
+        else
+        {
+            LOG_WRN("AabbTree: ray cast stack overflow, tree height %d", AabbTree_GetHeight(tree));
+        }
+    }
+}
+
+void AnimatedSprite_Initialize(AnimatedSprite* animatedSprite)
+{
+    animatedSprite->frameTime        = ANIMATEDSPRITE_DEFAULT_ANIMATION_SPEED;
+    animatedSprite->currentAnimation = NULL;
+    animatedSprite->isPlaying        = false;
+    animatedSprite->repeat           = false;
+    animatedSprite->currentFrame     = 0;
+    Sprite_Initialize(&animatedSprite->sprite);
+}
+
+void AnimatedSprite_Play(AnimatedSprite* animatedSprite, AnimationData* animation, bool repeat)
+{
+    animatedSprite->currentAnimation = animation;
+    animatedSprite->repeat           = repeat;
+    animatedSprite->isPlaying        = true;
+    animatedSprite->currentFrame     = 0;
+}
+
+void AnimatedSprite_Stop(AnimatedSprite* animatedSprite)
+{
+    animatedSprite->isPlaying = false;
+}
+
+void AnimatedSprite_Update(AnimatedSprite* animatedSprite)
+{
+    if (animatedSprite->isPlaying && animatedSprite->currentAnimation && Stopwatch_IsZero(&animatedSprite->stopwatch))
+    {
+        animatedSprite->sprite.currentTexture =
+            &animatedSprite->currentAnimation->animationFrames[animatedSprite->currentFrame++];
+        if (animatedSprite->currentFrame >= animatedSprite->currentAnimation->animationFrameCount)
+        {
+            if (animatedSprite->repeat)
+            {
+                animatedSprite->currentFrame = 0;
+            }
+            else
+            {
+                animatedSprite->isPlaying             = false;
+                animatedSprite->sprite.currentTexture = &animatedSprite->currentAnimation->animationFrames[0];
+            }
+        }
+        Stopwatch_Start(&animatedSprite->stopwatch, animatedSprite->frameTime);
+    }
+}
+
+void AsciiWindow_Initalize(AsciiWindow* window, Texture2D texture)
+{
+    AsciiWindow_Clear(window);
+    for (uint32_t i = 0; i < window->height * window->width; i++)
+    {
+        Sprite_Initialize(&window->spriteBuffer[i]);
+    }
+    window->spriteHeight = window->textureBuffer[0]->size.y;
+    window->spriteWidth  = window->textureBuffer[0]->size.x;
+    for (uint32_t i = 0; i < window->height; i++)
+    {
+        for (uint32_t j = 0; j < window->width; j++)
+        {
+            window->spriteBuffer[i * window->width + j].position.x = window->textureBuffer[0]->size.x
+                                                                     * window->spriteBuffer[i * window->width + j].scale
+                                                                     * window->entity.scale * j;
+            window->spriteBuffer[i * window->width + j].position.y = window->textureBuffer[0]->size.y
+                                                                     * window->spriteBuffer[i * window->width + j].scale
+                                                                     * window->entity.scale * i;
+            window->spriteBuffer[i * window->width + j].currentTexture = window->textureBuffer[0];
+            window->spriteBuffer[i * window->width + j].parent         = &window->entity;
+        }
+    }
+}
+
+void AsciiWindow_SetCharacter(AsciiWindow* window, uint32_t x, uint32_t y, char c)
+{
+    AsciiWindow_SetCell(window, x, y, static_cast<uint32_t>(c) - ASCIIWINDOW_ASCII_START);
+}
+
+char AsciiWindow_GetCharacter(AsciiWindow* window, uint32_t x, uint32_t y)
+{
+    return static_cast<char>(AsciiWindow_GetCell(window, x, y) + ASCIIWINDOW_ASCII_START);
+}
+
+void AsciiWindow_SetCell(AsciiWindow* window, uint32_t x, uint32_t y, uint32_t value)
+{
+    window->windowBuffer[y * window->width + x] = value;
+}
+
+uint32_t AsciiWindow_GetCell(AsciiWindow* window, uint32_t x, uint32_t y)
+{
+    return window->windowBuffer[y * window->width + x];
+}
+
+void AsciiWindow_Clear(AsciiWindow* window)
+{
+    for (uint32_t i = 0; i < window->height * window->width; i++)
+    {
+        window->windowBuffer[i] = 0;
+    }
+}
+
+void AsciiWindow_Draw(AsciiWindow* window)
+{
+    for (uint32_t i = 0; i < window->height; i++)
+    {
+        for (uint32_t j = 0; j < window->width; j++)
+        {
+            uint32_t currentChar                                       = AsciiWindow_GetCell(window, j, i);
+            window->spriteBuffer[i * window->width + j].currentTexture = window->textureBuffer[currentChar];
+        }
+    }
+}
+
+void AsciiWindow_DrawBorder(AsciiWindow* window, AsciiWindowBorder border)
+{
+    for (uint32_t i = 0; i < window->height; i++)
+    {
+        for (uint32_t j = 0; j < window->width; j++)
+        {
+            if (i == 0 && j == 0)
+            {
+                AsciiWindow_SetCell(window, j, i, border.top[0]);
+            }
+            else if (i == 0 && j == window->width - 1)
+            {
+                AsciiWindow_SetCell(window, j, i, border.top[2]);
+            }
+            else if (i == window->height - 1 && j == 0)
+            {
+                AsciiWindow_SetCell(window, j, i, border.bottom[0]);
+            }
+            else if (i == window->height - 1 && j == window->width - 1)
+            {
+                AsciiWindow_SetCell(window, j, i, border.bottom[2]);
+            }
+            else if (i == 0 && j != 0 && j != window->width - 1)
+            {
+                AsciiWindow_SetCell(window, j, i, border.top[1]);
+            }
+            else if (i == window->height - 1 && j != 0 && j != window->width - 1)
+            {
+                AsciiWindow_SetCell(window, j, i, border.bottom[1]);
+            }
+            else if (j == 0 && i != 0 && i != window->height - 1)
+            {
+                AsciiWindow_SetCell(window, j, i, border.middle[0]);
+            }
+            else if (j == window->width - 1 && i != 0 && i != window->height - 1)
+            {
+                AsciiWindow_SetCell(window, j, i, border.middle[2]);
+            }
+        }
+    }
+}
+
+void AsciiWindow_DrawFill(AsciiWindow* window, uint8_t fill)
+{
+    for (uint32_t i = 0; i < window->height; i++)
+    {
+        for (uint32_t j = 0; j < window->width; j++)
+        {
+            AsciiWindow_SetCharacter(window, j, i, fill);
+        }
+    }
+}
+
+void AsciiWindow_DrawString(AsciiWindow* window, uint8_t x, uint8_t y, const char* string)
+{
+    uint32_t position = 0;
+    while (string[position] != '\0')
+    {
+        AsciiWindow_SetCharacter(window, x, y, string[position]);
+        x++;
+        position++;
+        if (x >= window->width)
+        {
+            x = 0;
+            y++;
+        }
+        if (y >= window->height)
+        {
+            break;
+        }
+    }
+}
+
+static AudioMusicData* playingMusic[AUDIO_MAX_PLAYING_MUSIC];
+static uint32_t        playingMusicCount = 0;
+static Updatable       audioUpdatable;
+
+bool Audio_Init()
+{
+    InitAudioDevice();
+    // music streams have to be refilled every frame, that runs as an updatable so its cost shows up with the rest
+    Updatable_Initialize(&audioUpdatable, Audio_Update, "Audio");
+    audioUpdatable.phase = UPDATABLE_PHASE_POST_UPDATE;
+    Context_AddUpdatable(&audioUpdatable);
+    return IsAudioDeviceReady();
+}
+
+void Audio_Deinit()
+{
+    Context_RemoveUpdatable(&audioUpdatable);
+    playingMusicCount = 0;
+    CloseAudioDevice();
+}
+
+AudioData Audio_LoadAudio(const char* fileName)
+{
+    if (fileName == NULL)
+    {
+        return (AudioData){ 0 };
+    }
+    Sound     sound = LoadSound(fileName);
+    AudioData audio;
+    audio.sound = sound;
+    return audio;
+}
+
+void Audio_UnloadAudio(AudioData* audio)
+{
+    UnloadSound(audio->sound);
+}
+
+AudioMusicData Audio_LoadMusic(const char* fileName)
+{
+    if (fileName == NULL)
+    {
+        LOG_ERR("Audio: LoadMusic() failed, fileName is nullptr");
+        return (AudioMusicData){ 0 };
+    }
+    AudioMusicData music;
+    music.music     = LoadMusicStream(fileName);
+    music.isPlaying = false;
+    return music;
+}
+
+void Audio_UnloadMusic(AudioMusicData* music)
+{
+    Audio_StopMusic(music);
+    UnloadMusicStream(music->music);
+}
+
+bool Audio_PlayMusic(AudioMusicData* music)
+{
+    if (music->isPlaying)
+    {
+        return true;
+    }
+    if (playingMusicCount >= AUDIO_MAX_PLAYING_MUSIC)
+    {
+        LOG_ERR("Audio: PlayMusic() failed, %d music streams are already playing", AUDIO_MAX_PLAYING_MUSIC);
+        return false;
+    }
+    PlayMusicStream(music->music);
+    music->isPlaying                  = true;
+    playingMusic[playingMusicCount++] = music;
+    return true;
+}
+
+void Audio_StopMusic(AudioMusicData* music)
+{
+    for (uint32_t i = 0; i < playingMusicCount; i++)
+    {
+        if (playingMusic[i] == music)
+        {
+            playingMusic[i] = playingMusic[--playingMusicCount];
+            break;
+        }
+    }
+    if (music->isPlaying)
+    {
+        StopMusicStream(music->music);
+        music->isPlaying = false;
+    }
+}
+
+void Audio_Update()
+{
+    for (uint32_t i = 0; i < playingMusicCount; i++)
+    {
+        UpdateMusicStream(playingMusic[i]->music);
+    }
+}
+
+void AudioPlayer_Stop(AudioData* audio)
+{
+    StopSound(audio->sound);
+}
+
+void AudioPlayer_Start(AudioData* audio)
+{
+    PlaySound(audio->sound);
+}
+
+void Collider2D_Initialize(Collider2D* col)
+{
+    col->parent     = NULL;
+    col->position.x = 0;
+    col->position.y = 0;
+    col->size.x     = 0;
+    col->size.y     = 0;
+    col->isEnabled  = true;
+    col->id         = 0;
+}
+
+void Collider2D_DrawDebug(Collider2D* col)
+{
+    if (col == NULL)
+    {
+        LOG_ERR("Collider2D: DrawDebug(), collider is nullptr");
+        return;
+    }
+    Vector2Float position = Collider2D_GetWorldPosition(col);
+    Vector2Float size     = Collider2D_GetWorldSize(col);
+    DrawRectangleLines(position.x, position.y, size.x, size.y, YELLOW);
+}
+
+bool Collider2D_CheckCollider(Collider2D* a, Collider2D* b)
+{
+    Vector2Float aPos  = Collider2D_GetWorldPosition(a);
+    Vector2Float bPos  = Collider2D_GetWorldPosition(b);
+    Vector2Float aSize = Collider2D_GetWorldSize(a);
+    Vector2Float bSize = Collider2D_GetWorldSize(b);
+    if (aPos.x < bPos.x + bSize.x && aPos.x + aSize.x > bPos.x && aPos.y < bPos.y + bSize.y
+        && aPos.y + aSize.y > bPos.y)
+    {
+        return true;
+    }
+    return false;
+}
+
+bool Collider2D_CheckPoint(Collider2D* a, Vector2 b)
+{
+    Vector2Float aPos  = Collider2D_GetWorldPosition(a);
+    Vector2Float aSize = Collider2D_GetWorldSize(a);
+    if (aPos.x < b.x && aPos.x + aSize.x > b.x && aPos.y < b.y && aPos.y + aSize.y > b.y)
+    {
+        return true;
+    }
+    return false;
+}
+
+bool Collider2D_CheckRect(Collider2D* a, Rectangle b)
+{
+    Vector2Float aPos  = Collider2D_GetWorldPosition(a);
+    Vector2Float bPos  = { b.x, b.y };
+    Vector2Float aSize = Collider2D_GetWorldSize(a);
+    Vector2Float bSize = { b.width, b.height };
+    if (aPos.x < bPos.x + bSize.x && aPos.x + aSize.x > bPos.x && aPos.y < bPos.y + bSize.y
+        && aPos.y + aSize.y > bPos.y)
+    {
+        return true;
+    }
+    return false;
+}
+
+Collision2D_Collision Collider2D_CheckCollisionSide(Collider2D* a, Collider2D* b)
+{
+    // calculate on which side the colliders are colliding with each other
+    Vector2Float aPos  = Collider2D_GetWorldPosition(a);
+    Vector2Float bPos  = Collider2D_GetWorldPosition(b);
+    Vector2Float aSize = Collider2D_GetWorldSize(a);
+    Vector2Float bSize = Collider2D_GetWorldSize(b);
+    float aLeft   = aPos.x;
+    float aRight  = aPos.x + aSize.x;
+    float aTop    = aPos.y;
+    float aBottom = aPos.y + aSize.y;
+    float bLeft   = bPos.x;
+    float bRight  = bPos.x + bSize.x;
+    float bTop    = bPos.y;
+    float bBottom = bPos.y + bSize.y;
+    if (aBottom > bTop && aTop < bTop && aRight > bLeft && aLeft < bRight)
+    {
+        return Collision_Top;
+    }
+    else if (aTop < bBottom && aBottom > bBottom && aRight > bLeft && aLeft < bRight)
+    {
+        return Collision_Bottom;
+    }
+    else if (aRight > bLeft && aLeft < bLeft && aBottom > bTop && aTop < bBottom)
+    {
+        return Collision_Left;
+    }
+    else if (aLeft < bRight && aRight > bRight && aBottom > bTop && aTop < bBottom)
+    {
+        return Collision_Right;
+    }
+    return Collision_None;
+}
+
+Rectangle Collider2D_GetBounds(Collider2D* col)
+{
+    Vector2Float position = Collider2D_GetWorldPosition(col);
+    Vector2Float size     = Collider2D_GetWorldSize(col);
+    return (Rectangle){ position.x, position.y, size.x, size.y };
+}
+
+void Entity2D_Initialize(Entity2D* ent)
+{
+    ent->id            = 0;
+    ent->position.x    = 0;
+    ent->position.y    = 0;
+    ent->rotation      = 0;
+    ent->scale         = 1.0f;
+    ent->parent        = NULL;
+    ent->worldParent   = NULL;
+    ent->parentVersion = 0;
+    ent->version       = 0;
+    ent->isDirty       = true;
+}
+
+bool Entity2D_SetParent(Entity2D* ent, Entity2D* parent)
+{
+    for (Entity2D* ancestor = parent; ancestor != NULL; ancestor = ancestor->parent)
+    {
+        if (ancestor == ent)
+        {
+            LOG_ERR("Entity2D: SetParent() failed, parent is a child of the entity");
+            return false;
+        }
+    }
+    ent->parent  = parent;
+    ent->isDirty = true;
+    return true;
+}
+
+void Entity2D_MarkDirty(Entity2D* ent)
+{
+    ent->isDirty = true;
+}
+
+// Resolves the parent chain first, so a node is only rebuilt after its parent and only when something it depends on
+// changed, position/scale/rotation can still be written directly
+const Transform2D* Entity2D_GetWorld(Entity2D* ent)
+{
+    const Transform2D* parentWorld   = NULL;
+    uint32_t           parentVersion = 0;
+    if (ent->parent != NULL)
+    {
+        parentWorld   = Entity2D_GetWorld(ent->parent);
+        parentVersion = ent->parent->version;
+    }
+    Transform2D* source = &ent->worldSource;
+    if (!ent->isDirty && ent->worldParent == ent->parent && ent->parentVersion == parentVersion
+        && source->position.x == ent->position.x && source->position.y == ent->position.y
+        && source->scale == ent->scale && source->rotation == ent->rotation)
+    {
+        return &ent->world;
+    }
+    Transform2D* world = &ent->world;
+    if (parentWorld == NULL)
+    {
+        world->position = ent->position;
+        world->scale    = ent->scale;
+        world->rotation = ent->rotation;
+    }
+    else
+    {
+        world->position = Transform2D_Apply(parentWorld, ent->position);
+        world->scale    = parentWorld->scale * ent->scale;
+        world->rotation = parentWorld->rotation + ent->rotation;
+    }
+    world->rotationSin = sinf(world->rotation * DEG2RAD);
+    world->rotationCos = cosf(world->rotation * DEG2RAD);
+    source->position   = ent->position;
+    source->scale      = ent->scale;
+    source->rotation   = ent->rotation;
+    ent->worldParent   = ent->parent;
+    ent->parentVersion = parentVersion;
+    ent->isDirty       = false;
+    ent->version++;
+    return world;
+}
+
+Vector2Float Entity2D_TransformPoint(Entity2D* ent, Vector2Float local)
+{
+    return Transform2D_Apply(Entity2D_GetWorld(ent), local);
+}
+
+void Shape2D_Initialize(Shape2D* shape)
+{
+    shape->parent              = NULL;
+    shape->position            = { 0.0f, 0.0f };
+    shape->scale               = 1.0f;
+    shape->color               = WHITE;
+    shape->type                = SHAPE2D_RECTANGLE;
+    shape->rectangle.width     = 0.0f;
+    shape->rectangle.height    = 0.0f;
+    shape->rectangle.outlineThickness = 1.0f;
 }
 
 void Shape2D_Draw(Shape2D* shape)
 {
     Vector2 worldPosition = { shape->position.x, shape->position.y };
     float   worldScale    = shape->scale;
+    float   worldRotation = 0.0f;
+
+    if (shape->parent != NULL)
+    {
+        const Transform2D* parentWorld = Entity2D_GetWorld(shape->parent);
+        Vector2Float       position    = Entity2D_TransformPoint(shape->parent, shape->position);
+        worldPosition.x                = position.x;
+        worldPosition.y                = position.y;
+        worldScale *= parentWorld->scale;
+        worldRotation = parentWorld->rotation;
+    }
+
+    switch (shape->type)
+    {
+        case SHAPE2D_RECTANGLE:
+            DrawRectanglePro(
+                (Rectangle){ worldPosition.x, worldPosition.y,
+                             shape->rectangle.width  * worldScale,
+                             shape->rectangle.height * worldScale },
+                (Vector2){ 0.0f, 0.0f }, worldRotation, shape->color);
+            break;
+
+        case SHAPE2D_RECTANGLE_LINES:
+            DrawRectangleLinesEx(
+                (Rectangle){ worldPosition.x, worldPosition.y,
+                             shape->rectangle.width  * worldScale,
+                             shape->rectangle.height * worldScale },
+                shape->rectangle.outlineThickness * worldScale,
+                shape->color);
+            break;
+
+        case SHAPE2D_LINE:
+        {
+            Vector2 worldEnd;
+            if (shape->parent != NULL)
+            {
+                Vector2Float end = Entity2D_TransformPoint(shape->parent, shape->line.endPosition);
+                worldEnd.x       = end.x;
+                worldEnd.y       = end.y;
+            }
+            else
+            {
+                worldEnd.x = shape->line.endPosition.x;
+                worldEnd.y = shape->line.endPosition.y;
+            }
+            DrawLineEx(worldPosition, worldEnd, shape->line.thickness * worldScale, shape->color);
+            break;
+        }
+
+        case SHAPE2D_CIRCLE:
+            DrawCircleV(worldPosition, shape->circle.radius * worldScale, shape->color);
+            break;
+
+        case SHAPE2D_CIRCLE_LINES:
+        {
+            float outerRadius = shape->circle.radius * worldScale;
+            float innerRadius = outerRadius - shape->circle.outlineThickness * worldScale;
+            if (innerRadius < 0.0f)
+                innerRadius = 0.0f;
+            DrawRing(worldPosition, innerRadius, outerRadius, 0.0f, 360.0f, 36, shape->color);
+            break;
+        }
+    }
+}
+
+static uint32_t SpatialHash_Bucket(SpatialHash* hash, int32_t x, int32_t y)
+{
+    return (((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u)) & hash->bucketMask;
+}
+
+static bool SpatialHash_Overlaps(Rectangle a, Rectangle b)
+{
+    return a.x < b.x + b.width && a.x + a.width > b.x && a.y < b.y + b.height && a.y + a.height > b.y;
+}
+
+static int32_t SpatialHash_Cell(SpatialHash* hash, float value)
+{
+    return (int32_t)floorf(value * hash->inverseCellSize);
+}
+
+static uint32_t SpatialHash_AllocateNode(SpatialHash* hash)
+{
+    if (hash->freeNode != SPATIALHASH_NONE)
+    {
+        uint32_t node  = hash->freeNode;
+        hash->freeNode = hash->nodes[node].next;
+        return node;
+    }
+    if (hash->nodeCount == hash->nodeCapacity)
+    {
+        uint32_t         capacity = hash->nodeCapacity == 0 ? 256 : hash->nodeCapacity * 2;
+        SpatialHashNode* grown    = (SpatialHashNode*)realloc(hash->nodes, capacity * sizeof(SpatialHashNode));
+        if (grown == NULL)
+        {
+            LOG_ERR("SpatialHash: out of memory for cell nodes");
+            return SPATIALHASH_NONE;
+        }
+        hash->nodes        = grown;
+        hash->nodeCapacity = capacity;
+    }
+    return hash->nodeCount++;
+}
+
+static void SpatialHash_LinkProxy(SpatialHash* hash, uint32_t proxyIndex)
+{
+    SpatialHashProxy* proxy = &hash->proxies[proxyIndex];
+    proxy->firstNode        = SPATIALHASH_NONE;
+    for (int32_t y = proxy->minY; y <= proxy->maxY; y++)
+    {
+        for (int32_t x = proxy->minX; x <= proxy->maxX; x++)
+        {
+            uint32_t nodeIndex = SpatialHash_AllocateNode(hash);
+            if (nodeIndex == SPATIALHASH_NONE)
+            {
+                return;
+            }
+            SpatialHashNode* node   = &hash->nodes[nodeIndex];
+            uint32_t         bucket = SpatialHash_Bucket(hash, x, y);
+            node->cellX             = x;
+            node->cellY             = y;
+            node->proxy             = proxyIndex;
+            node->previous          = SPATIALHASH_NONE;
+            node->next              = hash->buckets[bucket];
+            node->nextInProxy       = proxy->firstNode;
+            if (node->next != SPATIALHASH_NONE)
+            {
+                hash->nodes[node->next].previous = nodeIndex;
+            }
+            hash->buckets[bucket] = nodeIndex;
+            proxy->firstNode      = nodeIndex;
+        }
+    }
+}
+
+static void SpatialHash_UnlinkProxy(SpatialHash* hash, uint32_t proxyIndex)
+{
+    SpatialHashProxy* proxy     = &hash->proxies[proxyIndex];
+    uint32_t          nodeIndex = proxy->firstNode;
+    while (nodeIndex != SPATIALHASH_NONE)
+    {
+        SpatialHashNode* node = &hash->nodes[nodeIndex];
+        if (node->previous != SPATIALHASH_NONE)
+        {
+            hash->nodes[node->previous].next = node->next;
+        }
+        else
+        {
+            hash->buckets[SpatialHash_Bucket(hash, node->cellX, node->cellY)] = node->next;
+        }
+        if (node->next != SPATIALHASH_NONE)
+        {
+            hash->nodes[node->next].previous = node->previous;
+        }
+        uint32_t nextInProxy = node->nextInProxy;
+        node->next           = hash->freeNode;
+        hash->freeNode       = nodeIndex;
+        nodeIndex            = nextInProxy;
+    }
+    proxy->firstNode = SPATIALHASH_NONE;
+}
+
+// Refreshes the bounds of a proxy, returns true if it now covers different cells.
+static bool SpatialHash_ComputeCells(SpatialHash* hash, SpatialHashProxy* proxy)
+{
+    proxy->bounds = Collider2D_GetBounds(proxy->collider);
+    int32_t minX  = SpatialHash_Cell(hash, proxy->bounds.x);
+    int32_t minY  = SpatialHash_Cell(hash, proxy->bounds.y);
+    int32_t maxX  = SpatialHash_Cell(hash, proxy->bounds.x + proxy->bounds.width);
+    int32_t maxY  = SpatialHash_Cell(hash, proxy->bounds.y + proxy->bounds.height);
+    if (minX == proxy->minX && minY == proxy->minY && maxX == proxy->maxX && maxY == proxy->maxY)
+    {
+        return false;
+    }
+    proxy->minX = minX;
+    proxy->minY = minY;
+    proxy->maxX = maxX;
+    proxy->maxY = maxY;
+    return true;
+}
+
+static uint32_t SpatialHash_NextQueryStamp(SpatialHash* hash)
+{
+    hash->queryStamp++;
+    if (hash->queryStamp == 0)
+    {
+        for (uint32_t i = 0; i < hash->proxyCount; i++)
+        {
+            hash->proxies[i].queryStamp = 0;
+        }
+        hash->queryStamp = 1;
+    }
+    return hash->queryStamp;
+}
+
+bool SpatialHash_Initialize(SpatialHash* hash, float cellSize, uint32_t bucketCount)
+{
+    memset(hash, 0, sizeof(SpatialHash));
+    if (cellSize <= 0.0f)
+    {
+        LOG_ERR("SpatialHash: Initialize() failed, cell size must be positive");
+        return false;
+    }
+    uint32_t count = 1;
+    while (count < bucketCount)
+    {
+        count <<= 1;
+    }
+    hash->buckets = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (hash->buckets == NULL)
+    {
+        LOG_ERR("SpatialHash: Initialize() failed, out of memory");
+        return false;
+    }
+    hash->cellSize        = cellSize;
+    hash->inverseCellSize = 1.0f / cellSize;
+    hash->bucketMask      = count - 1;
+    hash->freeProxy       = SPATIALHASH_NONE;
+    hash->freeNode        = SPATIALHASH_NONE;
+    memset(hash->buckets, 0xFF, count * sizeof(uint32_t));
+    return true;
+}
+
+void SpatialHash_Deinitialize(SpatialHash* hash)
+{
+    free(hash->buckets);
+    free(hash->proxies);
+    free(hash->nodes);
+    memset(hash, 0, sizeof(SpatialHash));
+}
+
+void SpatialHash_Clear(SpatialHash* hash)
+{
+    if (hash->buckets == NULL)
+    {
+        return;
+    }
+    memset(hash->buckets, 0xFF, (hash->bucketMask + 1) * sizeof(uint32_t));
+    hash->proxyCount = 0;
+    hash->nodeCount  = 0;
+    hash->freeProxy  = SPATIALHASH_NONE;
+    hash->freeNode   = SPATIALHASH_NONE;
+}
+
+uint32_t SpatialHash_Insert(SpatialHash* hash, Collider2D* col)
+{
+    if (hash->buckets == NULL || col == NULL)
+    {
+        LOG_ERR("SpatialHash: Insert() failed, hash not initialized or collider is nullptr");
+        return SPATIALHASH_NONE;
+    }
+    uint32_t proxyIndex;
+    if (hash->freeProxy != SPATIALHASH_NONE)
+    {
+        proxyIndex      = hash->freeProxy;
+        hash->freeProxy = hash->proxies[proxyIndex].firstNode;
+    }
+    else
+    {
+        if (hash->proxyCount == hash->proxyCapacity)
+        {
+            uint32_t          capacity = hash->proxyCapacity == 0 ? 64 : hash->proxyCapacity * 2;
+            SpatialHashProxy* grown = (SpatialHashProxy*)realloc(hash->proxies, capacity * sizeof(SpatialHashProxy));
+            if (grown == NULL)
+            {
+                LOG_ERR("SpatialHash: Insert() failed, out of memory");
+                return SPATIALHASH_NONE;
+            }
+            hash->proxies       = grown;
+            hash->proxyCapacity = capacity;
+        }
+        proxyIndex = hash->proxyCount++;
+    }
+    SpatialHashProxy* proxy = &hash->proxies[proxyIndex];
+    proxy->collider         = col;
+    proxy->queryStamp       = 0;
+    proxy->isUsed           = true;
+    proxy->minX             = 1;
+    proxy->maxX             = 0;
+    SpatialHash_ComputeCells(hash, proxy);
+    SpatialHash_LinkProxy(hash, proxyIndex);
+    return proxyIndex;
+}
+
+// Cheap when the collider stays inside the same cells, only its cached bounds change.
+void SpatialHash_Update(SpatialHash* hash, uint32_t proxyIndex)
+{
+    if (proxyIndex >= hash->proxyCount || !hash->proxies[proxyIndex].isUsed)
+    {
+        LOG_WRN("SpatialHash: Update() failed, invalid proxy %u", proxyIndex);
+        return;
+    }
+    if (SpatialHash_ComputeCells(hash, &hash->proxies[proxyIndex]))
+    {
+        SpatialHash_UnlinkProxy(hash, proxyIndex);
+        SpatialHash_LinkProxy(hash, proxyIndex);
+    }
+}
+
+void SpatialHash_Remove(SpatialHash* hash, uint32_t proxyIndex)
+{
+    if (proxyIndex >= hash->proxyCount || !hash->proxies[proxyIndex].isUsed)
+    {
+        LOG_WRN("SpatialHash: Remove() failed, invalid proxy %u", proxyIndex);
+        return;
+    }
+    SpatialHashProxy* proxy = &hash->proxies[proxyIndex];
+    SpatialHash_UnlinkProxy(hash, proxyIndex);
+    proxy->isUsed    = false;
+    proxy->collider  = NULL;
+    proxy->firstNode = hash->freeProxy;
+    hash->freeProxy  = proxyIndex;
+}
+
+uint32_t SpatialHash_QueryRect(SpatialHash* hash, Rectangle rect, Collider2D** output, uint32_t outputSize)
+{
+    if (hash->buckets == NULL)
+    {
+        return 0;
+    }
+    uint32_t stamp = SpatialHash_NextQueryStamp(hash);
+    uint32_t count = 0;
+    int32_t  minX  = SpatialHash_Cell(hash, rect.x);
+    int32_t  minY  = SpatialHash_Cell(hash, rect.y);
+    int32_t  maxX  = SpatialHash_Cell(hash, rect.x + rect.width);
+    int32_t  maxY  = SpatialHash_Cell(hash, rect.y + rect.height);
+    for (int32_t y = minY; y <= maxY; y++)
+    {
+        for (int32_t x = minX; x <= maxX; x++)
+        {
+            uint32_t nodeIndex = hash->buckets[SpatialHash_Bucket(hash, x, y)];
+            for (; nodeIndex != SPATIALHASH_NONE; nodeIndex = hash->nodes[nodeIndex].next)
+            {
+                SpatialHashNode*  node  = &hash->nodes[nodeIndex];
+                SpatialHashProxy* proxy = &hash->proxies[node->proxy];
+                if (node->cellX != x || node->cellY != y || proxy->queryStamp == stamp)
+                {
+                    continue;
+                }
+                proxy->queryStamp = stamp;
+                if (proxy->collider->isEnabled && SpatialHash_Overlaps(proxy->bounds, rect) && count < outputSize)
+                {
+                    output[count++] = proxy->collider;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+uint32_t SpatialHash_QueryPoint(SpatialHash* hash, Vector2Float point, Collider2D** output, uint32_t outputSize)
+{
+    if (hash->buckets == NULL)
+    {
+        return 0;
+    }
+    uint32_t count     = 0;
+    int32_t  x         = SpatialHash_Cell(hash, point.x);
+    int32_t  y         = SpatialHash_Cell(hash, point.y);
+    uint32_t nodeIndex = hash->buckets[SpatialHash_Bucket(hash, x, y)];
+    // a proxy has at most one node per cell, so no stamping is needed here
+    for (; nodeIndex != SPATIALHASH_NONE; nodeIndex = hash->nodes[nodeIndex].next)
+    {
+        SpatialHashNode* node = &hash->nodes[nodeIndex];
+        if (node->cellX != x || node->cellY != y)
+        {
+            continue;
+        }
+        SpatialHashProxy* proxy  = &hash->proxies[node->proxy];
+        Rectangle         bounds = proxy->bounds;
+        if (proxy->collider->isEnabled && bounds.x < point.x && bounds.x + bounds.width > point.x
+            && bounds.y < point.y && bounds.y + bounds.height > point.y && count < outputSize)
+        {
+            output[count++] = proxy->collider;
+        }
+    }
+    return count;
+}
 
-    if (shape->parent != NULL)
+// Reports every overlapping pair once: a pair sharing several cells is only reported from the first cell of the
+// overlap of both cell ranges.
+uint32_t SpatialHash_ForEachPair(SpatialHash* hash, void (*callback)(Collider2D* a, Collider2D* b, void* userData),
+                                 void* userData)
+{
+    if (hash->buckets == NULL)
     {
-        worldPosition.x = shape->parent->position.x + shape->position.x * shape->parent->scale;
-        worldPosition.y = shape->parent->position.y + shape->position.y * shape->parent->scale;
-        worldScale *= shape->parent->scale;
+        return 0;
     }
-
-    switch (shape->type)
+    uint32_t pairCount = 0;
+    for (uint32_t bucket = 0; bucket <= hash->bucketMask; bucket++)
     {
-        case SHAPE2D_RECTANGLE:
-            DrawRectangleRec(
-                (Rectangle){ worldPosition.x, worldPosition.y,
-                             shape->rectangle.width  * worldScale,
-                             shape->rectangle.height * worldScale },
-                shape->color);
-            break;
-
-        case SHAPE2D_RECTANGLE_LINES:
-            DrawRectangleLinesEx(
-                (Rectangle){ worldPosition.x, worldPosition.y,
-                             shape->rectangle.width  * worldScale,
-                             shape->rectangle.height * worldScale },
-                shape->rectangle.outlineThickness * worldScale,
-                shape->color);
-            break;
-
-        case SHAPE2D_LINE:
+        for (uint32_t i = hash->buckets[bucket]; i != SPATIALHASH_NONE; i = hash->nodes[i].next)
         {
-            Vector2 worldEnd;
-            if (shape->parent != NULL)
+            SpatialHashNode*  a      = &hash->nodes[i];
+            SpatialHashProxy* aProxy = &hash->proxies[a->proxy];
+            if (!aProxy->collider->isEnabled)
             {
-                worldEnd.x = shape->parent->position.x + shape->line.endPosition.x * shape->parent->scale;
-                worldEnd.y = shape->parent->position.y + shape->line.endPosition.y * shape->parent->scale;
+                continue;
             }
-            else
+            for (uint32_t j = a->next; j != SPATIALHASH_NONE; j = hash->nodes[j].next)
             {
-                worldEnd.x = shape->line.endPosition.x;
-                worldEnd.y = shape->line.endPosition.y;
+                SpatialHashNode*  b      = &hash->nodes[j];
+                SpatialHashProxy* bProxy = &hash->proxies[b->proxy];
+                if (b->cellX != a->cellX || b->cellY != a->cellY || !bProxy->collider->isEnabled)
+                {
+                    continue;
+                }
+                int32_t firstX = aProxy->minX > bProxy->minX ? aProxy->minX : bProxy->minX;
+                int32_t firstY = aProxy->minY > bProxy->minY ? aProxy->minY : bProxy->minY;
+                if (firstX != a->cellX || firstY != a->cellY || !SpatialHash_Overlaps(aProxy->bounds, bProxy->bounds))
+                {
+                    continue;
+                }
+                if (callback != NULL)
+                {
+                    callback(aProxy->collider, bProxy->collider, userData);
+                }
+                pairCount++;
             }
-            DrawLineEx(worldPosition, worldEnd, shape->line.thickness * worldScale, shape->color);
-            break;
-        }
-
-        case SHAPE2D_CIRCLE:
-            DrawCircleV(worldPosition, shape->circle.radius * worldScale, shape->color);
-            break;
-
-        case SHAPE2D_CIRCLE_LINES:
-        {
-            float outerRadius = shape->circle.radius * worldScale;
-            float innerRadius = outerRadius - shape->circle.outlineThickness * worldScale;
-            if (innerRadius < 0.0f)
-                innerRadius = 0.0f;
-            DrawRing(worldPosition, innerRadius, outerRadius, 0.0f, 360.0f, 36, shape->color);
-            break;
         }
     }
+    return pairCount;
 }
 
 void Sprite_Initialize(Sprite* spr)
@@ -481,50 +1618,558 @@ void Sprite_Draw(Sprite* spr)
 {
     if (!spr->isVisible || !spr->currentTexture)
     {
-        return;
+        return;
+    }
+    Vector2 position = { spr->position.x, spr->position.y };
+    float   scale    = spr->scale;
+    float   rotation = spr->rotation;
+    if (spr->parent != NULL)
+    {
+        const Transform2D* parentWorld = Entity2D_GetWorld(spr->parent);
+        Vector2Float       world       = Entity2D_TransformPoint(spr->parent, spr->position);
+        position.x                     = world.x;
+        position.y                     = world.y;
+        scale *= parentWorld->scale;
+        rotation += parentWorld->rotation;
+    }
+
+    Rectangle sourceRect;
+
+    sourceRect.x      = spr->currentTexture->uv.x;
+    sourceRect.y      = spr->currentTexture->uv.y;
+    sourceRect.width  = spr->currentTexture->uv.w;
+    sourceRect.height = spr->currentTexture->uv.h;
+
+    Rectangle destRect;
+
+    destRect.x      = position.x;
+    destRect.y      = position.y;
+    destRect.width  = spr->currentTexture->size.x * scale;
+    destRect.height = spr->currentTexture->size.y * scale;
+
+    if (spr->drawPortion)
+    {
+        sourceRect.x += spr->portionRect.x * spr->currentTexture->size.x;
+        sourceRect.y += spr->portionRect.y * spr->currentTexture->size.y;
+        sourceRect.width -= (1.0 - spr->portionRect.width) * spr->currentTexture->size.x;
+        sourceRect.height -= (1.0 - spr->portionRect.height) * spr->currentTexture->size.y;
+
+        destRect.x += spr->portionRect.x * spr->currentTexture->size.x * scale;
+        destRect.y += spr->portionRect.y * spr->currentTexture->size.y * scale;
+        destRect.width -= (1.0 - spr->portionRect.width) * spr->currentTexture->size.x * scale;
+        destRect.height -= (1.0 - spr->portionRect.height) * spr->currentTexture->size.y * scale;
+    }
+    DrawTexturePro(spr->currentTexture->texture, sourceRect, destRect, { 0, 0 }, rotation, spr->tint);
+}
+
+static bool SweepAndPrune_Less(SweepEndpoint a, SweepEndpoint b)
+{
+    if (a.value != b.value)
+    {
+        return a.value < b.value;
+    }
+    // a box always opens before it closes, touching boxes close before the next one opens so they do not overlap
+    if ((a.data >> 1) == (b.data >> 1))
+    {
+        return (a.data & 1) == 0;
+    }
+    return (a.data & 1) != 0 && (b.data & 1) == 0;
+}
+
+static uint32_t SweepAndPrune_PairHash(uint32_t a, uint32_t b)
+{
+    return (a * 0x9E3779B1u) ^ (b * 0x85EBCA6Bu);
+}
+
+static bool SweepAndPrune_RehashPairs(SweepAndPrune* sap)
+{
+    uint32_t capacity = sap->pairCapacity == 0 ? 64 : sap->pairCapacity;
+    while ((sap->pairLive + 1) * 4 > capacity)
+    {
+        capacity *= 2;
+    }
+    SweepPair* pairs = (SweepPair*)calloc(capacity, sizeof(SweepPair));
+    if (pairs == NULL)
+    {
+        LOG_ERR("SweepAndPrune: out of memory for pairs");
+        return false;
+    }
+    for (uint32_t i = 0; i < sap->pairCapacity; i++)
+    {
+        if (sap->pairs[i].state != SWEEP_PAIR_LIVE)
+        {
+            continue;
+        }
+        uint32_t index = SweepAndPrune_PairHash(sap->pairs[i].a, sap->pairs[i].b) & (capacity - 1);
+        while (pairs[index].state != SWEEP_PAIR_EMPTY)
+        {
+            index = (index + 1) & (capacity - 1);
+        }
+        pairs[index] = sap->pairs[i];
+    }
+    free(sap->pairs);
+    sap->pairs        = pairs;
+    sap->pairCapacity = capacity;
+    sap->pairUsed     = sap->pairLive;
+    return true;
+}
+
+static SweepPair* SweepAndPrune_FindPair(SweepAndPrune* sap, uint32_t a, uint32_t b, bool create)
+{
+    if (a > b)
+    {
+        uint32_t swap = a;
+        a             = b;
+        b             = swap;
+    }
+    if (create && (sap->pairUsed + 1) * 2 > sap->pairCapacity && !SweepAndPrune_RehashPairs(sap))
+    {
+        return NULL;
+    }
+    if (sap->pairCapacity == 0)
+    {
+        return NULL;
+    }
+    uint32_t   mask    = sap->pairCapacity - 1;
+    uint32_t   index   = SweepAndPrune_PairHash(a, b) & mask;
+    SweepPair* deleted = NULL;
+    while (true)
+    {
+        SweepPair* pair = &sap->pairs[index];
+        if (pair->state == SWEEP_PAIR_EMPTY)
+        {
+            if (!create)
+            {
+                return NULL;
+            }
+            if (deleted != NULL)
+            {
+                pair = deleted;
+            }
+            else
+            {
+                sap->pairUsed++;
+            }
+            pair->a              = a;
+            pair->b              = b;
+            pair->state          = SWEEP_PAIR_LIVE;
+            pair->isOverlapping  = false;
+            pair->wasOverlapping = false;
+            sap->pairLive++;
+            return pair;
+        }
+        if (pair->state == SWEEP_PAIR_DELETED)
+        {
+            if (deleted == NULL)
+            {
+                deleted = pair;
+            }
+        }
+        else if (pair->a == a && pair->b == b)
+        {
+            return pair;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Swaps two neighbouring endpoints; a max moving past a min may start an overlap, a min moving past a max ends one.
+static void SweepAndPrune_Swap(SweepAndPrune* sap, uint32_t axis, uint32_t lower)
+{
+    SweepEndpoint* list        = sap->endpoints[axis];
+    SweepEndpoint  first       = list[lower];
+    SweepEndpoint  second      = list[lower + 1];
+    uint32_t       firstProxy  = first.data >> 1;
+    uint32_t       secondProxy = second.data >> 1;
+    if (firstProxy != secondProxy)
+    {
+        if ((first.data & 1) != 0 && (second.data & 1) == 0)
+        {
+            if (SpatialHash_Overlaps(sap->proxies[firstProxy].bounds, sap->proxies[secondProxy].bounds))
+            {
+                SweepPair* pair = SweepAndPrune_FindPair(sap, firstProxy, secondProxy, true);
+                if (pair != NULL)
+                {
+                    pair->isOverlapping = true;
+                }
+            }
+        }
+        else if ((first.data & 1) == 0 && (second.data & 1) != 0)
+        {
+            SweepPair* pair = SweepAndPrune_FindPair(sap, firstProxy, secondProxy, false);
+            if (pair != NULL)
+            {
+                pair->isOverlapping = false;
+            }
+        }
+    }
+    list[lower]                                                 = second;
+    list[lower + 1]                                             = first;
+    sap->proxies[secondProxy].endpoints[axis][second.data & 1] = lower;
+    sap->proxies[firstProxy].endpoints[axis][first.data & 1]   = lower + 1;
+}
+
+static void SweepAndPrune_SortDown(SweepAndPrune* sap, uint32_t axis, uint32_t index)
+{
+    while (index > 0 && SweepAndPrune_Less(sap->endpoints[axis][index], sap->endpoints[axis][index - 1]))
+    {
+        SweepAndPrune_Swap(sap, axis, index - 1);
+        index--;
+    }
+}
+
+static void SweepAndPrune_SortUp(SweepAndPrune* sap, uint32_t axis, uint32_t index)
+{
+    while (index + 1 < sap->endpointCount
+           && SweepAndPrune_Less(sap->endpoints[axis][index + 1], sap->endpoints[axis][index]))
+    {
+        SweepAndPrune_Swap(sap, axis, index);
+        index++;
+    }
+}
+
+static void SweepAndPrune_MoveEndpoint(SweepAndPrune* sap, uint32_t axis, uint32_t proxyIndex, uint32_t side,
+                                       float value)
+{
+    uint32_t index                    = sap->proxies[proxyIndex].endpoints[axis][side];
+    float    previous                 = sap->endpoints[axis][index].value;
+    sap->endpoints[axis][index].value = value;
+    if (value < previous)
+    {
+        SweepAndPrune_SortDown(sap, axis, index);
+    }
+    else if (value > previous)
+    {
+        SweepAndPrune_SortUp(sap, axis, index);
+    }
+}
+
+// Moves the endpoints to the proxy's current bounds, the leading side first so min never has to pass its own max.
+static void SweepAndPrune_MoveProxy(SweepAndPrune* sap, uint32_t proxyIndex)
+{
+    Rectangle bounds  = sap->proxies[proxyIndex].bounds;
+    float     mins[2] = { bounds.x, bounds.y };
+    float     maxs[2] = { bounds.x + bounds.width, bounds.y + bounds.height };
+    for (uint32_t axis = 0; axis < 2; axis++)
+    {
+        uint32_t maxIndex = sap->proxies[proxyIndex].endpoints[axis][1];
+        if (maxs[axis] > sap->endpoints[axis][maxIndex].value)
+        {
+            SweepAndPrune_MoveEndpoint(sap, axis, proxyIndex, 1, maxs[axis]);
+            SweepAndPrune_MoveEndpoint(sap, axis, proxyIndex, 0, mins[axis]);
+        }
+        else
+        {
+            SweepAndPrune_MoveEndpoint(sap, axis, proxyIndex, 0, mins[axis]);
+            SweepAndPrune_MoveEndpoint(sap, axis, proxyIndex, 1, maxs[axis]);
+        }
+    }
+}
+
+static void SweepAndPrune_PushEvent(SweepAndPrune* sap, CollisionEventType type, SweepPair* pair)
+{
+    if (sap->eventCount == sap->eventCapacity)
+    {
+        uint32_t        capacity = sap->eventCapacity == 0 ? 64 : sap->eventCapacity * 2;
+        CollisionEvent* grown    = (CollisionEvent*)realloc(sap->events, capacity * sizeof(CollisionEvent));
+        if (grown == NULL)
+        {
+            LOG_ERR("SweepAndPrune: out of memory for events");
+            return;
+        }
+        sap->events        = grown;
+        sap->eventCapacity = capacity;
+    }
+    CollisionEvent* event = &sap->events[sap->eventCount++];
+    event->type           = type;
+    event->a              = sap->proxies[pair->a].collider;
+    event->b              = sap->proxies[pair->b].collider;
+    event->isTrigger      = event->a->isTrigger || event->b->isTrigger;
+}
+
+bool SweepAndPrune_Initialize(SweepAndPrune* sap)
+{
+    memset(sap, 0, sizeof(SweepAndPrune));
+    sap->freeProxy = SWEEPANDPRUNE_NONE;
+    return true;
+}
+
+void SweepAndPrune_Deinitialize(SweepAndPrune* sap)
+{
+    free(sap->proxies);
+    free(sap->endpoints[0]);
+    free(sap->endpoints[1]);
+    free(sap->pairs);
+    free(sap->events);
+    SweepAndPrune_Initialize(sap);
+}
+
+uint32_t SweepAndPrune_Insert(SweepAndPrune* sap, Collider2D* col)
+{
+    if (col == NULL)
+    {
+        LOG_ERR("SweepAndPrune: Insert() failed, collider is nullptr");
+        return SWEEPANDPRUNE_NONE;
+    }
+    uint32_t proxyIndex;
+    if (sap->freeProxy != SWEEPANDPRUNE_NONE)
+    {
+        proxyIndex     = sap->freeProxy;
+        sap->freeProxy = sap->proxies[proxyIndex].endpoints[0][0];
+    }
+    else
+    {
+        if (sap->proxyCount == sap->proxyCapacity)
+        {
+            uint32_t       capacity = sap->proxyCapacity == 0 ? 64 : sap->proxyCapacity * 2;
+            SweepProxy*    proxies  = (SweepProxy*)realloc(sap->proxies, capacity * sizeof(SweepProxy));
+            SweepEndpoint* x = (SweepEndpoint*)realloc(sap->endpoints[0], capacity * 2 * sizeof(SweepEndpoint));
+            SweepEndpoint* y = (SweepEndpoint*)realloc(sap->endpoints[1], capacity * 2 * sizeof(SweepEndpoint));
+            if (proxies != NULL)
+            {
+                sap->proxies = proxies;
+            }
+            if (x != NULL)
+            {
+                sap->endpoints[0] = x;
+            }
+            if (y != NULL)
+            {
+                sap->endpoints[1] = y;
+            }
+            if (proxies == NULL || x == NULL || y == NULL)
+            {
+                LOG_ERR("SweepAndPrune: Insert() failed, out of memory");
+                return SWEEPANDPRUNE_NONE;
+            }
+            sap->proxyCapacity = capacity;
+        }
+        proxyIndex = sap->proxyCount++;
+    }
+    SweepProxy* proxy = &sap->proxies[proxyIndex];
+    proxy->collider   = col;
+    proxy->bounds     = Collider2D_GetBounds(col);
+    proxy->isUsed     = true;
+    proxy->isRemoved  = false;
+    float mins[2]     = { proxy->bounds.x, proxy->bounds.y };
+    float maxs[2]     = { proxy->bounds.x + proxy->bounds.width, proxy->bounds.y + proxy->bounds.height };
+    for (uint32_t axis = 0; axis < 2; axis++)
+    {
+        // appended one at a time, each endpoint only has to be sorted down past the existing ones
+        uint32_t count                  = sap->endpointCount;
+        sap->endpoints[axis][count]     = (SweepEndpoint){ mins[axis], proxyIndex << 1 };
+        proxy->endpoints[axis][0]       = count;
+        SweepAndPrune_SortDown(sap, axis, count);
+        sap->endpoints[axis][count + 1] = (SweepEndpoint){ maxs[axis], (proxyIndex << 1) | 1 };
+        proxy->endpoints[axis][1]       = count + 1;
+        SweepAndPrune_SortDown(sap, axis, count + 1);
+    }
+    sap->endpointCount += 2;
+    return proxyIndex;
+}
+
+// The collider has to stay valid until the next BuildEvents, which reports the END events of its pairs.
+void SweepAndPrune_Remove(SweepAndPrune* sap, uint32_t proxyIndex)
+{
+    if (proxyIndex >= sap->proxyCount || !sap->proxies[proxyIndex].isUsed || sap->proxies[proxyIndex].isRemoved)
+    {
+        LOG_WRN("SweepAndPrune: Remove() failed, invalid proxy %u", proxyIndex);
+        return;
+    }
+    // pushing the bounds past everything ends all of its overlaps and leaves its endpoints at the end of the lists
+    sap->proxies[proxyIndex].bounds = (Rectangle){ FLT_MAX, FLT_MAX, 0.0f, 0.0f };
+    SweepAndPrune_MoveProxy(sap, proxyIndex);
+    sap->endpointCount -= 2;
+    sap->proxies[proxyIndex].isRemoved = true;
+}
+
+void SweepAndPrune_UpdateProxy(SweepAndPrune* sap, uint32_t proxyIndex)
+{
+    if (proxyIndex >= sap->proxyCount || !sap->proxies[proxyIndex].isUsed || sap->proxies[proxyIndex].isRemoved)
+    {
+        LOG_WRN("SweepAndPrune: UpdateProxy() failed, invalid proxy %u", proxyIndex);
+        return;
+    }
+    sap->proxies[proxyIndex].bounds = Collider2D_GetBounds(sap->proxies[proxyIndex].collider);
+    SweepAndPrune_MoveProxy(sap, proxyIndex);
+}
+
+void SweepAndPrune_UpdateAll(SweepAndPrune* sap)
+{
+    for (uint32_t i = 0; i < sap->proxyCount; i++)
+    {
+        if (sap->proxies[i].isUsed && !sap->proxies[i].isRemoved)
+        {
+            SweepAndPrune_UpdateProxy(sap, i);
+        }
+    }
+}
+
+// Turns the pair set into BEGIN/STAY/END events in sap->events, disabled colliders count as not overlapping.
+uint32_t SweepAndPrune_BuildEvents(SweepAndPrune* sap)
+{
+    sap->eventCount   = 0;
+    sap->overlapCount = 0;
+    for (uint32_t i = 0; i < sap->pairCapacity; i++)
+    {
+        SweepPair* pair = &sap->pairs[i];
+        if (pair->state != SWEEP_PAIR_LIVE)
+        {
+            continue;
+        }
+        SweepProxy* a           = &sap->proxies[pair->a];
+        SweepProxy* b           = &sap->proxies[pair->b];
+        bool        overlapping = pair->isOverlapping && !a->isRemoved && !b->isRemoved && a->collider->isEnabled
+                           && b->collider->isEnabled;
+        if (overlapping)
+        {
+            SweepAndPrune_PushEvent(sap, pair->wasOverlapping ? COLLISION_EVENT_STAY : COLLISION_EVENT_BEGIN, pair);
+            sap->overlapCount++;
+        }
+        else if (pair->wasOverlapping)
+        {
+            SweepAndPrune_PushEvent(sap, COLLISION_EVENT_END, pair);
+        }
+        pair->wasOverlapping = overlapping;
+        if (!pair->isOverlapping)
+        {
+            pair->state = SWEEP_PAIR_DELETED;
+            sap->pairLive--;
+        }
+    }
+    for (uint32_t i = 0; i < sap->proxyCount; i++)
+    {
+        SweepProxy* proxy = &sap->proxies[i];
+        if (proxy->isRemoved)
+        {
+            proxy->isUsed          = false;
+            proxy->isRemoved       = false;
+            proxy->collider        = NULL;
+            proxy->endpoints[0][0] = sap->freeProxy;
+            sap->freeProxy         = i;
+        }
+    }
+    return sap->eventCount;
+}
+
+uint32_t SweepAndPrune_GetPairCount(SweepAndPrune* sap)
+{
+    return sap->overlapCount;
+}
+
+// Area covered by box over the whole motion, for broadphase queries ahead of a sweep.
+Rectangle Sweep_GetBounds(Rectangle box, Vector2Float delta)
+{
+    return (Rectangle){ delta.x < 0.0f ? box.x + delta.x : box.x, delta.y < 0.0f ? box.y + delta.y : box.y,
+                        box.width + fabsf(delta.x), box.height + fabsf(delta.y) };
+}
+
+// Time of impact of box moving by delta against a static target, using the entry and exit times of both axes.
+// Boxes that already overlap deeper than SWEEP_SKIN are not reported, they are left to overlap resolution.
+bool Sweep_Rect(Rectangle box, Vector2Float delta, Rectangle target, SweepHit* hit)
+{
+    float boxMin[2]    = { box.x, box.y };
+    float boxMax[2]    = { box.x + box.width, box.y + box.height };
+    float targetMin[2] = { target.x, target.y };
+    float targetMax[2] = { target.x + target.width, target.y + target.height };
+    float move[2]      = { delta.x, delta.y };
+    float entry[2];
+    float exit[2];
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (move[axis] == 0.0f)
+        {
+            // a still axis has to overlap for the whole motion, touching edges let the box slide past
+            if (boxMin[axis] >= targetMax[axis] - SWEEP_SKIN || boxMax[axis] <= targetMin[axis] + SWEEP_SKIN)
+            {
+                return false;
+            }
+            entry[axis] = -FLT_MAX;
+            exit[axis]  = FLT_MAX;
+            continue;
+        }
+        float gapEntry = move[axis] > 0.0f ? targetMin[axis] - boxMax[axis] : boxMin[axis] - targetMax[axis];
+        float gapExit  = move[axis] > 0.0f ? targetMax[axis] - boxMin[axis] : boxMax[axis] - targetMin[axis];
+        if (gapEntry < 0.0f && gapEntry > -SWEEP_SKIN)
+        {
+            gapEntry = 0.0f;
+        }
+        entry[axis] = gapEntry / fabsf(move[axis]);
+        exit[axis]  = gapExit / fabsf(move[axis]);
+    }
+    float entryTime = Utils_MaxFloat(entry[0], entry[1]);
+    float exitTime  = Utils_MinFloat(exit[0], exit[1]);
+    if (entryTime < 0.0f || entryTime > 1.0f || entryTime >= exitTime)
+    {
+        return false;
     }
-    Vector2 position = { 0.0f, 0.0f };
-    float   scale    = 1.0f;
-    float   rotation = 0.0f;
-    if (spr->parent != NULL)
+    hit->time     = entryTime;
+    hit->normal   = (Vector2Float){ 0.0f, 0.0f };
+    hit->userData = NULL;
+    if (entry[0] > entry[1])  // exact corner hits land on the floor rather than the wall
     {
-        position.x = spr->parent->position.x;
-        position.y = spr->parent->position.y;
-        scale      = spr->parent->scale;
-        rotation   = spr->parent->rotation;
+        hit->normal.x = move[0] > 0.0f ? -1.0f : 1.0f;
     }
-    position.x += spr->position.x * scale;
-    position.y += spr->position.y * scale;
-    scale *= spr->scale;
-    rotation += spr->rotation;
-
-    Rectangle sourceRect;
-
-    sourceRect.x      = spr->currentTexture->uv.x;
-    sourceRect.y      = spr->currentTexture->uv.y;
-    sourceRect.width  = spr->currentTexture->uv.w;
-    sourceRect.height = spr->currentTexture->uv.h;
-
-    Rectangle destRect;
-
-    destRect.x      = position.x;
-    destRect.y      = position.y;
-    destRect.width  = spr->currentTexture->size.x * scale;
-    destRect.height = spr->currentTexture->size.y * scale;
+    else
+    {
+        hit->normal.y = move[1] > 0.0f ? -1.0f : 1.0f;
+    }
+    return true;
+}
 
-    if (spr->drawPortion)
+// Earliest hit against a grid of square cells, isSolid is asked about every cell the motion passes over.
+bool Sweep_Grid(Rectangle box, Vector2Float delta, float cellSize,
+                bool (*isSolid)(int32_t cellX, int32_t cellY, void* context), void* context, SweepHit* hit)
+{
+    Rectangle swept = Sweep_GetBounds(box, delta);
+    int32_t   minX  = (int32_t)floorf(swept.x / cellSize);
+    int32_t   minY  = (int32_t)floorf(swept.y / cellSize);
+    int32_t   maxX  = (int32_t)floorf((swept.x + swept.width) / cellSize);
+    int32_t   maxY  = (int32_t)floorf((swept.y + swept.height) / cellSize);
+    bool      found = false;
+    for (int32_t y = minY; y <= maxY; y++)
     {
-        sourceRect.x += spr->portionRect.x * spr->currentTexture->size.x;
-        sourceRect.y += spr->portionRect.y * spr->currentTexture->size.y;
-        sourceRect.width -= (1.0 - spr->portionRect.width) * spr->currentTexture->size.x;
-        sourceRect.height -= (1.0 - spr->portionRect.height) * spr->currentTexture->size.y;
+        for (int32_t x = minX; x <= maxX; x++)
+        {
+            SweepHit  cellHit;
+            Rectangle cell = { x * cellSize, y * cellSize, cellSize, cellSize };
+            if (isSolid(x, y, context) && Sweep_Rect(box, delta, cell, &cellHit) && (!found || cellHit.time < hit->time))
+            {
+                *hit  = cellHit;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
 
-        destRect.x += spr->portionRect.x * spr->currentTexture->size.x * scale;
-        destRect.y += spr->portionRect.y * spr->currentTexture->size.y * scale;
-        destRect.width -= (1.0 - spr->portionRect.width) * spr->currentTexture->size.x * scale;
-        destRect.height -= (1.0 - spr->portionRect.height) * spr->currentTexture->size.y * scale;
+// Moves box by delta, stopping at each hit and sliding the rest of the motion along the surface. Returns the number
+// of hits written to hits, at most maxHits.
+uint32_t Sweep_MoveAndSlide(Rectangle* box, Vector2Float delta,
+                            bool (*cast)(Rectangle box, Vector2Float delta, SweepHit* hit, void* context),
+                            void* context, SweepHit* hits, uint32_t maxHits)
+{
+    uint32_t hitCount = 0;
+    for (uint32_t i = 0; i < SWEEP_MAX_ITERATIONS && (delta.x != 0.0f || delta.y != 0.0f); i++)
+    {
+        SweepHit hit;
+        if (!cast(*box, delta, &hit, context))
+        {
+            box->x += delta.x;
+            box->y += delta.y;
+            break;
+        }
+        box->x += delta.x * hit.time;
+        box->y += delta.y * hit.time;
+        // what is left of the motion keeps going, minus the part that pushes into the surface
+        delta.x = hit.normal.x != 0.0f ? 0.0f : delta.x * (1.0f - hit.time);
+        delta.y = hit.normal.y != 0.0f ? 0.0f : delta.y * (1.0f - hit.time);
+        if (hitCount < maxHits)
+        {
+            hits[hitCount++] = hit;
+        }
     }
-    DrawTexturePro(spr->currentTexture->texture, sourceRect, destRect, { 0, 0 }, rotation, spr->tint);
+    return hitCount;
 }
 
 TextureData Texture_LoadTexture(const char* fileName)
@@ -542,6 +2187,43 @@ TextureData Texture_LoadTexture(const char* fileName)
     return textureData;
 }
 
+Image Texture_LoadImage(const char* fileName)
+{
+    if (fileName == NULL)
+    {
+        LOG_ERR("Texture: LoadImage() failed, fileName is nullptr");
+        return (Image){ 0 };
+    }
+    return LoadImage(fileName);
+}
+
+TextureData Texture_LoadTextureFromImage(Image* image)
+{
+    if (image == NULL || image->data == NULL)
+    {
+        LOG_ERR("Texture: LoadTextureFromImage() failed, image is empty");
+        return (TextureData){ 0 };
+    }
+    Texture2D   texture = LoadTextureFromImage(*image);
+    TextureData textureData;
+    textureData.texture = texture;
+    textureData.uv      = { 0.0f, 0.0f, (float)textureData.texture.width, (float)textureData.texture.height };
+    textureData.size    = { (uint32_t)texture.width, (uint32_t)texture.height };
+    UnloadImage(*image);
+    image->data = NULL;
+    return textureData;
+}
+
+void Texture_UnloadImage(Image* image)
+{
+    if (image == NULL || image->data == NULL)
+    {
+        return;
+    }
+    UnloadImage(*image);
+    image->data = NULL;
+}
+
 bool Texture_CreateTextureAtlas(TextureData texture, uint32_t columns, uint32_t rows, TextureData* output)
 {
     if (output == NULL)
@@ -581,6 +2263,417 @@ void Texture_UnloadTexture(TextureData* textureData)
     UnloadTexture(textureData->texture);
 }
 
+bool TileCollider_Initialize(TileCollider* tiles, float cellSize,
+                             uint8_t (*getCell)(int32_t cellX, int32_t cellY, void* context), void* context)
+{
+    memset(tiles, 0, sizeof(TileCollider));
+    if (cellSize <= 0.0f || getCell == NULL)
+    {
+        LOG_ERR("TileCollider: Initialize() failed, needs a positive cell size and a cell callback");
+        return false;
+    }
+    tiles->getCell  = getCell;
+    tiles->context  = context;
+    tiles->cellSize = cellSize;
+    return true;
+}
+
+void TileCollider_Deinitialize(TileCollider* tiles)
+{
+    memset(tiles, 0, sizeof(TileCollider));
+}
+
+uint8_t TileCollider_GetCell(TileCollider* tiles, int32_t cellX, int32_t cellY)
+{
+    if (tiles->getCell == NULL)
+    {
+        return TILECOLLIDER_EMPTY;
+    }
+    return tiles->getCell(cellX, cellY, tiles->context);
+}
+
+// Cell range covered by [min, max] on both axes. Cells that only touch rect are left out unless includeTouching is
+// set, which sweeps need to find surfaces a box is resting against.
+static bool TileCollider_GetRange(TileCollider* tiles, Rectangle rect, bool includeTouching, int32_t* minX,
+                                  int32_t* minY, int32_t* maxX, int32_t* maxY)
+{
+    if (tiles->getCell == NULL)
+    {
+        return false;
+    }
+    float inverseSize = 1.0f / tiles->cellSize;
+    *minX             = (int32_t)floorf(rect.x * inverseSize);
+    *minY             = (int32_t)floorf(rect.y * inverseSize);
+    if (includeTouching)
+    {
+        *maxX = (int32_t)floorf((rect.x + rect.width) * inverseSize);
+        *maxY = (int32_t)floorf((rect.y + rect.height) * inverseSize);
+    }
+    else
+    {
+        *maxX = (int32_t)ceilf((rect.x + rect.width) * inverseSize) - 1;
+        *maxY = (int32_t)ceilf((rect.y + rect.height) * inverseSize) - 1;
+    }
+    return *minX <= *maxX && *minY <= *maxY;
+}
+
+static Rectangle TileCollider_GetCellBounds(TileCollider* tiles, int32_t x, int32_t y)
+{
+    return (Rectangle){ x * tiles->cellSize, y * tiles->cellSize, tiles->cellSize, tiles->cellSize };
+}
+
+// Writes the bounds of every cell overlapping rect that has any of flags set, returns how many were written.
+uint32_t TileCollider_QueryRect(TileCollider* tiles, Rectangle rect, uint8_t flags, Rectangle* output,
+                                uint32_t outputSize)
+{
+    int32_t  minX, minY, maxX, maxY;
+    uint32_t count = 0;
+    if (!TileCollider_GetRange(tiles, rect, false, &minX, &minY, &maxX, &maxY))
+    {
+        return 0;
+    }
+    for (int32_t y = minY; y <= maxY; y++)
+    {
+        for (int32_t x = minX; x <= maxX && count < outputSize; x++)
+        {
+            if (TileCollider_GetCell(tiles, x, y) & flags)
+            {
+                output[count++] = TileCollider_GetCellBounds(tiles, x, y);
+            }
+        }
+    }
+    return count;
+}
+
+// Earliest hit of box moving by delta. One-way cells only count when the box lands on their top face, so a box can
+// jump up through them and walk off their sides.
+bool TileCollider_Sweep(TileCollider* tiles, Rectangle box, Vector2Float delta, SweepHit* hit)
+{
+    int32_t minX, minY, maxX, maxY;
+    bool    found = false;
+    if (!TileCollider_GetRange(tiles, Sweep_GetBounds(box, delta), true, &minX, &minY, &maxX, &maxY))
+    {
+        return false;
+    }
+    for (int32_t y = minY; y <= maxY; y++)
+    {
+        for (int32_t x = minX; x <= maxX; x++)
+        {
+            uint8_t  flags = TileCollider_GetCell(tiles, x, y);
+            SweepHit cellHit;
+            if (flags == TILECOLLIDER_EMPTY
+                || !Sweep_Rect(box, delta, TileCollider_GetCellBounds(tiles, x, y), &cellHit))
+            {
+                continue;
+            }
+            if (!(flags & TILECOLLIDER_SOLID) && cellHit.normal.y >= 0.0f)
+            {
+                continue;
+            }
+            if (!found || cellHit.time < hit->time)
+            {
+                *hit  = cellHit;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+// Outlines the cells inside area that have any of flags set, one-way cells by their top edge only.
+void TileCollider_DrawDebug(TileCollider* tiles, Rectangle area, uint8_t flags)
+{
+    int32_t minX, minY, maxX, maxY;
+    if (!TileCollider_GetRange(tiles, area, false, &minX, &minY, &maxX, &maxY))
+    {
+        return;
+    }
+    for (int32_t y = minY; y <= maxY; y++)
+    {
+        for (int32_t x = minX; x <= maxX; x++)
+        {
+            uint8_t   cell   = TileCollider_GetCell(tiles, x, y) & flags;
+            Rectangle bounds = TileCollider_GetCellBounds(tiles, x, y);
+            if (cell & TILECOLLIDER_SOLID)
+            {
+                DrawRectangleLines(bounds.x, bounds.y, bounds.width, bounds.height, YELLOW);
+            }
+            else if (cell & TILECOLLIDER_ONE_WAY)
+            {
+                DrawLine(bounds.x, bounds.y, bounds.x + bounds.width, bounds.y, ORANGE);
+            }
+        }
+    }
+}
+
+// Chunk holding a cell, rounding down for negative cells too.
+static int32_t TileRects_GetChunkCoord(int32_t cell)
+{
+    return cell >= 0 ? cell / TILERECTS_CHUNK_SIZE : (cell + 1) / TILERECTS_CHUNK_SIZE - 1;
+}
+
+static uint32_t TileRects_Hash(int32_t chunkX, int32_t chunkY)
+{
+    return ((uint32_t)chunkX * 73856093u) ^ ((uint32_t)chunkY * 19349663u);
+}
+
+static uint32_t TileRects_FindChunk(TileRects* rects, int32_t chunkX, int32_t chunkY)
+{
+    if (rects->buckets == NULL)
+    {
+        return TILERECTS_NONE;
+    }
+    for (uint32_t bucket = TileRects_Hash(chunkX, chunkY) & rects->bucketMask;;
+         bucket = (bucket + 1) & rects->bucketMask)
+    {
+        uint32_t index = rects->buckets[bucket];
+        if (index == TILERECTS_NONE || (rects->chunks[index].chunkX == chunkX && rects->chunks[index].chunkY == chunkY))
+        {
+            return index;
+        }
+    }
+}
+
+// Rebuilds the buckets at twice the size, load factor stays at or below one half.
+static bool TileRects_GrowBuckets(TileRects* rects)
+{
+    uint32_t  bucketCount = rects->buckets == NULL ? 64 : (rects->bucketMask + 1) * 2;
+    uint32_t* buckets     = (uint32_t*)malloc(bucketCount * sizeof(uint32_t));
+    if (buckets == NULL)
+    {
+        return false;
+    }
+    memset(buckets, 0xFF, bucketCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < rects->chunkCount; i++)
+    {
+        uint32_t bucket = TileRects_Hash(rects->chunks[i].chunkX, rects->chunks[i].chunkY) & (bucketCount - 1);
+        while (buckets[bucket] != TILERECTS_NONE)
+        {
+            bucket = (bucket + 1) & (bucketCount - 1);
+        }
+        buckets[bucket] = i;
+    }
+    free(rects->buckets);
+    rects->buckets    = buckets;
+    rects->bucketMask = bucketCount - 1;
+    return true;
+}
+
+static uint32_t TileRects_CreateChunk(TileRects* rects, int32_t chunkX, int32_t chunkY)
+{
+    if ((rects->chunkCount + 1) * 2 > rects->bucketMask + 1 && !TileRects_GrowBuckets(rects))
+    {
+        return TILERECTS_NONE;
+    }
+    if (rects->chunkCount == rects->chunkCapacity)
+    {
+        uint32_t       capacity = rects->chunkCapacity == 0 ? 16 : rects->chunkCapacity * 2;
+        TileRectChunk* grown    = (TileRectChunk*)realloc(rects->chunks, capacity * sizeof(TileRectChunk));
+        if (grown == NULL)
+        {
+            return TILERECTS_NONE;
+        }
+        rects->chunks        = grown;
+        rects->chunkCapacity = capacity;
+    }
+    uint32_t       index = rects->chunkCount++;
+    TileRectChunk* chunk = &rects->chunks[index];
+    memset(chunk, 0, sizeof(TileRectChunk));
+    chunk->chunkX   = chunkX;
+    chunk->chunkY   = chunkY;
+    uint32_t bucket = TileRects_Hash(chunkX, chunkY) & rects->bucketMask;
+    while (rects->buckets[bucket] != TILERECTS_NONE)
+    {
+        bucket = (bucket + 1) & rects->bucketMask;
+    }
+    rects->buckets[bucket] = index;
+    return index;
+}
+
+bool TileRects_Initialize(TileRects* rects, TileCollider* tiles, uint8_t flags)
+{
+    memset(rects, 0, sizeof(TileRects));
+    if (!TileRects_GrowBuckets(rects))
+    {
+        LOG_ERR("TileRects: Initialize() failed, out of memory");
+        return false;
+    }
+    rects->tiles = tiles;
+    rects->flags = flags;
+    return true;
+}
+
+void TileRects_Deinitialize(TileRects* rects)
+{
+    for (uint32_t i = 0; i < rects->chunkCount; i++)
+    {
+        free(rects->chunks[i].rects);
+    }
+    free(rects->chunks);
+    free(rects->buckets);
+    memset(rects, 0, sizeof(TileRects));
+}
+
+// Call after changing a cell, only its chunk gets merged again on the next TileRects_Update. Chunks are created the
+// first time one of their cells is marked, so the merged area follows the map however far it spreads.
+void TileRects_MarkDirty(TileRects* rects, int32_t cellX, int32_t cellY)
+{
+    if (rects->buckets == NULL)
+    {
+        return;
+    }
+    int32_t  chunkX = TileRects_GetChunkCoord(cellX);
+    int32_t  chunkY = TileRects_GetChunkCoord(cellY);
+    uint32_t index  = TileRects_FindChunk(rects, chunkX, chunkY);
+    if (index == TILERECTS_NONE)
+    {
+        index = TileRects_CreateChunk(rects, chunkX, chunkY);
+    }
+    if (index == TILERECTS_NONE)
+    {
+        LOG_ERR("TileRects: out of memory for chunk %d, %d", chunkX, chunkY);
+        return;
+    }
+    if (!rects->chunks[index].isDirty)
+    {
+        rects->chunks[index].isDirty = true;
+        rects->dirtyCount++;
+    }
+}
+
+static bool TileRects_Push(TileRectChunk* chunk, Rectangle rect)
+{
+    if (chunk->count == chunk->capacity)
+    {
+        uint32_t   capacity = chunk->capacity == 0 ? 8 : chunk->capacity * 2;
+        Rectangle* grown    = (Rectangle*)realloc(chunk->rects, capacity * sizeof(Rectangle));
+        if (grown == NULL)
+        {
+            LOG_ERR("TileRects: out of memory for merged rects");
+            return false;
+        }
+        chunk->rects    = grown;
+        chunk->capacity = capacity;
+    }
+    chunk->rects[chunk->count++] = rect;
+    return true;
+}
+
+// Greedy meshing inside one chunk: each unused flagged cell grows right as far as it can, then down while the whole
+// row below is flagged and unused. Rects never cross chunk borders so a change only touches its own chunk.
+static void TileRects_MergeChunk(TileRects* rects, TileRectChunk* chunk)
+{
+    TileCollider* tiles  = rects->tiles;
+    int32_t       startX = chunk->chunkX * TILERECTS_CHUNK_SIZE;
+    int32_t       startY = chunk->chunkY * TILERECTS_CHUNK_SIZE;
+    bool          cells[TILERECTS_CHUNK_SIZE][TILERECTS_CHUNK_SIZE];
+    uint32_t      used[TILERECTS_CHUNK_SIZE];  // one bit per cell of each chunk row
+    rects->rectCount -= chunk->count;
+    chunk->count      = 0;
+    memset(used, 0, sizeof(used));
+    // each cell goes through the callback once, the merge below reads it several times
+    for (uint32_t y = 0; y < TILERECTS_CHUNK_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < TILERECTS_CHUNK_SIZE; x++)
+        {
+            cells[y][x] = (TileCollider_GetCell(tiles, startX + x, startY + y) & rects->flags) != 0;
+        }
+    }
+    for (uint32_t y = 0; y < TILERECTS_CHUNK_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < TILERECTS_CHUNK_SIZE; x++)
+        {
+            if ((used[y] >> x) & 1 || !cells[y][x])
+            {
+                continue;
+            }
+            uint32_t runWidth = 1;
+            while (x + runWidth < TILERECTS_CHUNK_SIZE && !((used[y] >> (x + runWidth)) & 1) && cells[y][x + runWidth])
+            {
+                runWidth++;
+            }
+            uint32_t runMask   = (uint32_t)(((uint64_t)1 << runWidth) - 1) << x;
+            uint32_t runHeight = 1;
+            while (y + runHeight < TILERECTS_CHUNK_SIZE && !(used[y + runHeight] & runMask))
+            {
+                uint32_t i = 0;
+                while (i < runWidth && cells[y + runHeight][x + i])
+                {
+                    i++;
+                }
+                if (i < runWidth)
+                {
+                    break;
+                }
+                runHeight++;
+            }
+            for (uint32_t i = 0; i < runHeight; i++)
+            {
+                used[y + i] |= runMask;
+            }
+            Rectangle rect = TileCollider_GetCellBounds(tiles, startX + x, startY + y);
+            rect.width     = runWidth * tiles->cellSize;
+            rect.height    = runHeight * tiles->cellSize;
+            if (!TileRects_Push(chunk, rect))
+            {
+                return;
+            }
+            x += runWidth - 1;
+        }
+    }
+}
+
+// Merges every dirty chunk again, returns how many were rebuilt. Costs nothing while no chunk is dirty.
+uint32_t TileRects_Update(TileRects* rects)
+{
+    if (rects->dirtyCount == 0)
+    {
+        return 0;
+    }
+    double   start   = GetTime();
+    uint32_t rebuilt = 0;
+    for (uint32_t i = 0; i < rects->chunkCount && rebuilt < rects->dirtyCount; i++)
+    {
+        TileRectChunk* chunk = &rects->chunks[i];
+        if (chunk->isDirty)
+        {
+            TileRects_MergeChunk(rects, chunk);
+            rects->rectCount += chunk->count;
+            chunk->isDirty    = false;
+            rebuilt++;
+        }
+    }
+    rects->dirtyCount    = 0;
+    rects->lastMergeTime = GetTime() - start;
+    return rebuilt;
+}
+
+void TileRects_DrawDebug(TileRects* rects, Rectangle area)
+{
+    int32_t minX, minY, maxX, maxY;
+    if (rects->buckets == NULL || !TileCollider_GetRange(rects->tiles, area, false, &minX, &minY, &maxX, &maxY))
+    {
+        return;
+    }
+    for (int32_t chunkY = TileRects_GetChunkCoord(minY); chunkY <= TileRects_GetChunkCoord(maxY); chunkY++)
+    {
+        for (int32_t chunkX = TileRects_GetChunkCoord(minX); chunkX <= TileRects_GetChunkCoord(maxX); chunkX++)
+        {
+            uint32_t index = TileRects_FindChunk(rects, chunkX, chunkY);
+            if (index == TILERECTS_NONE)
+            {
+                continue;
+            }
+            TileRectChunk* chunk = &rects->chunks[index];
+            for (uint32_t i = 0; i < chunk->count; i++)
+            {
+                Rectangle rect = chunk->rects[i];
+                DrawRectangleLines(rect.x, rect.y, rect.width, rect.height, YELLOW);
+            }
+        }
+    }
+}
+
 void Drawable_Draw(Drawable* drawable)
 {
     if (drawable->type == DRAWABLE_SPRITE)
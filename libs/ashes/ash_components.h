@@ -11,13 +11,63 @@
 #define ANIMATEDSPRITE_DEFAULT_ANIMATION_SPEED 33
 #define ASCIIWINDOW_ASCII_START                0
 #define AUDIO_MAX_NAME                         32
+#define AUDIO_MAX_PLAYING_MUSIC                8
 #define COLLIDER2D_MAX_COUNT                   16
 #define COLLIDER2D_MAX_COLLISIONS              16
 #define TEXTURE_INFO_FILE_MAX_NAME             64
 #define TEXTURE_INFO_LINE_MAX                  128
+#define SPATIALHASH_NONE                       0xFFFFFFFF
+#define SPATIALHASH_DEFAULT_BUCKETS            4096
+#define SWEEPANDPRUNE_NONE                     0xFFFFFFFF
+#define SWEEP_SKIN                             0.01f  /* gaps and overlaps up to this many pixels count as touching */
+#define SWEEP_MAX_ITERATIONS                   4      /* move and slide casts per call */
+#define TILECOLLIDER_EMPTY                     0
+#define TILECOLLIDER_SOLID                     1
+#define TILECOLLIDER_ONE_WAY                   2  /* only blocks boxes landing on it from above */
+#define TILERECTS_CHUNK_SIZE                   16  /* cells per side of a merge chunk, at most 32 */
+#define TILERECTS_NONE                         0xFFFFFFFF
+#define AABBBATCH_NONE                         0xFFFFFFFF  /* AabbBatch_Add ran out of memory */
+#define AABBBATCH_MASK_WORDS(count)            (((count) + 31) / 32)  /* uint32_t words of a hit mask */
+#define AABBTREE_NULL                          0xFFFFFFFF
+#define AABBTREE_DEFAULT_MARGIN                4.0f
+#define AABBTREE_DISPLACEMENT_MULTIPLIER       2.0f  /* fat bounds are stretched ahead of the motion by this much */
+#define AABBTREE_STACK_SIZE                    256
 
 /* Structs, Enums, and Unions */
 
+/* world space boxes as separate min/max columns, so overlap tests run several boxes per instruction */
+typedef struct AabbBatch
+{
+    float*   minX;
+    float*   minY;
+    float*   maxX;
+    float*   maxY;
+    uint32_t count;
+    uint32_t capacity;
+} AabbBatch;
+
+typedef struct AabbTreeNode
+{
+    Vector2Float min;  /* fat bounds for leaves, union of the children otherwise */
+    Vector2Float max;
+    void*        userData;
+    uint32_t     parent;  /* next free node while on the free list */
+    uint32_t     child1;
+    uint32_t     child2;
+    int32_t      height;  /* 0 for leaves, -1 for free nodes */
+} AabbTreeNode;
+
+/* dynamic bounding volume tree over user payloads, balanced with rotations as leaves move */
+typedef struct AabbTree
+{
+    AabbTreeNode* nodes;
+    uint32_t      nodeCount;
+    uint32_t      nodeCapacity;
+    uint32_t      freeList;
+    uint32_t      root;
+    float         margin;  /* leaves store bounds grown by this so small motion does not touch the tree */
+} AabbTree;
+
 typedef enum Shape2DType
 {
     SHAPE2D_RECTANGLE,        /* filled rectangle          */
@@ -57,12 +107,29 @@ typedef struct Shape2D
     };
 } Shape2D;
 
-typedef struct Entity2D
+typedef struct Transform2D
 {
     Vector2Float position;
     float        scale;
+    float        rotation;     /* degrees */
+    float        rotationSin;  /* sin/cos of rotation, cached for transforming children */
+    float        rotationCos;
+} Transform2D;
+
+typedef struct Entity2D
+{
+    Vector2Float position;  /* local, relative to parent when there is one */
+    float        scale;
     float        rotation;
     uint8_t      id;
+    Entity2D*    parent;    /* optional, set with Entity2D_SetParent */
+    /* world transform cache, rebuilt by Entity2D_GetWorld only when the local values or a parent changed */
+    Transform2D  world;
+    Transform2D  worldSource;    /* local values the cache was built from */
+    Entity2D*    worldParent;    /* parent the cache was built with */
+    uint32_t     parentVersion;  /* parent version the cache was built with */
+    uint32_t     version;        /* bumped every time world changes */
+    bool         isDirty;
 } Entity2D;
 
 typedef struct TextureData TextureData;
@@ -152,6 +219,12 @@ typedef struct AudioPlayerData
     Sound sound;
 } AudioPlayerData;
 
+typedef struct AudioMusicData
+{
+    Music music;
+    bool  isPlaying;
+} AudioMusicData;
+
 enum Collision2D_Collision
 {
     Collision_None,
@@ -171,6 +244,146 @@ typedef struct Collider2D
     uint8_t      id;
 } Collider2D;
 
+typedef struct SpatialHashNode
+{
+    int32_t  cellX;
+    int32_t  cellY;
+    uint32_t proxy;
+    uint32_t previous;     /* bucket list */
+    uint32_t next;         /* bucket list */
+    uint32_t nextInProxy;  /* every cell of a proxy, for removal */
+} SpatialHashNode;
+
+typedef struct SpatialHashProxy
+{
+    Collider2D* collider;
+    Rectangle   bounds;  /* world bounds at the last insert/update */
+    int32_t     minX;    /* covered cell range, inclusive */
+    int32_t     minY;
+    int32_t     maxX;
+    int32_t     maxY;
+    uint32_t    firstNode;
+    uint32_t    queryStamp;  /* last query that reported this proxy */
+    bool        isUsed;
+} SpatialHashProxy;
+
+/* uniform grid broadphase, colliders are hashed into every cell their bounds touch */
+typedef struct SpatialHash
+{
+    float             cellSize;
+    float             inverseCellSize;
+    uint32_t*         buckets;
+    uint32_t          bucketMask;  /* bucket count - 1, the count is a power of two */
+    SpatialHashProxy* proxies;
+    uint32_t          proxyCount;
+    uint32_t          proxyCapacity;
+    uint32_t          freeProxy;
+    SpatialHashNode*  nodes;
+    uint32_t          nodeCount;
+    uint32_t          nodeCapacity;
+    uint32_t          freeNode;
+    uint32_t          queryStamp;
+} SpatialHash;
+
+typedef enum CollisionEventType
+{
+    COLLISION_EVENT_BEGIN,  /* started overlapping since the last BuildEvents */
+    COLLISION_EVENT_STAY,
+    COLLISION_EVENT_END,    /* stopped overlapping, got disabled or was removed */
+} CollisionEventType;
+
+typedef struct CollisionEvent
+{
+    CollisionEventType type;
+    Collider2D*        a;
+    Collider2D*        b;
+    bool               isTrigger;  /* either collider is a trigger */
+} CollisionEvent;
+
+typedef struct SweepEndpoint
+{
+    float    value;
+    uint32_t data;  /* proxy << 1 | isMax */
+} SweepEndpoint;
+
+typedef struct SweepProxy
+{
+    Collider2D* collider;
+    Rectangle   bounds;
+    uint32_t    endpoints[2][2];  /* [axis][min, max] index into the endpoint lists */
+    bool        isUsed;
+    bool        isRemoved;  /* removed, the slot is released by the next BuildEvents */
+} SweepProxy;
+
+typedef struct SweepPair
+{
+    uint32_t a;  /* a < b */
+    uint32_t b;
+    uint8_t  state;
+    bool     isOverlapping;
+    bool     wasOverlapping;
+} SweepPair;
+
+typedef struct SweepHit
+{
+    float        time;      /* fraction of the motion travelled before touching, 0 to 1 */
+    Vector2Float normal;    /* axis aligned, points out of the surface that was hit */
+    void*        userData;  /* whatever the cast callback hit, NULL for grid cells */
+} SweepHit;
+
+/* collision view of a tile grid, queries only look at the cells a box covers so their cost does not grow with the map.
+ * Cells are read through getCell, so the collider sits on top of whatever stores the tiles without copying them. */
+typedef struct TileCollider
+{
+    uint8_t (*getCell)(int32_t cellX, int32_t cellY, void* context);  /* TILECOLLIDER_ flags of one cell */
+    void*   context;
+    float   cellSize;
+} TileCollider;
+
+typedef struct TileRectChunk
+{
+    int32_t    chunkX;  /* cell coordinates / TILERECTS_CHUNK_SIZE */
+    int32_t    chunkY;
+    Rectangle* rects;
+    uint32_t   count;
+    uint32_t   capacity;
+    bool       isDirty;
+} TileRectChunk;
+
+/* flagged cells of a TileCollider merged into as few rectangles as possible, rebuilt one chunk at a time */
+typedef struct TileRects
+{
+    TileCollider*  tiles;
+    uint8_t        flags;
+    TileRectChunk* chunks;         /* every chunk marked so far, in marking order */
+    uint32_t       chunkCount;
+    uint32_t       chunkCapacity;
+    uint32_t*      buckets;        /* chunk index or TILERECTS_NONE, linear probing */
+    uint32_t       bucketMask;     /* bucket count - 1, the count is a power of two */
+    uint32_t       dirtyCount;
+    uint32_t       rectCount;      /* over all chunks */
+    double         lastMergeTime;  /* seconds spent in the last TileRects_Update that rebuilt something */
+} TileRects;
+
+/* incremental sort-and-sweep broadphase, endpoint lists stay sorted between frames so small motion is cheap */
+typedef struct SweepAndPrune
+{
+    SweepProxy*     proxies;
+    uint32_t        proxyCount;
+    uint32_t        proxyCapacity;
+    uint32_t        freeProxy;
+    SweepEndpoint*  endpoints[2];  /* x and y */
+    uint32_t        endpointCount;
+    SweepPair*      pairs;         /* open addressing hash set keyed by proxy pair */
+    uint32_t        pairCapacity;  /* power of two */
+    uint32_t        pairUsed;      /* live and deleted slots */
+    uint32_t        pairLive;
+    uint32_t        overlapCount;  /* overlapping pairs at the last BuildEvents */
+    CollisionEvent* events;
+    uint32_t        eventCount;
+    uint32_t        eventCapacity;
+} SweepAndPrune;
+
 typedef struct TextureData
 {
     Texture2D    texture;
@@ -215,18 +428,102 @@ void      Audio_UnloadAudio(AudioData* audio);
 void      Audio_Play(AudioData* audio);
 void      Audio_Stop(AudioData* audio);
 
+AudioMusicData Audio_LoadMusic(const char* fileName);
+void           Audio_UnloadMusic(AudioMusicData* music);
+bool           Audio_PlayMusic(AudioMusicData* music);
+void           Audio_StopMusic(AudioMusicData* music);
+void           Audio_Update();
+
 void                  Collider2D_Initialize(Collider2D* col);
 void                  Collider2D_DrawDebug(Collider2D* col);
 bool                  Collider2D_CheckCollider(Collider2D* a, Collider2D* b);
 bool                  Collider2D_CheckPoint(Collider2D* a, Vector2 b);
 bool                  Collider2D_CheckRect(Collider2D* a, Rectangle b);
 Collision2D_Collision Collider2D_CheckCollisionSide(Collider2D* a, Collider2D* b);
+Rectangle             Collider2D_GetBounds(Collider2D* col);
 
-void Entity2D_Initialize(Entity2D* ent);
+void               Entity2D_Initialize(Entity2D* ent);
+bool               Entity2D_SetParent(Entity2D* ent, Entity2D* parent);
+void               Entity2D_MarkDirty(Entity2D* ent);
+const Transform2D* Entity2D_GetWorld(Entity2D* ent);
+Vector2Float       Entity2D_TransformPoint(Entity2D* ent, Vector2Float local);
 
 void Shape2D_Initialize(Shape2D* shape);
 void Shape2D_Draw(Shape2D* shape);
 
+bool        AabbBatch_Initialize(AabbBatch* batch, uint32_t capacity);
+void        AabbBatch_Deinitialize(AabbBatch* batch);
+void        AabbBatch_Clear(AabbBatch* batch);
+uint32_t    AabbBatch_Add(AabbBatch* batch, Rectangle bounds);
+uint32_t    AabbBatch_AddCollider(AabbBatch* batch, Collider2D* col);
+void        AabbBatch_Set(AabbBatch* batch, uint32_t index, Rectangle bounds);
+uint32_t    AabbBatch_Overlap(const AabbBatch* batch, Rectangle box, uint32_t* hitMask);
+uint32_t    AabbBatch_OverlapScalar(const AabbBatch* batch, Rectangle box, uint32_t* hitMask);
+uint32_t    AabbBatch_OverlapDepths(const AabbBatch* batch, Rectangle box, float* depthX, float* depthY);
+const char* AabbBatch_GetKernelName();
+
+bool     AabbTree_Initialize(AabbTree* tree, float margin);
+void     AabbTree_Deinitialize(AabbTree* tree);
+uint32_t AabbTree_Insert(AabbTree* tree, Rectangle bounds, void* userData);
+void     AabbTree_Remove(AabbTree* tree, uint32_t proxy);
+bool     AabbTree_Move(AabbTree* tree, uint32_t proxy, Rectangle bounds, Vector2Float displacement);
+void*    AabbTree_GetUserData(AabbTree* tree, uint32_t proxy);
+int32_t  AabbTree_GetHeight(AabbTree* tree);
+// callback returns false to stop the query
+void AabbTree_QueryRect(AabbTree* tree, Rectangle rect, bool (*callback)(uint32_t proxy, void* userData, void* context),
+                        void* context);
+void AabbTree_QueryPoint(AabbTree* tree, Vector2Float point,
+                         bool (*callback)(uint32_t proxy, void* userData, void* context), void* context);
+// callback returns -1 to ignore the proxy, 0 to stop, the hit fraction to clip the ray or maxFraction to continue
+void AabbTree_RayCast(AabbTree* tree, Vector2Float from, Vector2Float to,
+                      float (*callback)(uint32_t proxy, void* userData, Vector2Float from, Vector2Float to,
+                                        float maxFraction, void* context),
+                      void* context);
+
+bool     SpatialHash_Initialize(SpatialHash* hash, float cellSize, uint32_t bucketCount);
+void     SpatialHash_Deinitialize(SpatialHash* hash);
+void     SpatialHash_Clear(SpatialHash* hash);
+uint32_t SpatialHash_Insert(SpatialHash* hash, Collider2D* col);
+void     SpatialHash_Update(SpatialHash* hash, uint32_t proxy);
+void     SpatialHash_Remove(SpatialHash* hash, uint32_t proxy);
+uint32_t SpatialHash_QueryRect(SpatialHash* hash, Rectangle rect, Collider2D** output, uint32_t outputSize);
+uint32_t SpatialHash_QueryPoint(SpatialHash* hash, Vector2Float point, Collider2D** output, uint32_t outputSize);
+uint32_t SpatialHash_ForEachPair(SpatialHash* hash, void (*callback)(Collider2D* a, Collider2D* b, void* userData),
+                                 void* userData);
+
+bool     SweepAndPrune_Initialize(SweepAndPrune* sap);
+void     SweepAndPrune_Deinitialize(SweepAndPrune* sap);
+uint32_t SweepAndPrune_Insert(SweepAndPrune* sap, Collider2D* col);
+void     SweepAndPrune_Remove(SweepAndPrune* sap, uint32_t proxy);
+void     SweepAndPrune_UpdateProxy(SweepAndPrune* sap, uint32_t proxy);
+void     SweepAndPrune_UpdateAll(SweepAndPrune* sap);
+uint32_t SweepAndPrune_BuildEvents(SweepAndPrune* sap);
+uint32_t SweepAndPrune_GetPairCount(SweepAndPrune* sap);
+
+Rectangle Sweep_GetBounds(Rectangle box, Vector2Float delta);
+bool      Sweep_Rect(Rectangle box, Vector2Float delta, Rectangle target, SweepHit* hit);
+bool      Sweep_Grid(Rectangle box, Vector2Float delta, float cellSize,
+                     bool (*isSolid)(int32_t cellX, int32_t cellY, void* context), void* context, SweepHit* hit);
+// cast returns the earliest hit of box moving by delta, or false when the motion is free
+uint32_t Sweep_MoveAndSlide(Rectangle* box, Vector2Float delta,
+                            bool (*cast)(Rectangle box, Vector2Float delta, SweepHit* hit, void* context),
+                            void* context, SweepHit* hits, uint32_t maxHits);
+
+bool     TileCollider_Initialize(TileCollider* tiles, float cellSize,
+                                uint8_t (*getCell)(int32_t cellX, int32_t cellY, void* context), void* context);
+void     TileCollider_Deinitialize(TileCollider* tiles);
+uint8_t  TileCollider_GetCell(TileCollider* tiles, int32_t cellX, int32_t cellY);
+uint32_t TileCollider_QueryRect(TileCollider* tiles, Rectangle rect, uint8_t flags, Rectangle* output,
+                                uint32_t outputSize);
+bool     TileCollider_Sweep(TileCollider* tiles, Rectangle box, Vector2Float delta, SweepHit* hit);
+void     TileCollider_DrawDebug(TileCollider* tiles, Rectangle area, uint8_t flags);
+
+bool     TileRects_Initialize(TileRects* rects, TileCollider* tiles, uint8_t flags);
+void     TileRects_Deinitialize(TileRects* rects);
+void     TileRects_MarkDirty(TileRects* rects, int32_t cellX, int32_t cellY);
+uint32_t TileRects_Update(TileRects* rects);
+void     TileRects_DrawDebug(TileRects* rects, Rectangle area);
+
 void Sprite_Initialize(Sprite* spr);
 void Sprite_Update(Sprite* spr);
 void Sprite_Draw(Sprite* spr);
@@ -234,6 +531,9 @@ void Sprite_Draw(Sprite* spr);
 void Drawable_Draw(Drawable* drawable);
 
 TextureData Texture_LoadTexture(const char* fileName);
+Image       Texture_LoadImage(const char* fileName);
+TextureData Texture_LoadTextureFromImage(Image* image);
+void        Texture_UnloadImage(Image* image);
 bool        Texture_CreateTextureAtlas(TextureData texture, uint32_t columns, uint32_t rows, TextureData* output);
 void        Texture_UnloadTexture(TextureData* texture);
 
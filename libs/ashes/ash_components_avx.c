@@ -0,0 +1,44 @@
+// The only translation unit built with -mavx (see the Makefile). It deliberately includes nothing but the intrinsics
+// headers: an inline function from a shared header compiled here could be picked by the linker for the whole program
+// and run AVX code on a CPU without it. AabbBatch_Overlap only calls in here once cpuid reported AVX support.
+#include <stdint.h>
+
+#if defined(__AVX__)
+#    include <immintrin.h>
+#endif
+
+bool AabbBatch_AvxBuilt()
+{
+#if defined(__AVX__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Tests boxes 8 at a time and returns how many were processed, the caller finishes the tail.
+uint32_t AabbBatch_OverlapAvx(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                              uint32_t count, const float box[4], uint32_t* hitMask, uint32_t* outHits)
+{
+    uint32_t i    = 0;
+    uint32_t hits = 0;
+#if defined(__AVX__)
+    __m256 boxMinX = _mm256_set1_ps(box[0]);
+    __m256 boxMinY = _mm256_set1_ps(box[1]);
+    __m256 boxMaxX = _mm256_set1_ps(box[2]);
+    __m256 boxMaxY = _mm256_set1_ps(box[3]);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_and_ps(_mm256_cmp_ps(boxMinX, _mm256_loadu_ps(maxX + i), _CMP_LT_OQ),
+                                 _mm256_cmp_ps(boxMaxX, _mm256_loadu_ps(minX + i), _CMP_GT_OQ));
+        __m256 y = _mm256_and_ps(_mm256_cmp_ps(boxMinY, _mm256_loadu_ps(maxY + i), _CMP_LT_OQ),
+                                 _mm256_cmp_ps(boxMaxY, _mm256_loadu_ps(minY + i), _CMP_GT_OQ));
+        uint32_t bits = (uint32_t)_mm256_movemask_ps(_mm256_and_ps(x, y));
+        // i is a multiple of 8, so the 8 bits never straddle two mask words
+        hitMask[i >> 5] |= bits << (i & 31);
+        hits += __builtin_popcount(bits);
+    }
+#endif
+    *outHits = hits;
+    return i;
+}
@@ -2,91 +2,423 @@
 
 #include "ash_debug.h"
 #include "ash_io.h"
+#include "ash_misc.h"
 #include "raylib.h"
 #include "rlImGui.h"
 
+#include <atomic>
 #include <stdint.h>
+#include <stdlib.h>
+#include <thread>
 
-Mode*      screen[MAX_MODES];
-Updatable* updatables[MAX_UPDATABLES];
-uint8_t    screenCount     = 0;
-uint8_t    updatablesCount = 0;
-bool       currentFinished = false;
-bool       resumed         = false;
+#define UPDATABLE_AVERAGE_WEIGHT 0.05
 
-void Context_SetMode(Mode* mode)
+typedef struct ModeTransition
+{
+    ModeTransitionType type;
+    Mode*              mode;
+} ModeTransition;
+
+Mode*          screen[MAX_MODES];
+Updatable**    updatables = NULL;
+ModeTransition transitions[MAX_TRANSITIONS];
+uint8_t        screenCount        = 0;
+uint32_t       updatablesCount    = 0;
+uint32_t       updatablesCapacity = 0;
+uint8_t        transitionCount    = 0;
+uint32_t       frameIndex         = 0;
+
+// updatables added or removed while a phase runs are applied once it ends, so the running loop never shifts
+static bool       isRunningPhase = false;
+static uint32_t   removedCount   = 0;  // entries set to NULL by removals during the phase
+static Updatable* pendingAdds[UPDATABLES_MAX_PENDING];
+static uint32_t   pendingAddCount = 0;
+
+static Mode*             preloadMode = NULL;
+static std::thread       preloadThread;
+static std::atomic<bool> preloadDone(false);
+
+static void Context_PreloadWorker(Mode* mode)
+{
+    PROFILE_ZONE("Mode Preload");
+    mode->OnPreload();
+    preloadDone.store(true, std::memory_order_release);
+}
+
+static bool Context_QueueTransition(ModeTransitionType type, Mode* mode)
 {
-    if (screenCount + 1 < MAX_MODES)
+    // a key pressed again while the mode is still preloading must not start it twice
+    for (uint8_t i = 0; i < transitionCount && type != MODE_TRANSITION_POP; i++)
     {
-        if (screenCount != 0)
+        if (transitions[i].type == type && transitions[i].mode == mode)
         {
-            screen[screenCount - 1]->OnPause();
-            EndMode2D();
-            rlImGuiEnd();
-            EndDrawing();
-        }
-        screen[screenCount] = mode;
-        screenCount += 1;
-        currentFinished = false;
-        screen[screenCount - 1]->OnStart();
-        while (!currentFinished && !WindowShouldClose())
-        {
-            BeginDrawing();
-            rlImGuiBegin();
-            ClearBackground(BLACK);
-            BeginMode2D(*Window_GetCamera());
-            for (int i = 0; i < updatablesCount; i++)
+            LOG_INF("Context: transition to a mode that is already pending ignored");
+            return false;
+        }
+    }
+    if (transitionCount >= MAX_TRANSITIONS)
+    {
+        LOG_ERR("Context: transition queue is full");
+        return false;
+    }
+    transitions[transitionCount].type = type;
+    transitions[transitionCount].mode = mode;
+    transitionCount++;
+    return true;
+}
+
+// Returns true once the mode's OnPreload has finished, starting it on the worker thread if needed.
+static bool Context_IsPreloaded(Mode* mode)
+{
+    if (mode->OnPreload == NULL)
+    {
+        return true;
+    }
+    if (preloadMode == NULL)
+    {
+        preloadMode = mode;
+        preloadDone.store(false, std::memory_order_relaxed);
+        preloadThread = std::thread(Context_PreloadWorker, mode);
+        return false;
+    }
+    if (preloadMode != mode || !preloadDone.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    preloadThread.join();
+    preloadMode = NULL;
+    return true;
+}
+
+static void Context_StartMode(Mode* mode)
+{
+    screen[screenCount] = mode;
+    screenCount += 1;
+    mode->OnStart();
+}
+
+static void Context_StopMode()
+{
+    screen[screenCount - 1]->OnStop();
+    screenCount -= 1;
+}
+
+// Applies queued transitions in order, stops at the first one that still waits for its preload.
+static void Context_ApplyTransitions()
+{
+    uint8_t applied = 0;
+    while (applied < transitionCount)
+    {
+        ModeTransition* transition = &transitions[applied];
+        if (transition->type != MODE_TRANSITION_POP && !Context_IsPreloaded(transition->mode))
+        {
+            break;
+        }
+        switch (transition->type)
+        {
+            case MODE_TRANSITION_PUSH:
+                if (screenCount < MAX_MODES)
+                {
+                    if (screenCount != 0)
+                    {
+                        screen[screenCount - 1]->OnPause();
+                    }
+                    Context_StartMode(transition->mode);
+                }
+                else
+                {
+                    LOG_ERR("Context: SetMode() failed, not enough space");
+                }
+                break;
+            case MODE_TRANSITION_POP:
+                if (screenCount != 0)
+                {
+                    Context_StopMode();
+                    if (screenCount != 0)
+                    {
+                        screen[screenCount - 1]->OnResume();
+                    }
+                }
+                break;
+            case MODE_TRANSITION_REPLACE:
+                if (screenCount != 0)
+                {
+                    Context_StopMode();
+                }
+                Context_StartMode(transition->mode);
+                break;
+        }
+        applied++;
+    }
+    for (uint8_t i = applied; i < transitionCount; i++)
+    {
+        transitions[i - applied] = transitions[i];
+    }
+    transitionCount -= applied;
+    // kick off the preload of the next waiting mode so it overlaps with the current one
+    if (transitionCount != 0 && transitions[0].type != MODE_TRANSITION_POP)
+    {
+        Context_IsPreloaded(transitions[0].mode);
+    }
+}
+
+static void Context_ApplyUpdatableChanges()
+{
+    if (removedCount != 0)
+    {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < updatablesCount; i++)
+        {
+            if (updatables[i] != NULL)
             {
-                updatables[i]->Update();
+                updatables[kept++] = updatables[i];
             }
+        }
+        updatablesCount = kept;
+        removedCount    = 0;
+    }
+    uint32_t addCount = pendingAddCount;
+    pendingAddCount   = 0;
+    for (uint32_t i = 0; i < addCount; i++)
+    {
+        Context_AddUpdatable(pendingAdds[i]);
+    }
+}
 
-            // for IUpdatables
-            if (resumed)
+// updatables are kept sorted by phase, then priority, so a phase is one contiguous run
+static void Context_RunPhase(UpdatablePhase phase)
+{
+    static const char* phaseNames[] = { "Pre Update", "Update", "Post Update", "Pre Render" };
+    PROFILE_ZONE(phaseNames[phase]);
+    isRunningPhase = true;
+    for (uint32_t i = 0; i < updatablesCount; i++)
+    {
+        Updatable* updatable = updatables[i];
+        if (updatable == NULL)
+        {
+            continue;
+        }
+        if (updatable->phase != phase)
+        {
+            if (updatable->phase > phase)
             {
-                screen[screenCount - 1]->OnResume();
-                resumed = false;
+                break;
             }
-            screen[screenCount - 1]->Update();
-            EndMode2D();
-            DrawFPS(10, 10);
-            rlImGuiEnd();
-            EndDrawing();
+            continue;
+        }
+        if (!updatable->isEnabled || updatable->Update == NULL)
+        {
+            continue;
+        }
+        if (updatable->frequencyDivisor > 1 && frameIndex % updatable->frequencyDivisor != 0)
+        {
+            continue;
+        }
+        double start = GetTime();
+        {
+            PROFILE_ZONE(updatable->name ? updatable->name : "Updatable");
+            updatable->Update();
         }
-        screen[screenCount - 1]->OnStop();
-        screenCount -= 1;
+        updatable->lastTime = GetTime() - start;
+        if (updatable->updateCount == 0)
+        {
+            updatable->averageTime = updatable->lastTime;
+        }
+        else
+        {
+            updatable->averageTime += (updatable->lastTime - updatable->averageTime) * UPDATABLE_AVERAGE_WEIGHT;
+        }
+        updatable->updateCount++;
+    }
+    isRunningPhase = false;
+    Context_ApplyUpdatableChanges();
+}
+
+void Context_Run()
+{
+    Context_ApplyTransitions();
+    while ((screenCount != 0 || transitionCount != 0) && !WindowShouldClose())
+    {
+        PROFILE_FRAME();
+        PROFILE_BEGIN("Frame");
+        FrameArena_BeginFrame();
+        BeginDrawing();
+        rlImGuiBegin();
+        ClearBackground(BLACK);
+        BeginMode2D(*Window_GetCamera());
+        Context_RunPhase(UPDATABLE_PHASE_PRE_UPDATE);
+        Context_RunPhase(UPDATABLE_PHASE_UPDATE);
         if (screenCount != 0)
         {
-            currentFinished = false;
-            resumed         = true;
+            PROFILE_ZONE("Mode Update");
+            screen[screenCount - 1]->Update();
+        }
+        Context_RunPhase(UPDATABLE_PHASE_POST_UPDATE);
+        Context_RunPhase(UPDATABLE_PHASE_PRE_RENDER);
+        EndMode2D();
+        DrawFPS(10, 10);
+        Debug_ShowProfilerWindow();
+        PROFILE_BEGIN("ImGui");
+        rlImGuiEnd();
+        PROFILE_END();
+        PROFILE_BEGIN("Present");
+        EndDrawing();
+        PROFILE_END();
+
+        PROFILE_BEGIN("Transitions");
+        Context_ApplyTransitions();
+        PROFILE_END();
+        PROFILE_END();
+        frameIndex++;
+    }
+    if (preloadMode != NULL)
+    {
+        // the mode never started, so nothing took ownership of what its preload produced
+        preloadThread.join();
+        if (preloadMode->OnPreloadDiscard != NULL)
+        {
+            preloadMode->OnPreloadDiscard();
         }
+        preloadMode = NULL;
     }
-    else
+    transitionCount = 0;
+    while (screenCount != 0)
     {
-        LOG_INF("Context: SetMode() failed, not enough space");
+        Context_StopMode();
     }
 }
 
+void Context_SetMode(Mode* mode)
+{
+    Context_QueueTransition(MODE_TRANSITION_PUSH, mode);
+}
+
+void Context_ReplaceMode(Mode* mode)
+{
+    Context_QueueTransition(MODE_TRANSITION_REPLACE, mode);
+}
+
+void Context_FinishMode()
+{
+    Context_QueueTransition(MODE_TRANSITION_POP, NULL);
+}
+
+void Updatable_Initialize(Updatable* updatable, void (*update)(), const char* name)
+{
+    updatable->Update           = update;
+    updatable->name             = name;
+    updatable->phase            = UPDATABLE_PHASE_PRE_UPDATE;
+    updatable->priority         = 0;
+    updatable->frequencyDivisor = 1;
+    updatable->isEnabled        = true;
+    updatable->lastTime         = 0.0;
+    updatable->averageTime      = 0.0;
+    updatable->updateCount      = 0;
+}
+
 bool Context_AddUpdatable(Updatable* updatable)
 {
-    if (updatablesCount + 1 < MAX_UPDATABLES)
+    if (updatable == NULL)
+    {
+        LOG_ERR("Context: AddUpdatable() failed, updatable is nullptr");
+        return false;
+    }
+    if (isRunningPhase)
     {
-        updatables[updatablesCount] = updatable;
-        updatablesCount++;
+        if (pendingAddCount >= UPDATABLES_MAX_PENDING)
+        {
+            LOG_ERR("Context: AddUpdatable() failed, too many updatables added during one phase");
+            return false;
+        }
+        pendingAdds[pendingAddCount++] = updatable;
         return true;
     }
+    if (updatablesCount == updatablesCapacity)
+    {
+        uint32_t    capacity = updatablesCapacity == 0 ? UPDATABLES_INITIAL_CAPACITY : updatablesCapacity * 2;
+        Updatable** grown    = (Updatable**)realloc(updatables, capacity * sizeof(Updatable*));
+        if (grown == NULL)
+        {
+            LOG_ERR("Context: AddUpdatable() failed, out of memory");
+            return false;
+        }
+        updatables         = grown;
+        updatablesCapacity = capacity;
+    }
+    // insert after every updatable that sorts before or equal, so equal priorities keep insertion order
+    uint32_t position = updatablesCount;
+    while (position > 0)
+    {
+        Updatable* previous = updatables[position - 1];
+        if (previous->phase < updatable->phase
+            || (previous->phase == updatable->phase && previous->priority <= updatable->priority))
+        {
+            break;
+        }
+        updatables[position] = previous;
+        position--;
+    }
+    updatables[position] = updatable;
+    updatablesCount++;
+    return true;
+}
+
+bool Context_RemoveUpdatable(Updatable* updatable)
+{
+    if (updatable == NULL)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < pendingAddCount; i++)
+    {
+        if (pendingAdds[i] == updatable)
+        {
+            pendingAdds[i] = pendingAdds[--pendingAddCount];
+            return true;
+        }
+    }
+    for (uint32_t i = 0; i < updatablesCount; i++)
+    {
+        if (updatables[i] == updatable)
+        {
+            if (isRunningPhase)
+            {
+                updatables[i] = NULL;
+                removedCount++;
+                return true;
+            }
+            for (uint32_t j = i + 1; j < updatablesCount; j++)
+            {
+                updatables[j - 1] = updatables[j];
+            }
+            updatablesCount--;
+            return true;
+        }
+    }
     return false;
 }
 
 void Context_ClearUpdatables()
 {
-    for (int i = 0; i < updatablesCount; i++)
+    for (uint32_t i = 0; i < updatablesCount; i++)
+    {
+        updatables[i] = NULL;
+    }
+    pendingAddCount = 0;
+    if (isRunningPhase)
     {
-        updatables[updatablesCount] = 0;
+        removedCount = updatablesCount;
+        return;
     }
     updatablesCount = 0;
 }
 
-void Context_FinishMode()
+uint32_t Context_GetUpdatableCount()
+{
+    return updatablesCount;
+}
+
+Updatable* Context_GetUpdatable(uint32_t index)
 {
-    currentFinished = true;
+    return index < updatablesCount ? updatables[index] : NULL;
 }
@@ -1,12 +1,19 @@
 #ifndef ASH_CONTEXT_H
 #define ASH_CONTEXT_H
 
+#include <stdint.h>
+
 /* Defines */
-#define MAX_MODES      8
-#define MAX_UPDATABLES 8
+#define MAX_MODES                   8
+#define MAX_TRANSITIONS             8
+#define UPDATABLES_INITIAL_CAPACITY 8
+#define UPDATABLES_MAX_PENDING      16
 #define LIBS_ENGINE_UPDATABLE_H
 #define MODE_FROM_CLASSNAME(className) \
     { className##_OnStart, className##_OnPause, className##_Update, className##_OnStop, className##_OnResume }
+#define MODE_FROM_CLASSNAME_PRELOADED(className)                                                              \
+    { className##_OnStart, className##_OnPause, className##_Update, className##_OnStop, className##_OnResume, \
+      className##_OnPreload, className##_OnPreloadDiscard }
 
 /* Structs, Enums, and Unions */
 typedef struct Updatable Updatable;
@@ -23,18 +30,54 @@ typedef struct Mode
     void (*OnStop)();
     // OnResume runs once when mode is resumed
     void (*OnResume)();
+    // OnPreload (optional) runs once on a worker thread before OnStart, must not touch GPU resources
+    void (*OnPreload)();
+    // OnPreloadDiscard (optional) runs on the main thread when a finished preload is dropped without OnStart
+    void (*OnPreloadDiscard)();
 } Mode;
 
+typedef enum ModeTransitionType
+{
+    MODE_TRANSITION_PUSH,
+    MODE_TRANSITION_POP,
+    MODE_TRANSITION_REPLACE,
+} ModeTransitionType;
+
+typedef enum UpdatablePhase
+{
+    UPDATABLE_PHASE_PRE_UPDATE,   /* before the mode Update */
+    UPDATABLE_PHASE_UPDATE,       /* right before the mode Update, after PRE_UPDATE */
+    UPDATABLE_PHASE_POST_UPDATE,  /* after the mode Update */
+    UPDATABLE_PHASE_PRE_RENDER,   /* last, before the frame is presented */
+    UPDATABLE_PHASE_COUNT,
+} UpdatablePhase;
+
 typedef struct Updatable
 {
     void (*Update)();
+    const char*    name;
+    UpdatablePhase phase;             /* phase and priority are read once, in Context_AddUpdatable */
+    int16_t        priority;          /* lower runs first inside a phase */
+    uint16_t       frequencyDivisor;  /* runs every Nth frame, 0 and 1 run every frame */
+    bool           isEnabled;         /* disabled updatables stay registered but are skipped */
+    /* filled in by the context */
+    double   lastTime;     /* seconds spent in the last Update call */
+    double   averageTime;  /* exponential moving average of lastTime */
+    uint32_t updateCount;
 } Updatable;
 
 /* Function Prototypes */
 
+void Context_Run();
 void Context_SetMode(Mode* mode);
-void Context_ClearUpdatables();
-bool Context_AddUpdatable(Updatable* updatable);
+void Context_ReplaceMode(Mode* mode);
 void Context_FinishMode();
 
+void       Updatable_Initialize(Updatable* updatable, void (*update)(), const char* name);
+void       Context_ClearUpdatables();
+bool       Context_AddUpdatable(Updatable* updatable);
+bool       Context_RemoveUpdatable(Updatable* updatable);
+uint32_t   Context_GetUpdatableCount();
+Updatable* Context_GetUpdatable(uint32_t index);
+
 #endif  // ASH_CONTEXT_H
@@ -1,14 +1,612 @@
 #include "ash_debug.h"
 
+#include "ash_context.h"
+#include "ash_ecs.h"
 #include "ash_io.h"
 #include "imgui.h"
 
+#include <atomic>
+#include <chrono>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-#define MOUSE_BUTTON_COUNT    5
-#define KEYBOARD_BUTTON_COUNT 128
+#define MOUSE_BUTTON_COUNT      5
+#define KEYBOARD_BUTTON_COUNT   128
+#define PROFILER_ROW_HEIGHT     18.0f
+#define PROFILER_TRACE_FILE     "profile_trace.json"
+#define PROFILER_MAX_SHOWN      16
+#define BENCHMARK_RESULT_SIZE   192
+#define BENCHMARK_BRUTE_MAX     10000  /* above this the O(n^2) reference loop takes too long */
+#define BENCHMARK_FRAMES        10
+#define BENCHMARK_QUERIES       1000
 bool debugVisible = false;
 
+#ifdef PROFILER_ENABLED
+typedef struct ProfilerOpenZone
+{
+    const char* name;
+    uint64_t    start;
+} ProfilerOpenZone;
+
+typedef struct ProfilerThread
+{
+    ProfilerEvent         events[PROFILER_MAX_EVENTS];
+    std::atomic<uint32_t> head;  // events written so far, the ring slot is head % PROFILER_MAX_EVENTS
+    ProfilerOpenZone      stack[PROFILER_MAX_DEPTH];
+    uint32_t              depth;
+    std::atomic<bool>     inUse;  // owned by a running thread, released when that thread exits
+} ProfilerThread;
+
+// releases the slot of a thread when it exits, so short lived workers do not use up PROFILER_MAX_THREADS
+struct ProfilerThreadSlot
+{
+    ProfilerThread* thread    = NULL;
+    bool            hasWarned = false;
+    ~ProfilerThreadSlot()
+    {
+        if (thread != NULL)
+        {
+            thread->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+static ProfilerThread        profilerThreads[PROFILER_MAX_THREADS];
+static std::atomic<uint32_t> profilerThreadCount(0);  // slots ever used, readers go over all of them
+static std::atomic<uint32_t> profilerFrame(0);
+static uint64_t              profilerFrameStart[PROFILER_MAX_FRAMES];
+static bool                  profilerVisible       = false;
+static int                   profilerShownFrames   = 1;
+static int                   profilerCaptureFrames = PROFILER_DEFAULT_CAPTURE;
+
+static thread_local ProfilerThreadSlot profilerSlot;
+
+static const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+
+static uint64_t Profiler_Now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                                          - profilerEpoch)
+        .count();
+}
+
+static ProfilerThread* Profiler_GetThread()
+{
+    if (profilerSlot.thread != NULL)
+    {
+        return profilerSlot.thread;
+    }
+    for (uint32_t i = 0; i < PROFILER_MAX_THREADS; i++)
+    {
+        bool expected = false;
+        if (!profilerThreads[i].inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            continue;
+        }
+        // the ring keeps the events of the previous owner, head only ever grows so readers stay consistent
+        profilerThreads[i].depth = 0;
+        profilerSlot.thread      = &profilerThreads[i];
+        uint32_t count           = profilerThreadCount.load();
+        while (count < i + 1 && !profilerThreadCount.compare_exchange_weak(count, i + 1))
+        {
+        }
+        return profilerSlot.thread;
+    }
+    // every slot is taken by a running thread, try again on the next zone in case one exits
+    if (!profilerSlot.hasWarned)
+    {
+        profilerSlot.hasWarned = true;
+        LOG_WRN("Profiler: more than %d threads running, zones of this thread are dropped", PROFILER_MAX_THREADS);
+    }
+    return NULL;
+}
+
+// Copies ring entry index, false when the writer may have overwritten it while it was being read.
+static bool Profiler_ReadEvent(ProfilerThread* thread, uint32_t index, ProfilerEvent* outEvent)
+{
+    *outEvent = thread->events[index % PROFILER_MAX_EVENTS];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // the writer fills slot head before it publishes head + 1, so only entries a full ring behind can be torn
+    return thread->head.load(std::memory_order_relaxed) - index < PROFILER_MAX_EVENTS;
+}
+
+void Profiler_BeginFrame()
+{
+    uint32_t frame                                    = profilerFrame.load(std::memory_order_relaxed) + 1;
+    profilerFrameStart[frame % PROFILER_MAX_FRAMES] = Profiler_Now();
+    profilerFrame.store(frame, std::memory_order_release);
+}
+
+void Profiler_BeginZone(const char* name)
+{
+    ProfilerThread* thread = Profiler_GetThread();
+    if (thread == NULL)
+    {
+        return;
+    }
+    if (thread->depth < PROFILER_MAX_DEPTH)
+    {
+        thread->stack[thread->depth].name  = name;
+        thread->stack[thread->depth].start = Profiler_Now();
+    }
+    thread->depth++;
+}
+
+void Profiler_EndZone()
+{
+    ProfilerThread* thread = Profiler_GetThread();
+    if (thread == NULL || thread->depth == 0)
+    {
+        return;
+    }
+    thread->depth--;
+    if (thread->depth >= PROFILER_MAX_DEPTH)
+    {
+        return;
+    }
+    uint32_t       head  = thread->head.load(std::memory_order_relaxed);
+    ProfilerEvent* event = &thread->events[head % PROFILER_MAX_EVENTS];
+    event->name          = thread->stack[thread->depth].name;
+    event->start         = thread->stack[thread->depth].start;
+    event->end           = Profiler_Now();
+    event->frame         = profilerFrame.load(std::memory_order_relaxed);
+    event->depth         = (uint8_t)thread->depth;
+    thread->head.store(head + 1, std::memory_order_release);
+}
+
+static void Profiler_WriteJsonString(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool Profiler_ExportChromeTrace(const char* fileName, uint32_t frameCount)
+{
+    uint32_t current = profilerFrame.load(std::memory_order_acquire);
+    if (current < 2)
+    {
+        LOG_WRN("Profiler: ExportChromeTrace() nothing captured yet");
+        return false;
+    }
+    // only completed frames, and only as many as the frame ring still remembers
+    uint32_t lastFrame = current - 1;
+    if (frameCount > lastFrame)
+    {
+        frameCount = lastFrame;
+    }
+    if (frameCount > PROFILER_MAX_FRAMES - 1)
+    {
+        frameCount = PROFILER_MAX_FRAMES - 1;
+    }
+    uint32_t firstFrame = lastFrame - frameCount + 1;
+
+    FILE* file = fopen(fileName, "w");
+    if (file == NULL)
+    {
+        LOG_ERR("Profiler: ExportChromeTrace() cannot open '%s'", fileName);
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool     first      = true;
+    uint32_t eventCount = 0;
+    uint32_t threads    = profilerThreadCount.load();
+    if (threads > PROFILER_MAX_THREADS)
+    {
+        threads = PROFILER_MAX_THREADS;
+    }
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        ProfilerThread* thread = &profilerThreads[t];
+        uint32_t        head   = thread->head.load(std::memory_order_acquire);
+        uint32_t        begin  = head > PROFILER_MAX_EVENTS ? head - PROFILER_MAX_EVENTS : 0;
+        for (uint32_t i = begin; i < head; i++)
+        {
+            ProfilerEvent event;
+            if (!Profiler_ReadEvent(thread, i, &event) || event.frame < firstFrame || event.frame > lastFrame)
+            {
+                continue;
+            }
+            fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+            Profiler_WriteJsonString(file, event.name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}", t,
+                    event.start / 1000.0, (event.end - event.start) / 1000.0, event.frame);
+            first = false;
+            eventCount++;
+        }
+    }
+    for (uint32_t f = firstFrame; f <= lastFrame; f++)
+    {
+        fprintf(file, "%s{\"name\":\"Frame %u\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}",
+                first ? "" : ",\n", f, profilerFrameStart[f % PROFILER_MAX_FRAMES] / 1000.0);
+        first = false;
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    LOG_INF("Profiler: exported %u zones over %u frames to '%s'", eventCount, frameCount, fileName);
+    return true;
+}
+
+static ImU32 Profiler_ZoneColor(const char* name)
+{
+    // stable color per zone name, so the same zone keeps its color across frames
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; c++)
+    {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    return IM_COL32(90 + (hash & 0x7F), 90 + ((hash >> 8) & 0x7F), 90 + ((hash >> 16) & 0x7F), 255);
+}
+
+void Debug_ShowProfilerWindow()
+{
+    if (Input_IsKeyPressed(INPUT_KEYCODE_F4))
+    {
+        profilerVisible = !profilerVisible;
+    }
+    if (!profilerVisible)
+    {
+        return;
+    }
+    ImGui::SetNextWindowPos(ImVec2(20, 420), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(1240, 280), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", nullptr, 0))
+    {
+        ImGui::End();
+        return;
+    }
+
+    uint32_t current = profilerFrame.load(std::memory_order_acquire);
+    if (current < 2)
+    {
+        ImGui::Text("Waiting for the first frame...");
+        ImGui::End();
+        return;
+    }
+    uint32_t lastFrame = current - 1;
+    ImGui::PushItemWidth(ImGui::GetFontSize() * 10);
+    ImGui::SliderInt("Frames shown", &profilerShownFrames, 1, PROFILER_MAX_SHOWN);
+    ImGui::SameLine();
+    ImGui::SliderInt("Frames exported", &profilerCaptureFrames, 1, PROFILER_MAX_FRAMES - 1);
+    ImGui::SameLine();
+    if (ImGui::Button("Export trace"))
+    {
+        Profiler_ExportChromeTrace(PROFILER_TRACE_FILE, (uint32_t)profilerCaptureFrames);
+    }
+    uint32_t shown = (uint32_t)profilerShownFrames < lastFrame ? (uint32_t)profilerShownFrames : lastFrame;
+    uint32_t firstFrame = lastFrame - shown + 1;
+    uint64_t rangeStart = profilerFrameStart[firstFrame % PROFILER_MAX_FRAMES];
+    uint64_t rangeEnd   = profilerFrameStart[current % PROFILER_MAX_FRAMES];
+    if (rangeEnd <= rangeStart)
+    {
+        ImGui::End();
+        return;
+    }
+    ImGui::Text("Frame %u: %.3f ms", lastFrame,
+                (rangeEnd - profilerFrameStart[lastFrame % PROFILER_MAX_FRAMES]) / 1000000.0);
+
+    // one icicle graph per thread, a row per nesting depth, time on the x axis
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2      origin   = ImGui::GetCursorScreenPos();
+    float       width    = ImGui::GetContentRegionAvail().x;
+    double      scale    = width / (double)(rangeEnd - rangeStart);
+    float       y        = origin.y;
+    uint32_t    threads  = profilerThreadCount.load();
+    if (threads > PROFILER_MAX_THREADS)
+    {
+        threads = PROFILER_MAX_THREADS;
+    }
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        ProfilerThread* thread   = &profilerThreads[t];
+        uint32_t        head     = thread->head.load(std::memory_order_acquire);
+        uint32_t        begin    = head > PROFILER_MAX_EVENTS ? head - PROFILER_MAX_EVENTS : 0;
+        uint32_t        maxDepth = 0;
+        char            label[16];
+        snprintf(label, sizeof(label), "Thread %u", t);
+        drawList->AddText(ImVec2(origin.x, y), IM_COL32(200, 200, 200, 255), label);
+        y += PROFILER_ROW_HEIGHT;
+        for (uint32_t i = begin; i < head; i++)
+        {
+            ProfilerEvent event;
+            if (!Profiler_ReadEvent(thread, i, &event) || event.end <= rangeStart || event.start >= rangeEnd)
+            {
+                continue;
+            }
+            uint64_t start = event.start > rangeStart ? event.start : rangeStart;
+            uint64_t end   = event.end < rangeEnd ? event.end : rangeEnd;
+            ImVec2   min(origin.x + (float)((start - rangeStart) * scale), y + event.depth * PROFILER_ROW_HEIGHT);
+            ImVec2   max(origin.x + (float)((end - rangeStart) * scale), min.y + PROFILER_ROW_HEIGHT - 1.0f);
+            if (max.x - min.x < 1.0f)
+            {
+                max.x = min.x + 1.0f;
+            }
+            drawList->AddRectFilled(min, max, Profiler_ZoneColor(event.name));
+            if (max.x - min.x > 24.0f)
+            {
+                drawList->PushClipRect(min, max, true);
+                drawList->AddText(ImVec2(min.x + 2.0f, min.y + 1.0f), IM_COL32(0, 0, 0, 255), event.name);
+                drawList->PopClipRect();
+            }
+            if (ImGui::IsMouseHoveringRect(min, max))
+            {
+                ImGui::SetTooltip("%s\n%.3f ms (frame %u)", event.name, (event.end - event.start) / 1000000.0,
+                                  event.frame);
+            }
+            if (event.depth + 1u > maxDepth)
+            {
+                maxDepth = event.depth + 1u;
+            }
+        }
+        y += maxDepth * PROFILER_ROW_HEIGHT;
+    }
+    for (uint32_t f = firstFrame + 1; f <= lastFrame; f++)
+    {
+        float x = origin.x + (float)((profilerFrameStart[f % PROFILER_MAX_FRAMES] - rangeStart) * scale);
+        drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, y), IM_COL32(255, 255, 255, 120));
+    }
+    ImGui::Dummy(ImVec2(width, y - origin.y));
+    ImGui::End();
+}
+#else
+void Profiler_BeginFrame()
+{
+}
+
+void Profiler_BeginZone(const char* name)
+{
+}
+
+void Profiler_EndZone()
+{
+}
+
+bool Profiler_ExportChromeTrace(const char* fileName, uint32_t frameCount)
+{
+    return false;
+}
+
+void Debug_ShowProfilerWindow()
+{
+}
+#endif
+
+// side of the benchmark scene, it grows with the collider count so density stays the same
+#define BENCHMARK_WORLD_SIZE(count) ((int32_t)(sqrtf((float)(count)) * 64.0f))
+
+// Scatters count colliders over a worldSize square, the scene every benchmark runs on. NULL when out of memory.
+static Collider2D* Debug_ScatterColliders(uint32_t count, int32_t worldSize)
+{
+    Collider2D* colliders = (Collider2D*)malloc(count * sizeof(Collider2D));
+    for (uint32_t i = 0; colliders != NULL && i < count; i++)
+    {
+        Collider2D_Initialize(&colliders[i]);
+        colliders[i].position.x = (float)GetRandomValue(0, worldSize);
+        colliders[i].position.y = (float)GetRandomValue(0, worldSize);
+        colliders[i].size.x     = (float)GetRandomValue(8, 32);
+        colliders[i].size.y     = (float)GetRandomValue(8, 32);
+    }
+    return colliders;
+}
+
+static void Debug_BenchmarkSpatialHash(uint32_t count, char* result)
+{
+    Collider2D* colliders = Debug_ScatterColliders(count, BENCHMARK_WORLD_SIZE(count));
+    uint32_t*   proxies   = (uint32_t*)malloc(count * sizeof(uint32_t));
+    SpatialHash hash;
+    if (colliders == NULL || proxies == NULL || !SpatialHash_Initialize(&hash, 64.0f, count * 2))
+    {
+        snprintf(result, BENCHMARK_RESULT_SIZE, "%u colliders: out of memory", count);
+        free(colliders);
+        free(proxies);
+        return;
+    }
+    double start = GetTime();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        proxies[i] = SpatialHash_Insert(&hash, &colliders[i]);
+    }
+    double insertTime = GetTime() - start;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        colliders[i].position.x += (float)GetRandomValue(-4, 4);
+        colliders[i].position.y += (float)GetRandomValue(-4, 4);
+    }
+    start = GetTime();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SpatialHash_Update(&hash, proxies[i]);
+    }
+    double   updateTime = GetTime() - start;
+    start               = GetTime();
+    uint32_t pairs      = SpatialHash_ForEachPair(&hash, NULL, NULL);
+    double   pairTime   = GetTime() - start;
+    int      written    = snprintf(result, BENCHMARK_RESULT_SIZE,
+                                   "%u colliders: insert %.2f ms, update %.2f ms, %u pairs in %.2f ms", count,
+                                   insertTime * 1000.0, updateTime * 1000.0, pairs, pairTime * 1000.0);
+    if (count <= BENCHMARK_BRUTE_MAX && written > 0 && written < BENCHMARK_RESULT_SIZE)
+    {
+        uint32_t brutePairs = 0;
+        start               = GetTime();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t j = i + 1; j < count; j++)
+            {
+                brutePairs += Collider2D_CheckCollider(&colliders[i], &colliders[j]);
+            }
+        }
+        snprintf(result + written, BENCHMARK_RESULT_SIZE - written, ", brute force %u in %.2f ms", brutePairs,
+                 (GetTime() - start) * 1000.0);
+    }
+    LOG_INF("Benchmark: %s", result);
+    SpatialHash_Deinitialize(&hash);
+    free(proxies);
+    free(colliders);
+}
+
+// Same scene as the spatial hash benchmark, then a few frames of small coherent motion, which is the case the
+// incremental sort is meant for.
+static void Debug_BenchmarkSweepAndPrune(uint32_t count, char* result)
+{
+    Collider2D*   colliders = Debug_ScatterColliders(count, BENCHMARK_WORLD_SIZE(count));
+    SweepAndPrune sap;
+    if (colliders == NULL || !SweepAndPrune_Initialize(&sap))
+    {
+        snprintf(result, BENCHMARK_RESULT_SIZE, "%u colliders: out of memory", count);
+        free(colliders);
+        return;
+    }
+    double start = GetTime();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SweepAndPrune_Insert(&sap, &colliders[i]);
+    }
+    SweepAndPrune_BuildEvents(&sap);
+    double   insertTime = GetTime() - start;
+    double   updateTime = 0.0;
+    uint32_t events     = 0;
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            colliders[i].position.x += (float)GetRandomValue(-2, 2);
+            colliders[i].position.y += (float)GetRandomValue(-2, 2);
+        }
+        start = GetTime();
+        SweepAndPrune_UpdateAll(&sap);
+        events += SweepAndPrune_BuildEvents(&sap);
+        updateTime += GetTime() - start;
+    }
+    snprintf(result, BENCHMARK_RESULT_SIZE, "%u colliders: insert %.2f ms, update + events %.2f ms/frame, %u pairs",
+             count, insertTime * 1000.0, updateTime * 1000.0 / BENCHMARK_FRAMES, SweepAndPrune_GetPairCount(&sap));
+    LOG_INF("Benchmark: %s (%u events)", result, events);
+    SweepAndPrune_Deinitialize(&sap);
+    free(colliders);
+}
+
+typedef struct DebugTreeQuery
+{
+    Rectangle rect;
+    uint32_t  hits;
+} DebugTreeQuery;
+
+static bool Debug_CountTreeHit(uint32_t proxy, void* userData, void* context)
+{
+    DebugTreeQuery* query = (DebugTreeQuery*)context;
+    query->hits += Collider2D_CheckRect((Collider2D*)userData, query->rect);
+    return true;
+}
+
+// Rect queries through the tree against testing every collider with Collider2D_CheckRect.
+static void Debug_BenchmarkAabbTree(uint32_t count, char* result)
+{
+    int32_t     worldSize = BENCHMARK_WORLD_SIZE(count);
+    Collider2D* colliders = Debug_ScatterColliders(count, worldSize);
+    AabbTree    tree;
+    if (colliders == NULL || !AabbTree_Initialize(&tree, AABBTREE_DEFAULT_MARGIN))
+    {
+        snprintf(result, BENCHMARK_RESULT_SIZE, "%u colliders: out of memory", count);
+        free(colliders);
+        return;
+    }
+    double start = GetTime();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        AabbTree_Insert(&tree, Collider2D_GetBounds(&colliders[i]), &colliders[i]);
+    }
+    double         buildTime  = GetTime() - start;
+    DebugTreeQuery query      = { { 0.0f, 0.0f, 128.0f, 128.0f }, 0 };
+    uint32_t       linearHits = 0;
+    double         treeTime   = 0.0;
+    double         linearTime = 0.0;
+    for (uint32_t q = 0; q < BENCHMARK_QUERIES; q++)
+    {
+        query.rect.x = (float)GetRandomValue(0, worldSize);
+        query.rect.y = (float)GetRandomValue(0, worldSize);
+        start        = GetTime();
+        AabbTree_QueryRect(&tree, query.rect, Debug_CountTreeHit, &query);
+        treeTime += GetTime() - start;
+        start = GetTime();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            linearHits += Collider2D_CheckRect(&colliders[i], query.rect);
+        }
+        linearTime += GetTime() - start;
+    }
+    snprintf(result, BENCHMARK_RESULT_SIZE,
+             "%u colliders: build %.2f ms (height %d), %d queries tree %.2f ms / linear %.2f ms, hits %u / %u", count,
+             buildTime * 1000.0, AabbTree_GetHeight(&tree), BENCHMARK_QUERIES, treeTime * 1000.0, linearTime * 1000.0,
+             query.hits, linearHits);
+    LOG_INF("Benchmark: %s", result);
+    AabbTree_Deinitialize(&tree);
+    free(colliders);
+}
+
+// One moving box tested against every collider, the pattern game2 uses for the player against the platforms, with the
+// pointer-chasing Collider2D loop, the scalar batch loop and the SIMD batch kernel.
+static void Debug_BenchmarkAabbBatch(uint32_t count, char* result)
+{
+    int32_t     worldSize = BENCHMARK_WORLD_SIZE(count);
+    Collider2D* colliders = Debug_ScatterColliders(count, worldSize);
+    uint32_t*   hitMask   = (uint32_t*)malloc(AABBBATCH_MASK_WORDS(count) * sizeof(uint32_t));
+    AabbBatch   batch;
+    if (colliders == NULL || hitMask == NULL || !AabbBatch_Initialize(&batch, count))
+    {
+        snprintf(result, BENCHMARK_RESULT_SIZE, "%u colliders: out of memory", count);
+        free(colliders);
+        free(hitMask);
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        AabbBatch_AddCollider(&batch, &colliders[i]);
+    }
+    Collider2D probe;
+    Collider2D_Initialize(&probe);
+    probe.size.x          = 128.0f;
+    probe.size.y          = 128.0f;
+    uint32_t colliderHits = 0;
+    uint32_t scalarHits   = 0;
+    uint32_t batchHits    = 0;
+    double   colliderTime = 0.0;
+    double   scalarTime   = 0.0;
+    double   batchTime    = 0.0;
+    for (uint32_t q = 0; q < BENCHMARK_QUERIES; q++)
+    {
+        probe.position.x = (float)GetRandomValue(0, worldSize);
+        probe.position.y = (float)GetRandomValue(0, worldSize);
+        Rectangle box    = Collider2D_GetBounds(&probe);
+        double    start  = GetTime();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            colliderHits += Collider2D_CheckCollider(&probe, &colliders[i]);
+        }
+        colliderTime += GetTime() - start;
+        start = GetTime();
+        scalarHits += AabbBatch_OverlapScalar(&batch, box, hitMask);
+        scalarTime += GetTime() - start;
+        start = GetTime();
+        batchHits += AabbBatch_Overlap(&batch, box, hitMask);
+        batchTime += GetTime() - start;
+    }
+    snprintf(result, BENCHMARK_RESULT_SIZE,
+             "%u colliders, %d queries: Collider2D %.2f ms, scalar %.2f ms, %s %.2f ms, hits %u / %u / %u", count,
+             BENCHMARK_QUERIES, colliderTime * 1000.0, scalarTime * 1000.0, AabbBatch_GetKernelName(),
+             batchTime * 1000.0, colliderHits, scalarHits, batchHits);
+    LOG_INF("Benchmark: %s", result);
+    AabbBatch_Deinitialize(&batch);
+    free(hitMask);
+    free(colliders);
+}
+
 static void Debug_ShowMisc(Entity2D* ent, uint32_t entSize, Sprite* spr, uint32_t sprSize, Collider2D* col,
                            uint32_t colSize, TextureData* tex, uint32_t texSize, AnimatedSprite* anim,
                            uint32_t animSize, AudioData* aud, uint32_t audSize)
@@ -30,6 +628,9 @@ static void Debug_ShowMisc(Entity2D* ent, uint32_t entSize, Sprite* spr, uint32_
                     ImGui::Text("Entity scale: %f", current->scale);
                     ImGui::Text("Entity rotation: %f", current->rotation);
                     ImGui::Text("Entity id: %d", current->id);
+                    const Transform2D* world = Entity2D_GetWorld(current);
+                    ImGui::Text("World: {%f, %f } scale %f rotation %f (version %u)", world->position.x,
+                                world->position.y, world->scale, world->rotation, current->version);
                 }
             }
             ImGui::TreePop();
@@ -226,6 +827,87 @@ static void Debug_ShowMisc(Entity2D* ent, uint32_t entSize, Sprite* spr, uint32_
     {
         ImGui::Text("Delta time: %f", DeltaTime_GetDeltaTime());
     }
+    if (ImGui::CollapsingHeader("Frame arena"))
+    {
+        ImGui::Text("Used: %u / %u bytes", (uint32_t)FrameArena_GetUsed(), (uint32_t)FrameArena_GetCapacity());
+        ImGui::Text("High water mark: %u bytes", (uint32_t)FrameArena_GetHighWaterMark());
+    }
+    if (ImGui::CollapsingHeader("ECS"))
+    {
+        ImGui::Text("Entities: %u  Archetypes: %d", Ecs_GetEntityCount(), Ecs_GetArchetypeCount());
+        for (uint16_t i = 0; i < Ecs_GetArchetypeCount(); i++)
+        {
+            EcsArchetype* archetype = Ecs_GetArchetype(i);
+            ImGui::Text("0x%08x  %6u entities  %4d chunks of %d", archetype->mask, archetype->entityCount,
+                        archetype->chunkCount, archetype->chunkCapacity);
+        }
+    }
+    if (ImGui::CollapsingHeader("Benchmarks"))
+    {
+        static const uint32_t benchmarkCounts[]                            = { 1000, 10000, 50000 };
+        static char           spatialHashResults[3][BENCHMARK_RESULT_SIZE] = { { 0 } };
+        if (ImGui::Button("Spatial hash broadphase"))
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                Debug_BenchmarkSpatialHash(benchmarkCounts[i], spatialHashResults[i]);
+            }
+        }
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            ImGui::TextUnformatted(spatialHashResults[i]);
+        }
+        static char sweepAndPruneResults[3][BENCHMARK_RESULT_SIZE] = { { 0 } };
+        if (ImGui::Button("Sweep and prune broadphase"))
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                Debug_BenchmarkSweepAndPrune(benchmarkCounts[i], sweepAndPruneResults[i]);
+            }
+        }
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            ImGui::TextUnformatted(sweepAndPruneResults[i]);
+        }
+        static char aabbTreeResults[3][BENCHMARK_RESULT_SIZE] = { { 0 } };
+        if (ImGui::Button("AABB tree queries"))
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                Debug_BenchmarkAabbTree(benchmarkCounts[i], aabbTreeResults[i]);
+            }
+        }
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            ImGui::TextUnformatted(aabbTreeResults[i]);
+        }
+        static const uint32_t batchCounts[]                              = { 1000, 10000, 100000 };
+        static char           aabbBatchResults[3][BENCHMARK_RESULT_SIZE] = { { 0 } };
+        if (ImGui::Button("SIMD batch overlap"))
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                Debug_BenchmarkAabbBatch(batchCounts[i], aabbBatchResults[i]);
+            }
+        }
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            ImGui::TextUnformatted(aabbBatchResults[i]);
+        }
+    }
+    if (ImGui::CollapsingHeader("Updatables"))
+    {
+        static const char* phaseNames[] = { "PRE_UPDATE", "UPDATE", "POST_UPDATE", "PRE_RENDER" };
+        ImGui::Text("Updatable count: %d", Context_GetUpdatableCount());
+        for (uint32_t i = 0; i < Context_GetUpdatableCount(); i++)
+        {
+            Updatable* current = Context_GetUpdatable(i);
+            ImGui::Text("%-24s %-11s prio %4d  every %2d  %s  last %.3f ms  avg %.3f ms",
+                        current->name ? current->name : "(unnamed)", phaseNames[current->phase], current->priority,
+                        current->frequencyDivisor, current->isEnabled ? "on " : "off", current->lastTime * 1000.0,
+                        current->averageTime * 1000.0);
+        }
+    }
 }
 
 void Debug_ShowDebugWindow(Entity2D* ent, uint32_t entSize, Sprite* spr, uint32_t sprSize, Collider2D* col,
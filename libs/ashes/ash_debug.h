@@ -3,6 +3,12 @@
 
 #include "ash_components.h"
 
+#define PROFILER_MAX_THREADS     8
+#define PROFILER_MAX_EVENTS      16384  /* per thread ring buffer */
+#define PROFILER_MAX_DEPTH       32
+#define PROFILER_MAX_FRAMES      256
+#define PROFILER_DEFAULT_CAPTURE 120
+
 #define LOG_LEVEL_DEBUG   4
 #define LOG_LEVEL_INFO    3
 #define LOG_LEVEL_WARNING 2
@@ -43,9 +49,55 @@
 #    define LOG_ERR(...) (void)0
 #endif
 
+#ifdef DEBUG
+#    define PROFILER_ENABLED
+#endif
+
+#ifdef PROFILER_ENABLED
+#    define PROFILE_CONCAT_INNER(a, b) a##b
+#    define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+#    define PROFILE_ZONE(name)         ProfilerZone PROFILE_CONCAT(profilerZone, __LINE__)(name)
+#    define PROFILE_FUNCTION()         PROFILE_ZONE(__FUNCTION__)
+#    define PROFILE_BEGIN(name)        Profiler_BeginZone(name)
+#    define PROFILE_END()              Profiler_EndZone()
+#    define PROFILE_FRAME()            Profiler_BeginFrame()
+#else
+#    define PROFILE_ZONE(name)  (void)0
+#    define PROFILE_FUNCTION()  (void)0
+#    define PROFILE_BEGIN(name) (void)0
+#    define PROFILE_END()       (void)0
+#    define PROFILE_FRAME()     (void)0
+#endif
+
+/* Structs, Enums, and Unions */
+typedef struct ProfilerEvent
+{
+    const char* name;  /* must outlive the profiler, string literals or static names */
+    uint64_t    start; /* nanoseconds since profiler start */
+    uint64_t    end;
+    uint32_t    frame;
+    uint8_t     depth;
+} ProfilerEvent;
+
+/* Function Prototypes */
 void Logger_Init();
 void Logger_Deinit();
 
+void Profiler_BeginFrame();
+void Profiler_BeginZone(const char* name);
+void Profiler_EndZone();
+bool Profiler_ExportChromeTrace(const char* fileName, uint32_t frameCount);
+
+#ifdef PROFILER_ENABLED
+struct ProfilerZone
+{
+    ProfilerZone(const char* name) { Profiler_BeginZone(name); }
+    ~ProfilerZone() { Profiler_EndZone(); }
+};
+#endif
+
+void Debug_ShowProfilerWindow();
+
 void Debug_ShowDebugWindow(Entity2D* ent, uint32_t entSize, Sprite* spr, uint32_t sprSize, Collider2D* col,
                            uint32_t colSize, TextureData* tex, uint32_t texSize, AnimatedSprite* anim,
                            uint32_t animSize, AudioData* aud, uint32_t audSize);
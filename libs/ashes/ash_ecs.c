@@ -0,0 +1,675 @@
+#include "ash_ecs.h"
+
+#include "ash_debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ECS_MAX_ALIGNMENT   16
+#define ECS_ARCHETYPE_NONE  0xFFFF
+
+typedef enum EcsEntityState
+{
+    ECS_ENTITY_FREE,
+    ECS_ENTITY_RESERVED,  /* id handed out by a command buffer, created on flush */
+    ECS_ENTITY_ALIVE,
+} EcsEntityState;
+
+typedef struct EcsEntityRecord
+{
+    uint16_t generation;
+    uint16_t archetype;
+    uint16_t chunk;
+    uint16_t row;
+    uint8_t  state;
+} EcsEntityRecord;
+
+static EcsComponentInfo components[ECS_MAX_COMPONENTS];
+static EcsArchetype     archetypes[ECS_MAX_ARCHETYPES];
+static EcsQuery         queries[ECS_MAX_QUERIES];
+static EcsEntityRecord* records        = NULL;
+static uint16_t*        freeIndices    = NULL;
+static uint32_t         freeCount      = 0;
+static uint32_t         usedIndices    = 0;  /* indices below this were handed out at least once */
+static uint32_t         aliveCount     = 0;
+static uint8_t          componentCount = 0;
+static uint16_t         archetypeCount = 0;
+static uint8_t          queryCount     = 0;
+
+static inline uint32_t Ecs_EntityIndex(EcsEntity entity)
+{
+    return entity & ECS_ENTITY_INDEX_MASK;
+}
+
+static inline uint16_t Ecs_EntityGeneration(EcsEntity entity)
+{
+    return (uint16_t)(entity >> ECS_ENTITY_INDEX_BITS);
+}
+
+static EcsEntityRecord* Ecs_GetRecord(EcsEntity entity, uint8_t state)
+{
+    if (records == NULL || entity == ECS_ENTITY_NULL)
+    {
+        return NULL;
+    }
+    EcsEntityRecord* record = &records[Ecs_EntityIndex(entity)];
+    if (record->state != state || record->generation != Ecs_EntityGeneration(entity))
+    {
+        return NULL;
+    }
+    return record;
+}
+
+static EcsEntity Ecs_AllocateIndex()
+{
+    uint32_t index;
+    if (freeCount != 0)
+    {
+        index = freeIndices[--freeCount];
+    }
+    else if (usedIndices < ECS_MAX_ENTITIES)
+    {
+        index                     = usedIndices++;
+        records[index].generation = 1;
+    }
+    else
+    {
+        LOG_ERR("Ecs: out of entity ids");
+        return ECS_ENTITY_NULL;
+    }
+    records[index].state     = ECS_ENTITY_RESERVED;
+    records[index].archetype = ECS_ARCHETYPE_NONE;
+    return ((EcsEntity)records[index].generation << ECS_ENTITY_INDEX_BITS) | index;
+}
+
+static void Ecs_FreeIndex(uint32_t index)
+{
+    EcsEntityRecord* record = &records[index];
+    record->state           = ECS_ENTITY_FREE;
+    record->archetype       = ECS_ARCHETYPE_NONE;
+    // generation 0 is skipped so a valid entity id is never ECS_ENTITY_NULL
+    record->generation = (uint16_t)((record->generation + 1) & ECS_ENTITY_GEN_MASK);
+    if (record->generation == 0)
+    {
+        record->generation = 1;
+    }
+    freeIndices[freeCount++] = (uint16_t)index;
+}
+
+// Lays the columns out back to back, entity ids first, and picks the largest capacity that fits a chunk.
+static bool Ecs_LayoutArchetype(EcsArchetype* archetype)
+{
+    uint32_t bytesPerEntity = sizeof(EcsEntity);
+    for (uint8_t i = 0; i < componentCount; i++)
+    {
+        if (archetype->mask & Ecs_ComponentBit(i))
+        {
+            bytesPerEntity += components[i].size;
+        }
+    }
+    uint32_t capacity = ECS_CHUNK_SIZE / bytesPerEntity;
+    while (capacity > 0)
+    {
+        uint32_t offset = sizeof(EcsEntity) * capacity;
+        for (uint8_t i = 0; i < componentCount; i++)
+        {
+            if (!(archetype->mask & Ecs_ComponentBit(i)))
+            {
+                continue;
+            }
+            uint32_t alignment         = components[i].alignment;
+            offset                     = (offset + alignment - 1) & ~(alignment - 1);
+            archetype->columnOffset[i] = (uint16_t)offset;
+            offset += components[i].size * capacity;
+        }
+        if (offset <= ECS_CHUNK_SIZE)
+        {
+            break;
+        }
+        capacity--;
+    }
+    if (capacity == 0)
+    {
+        LOG_ERR("Ecs: archetype 0x%08x does not fit in a chunk", archetype->mask);
+        return false;
+    }
+    archetype->chunkCapacity = (uint16_t)(capacity > 0xFFFF ? 0xFFFF : capacity);
+    return true;
+}
+
+static uint16_t Ecs_FindArchetype(EcsComponentMask mask)
+{
+    for (uint16_t i = 0; i < archetypeCount; i++)
+    {
+        if (archetypes[i].mask == mask)
+        {
+            return i;
+        }
+    }
+    if (archetypeCount >= ECS_MAX_ARCHETYPES)
+    {
+        LOG_ERR("Ecs: out of archetypes");
+        return ECS_ARCHETYPE_NONE;
+    }
+    EcsArchetype* archetype = &archetypes[archetypeCount];
+    memset(archetype, 0, sizeof(EcsArchetype));
+    archetype->mask = mask;
+    if (!Ecs_LayoutArchetype(archetype))
+    {
+        return ECS_ARCHETYPE_NONE;
+    }
+    return archetypeCount++;
+}
+
+static void* Ecs_ChunkComponent(EcsArchetype* archetype, EcsChunk* chunk, EcsComponentId id, uint16_t row)
+{
+    return chunk->data + archetype->columnOffset[id] + (uint32_t)components[id].size * row;
+}
+
+// Takes the next free row of the archetype, only the last chunk is ever partially filled.
+static bool Ecs_PushRow(uint16_t archetypeIndex, EcsEntity entity)
+{
+    EcsArchetype* archetype = &archetypes[archetypeIndex];
+    if (archetype->chunkCount == 0 || archetype->chunks[archetype->chunkCount - 1].count == archetype->chunkCapacity)
+    {
+        if (archetype->chunkCount == archetype->chunkAllocated)
+        {
+            uint16_t  allocated = archetype->chunkAllocated == 0 ? 4 : archetype->chunkAllocated * 2;
+            EcsChunk* grown     = (EcsChunk*)realloc(archetype->chunks, allocated * sizeof(EcsChunk));
+            if (grown == NULL)
+            {
+                LOG_ERR("Ecs: out of memory for chunk list");
+                return false;
+            }
+            memset(grown + archetype->chunkAllocated, 0, (allocated - archetype->chunkAllocated) * sizeof(EcsChunk));
+            archetype->chunks         = grown;
+            archetype->chunkAllocated = allocated;
+        }
+        EcsChunk* chunk = &archetype->chunks[archetype->chunkCount];
+        // emptied chunks keep their memory and are reused here
+        if (chunk->data == NULL)
+        {
+            chunk->data = (uint8_t*)malloc(ECS_CHUNK_SIZE);
+            if (chunk->data == NULL)
+            {
+                LOG_ERR("Ecs: out of memory for chunk");
+                return false;
+            }
+            chunk->entities = (EcsEntity*)chunk->data;
+        }
+        chunk->count = 0;
+        archetype->chunkCount++;
+    }
+    uint16_t         chunkIndex = archetype->chunkCount - 1;
+    EcsChunk*        chunk      = &archetype->chunks[chunkIndex];
+    EcsEntityRecord* record     = &records[Ecs_EntityIndex(entity)];
+    chunk->entities[chunk->count] = entity;
+    record->archetype             = archetypeIndex;
+    record->chunk                 = chunkIndex;
+    record->row                   = chunk->count;
+    chunk->count++;
+    archetype->entityCount++;
+    return true;
+}
+
+// Fills the hole with the last row of the archetype so the chunks stay dense.
+static void Ecs_RemoveRow(uint16_t archetypeIndex, uint16_t chunkIndex, uint16_t row)
+{
+    EcsArchetype* archetype = &archetypes[archetypeIndex];
+    EcsChunk*     chunk     = &archetype->chunks[chunkIndex];
+    EcsChunk*     last      = &archetype->chunks[archetype->chunkCount - 1];
+    uint16_t      lastRow   = last->count - 1;
+    if (chunk != last || row != lastRow)
+    {
+        EcsEntity moved      = last->entities[lastRow];
+        chunk->entities[row] = moved;
+        for (uint8_t i = 0; i < componentCount; i++)
+        {
+            if ((archetype->mask & Ecs_ComponentBit(i)) && components[i].size != 0)
+            {
+                memcpy(Ecs_ChunkComponent(archetype, chunk, i, row), Ecs_ChunkComponent(archetype, last, i, lastRow),
+                       components[i].size);
+            }
+        }
+        EcsEntityRecord* record = &records[Ecs_EntityIndex(moved)];
+        record->chunk           = chunkIndex;
+        record->row             = row;
+    }
+    last->count--;
+    if (last->count == 0)
+    {
+        archetype->chunkCount--;
+    }
+    archetype->entityCount--;
+}
+
+// Moves an alive entity to the archetype of newMask, copying the shared components and zeroing the new ones.
+static bool Ecs_MoveEntity(EcsEntity entity, EcsComponentMask newMask)
+{
+    EcsEntityRecord* record      = &records[Ecs_EntityIndex(entity)];
+    uint16_t         destination = Ecs_FindArchetype(newMask);
+    if (destination == ECS_ARCHETYPE_NONE)
+    {
+        return false;
+    }
+    uint16_t source      = record->archetype;
+    uint16_t sourceChunk = record->chunk;
+    uint16_t sourceRow   = record->row;
+    if (!Ecs_PushRow(destination, entity))
+    {
+        return false;
+    }
+    EcsArchetype* from = &archetypes[source];
+    EcsArchetype* to   = &archetypes[destination];
+    EcsChunk*     src  = &from->chunks[sourceChunk];
+    EcsChunk*     dst  = &to->chunks[record->chunk];
+    for (uint8_t i = 0; i < componentCount; i++)
+    {
+        if (!(newMask & Ecs_ComponentBit(i)) || components[i].size == 0)
+        {
+            continue;
+        }
+        void* target = Ecs_ChunkComponent(to, dst, i, record->row);
+        if (from->mask & Ecs_ComponentBit(i))
+        {
+            memcpy(target, Ecs_ChunkComponent(from, src, i, sourceRow), components[i].size);
+        }
+        else
+        {
+            memset(target, 0, components[i].size);
+        }
+    }
+    Ecs_RemoveRow(source, sourceChunk, sourceRow);
+    return true;
+}
+
+void Ecs_Initialize()
+{
+    Ecs_Deinitialize();
+    records     = (EcsEntityRecord*)calloc(ECS_MAX_ENTITIES, sizeof(EcsEntityRecord));
+    freeIndices = (uint16_t*)malloc(ECS_MAX_ENTITIES * sizeof(uint16_t));
+    if (records == NULL || freeIndices == NULL)
+    {
+        LOG_ERR("Ecs: Initialize() failed, out of memory");
+        Ecs_Deinitialize();
+    }
+}
+
+void Ecs_Deinitialize()
+{
+    for (uint16_t i = 0; i < archetypeCount; i++)
+    {
+        for (uint16_t j = 0; j < archetypes[i].chunkAllocated; j++)
+        {
+            free(archetypes[i].chunks[j].data);
+        }
+        free(archetypes[i].chunks);
+    }
+    free(records);
+    free(freeIndices);
+    records        = NULL;
+    freeIndices    = NULL;
+    freeCount      = 0;
+    usedIndices    = 0;
+    aliveCount     = 0;
+    componentCount = 0;
+    archetypeCount = 0;
+    queryCount     = 0;
+}
+
+EcsComponentId Ecs_RegisterComponent(const char* name, uint16_t size, uint16_t alignment)
+{
+    if (componentCount >= ECS_MAX_COMPONENTS)
+    {
+        LOG_ERR("Ecs: RegisterComponent() failed, too many components");
+        return ECS_COMPONENT_INVALID;
+    }
+    if (alignment == 0 || alignment > ECS_MAX_ALIGNMENT || (alignment & (alignment - 1)) != 0)
+    {
+        LOG_ERR("Ecs: RegisterComponent() failed, unsupported alignment %d for %s", alignment, name);
+        return ECS_COMPONENT_INVALID;
+    }
+    if (archetypeCount != 0)
+    {
+        LOG_WRN("Ecs: component %s registered after archetypes were created", name);
+    }
+    components[componentCount].name      = name;
+    components[componentCount].size      = size;
+    components[componentCount].alignment = alignment;
+    return componentCount++;
+}
+
+const EcsComponentInfo* Ecs_GetComponentInfo(EcsComponentId id)
+{
+    return id < componentCount ? &components[id] : NULL;
+}
+
+EcsEntity Ecs_CreateEntity(EcsComponentMask mask)
+{
+    if (records == NULL)
+    {
+        LOG_ERR("Ecs: CreateEntity() failed, not initialized");
+        return ECS_ENTITY_NULL;
+    }
+    uint16_t archetypeIndex = Ecs_FindArchetype(mask);
+    if (archetypeIndex == ECS_ARCHETYPE_NONE)
+    {
+        return ECS_ENTITY_NULL;
+    }
+    EcsEntity entity = Ecs_AllocateIndex();
+    if (entity == ECS_ENTITY_NULL)
+    {
+        return ECS_ENTITY_NULL;
+    }
+    if (!Ecs_PushRow(archetypeIndex, entity))
+    {
+        Ecs_FreeIndex(Ecs_EntityIndex(entity));
+        return ECS_ENTITY_NULL;
+    }
+    EcsEntityRecord* record    = &records[Ecs_EntityIndex(entity)];
+    EcsArchetype*    archetype = &archetypes[archetypeIndex];
+    for (uint8_t i = 0; i < componentCount; i++)
+    {
+        if ((mask & Ecs_ComponentBit(i)) && components[i].size != 0)
+        {
+            memset(Ecs_ChunkComponent(archetype, &archetype->chunks[record->chunk], i, record->row), 0,
+                   components[i].size);
+        }
+    }
+    record->state = ECS_ENTITY_ALIVE;
+    aliveCount++;
+    return entity;
+}
+
+bool Ecs_DestroyEntity(EcsEntity entity)
+{
+    EcsEntityRecord* record = Ecs_GetRecord(entity, ECS_ENTITY_ALIVE);
+    if (record == NULL)
+    {
+        LOG_WRN("Ecs: DestroyEntity() failed, entity 0x%08x is not alive", entity);
+        return false;
+    }
+    Ecs_RemoveRow(record->archetype, record->chunk, record->row);
+    Ecs_FreeIndex(Ecs_EntityIndex(entity));
+    aliveCount--;
+    return true;
+}
+
+bool Ecs_IsAlive(EcsEntity entity)
+{
+    return Ecs_GetRecord(entity, ECS_ENTITY_ALIVE) != NULL;
+}
+
+bool Ecs_HasComponent(EcsEntity entity, EcsComponentId id)
+{
+    EcsEntityRecord* record = Ecs_GetRecord(entity, ECS_ENTITY_ALIVE);
+    return record != NULL && id < componentCount && (archetypes[record->archetype].mask & Ecs_ComponentBit(id));
+}
+
+void* Ecs_GetComponent(EcsEntity entity, EcsComponentId id)
+{
+    if (!Ecs_HasComponent(entity, id))
+    {
+        return NULL;
+    }
+    EcsEntityRecord* record    = &records[Ecs_EntityIndex(entity)];
+    EcsArchetype*    archetype = &archetypes[record->archetype];
+    return Ecs_ChunkComponent(archetype, &archetype->chunks[record->chunk], id, record->row);
+}
+
+void* Ecs_AddComponent(EcsEntity entity, EcsComponentId id)
+{
+    EcsEntityRecord* record = Ecs_GetRecord(entity, ECS_ENTITY_ALIVE);
+    if (record == NULL || id >= componentCount)
+    {
+        LOG_WRN("Ecs: AddComponent() failed, invalid entity or component");
+        return NULL;
+    }
+    EcsComponentMask mask = archetypes[record->archetype].mask;
+    if (!(mask & Ecs_ComponentBit(id)) && !Ecs_MoveEntity(entity, mask | Ecs_ComponentBit(id)))
+    {
+        return NULL;
+    }
+    return Ecs_GetComponent(entity, id);
+}
+
+bool Ecs_RemoveComponent(EcsEntity entity, EcsComponentId id)
+{
+    EcsEntityRecord* record = Ecs_GetRecord(entity, ECS_ENTITY_ALIVE);
+    if (record == NULL || id >= componentCount)
+    {
+        LOG_WRN("Ecs: RemoveComponent() failed, invalid entity or component");
+        return false;
+    }
+    EcsComponentMask mask = archetypes[record->archetype].mask;
+    if (!(mask & Ecs_ComponentBit(id)))
+    {
+        return true;
+    }
+    return Ecs_MoveEntity(entity, mask & ~Ecs_ComponentBit(id));
+}
+
+uint32_t Ecs_GetEntityCount()
+{
+    return aliveCount;
+}
+
+EcsQuery* Ecs_CreateQuery(EcsComponentMask all, EcsComponentMask none)
+{
+    // identical queries share their cache
+    for (uint8_t i = 0; i < queryCount; i++)
+    {
+        if (queries[i].all == all && queries[i].none == none)
+        {
+            return &queries[i];
+        }
+    }
+    if (queryCount >= ECS_MAX_QUERIES)
+    {
+        LOG_ERR("Ecs: CreateQuery() failed, too many queries");
+        return NULL;
+    }
+    EcsQuery* query = &queries[queryCount++];
+    memset(query, 0, sizeof(EcsQuery));
+    query->all  = all;
+    query->none = none;
+    return query;
+}
+
+void Ecs_QueryBegin(EcsQuery* query, EcsIterator* iterator)
+{
+    // only archetypes created since the last iteration have to be tested
+    for (; query->checkedArchetypes < archetypeCount; query->checkedArchetypes++)
+    {
+        EcsComponentMask mask = archetypes[query->checkedArchetypes].mask;
+        if ((mask & query->all) == query->all && (mask & query->none) == 0)
+        {
+            query->archetypes[query->archetypeCount++] = query->checkedArchetypes;
+        }
+    }
+    iterator->query          = query;
+    iterator->archetype      = NULL;
+    iterator->chunk          = NULL;
+    iterator->entities       = NULL;
+    iterator->count          = 0;
+    iterator->archetypeIndex = 0;
+    iterator->chunkIndex     = 0;
+}
+
+bool Ecs_QueryNext(EcsIterator* iterator)
+{
+    EcsQuery* query = iterator->query;
+    while (iterator->archetypeIndex < query->archetypeCount)
+    {
+        EcsArchetype* archetype = &archetypes[query->archetypes[iterator->archetypeIndex]];
+        if (iterator->chunkIndex < archetype->chunkCount)
+        {
+            iterator->archetype = archetype;
+            iterator->chunk     = &archetype->chunks[iterator->chunkIndex];
+            iterator->entities  = iterator->chunk->entities;
+            iterator->count     = iterator->chunk->count;
+            iterator->chunkIndex++;
+            return true;
+        }
+        iterator->archetypeIndex++;
+        iterator->chunkIndex = 0;
+    }
+    return false;
+}
+
+void* Ecs_IteratorColumn(EcsIterator* iterator, EcsComponentId id)
+{
+    if (iterator->chunk == NULL || id >= componentCount || !(iterator->archetype->mask & Ecs_ComponentBit(id)))
+    {
+        return NULL;
+    }
+    return iterator->chunk->data + iterator->archetype->columnOffset[id];
+}
+
+uint16_t Ecs_GetArchetypeCount()
+{
+    return archetypeCount;
+}
+
+EcsArchetype* Ecs_GetArchetype(uint16_t index)
+{
+    return index < archetypeCount ? &archetypes[index] : NULL;
+}
+
+void EcsCommandBuffer_Initialize(EcsCommandBuffer* buffer)
+{
+    buffer->count    = 0;
+    buffer->dataUsed = 0;
+}
+
+static EcsCommand* EcsCommandBuffer_Push(EcsCommandBuffer* buffer, EcsCommandType type, EcsEntity entity)
+{
+    if (buffer->count >= ECS_MAX_COMMANDS)
+    {
+        LOG_ERR("Ecs: command buffer is full");
+        return NULL;
+    }
+    EcsCommand* command = &buffer->commands[buffer->count++];
+    command->type       = type;
+    command->entity     = entity;
+    command->mask       = 0;
+    command->component  = ECS_COMPONENT_INVALID;
+    command->dataOffset = 0;
+    command->dataSize   = 0;
+    return command;
+}
+
+EcsEntity EcsCommandBuffer_Create(EcsCommandBuffer* buffer, EcsComponentMask mask)
+{
+    if (records == NULL || buffer->count >= ECS_MAX_COMMANDS)
+    {
+        LOG_ERR("Ecs: CommandBuffer_Create() failed");
+        return ECS_ENTITY_NULL;
+    }
+    EcsEntity entity = Ecs_AllocateIndex();
+    if (entity == ECS_ENTITY_NULL)
+    {
+        return ECS_ENTITY_NULL;
+    }
+    EcsCommandBuffer_Push(buffer, ECS_COMMAND_CREATE, entity)->mask = mask;
+    return entity;
+}
+
+bool EcsCommandBuffer_Destroy(EcsCommandBuffer* buffer, EcsEntity entity)
+{
+    return EcsCommandBuffer_Push(buffer, ECS_COMMAND_DESTROY, entity) != NULL;
+}
+
+bool EcsCommandBuffer_AddComponent(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentId id, const void* value)
+{
+    if (id >= componentCount)
+    {
+        LOG_WRN("Ecs: CommandBuffer_AddComponent() failed, invalid component");
+        return false;
+    }
+    uint16_t size   = value != NULL ? components[id].size : 0;
+    uint32_t offset = (buffer->dataUsed + ECS_MAX_ALIGNMENT - 1) & ~(uint32_t)(ECS_MAX_ALIGNMENT - 1);
+    if (offset + size > ECS_COMMAND_DATA_SIZE)
+    {
+        LOG_ERR("Ecs: command buffer data is full");
+        return false;
+    }
+    EcsCommand* command = EcsCommandBuffer_Push(buffer, ECS_COMMAND_ADD, entity);
+    if (command == NULL)
+    {
+        return false;
+    }
+    command->component = id;
+    if (size != 0)
+    {
+        memcpy(buffer->data + offset, value, size);
+        command->dataOffset = offset;
+        command->dataSize   = size;
+        buffer->dataUsed    = offset + size;
+    }
+    return true;
+}
+
+bool EcsCommandBuffer_RemoveComponent(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentId id)
+{
+    EcsCommand* command = EcsCommandBuffer_Push(buffer, ECS_COMMAND_REMOVE, entity);
+    if (command == NULL)
+    {
+        return false;
+    }
+    command->component = id;
+    return true;
+}
+
+// Applies the recorded commands in order, must not be called while a query is being iterated.
+void EcsCommandBuffer_Flush(EcsCommandBuffer* buffer)
+{
+    for (uint16_t i = 0; i < buffer->count; i++)
+    {
+        EcsCommand* command = &buffer->commands[i];
+        switch (command->type)
+        {
+            case ECS_COMMAND_CREATE:
+            {
+                EcsEntityRecord* record = Ecs_GetRecord(command->entity, ECS_ENTITY_RESERVED);
+                uint16_t         index  = record != NULL ? Ecs_FindArchetype(command->mask) : ECS_ARCHETYPE_NONE;
+                if (index == ECS_ARCHETYPE_NONE || !Ecs_PushRow(index, command->entity))
+                {
+                    if (record != NULL)
+                    {
+                        Ecs_FreeIndex(Ecs_EntityIndex(command->entity));
+                    }
+                    break;
+                }
+                EcsArchetype* archetype = &archetypes[index];
+                for (uint8_t j = 0; j < componentCount; j++)
+                {
+                    if ((command->mask & Ecs_ComponentBit(j)) && components[j].size != 0)
+                    {
+                        memset(Ecs_ChunkComponent(archetype, &archetype->chunks[record->chunk], j, record->row), 0,
+                               components[j].size);
+                    }
+                }
+                record->state = ECS_ENTITY_ALIVE;
+                aliveCount++;
+                break;
+            }
+            case ECS_COMMAND_DESTROY:
+                Ecs_DestroyEntity(command->entity);
+                break;
+            case ECS_COMMAND_ADD:
+            {
+                void* component = Ecs_AddComponent(command->entity, command->component);
+                if (component != NULL && command->dataSize != 0)
+                {
+                    memcpy(component, buffer->data + command->dataOffset, command->dataSize);
+                }
+                break;
+            }
+            case ECS_COMMAND_REMOVE:
+                Ecs_RemoveComponent(command->entity, command->component);
+                break;
+        }
+    }
+    EcsCommandBuffer_Initialize(buffer);
+}
@@ -0,0 +1,132 @@
+#ifndef ASH_ECS_H
+#define ASH_ECS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Defines */
+#define ECS_MAX_COMPONENTS       32
+#define ECS_MAX_ARCHETYPES       64
+#define ECS_MAX_QUERIES          32
+#define ECS_MAX_ENTITIES         65536
+#define ECS_CHUNK_SIZE           (16 * 1024) /* bytes per archetype chunk, all columns of the chunk included */
+#define ECS_MAX_COMMANDS         1024
+#define ECS_COMMAND_DATA_SIZE    (16 * 1024)
+#define ECS_ENTITY_NULL          0
+#define ECS_ENTITY_INDEX_BITS    16
+#define ECS_ENTITY_INDEX_MASK    ((1u << ECS_ENTITY_INDEX_BITS) - 1)
+#define ECS_ENTITY_GEN_MASK      ((1u << (32 - ECS_ENTITY_INDEX_BITS)) - 1)
+#define ECS_COMPONENT_INVALID    0xFF
+#define Ecs_ComponentBit(id)     ((EcsComponentMask)1u << (id))
+#define Ecs_RegisterComponentType(type) Ecs_RegisterComponent(#type, sizeof(type), alignof(type))
+#define Ecs_Column(iterator, type, id)  ((type*)Ecs_IteratorColumn((iterator), (id)))
+
+/* Structs, Enums, and Unions */
+typedef uint32_t EcsEntity;         /* slot index plus generation, ECS_ENTITY_NULL is never a live entity */
+typedef uint8_t  EcsComponentId;
+typedef uint32_t EcsComponentMask;  /* one bit per registered component */
+
+typedef struct EcsComponentInfo
+{
+    const char* name;
+    uint16_t    size;
+    uint16_t    alignment;
+} EcsComponentInfo;
+
+typedef struct EcsChunk
+{
+    uint8_t*   data;      /* ECS_CHUNK_SIZE bytes, one column per component of the archetype */
+    EcsEntity* entities;  /* first column of data */
+    uint16_t   count;
+} EcsChunk;
+
+typedef struct EcsArchetype
+{
+    EcsComponentMask mask;
+    uint16_t         chunkCapacity;                      /* entities per chunk */
+    uint16_t         columnOffset[ECS_MAX_COMPONENTS];  /* byte offset of each column inside a chunk */
+    EcsChunk*        chunks;
+    uint16_t         chunkCount;
+    uint16_t         chunkAllocated;
+    uint32_t         entityCount;
+} EcsArchetype;
+
+typedef struct EcsQuery
+{
+    EcsComponentMask all;   /* archetype needs every one of these */
+    EcsComponentMask none;  /* and none of these */
+    uint16_t         archetypes[ECS_MAX_ARCHETYPES];
+    uint16_t         archetypeCount;
+    uint16_t         checkedArchetypes;  /* archetypes created later are matched on the next iteration */
+} EcsQuery;
+
+typedef struct EcsIterator
+{
+    EcsQuery*     query;
+    EcsArchetype* archetype;
+    EcsChunk*     chunk;
+    EcsEntity*    entities;
+    uint16_t      count;  /* entities in the current chunk */
+    uint16_t      archetypeIndex;
+    uint16_t      chunkIndex;
+} EcsIterator;
+
+typedef enum EcsCommandType
+{
+    ECS_COMMAND_CREATE,
+    ECS_COMMAND_DESTROY,
+    ECS_COMMAND_ADD,
+    ECS_COMMAND_REMOVE,
+} EcsCommandType;
+
+typedef struct EcsCommand
+{
+    EcsCommandType   type;
+    EcsEntity        entity;
+    EcsComponentMask mask;       /* CREATE */
+    EcsComponentId   component;  /* ADD, REMOVE */
+    uint32_t         dataOffset; /* ADD, initial value inside the buffer data */
+    uint16_t         dataSize;
+} EcsCommand;
+
+/* structural changes recorded while a query is running and applied afterwards with EcsCommandBuffer_Flush */
+typedef struct EcsCommandBuffer
+{
+    EcsCommand commands[ECS_MAX_COMMANDS];
+    uint16_t   count;
+    uint8_t    data[ECS_COMMAND_DATA_SIZE];
+    uint32_t   dataUsed;
+} EcsCommandBuffer;
+
+/* Function Prototypes */
+void Ecs_Initialize();
+void Ecs_Deinitialize();
+
+EcsComponentId          Ecs_RegisterComponent(const char* name, uint16_t size, uint16_t alignment);
+const EcsComponentInfo* Ecs_GetComponentInfo(EcsComponentId id);
+
+EcsEntity Ecs_CreateEntity(EcsComponentMask mask);
+bool      Ecs_DestroyEntity(EcsEntity entity);
+bool      Ecs_IsAlive(EcsEntity entity);
+bool      Ecs_HasComponent(EcsEntity entity, EcsComponentId id);
+void*     Ecs_GetComponent(EcsEntity entity, EcsComponentId id);
+void*     Ecs_AddComponent(EcsEntity entity, EcsComponentId id);
+bool      Ecs_RemoveComponent(EcsEntity entity, EcsComponentId id);
+uint32_t  Ecs_GetEntityCount();
+
+EcsQuery* Ecs_CreateQuery(EcsComponentMask all, EcsComponentMask none);
+void      Ecs_QueryBegin(EcsQuery* query, EcsIterator* iterator);
+bool      Ecs_QueryNext(EcsIterator* iterator);
+void*     Ecs_IteratorColumn(EcsIterator* iterator, EcsComponentId id);
+
+uint16_t      Ecs_GetArchetypeCount();
+EcsArchetype* Ecs_GetArchetype(uint16_t index);
+
+void      EcsCommandBuffer_Initialize(EcsCommandBuffer* buffer);
+EcsEntity EcsCommandBuffer_Create(EcsCommandBuffer* buffer, EcsComponentMask mask);  // id is reserved right away
+bool      EcsCommandBuffer_Destroy(EcsCommandBuffer* buffer, EcsEntity entity);
+bool EcsCommandBuffer_AddComponent(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentId id, const void* value);
+bool EcsCommandBuffer_RemoveComponent(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentId id);
+void EcsCommandBuffer_Flush(EcsCommandBuffer* buffer);
+
+#endif  // ASH_ECS_H
@@ -0,0 +1,285 @@
+#include "ash_file.h"
+
+#include <string.h>
+
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    include <io.h>
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+bool MappedFile_Open(MappedFile* mapped, const char* fileName)
+{
+    memset(mapped, 0, sizeof(MappedFile));
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mapped->file    = file;
+    mapped->mapping = mapping;
+    mapped->data    = (const uint8_t*)data;
+    mapped->size    = (size_t)size.QuadPart;
+#else
+    int file = open(fileName, O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);  // the mapping keeps its own reference
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    mapped->data = (const uint8_t*)data;
+    mapped->size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void MappedFile_Close(MappedFile* mapped)
+{
+    if (mapped->data == NULL)
+    {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(mapped->data);
+    CloseHandle((HANDLE)mapped->mapping);
+    CloseHandle((HANDLE)mapped->file);
+#else
+    munmap((void*)mapped->data, mapped->size);
+#endif
+    memset(mapped, 0, sizeof(MappedFile));
+}
+
+/* FNV-1a, cheap enough to run over every chunk that is saved or loaded */
+uint32_t File_Fnv1a(uint32_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+bool File_Sync(FILE* file)
+{
+    if (fflush(file) != 0)
+    {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool File_Replace(const char* fileName, const char* target)
+{
+#if defined(_WIN32)
+    return MoveFileExA(fileName, target, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(fileName, target) == 0;
+#endif
+}
+
+/* adds the 255 run extension of a length that did not fit its 4 bit token field */
+static uint8_t* Lz_WriteLength(uint8_t* out, const uint8_t* end, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        if (out >= end)
+        {
+            return NULL;
+        }
+        *out++ = 255;
+    }
+    if (out >= end)
+    {
+        return NULL;
+    }
+    *out++ = (uint8_t)length;
+    return out;
+}
+
+/*
+ * Sequence layout: token (literal length << 4 | match length - LZ_MIN_MATCH), literals, 16 bit offset.
+ * A nibble of 15 means the length continues in extra bytes. The last sequence has literals only.
+ */
+static uint8_t* Lz_WriteSequence(uint8_t* out, const uint8_t* end, const uint8_t* literals, size_t literalCount,
+                                 size_t offset, size_t matchLength)
+{
+    if (out >= end)
+    {
+        return NULL;
+    }
+    uint8_t* token = out++;
+    *token         = (uint8_t)((literalCount < 15 ? literalCount : 15) << 4);
+    if (literalCount >= 15 && (out = Lz_WriteLength(out, end, literalCount - 15)) == NULL)
+    {
+        return NULL;
+    }
+    if ((size_t)(end - out) < literalCount)
+    {
+        return NULL;
+    }
+    memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (matchLength == 0)
+    {
+        return out;
+    }
+    if (end - out < 2)
+    {
+        return NULL;
+    }
+    *out++ = (uint8_t)offset;
+    *out++ = (uint8_t)(offset >> 8);
+    matchLength -= LZ_MIN_MATCH;
+    *token |= (uint8_t)(matchLength < 15 ? matchLength : 15);
+    if (matchLength >= 15)
+    {
+        out = Lz_WriteLength(out, end, matchLength - 15);
+    }
+    return out;
+}
+
+size_t Lz_Compress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t capacity)
+{
+    uint32_t       table[1 << LZ_HASH_BITS];  // last position of every hashed 4 byte sequence
+    const uint8_t* end      = destination + capacity;
+    uint8_t*       out      = destination;
+    size_t         anchor   = 0;
+    size_t         position = 0;
+    memset(table, 0xFF, sizeof(table));
+    while (sourceSize >= LZ_MIN_MATCH && position <= sourceSize - LZ_MIN_MATCH)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, source + position, sizeof(sequence));
+        uint32_t hash      = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        uint32_t candidate = table[hash];
+        table[hash]        = (uint32_t)position;
+        if (candidate == 0xFFFFFFFF || position - candidate > LZ_MAX_OFFSET
+            || memcmp(source + candidate, source + position, LZ_MIN_MATCH) != 0)
+        {
+            position++;
+            continue;
+        }
+        size_t length = LZ_MIN_MATCH;
+        while (position + length < sourceSize && source[candidate + length] == source[position + length])
+        {
+            length++;
+        }
+        out = Lz_WriteSequence(out, end, source + anchor, position - anchor, position - candidate, length);
+        if (out == NULL)
+        {
+            return 0;
+        }
+        position += length;
+        anchor = position;
+    }
+    out = Lz_WriteSequence(out, end, source + anchor, sourceSize - anchor, 0, 0);
+    return out == NULL ? 0 : (size_t)(out - destination);
+}
+
+static bool Lz_ReadLength(const uint8_t** in, const uint8_t* end, size_t* length)
+{
+    uint8_t value;
+    do
+    {
+        if (*in >= end)
+        {
+            return false;
+        }
+        value = *(*in)++;
+        *length += value;
+    } while (value == 255);
+    return true;
+}
+
+/* every read and write is bounds checked, a corrupt stream fails instead of overrunning the destination */
+size_t Lz_Decompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t capacity)
+{
+    const uint8_t* in     = source;
+    const uint8_t* inEnd  = source + sourceSize;
+    uint8_t*       out    = destination;
+    uint8_t*       outEnd = destination + capacity;
+    while (in < inEnd)
+    {
+        uint8_t token        = *in++;
+        size_t  literalCount = token >> 4;
+        if (literalCount == 15 && !Lz_ReadLength(&in, inEnd, &literalCount))
+        {
+            return 0;
+        }
+        if ((size_t)(inEnd - in) < literalCount || (size_t)(outEnd - out) < literalCount)
+        {
+            return 0;
+        }
+        memcpy(out, in, literalCount);
+        in += literalCount;
+        out += literalCount;
+        if (in == inEnd)
+        {
+            break;  // the last sequence has no match
+        }
+        if (inEnd - in < 2)
+        {
+            return 0;
+        }
+        size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !Lz_ReadLength(&in, inEnd, &matchLength))
+        {
+            return 0;
+        }
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(out - destination) || (size_t)(outEnd - out) < matchLength)
+        {
+            return 0;
+        }
+        // byte by byte, matches may overlap their own output
+        const uint8_t* match = out - offset;
+        for (size_t i = 0; i < matchLength; i++)
+        {
+            out[i] = match[i];
+        }
+        out += matchLength;
+    }
+    return (size_t)(out - destination);
+}
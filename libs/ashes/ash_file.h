@@ -0,0 +1,39 @@
+#ifndef ASH_FILE_H
+#define ASH_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Defines */
+#define LZ_MIN_MATCH   4
+#define LZ_HASH_BITS   12
+#define LZ_MAX_OFFSET  0xFFFF
+#define LZ_BOUND(size) ((size) + (size) / 255 + 16)  /* worst case output of Lz_Compress */
+#define FNV_OFFSET     2166136261u                   /* starting hash for File_Fnv1a */
+
+/* Structs, Enums, and Unions */
+
+/* read only view of a whole file, pages are only read from disk when they are touched */
+typedef struct MappedFile
+{
+    const uint8_t* data;
+    size_t         size;
+    void*          file;     /* platform handles */
+    void*          mapping;
+} MappedFile;
+
+/* Function Prototypes */
+// kept out of the other ashes files so windows.h never meets raylib.h in one translation unit
+bool MappedFile_Open(MappedFile* mapped, const char* fileName);
+void MappedFile_Close(MappedFile* mapped);
+
+uint32_t File_Fnv1a(uint32_t hash, const void* data, size_t size);
+bool     File_Sync(FILE* file);                                  // flushes the C buffers and waits for the disk
+bool     File_Replace(const char* fileName, const char* target);  // moves over an existing target
+
+/* byte oriented LZ77 in the LZ4 style, fast enough to run on every save. Both return the output size, 0 on error */
+size_t Lz_Compress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t capacity);
+size_t Lz_Decompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t capacity);
+
+#endif  // ASH_FILE_H
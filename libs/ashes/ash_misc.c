@@ -7,6 +7,63 @@
 #include <stdio.h>
 #include <time.h>
 
+alignas(FRAME_ARENA_ALIGNMENT) static uint8_t frameArenaMemory[2][FRAME_ARENA_SIZE];
+static uint8_t frameArenaIndex         = 0;
+static size_t  frameArenaOffset        = 0;
+static size_t  frameArenaHighWaterMark = 0;
+
+void FrameArena_BeginFrame()
+{
+    frameArenaIndex  = (uint8_t)(frameArenaIndex ^ 1);
+    frameArenaOffset = 0;
+}
+
+void* FrameArena_Alloc(size_t size)
+{
+    size_t start = (frameArenaOffset + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1);
+    if (size > FRAME_ARENA_SIZE - start || start > FRAME_ARENA_SIZE)
+    {
+        LOG_ERR("FrameArena: Alloc() failed, %u bytes requested with %u of %u used", (uint32_t)size,
+                (uint32_t)frameArenaOffset, (uint32_t)FRAME_ARENA_SIZE);
+        return NULL;
+    }
+    frameArenaOffset = start + size;
+    if (frameArenaOffset > frameArenaHighWaterMark)
+    {
+        frameArenaHighWaterMark = frameArenaOffset;
+    }
+    return &frameArenaMemory[frameArenaIndex][start];
+}
+
+// scratch allocations that do not outlive a function can be released again with a marker
+size_t FrameArena_GetMarker()
+{
+    return frameArenaOffset;
+}
+
+void FrameArena_ResetToMarker(size_t marker)
+{
+    if (marker <= frameArenaOffset)
+    {
+        frameArenaOffset = marker;
+    }
+}
+
+size_t FrameArena_GetUsed()
+{
+    return frameArenaOffset;
+}
+
+size_t FrameArena_GetHighWaterMark()
+{
+    return frameArenaHighWaterMark;
+}
+
+size_t FrameArena_GetCapacity()
+{
+    return FRAME_ARENA_SIZE;
+}
+
 AStar_Node* AStar_CalucalatePath(AStar_Node* nodeArray, size_t nodeArraySize, const Vector2Int startPos,
                                  const Vector2Int targetPos, HeuristicFuncPtr hFunc)
 {
@@ -123,12 +180,18 @@ Vector2Int8 AStar_GetMoveDirection(const Vector2Int startPos, const Vector2Int t
                                    HeuristicFuncPtr hFunc)
 {
     LOG_INF("A* Pathfinding from (%d, %d) to (%d, %d)", startPos.x, startPos.y, targetPos.x, targetPos.y);
-    AStar_Node  nodeList[maxSearchArea];
+    size_t      marker   = FrameArena_GetMarker();
+    AStar_Node* nodeList = FrameArena_AllocArray(AStar_Node, maxSearchArea);
     AStar_Node* lastNode = NULL;
+    if (nodeList == NULL)
+    {
+        return { 0, 0 };
+    }
 
     lastNode = AStar_CalucalatePath(nodeList, maxSearchArea, startPos, targetPos, hFunc);
     if (lastNode == NULL)
     {
+        FrameArena_ResetToMarker(marker);
         return { 0, 0 };
     }
 
@@ -150,6 +213,7 @@ Vector2Int8 AStar_GetMoveDirection(const Vector2Int startPos, const Vector2Int t
     Vector2Int8 direction;
     direction.x = int8_t(lastNode->position.x - startPos.x);
     direction.y = int8_t(lastNode->position.y - startPos.y);
+    FrameArena_ResetToMarker(marker);
     return direction;
 }
 
@@ -157,10 +221,16 @@ bool AStar_IsPathAvailable(const Vector2Int startPos, const Vector2Int targetPos
                            HeuristicFuncPtr hFunc)
 {
     LOG_INF("A* Pathfinding from (%d, %d) to (%d, %d)", startPos.x, startPos.y, targetPos.x, targetPos.y);
-    AStar_Node  nodeList[maxSearchArea];
-    AStar_Node* currentNode = NULL;
+    size_t      marker   = FrameArena_GetMarker();
+    AStar_Node* nodeList = FrameArena_AllocArray(AStar_Node, maxSearchArea);
+    if (nodeList == NULL)
+    {
+        return false;
+    }
 
-    return AStar_CalucalatePath(nodeList, maxSearchArea, startPos, targetPos, hFunc) != NULL;
+    bool result = AStar_CalucalatePath(nodeList, maxSearchArea, startPos, targetPos, hFunc) != NULL;
+    FrameArena_ResetToMarker(marker);
+    return result;
 }
 
 uint16_t AStar_GetPath(const Vector2Int startPos, const Vector2Int targetPos, uint16_t maxSearchArea,
@@ -168,33 +238,37 @@ uint16_t AStar_GetPath(const Vector2Int startPos, const Vector2Int targetPos, ui
 {
 
     LOG_INF("A* Pathfinding from (%d, %d) to (%d, %d)", startPos.x, startPos.y, targetPos.x, targetPos.y);
-    AStar_Node  nodeList[maxSearchArea];
+    size_t      marker   = FrameArena_GetMarker();
+    AStar_Node* nodeList = FrameArena_AllocArray(AStar_Node, maxSearchArea);
     AStar_Node* lastNode = NULL;
-
-    lastNode = AStar_CalucalatePath(nodeList, maxSearchArea, startPos, targetPos, hFunc);
-    if (lastNode == NULL)
+    if (nodeList == NULL)
     {
         return 0;
     }
+
+    lastNode = AStar_CalucalatePath(nodeList, maxSearchArea, startPos, targetPos, hFunc);
     // Reruct path
+    uint16_t result     = 0;
     uint16_t pathLength = 0;
-    for (int i = 0; i < maxSearchArea; i++)
+    for (int i = 0; lastNode != NULL && i < maxSearchArea; i++)
     {
         if (pathLength >= outPathBufferSize)
         {
             LOG_WRN("Output path buffer too small, truncating path");
-            return 0;
+            break;
         }
         outPathBuffer[pathLength] = lastNode->position;
         pathLength++;
         if (lastNode->parent == NULL
             || (lastNode->parent->position.x == startPos.x && lastNode->parent->position.y == startPos.y))
         {
-            return pathLength;
+            result = pathLength;
+            break;
         }
         lastNode = lastNode->parent;
     }
-    return 0;
+    FrameArena_ResetToMarker(marker);
+    return result;
 }
 
 long  lastClock  = 0;
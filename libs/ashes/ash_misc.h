@@ -2,9 +2,13 @@
 #define ASH_MISC_H
 
 #include <raylib.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define CLOCKS_PER_MS        CLOCKS_PER_SEC / 1000
+#define FRAME_ARENA_SIZE      (2 * 1024 * 1024)  /* per buffer, the arena is double-buffered */
+#define FRAME_ARENA_ALIGNMENT 16
+#define FrameArena_AllocArray(type, count) ((type*)FrameArena_Alloc(sizeof(type) * (count)))
 #define Utils_ArraySize(arr) (sizeof(arr) / sizeof(arr[0]))
 #define Utils_AddToArray(arr, value, currentSize, maxSize) \
     (((currentSize) < (maxSize)) ? ((arr)[(currentSize)++] = (value), true) : false)
@@ -116,6 +120,18 @@ typedef void (*GetPositionScoreFunc)(Vector2Int8);
 
 /* Function Prototypes */
 
+/*
+ * Frame arena: transient memory that lives until the end of the next frame. FrameArena_BeginFrame swaps the two
+ * buffers and resets the new one, so whatever was allocated last frame stays valid for one more frame.
+ */
+void   FrameArena_BeginFrame();
+void*  FrameArena_Alloc(size_t size);
+size_t FrameArena_GetMarker();
+void   FrameArena_ResetToMarker(size_t marker);
+size_t FrameArena_GetUsed();
+size_t FrameArena_GetHighWaterMark();
+size_t FrameArena_GetCapacity();
+
 typedef bool (*HeuristicFuncPtr)(const Vector2Int, const Vector2Int, uint16_t& outCost);
 
 Vector2Int8 AStar_GetMoveDirection(const Vector2Int startPos, const Vector2Int targetPos, uint16_t maxSearchArea,
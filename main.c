@@ -18,6 +18,7 @@ int main()
     Audio_Init();
 
     Context_SetMode(&menuMode);
+    Context_Run();
 
     Logger_Deinit();
     Audio_Deinit();
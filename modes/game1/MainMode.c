@@ -7,19 +7,54 @@
 #include "ashes/ash_misc.h"
 #include "imgui.h"
 #include "raylib.h"
+#include "utils/ChunkStreamer.h"
+#include "utils/ObjectPool.h"
 #include "utils/Prefabs.h"
 #include "utils/Stats.h"
 #include "utils/Structs.h"
 #include "utils/UI_old.h"
+#include "utils/WorldGen.h"
 #include <stdio.h>
+#include <time.h>
+
+#define LAYOUT_BENCHMARK_OBJECTS    4000
+#define LAYOUT_BENCHMARK_ITERATIONS 200
+#define WORLD_FILE                  "world.dat"
+#define HANDLE_MAP_SIZE             (MAX_OBJECT_COUNT * 2)  // a power of two, the map stays at most half full
+#define STREAM_PINNED_CHUNKS        ((STREAM_RESIDENT_RADIUS * 2 + 1) * (STREAM_RESIDENT_RADIUS * 2 + 1) + 2)
+
+// EvictChunks never evicts the residency square or the chunks of the player and the dragged object, and keeps room
+// for the next activations next to them; if that does not fit, the loads around the player wait forever
+static_assert((STREAM_PINNED_CHUNKS + STREAM_MAX_ACTIVATIONS) * CHUNK_RECORD_MAX_OBJECTS <= MAX_OBJECT_COUNT,
+              "the object pool cannot hold the chunks that are never evicted");
+static_assert(STREAM_PINNED_CHUNKS + STREAM_MAX_ACTIVATIONS <= CHUNK_SIZE * CHUNK_SIZE,
+              "the chunk array cannot hold the chunks that are never evicted");
 
 Mode mainMode = MODE_FROM_CLASSNAME(MainMode);
 
 GameData  gameData;
 DebugData debugData;
 
-uint8_t GetObjectsAtPosition(Vector3Int pos, Object** outObjs)
+// despawns and chunk moves are deferred to the end of the frame, so chunk lists are not modified while they are
+// iterated
+static ObjectHandle despawnQueue[MAX_OBJECT_COUNT];
+static uint16_t     despawnQueueCount = 0;
+static ObjectHandle moveQueue[MAX_OBJECT_COUNT];
+static uint16_t     moveQueueCount = 0;
+
+static ChunkRecord  streamRecord;  // too big for the stack
+static ObjectHandle streamSpawned[CHUNK_RECORD_MAX_OBJECTS];
+static uint32_t     handleMapIds[HANDLE_MAP_SIZE];  // object id to handle, rebuilt before record handles resolve
+static ObjectHandle handleMap[HANDLE_MAP_SIZE];     // OBJECT_HANDLE_NULL for an empty bucket
+static uint32_t     streamFrame     = 0;
+static uint32_t     streamEvictions = 0;
+static double       worldSaveMs     = 0.0;
+static Updatable    streamUpdatable;
+static Vector2Float streamCameraPosition;  // camera position at the last stream update
+
+uint8_t GetObjectsAtPosition(Vector3Int pos, uint16_t* outObjs)
 {
+    ObjectPool* pool = &gameData.objectPool;
     Vector3Int8 chunkPos;
     chunkPos = Utils_GridToChunk(pos, CHUNK_SIZE);
 
@@ -31,12 +66,12 @@ uint8_t GetObjectsAtPosition(Vector3Int pos, Object** outObjs)
         {
             for (uint16_t j = 0; j < chunk->objectCount; j++)
             {
-                Object* obj = chunk->objects[j];
-                if (obj->position.x == pos.x && obj->position.y == pos.y)
+                uint16_t index = chunk->objects[j];
+                if (pool->positions[index].x == pos.x && pool->positions[index].y == pos.y)
                 {
                     if (count < MAX_LAYERS)
                     {
-                        outObjs[count++] = obj;
+                        outObjs[count++] = index;
                     }
                     else
                     {
@@ -50,46 +85,41 @@ uint8_t GetObjectsAtPosition(Vector3Int pos, Object** outObjs)
     return count;
 }
 
-bool GetClosestEntityInRange(Object* sourceObj, uint8_t range, Object** outObj)
+bool GetClosestEntityInRange(uint16_t source, uint8_t range, uint16_t* outObj)
 {
-    Vector2 sourceWorldPos = Utils_GridCenterToWorld(sourceObj->position, TEXTURE_SIZE * TEXTURE_SCALE);
-    float   closestDist    = float(range * TEXTURE_SIZE * TEXTURE_SCALE);
-    Object* closestObj     = NULL;
-    for (uint16_t i = 0; i < gameData.chunkCount; i++)
+    ObjectPool* pool           = &gameData.objectPool;
+    Vector2     sourceWorldPos = Utils_GridCenterToWorld(pool->positions[source], TEXTURE_SIZE * TEXTURE_SCALE);
+    float       closestDist    = float(range * TEXTURE_SIZE * TEXTURE_SCALE);
+    bool        found          = false;
+    // only entities can be targets, so walk the entity table instead of every object of every chunk
+    for (uint16_t row = 0; row < pool->entityCount; row++)
     {
-        Chunk* chunk = &gameData.chunks[i];
-        for (uint16_t j = 0; j < chunk->objectCount; j++)
+        uint16_t index = pool->entityOwners[row];
+        if (index == source)
         {
-            Object* obj = chunk->objects[j];
-            if (obj->type == Type::ENTITY && obj->id != sourceObj->id)
-            {
-                Vector2 targetWorldPos = Utils_GridCenterToWorld(obj->position, TEXTURE_SIZE * TEXTURE_SCALE);
-                float   dist           = Utils_Vector2Distance(sourceWorldPos, targetWorldPos);
-                if (dist < closestDist)
-                {
-                    closestDist = dist;
-                    closestObj  = obj;
-                }
-            }
+            continue;
+        }
+        Vector2 targetWorldPos = Utils_GridCenterToWorld(pool->positions[index], TEXTURE_SIZE * TEXTURE_SCALE);
+        float   dist           = Utils_Vector2Distance(sourceWorldPos, targetWorldPos);
+        if (dist < closestDist)
+        {
+            closestDist = dist;
+            *outObj     = index;
+            found       = true;
         }
     }
-    if (closestObj != NULL)
-    {
-        *outObj = closestObj;
-        return true;
-    }
-    return false;
+    return found;
 }
 
 
 bool CheckCollision(Vector3Int pos)
 {
     // Objects objsAtPos = GetObjectsAtPosition(pos);
-    Object* objects[MAX_LAYERS];
-    uint8_t objCount = GetObjectsAtPosition(pos, objects);
+    uint16_t objects[MAX_LAYERS];
+    uint8_t  objCount = GetObjectsAtPosition(pos, objects);
     for (uint16_t i = 0; i < objCount; i++)
     {
-        if (objects[i]->isCollidable)
+        if (gameData.objectPool.flags[objects[i]] & OBJECT_FLAG_COLLIDABLE)
         {
             // Collision detected
             // LOG_INF("Collision detected at (%d, %d, %d) with object id %d", pos.x, pos.y, pos.z,
@@ -101,19 +131,19 @@ bool CheckCollision(Vector3Int pos)
     // No collision
 }
 
-bool CheckCollision(Vector3Int pos, Object* outObj)
+bool CheckCollision(Vector3Int pos, uint16_t* outObj)
 {
     // Objects objsAtPos = GetObjectsAtPosition(pos);
-    Object* objects[MAX_LAYERS];
-    uint8_t objCount = GetObjectsAtPosition(pos, objects);
+    uint16_t objects[MAX_LAYERS];
+    uint8_t  objCount = GetObjectsAtPosition(pos, objects);
     for (uint16_t i = 0; i < objCount; i++)
     {
-        if (objects[i]->isCollidable)
+        if (gameData.objectPool.flags[objects[i]] & OBJECT_FLAG_COLLIDABLE)
         {
             // Collision detected
             // LOG_INF("Collision detected at (%d, %d, %d) with object id %d", pos.x, pos.y, pos.z,
             //         objsAtPos.objects[i].id);
-            *outObj = *objects[i];
+            *outObj = objects[i];
             return true;
         }
     }
@@ -137,31 +167,35 @@ Vector2Int8 GetMoveTowardsPosition(Vector2Int source, Vector2Int target)
     return direction;
 }
 
-void RemoveFromChunk(Object* obj)
+void RemoveFromChunk(uint16_t index)
 {
-    if (obj->parentChunk == NULL)
+    ObjectPool* pool  = &gameData.objectPool;
+    Chunk*      chunk = pool->parentChunks[index];
+    if (chunk == NULL)
     {
-        LOG_WRN("Object id %d has no parent chunk!", obj->id);
+        LOG_WRN("Object id %u has no parent chunk!", pool->ids[index]);
         return;
     }
-    for (uint16_t j = 0; j < obj->parentChunk->objectCount; j++)
+    for (uint16_t j = 0; j < chunk->objectCount; j++)
     {
-        if (obj->parentChunk->objects[j] == obj)
+        if (chunk->objects[j] == index)
         {
             // Remove from old chunk
-            obj->parentChunk->objects[j] = obj->parentChunk->objects[obj->parentChunk->objectCount - 1];
-            obj->parentChunk->objectCount--;
-            LOG_INF("Removed object id %d from chunk (%d, %d)", obj->id, obj->parentChunk->chunkPosition.x,
-                    obj->parentChunk->chunkPosition.y);
-            obj->parentChunk = NULL;
+            chunk->objects[j] = chunk->objects[chunk->objectCount - 1];
+            chunk->objectCount--;
+            chunk->isDirty = true;
+            LOG_INF("Removed object id %u from chunk (%d, %d)", pool->ids[index], chunk->chunkPosition.x,
+                    chunk->chunkPosition.y);
+            pool->parentChunks[index] = NULL;
             return;
         }
     }
 }
 
-void AddToChunk(Object* obj)
+void AddToChunk(uint16_t index)
 {
-    Vector3Int8 toChunkPos = Utils_GridToChunk(obj->position, CHUNK_SIZE);
+    ObjectPool* pool       = &gameData.objectPool;
+    Vector3Int8 toChunkPos = Utils_GridToChunk(pool->positions[index], CHUNK_SIZE);
     for (uint16_t i = 0; i < gameData.chunkCount; i++)
     {
         if (gameData.chunks[i].chunkPosition.x == toChunkPos.x && gameData.chunks[i].chunkPosition.y == toChunkPos.y)
@@ -169,9 +203,10 @@ void AddToChunk(Object* obj)
             // Add to new chunk
             if (gameData.chunks[i].objectCount < CHUNK_MAX_OBJECTS)
             {
-                obj->parentChunk                                             = &gameData.chunks[i];
-                gameData.chunks[i].objects[gameData.chunks[i].objectCount++] = obj;
-                LOG_INF("Added object id %d to chunk (%d, %d)", obj->id, toChunkPos.x, toChunkPos.y);
+                pool->parentChunks[index]                                    = &gameData.chunks[i];
+                gameData.chunks[i].objects[gameData.chunks[i].objectCount++] = index;
+                gameData.chunks[i].isDirty                                   = true;
+                LOG_INF("Added object id %u to chunk (%d, %d)", pool->ids[index], toChunkPos.x, toChunkPos.y);
             }
             else
             {
@@ -186,9 +221,12 @@ void AddToChunk(Object* obj)
         Chunk* chunk                         = &gameData.chunks[gameData.chunkCount++];
         chunk->chunkPosition                 = toChunkPos;
         chunk->objectCount                   = 0;
-        chunk->objects[chunk->objectCount++] = obj;
-        obj->parentChunk                     = chunk;
-        LOG_INF("Created new chunk (%d, %d) and added object id %d", toChunkPos.x, toChunkPos.y, obj->id);
+        chunk->objects[chunk->objectCount++] = index;
+        chunk->isDirty                       = true;
+        chunk->packedHash                    = 0;
+        chunk->lastUsedFrame                 = streamFrame;
+        pool->parentChunks[index]            = chunk;
+        LOG_INF("Created new chunk (%d, %d) and added object id %u", toChunkPos.x, toChunkPos.y, pool->ids[index]);
     }
     else
     {
@@ -196,59 +234,373 @@ void AddToChunk(Object* obj)
     }
 }
 
-void SaveChunksToFile(Chunk* chunks, uint16_t chunkCount)
+ObjectHandle SpawnObject(const Object* prefab)
 {
-    if (chunkCount == 0)
+    ObjectHandle handle = ObjectPool_Spawn(&gameData.objectPool, prefab);
+    uint16_t     index;
+    if (!ObjectPool_Resolve(&gameData.objectPool, handle, &index))
     {
-        return;
+        return OBJECT_HANDLE_NULL;
+    }
+    EffectData* effect = ObjectPool_GetEffect(&gameData.objectPool, index);
+    if (effect != NULL)
+    {
+        Stopwatch_Start(&effect->effectTimer, effect->effectDuration);
     }
-    FILE*    file  = NULL;
-    uint32_t error = fopen_s(&file, "world.dat", "wb");
-    if (error != 0 || file == NULL)
+    AddToChunk(index);
+    return handle;
+}
+
+void DespawnObject(uint16_t index)
+{
+    ObjectHandle handle = ObjectPool_GetHandle(&gameData.objectPool, index);
+    if (handle == OBJECT_HANDLE_NULL)
     {
-        LOG_ERR("Failed to open world.dat for writing");
         return;
     }
-    fwrite(&chunkCount, sizeof(uint16_t), 1, file);
-    for (uint16_t i = 0; i < chunkCount; i++)
+    if (despawnQueueCount < MAX_OBJECT_COUNT)
     {
-        fwrite(&chunks[i], sizeof(Chunk), 1, file);
+        despawnQueue[despawnQueueCount++] = handle;
     }
-    LOG_INF("Saved %d chunks to world.dat", chunkCount);
-    fclose(file);
 }
 
-uint16_t LoadChunksFromFile(Chunk* chunks)
+void FlushDespawnedObjects()
 {
-    uint16_t count = 0;
-    LOG_INF("Loading chunks from world.dat");
-    FILE*    file  = NULL;
-    uint32_t error = fopen_s(&file, "world.dat", "rb");
-    if (error != 0 || file == NULL)
+    for (uint16_t i = 0; i < despawnQueueCount; i++)
+    {
+        // the same object may have been queued twice, the second handle is already stale
+        uint16_t index;
+        if (!ObjectPool_Resolve(&gameData.objectPool, despawnQueue[i], &index))
+        {
+            continue;
+        }
+        if (gameData.objectPool.parentChunks[index] != NULL)
+        {
+            RemoveFromChunk(index);
+        }
+        if (gameData.draggedObject == despawnQueue[i])
+        {
+            gameData.isDraggingObject = false;
+            gameData.draggedObject    = OBJECT_HANDLE_NULL;
+        }
+        ObjectPool_Free(&gameData.objectPool, despawnQueue[i]);
+    }
+    despawnQueueCount = 0;
+}
+
+Chunk* FindChunk(Vector3Int8 chunkPos)
+{
+    for (uint16_t i = 0; i < gameData.chunkCount; i++)
+    {
+        if (gameData.chunks[i].chunkPosition.x == chunkPos.x && gameData.chunks[i].chunkPosition.y == chunkPos.y)
+        {
+            return &gameData.chunks[i];
+        }
+    }
+    return NULL;
+}
+
+// records store a handle as the id of its object plus one, 0 stays null
+uint32_t HandleToRecordId(ObjectHandle handle)
+{
+    uint16_t index;
+    if (!ObjectPool_Resolve(&gameData.objectPool, handle, &index))
     {
-        LOG_ERR("Failed to open world.dat for reading");
         return 0;
     }
-    fread(&count, sizeof(uint16_t), 1, file);
-    if (count > CHUNK_SIZE * CHUNK_SIZE)
+    return gameData.objectPool.ids[index] + 1;
+}
+
+// linear probing from the hashed id, ends on the bucket of the id or on the empty one it would go into
+uint32_t FindHandleBucket(uint32_t id)
+{
+    uint32_t bucket = (id * 2654435761u) & (HANDLE_MAP_SIZE - 1);
+    while (handleMap[bucket] != OBJECT_HANDLE_NULL && handleMapIds[bucket] != id)
     {
-        LOG_ERR("Invalid chunk count in world.dat");
-        count = 0;
-        fclose(file);
-        return count;
+        bucket = (bucket + 1) & (HANDLE_MAP_SIZE - 1);
+    }
+    return bucket;
+}
+
+ObjectHandle RecordIdToHandle(uint32_t id)
+{
+    ObjectPool* pool = &gameData.objectPool;
+    uint16_t    index;
+    if (id == 0)
+    {
+        return OBJECT_HANDLE_NULL;
+    }
+    ObjectHandle handle = handleMap[FindHandleBucket(id - 1)];
+    if (!ObjectPool_Resolve(pool, handle, &index) || pool->ids[index] != id - 1)
+    {
+        return OBJECT_HANDLE_NULL;
+    }
+    return handle;
+}
+
+// copies the objects of a chunk by value, plus the items its entities carry, with ids in place of handles
+void PackChunk(const Chunk* chunk, ChunkRecord* record)
+{
+    ObjectPool* pool      = &gameData.objectPool;
+    record->chunkPosition = chunk->chunkPosition;
+    record->reserved      = 0;
+    record->objectCount   = chunk->objectCount;
+    record->carriedCount  = 0;
+    for (uint16_t j = 0; j < chunk->objectCount; j++)
+    {
+        Object* obj = &record->objects[j];
+        ObjectPool_Read(pool, chunk->objects[j], obj);
+        if (obj->type != Type::ENTITY)
+        {
+            continue;
+        }
+        obj->entity.entityTarget = HandleToRecordId(obj->entity.entityTarget);
+        for (size_t k = 0; k < ENTITY_MAX_ITEMS; k++)
+        {
+            uint16_t item;
+            if (ObjectPool_Resolve(pool, obj->entity.entityItems[k], &item) && pool->parentChunks[item] == NULL)
+            {
+                if (record->objectCount + record->carriedCount >= CHUNK_RECORD_MAX_OBJECTS)
+                {
+                    LOG_WRN("Chunk (%d, %d) carries too many items, item id %u is not saved", chunk->chunkPosition.x,
+                            chunk->chunkPosition.y, pool->ids[item]);
+                    obj->entity.entityItems[k] = OBJECT_HANDLE_NULL;
+                    continue;
+                }
+                ObjectPool_Read(pool, item, &record->objects[record->objectCount + record->carriedCount++]);
+            }
+            obj->entity.entityItems[k] = HandleToRecordId(obj->entity.entityItems[k]);
+        }
+    }
+}
+
+// one pass over the pool maps ids to handles, one pass over the spawned objects swaps their ids for handles
+void ResolveRecordHandles(const ObjectHandle* spawned, uint16_t count)
+{
+    ObjectPool* pool = &gameData.objectPool;
+    memset(handleMap, 0, sizeof(handleMap));
+    for (uint16_t i = 0; i < ObjectPool_GetCount(pool); i++)
+    {
+        uint16_t index       = ObjectPool_GetLiveIndex(pool, i);
+        uint32_t bucket      = FindHandleBucket(pool->ids[index]);
+        handleMapIds[bucket] = pool->ids[index];
+        handleMap[bucket]    = ObjectPool_GetHandle(pool, index);
     }
     for (uint16_t i = 0; i < count; i++)
     {
-        fread(&chunks[i], sizeof(Chunk), 1, file);
+        uint16_t index;
+        if (!ObjectPool_Resolve(pool, spawned[i], &index))
+        {
+            continue;
+        }
+        EntityData* entity = ObjectPool_GetEntity(pool, index);
+        if (entity == NULL)
+        {
+            continue;
+        }
+        entity->entityTarget = RecordIdToHandle(entity->entityTarget);
+        for (size_t k = 0; k < ENTITY_MAX_ITEMS; k++)
+        {
+            entity->entityItems[k] = RecordIdToHandle(entity->entityItems[k]);
+        }
     }
-    LOG_INF("Loaded %d chunks from world.dat", count);
-    fclose(file);
-    return count;
+}
+
+// objects came or went, or packing the chunk gives other bytes than it was loaded or last stored with
+bool IsChunkChanged(const Chunk* chunk, const ChunkRecord* packed)
+{
+    return chunk->isDirty || ChunkStreamer_HashRecord(packed) != chunk->packedHash;
+}
+
+// turns a few finished loads per frame into live objects, so crossing a chunk border never loads in one go; a load
+// the pool or the chunk array has no room for waits in the streamer until eviction made some
+void ActivateStreamedChunks()
+{
+    ObjectPool* pool = &gameData.objectPool;
+    for (uint32_t i = 0; i < STREAM_MAX_ACTIVATIONS; i++)
+    {
+        uint32_t freeObjects = gameData.chunkCount < CHUNK_SIZE * CHUNK_SIZE ? pool->freeCount : 0;
+        if (!ChunkStreamer_PopLoaded(&streamRecord, freeObjects))
+        {
+            break;
+        }
+        // objects spawned into the area while it was loading stay, the stored ones join them
+        Chunk*   chunk    = FindChunk(streamRecord.chunkPosition);
+        bool     wasDirty = chunk != NULL && chunk->isDirty;
+        uint16_t count    = streamRecord.objectCount + streamRecord.carriedCount;
+        for (uint16_t j = 0; j < count; j++)
+        {
+            Object* obj = &streamRecord.objects[j];
+            if (obj->type == Type::ENTITY)
+            {
+                Stopwatch_Stop(&obj->entity.entityMovementTimer);
+                Stopwatch_Stop(&obj->entity.entityAttackTimer);
+            }
+            // carried objects belong to no chunk
+            streamSpawned[j] = j < streamRecord.objectCount ? SpawnObject(obj) : ObjectPool_Spawn(pool, obj);
+            if (streamSpawned[j] == OBJECT_HANDLE_NULL)
+            {
+                LOG_ERR("Object id %u of chunk (%d, %d) could not be spawned", obj->id, streamRecord.chunkPosition.x,
+                        streamRecord.chunkPosition.y);
+            }
+            if (obj->type == Type::ENTITY && obj->entity.entityType == EntityType::PLAYER)
+            {
+                gameData.playerObject = streamSpawned[j];
+            }
+        }
+        ResolveRecordHandles(streamSpawned, count);
+        chunk = FindChunk(streamRecord.chunkPosition);
+        if (chunk != NULL)
+        {
+            PackChunk(chunk, &streamRecord);
+            chunk->isDirty       = wasDirty;
+            chunk->packedHash    = ChunkStreamer_HashRecord(&streamRecord);
+            chunk->lastUsedFrame = streamFrame;
+        }
+    }
+}
+
+// hands the chunk to the streamer, frees its objects and fills the hole with the last chunk
+void EvictChunk(uint16_t slot)
+{
+    ObjectPool* pool  = &gameData.objectPool;
+    Chunk*      chunk = &gameData.chunks[slot];
+    PackChunk(chunk, &streamRecord);
+    ChunkStreamer_Evict(&streamRecord, IsChunkChanged(chunk, &streamRecord));
+    for (uint16_t j = 0; j < chunk->objectCount; j++)
+    {
+        EntityData* entity = ObjectPool_GetEntity(pool, chunk->objects[j]);
+        for (size_t k = 0; entity != NULL && k < ENTITY_MAX_ITEMS; k++)
+        {
+            uint16_t item;
+            if (ObjectPool_Resolve(pool, entity->entityItems[k], &item) && pool->parentChunks[item] == NULL)
+            {
+                ObjectPool_Free(pool, entity->entityItems[k]);
+            }
+        }
+        ObjectPool_Free(pool, ObjectPool_GetHandle(pool, chunk->objects[j]));
+    }
+    Chunk* last = &gameData.chunks[--gameData.chunkCount];
+    if (chunk != last)
+    {
+        *chunk = *last;
+        for (uint16_t j = 0; j < chunk->objectCount; j++)
+        {
+            pool->parentChunks[chunk->objects[j]] = chunk;
+        }
+    }
+    streamEvictions++;
+}
+
+// writes every changed chunk without unloading it and waits until the data is on disk; a chunk whose stored
+// version has not streamed in yet keeps its changes until it is merged on eviction
+void SaveWorld()
+{
+    double   start = GetTime();
+    uint16_t saved = 0;
+    for (uint16_t i = 0; i < gameData.chunkCount; i++)
+    {
+        Chunk* chunk = &gameData.chunks[i];
+        PackChunk(chunk, &streamRecord);
+        if (IsChunkChanged(chunk, &streamRecord) && ChunkStreamer_Store(&streamRecord))
+        {
+            chunk->isDirty    = false;
+            chunk->packedHash = ChunkStreamer_HashRecord(&streamRecord);
+            saved++;
+        }
+    }
+    ChunkStreamer_Flush();
+    worldSaveMs = (GetTime() - start) * 1000.0;
+    LOG_INF("Saved %d of %d chunks to %s in %.2f ms", saved, gameData.chunkCount, WORLD_FILE, worldSaveMs);
+}
+
+uint32_t GetResidentChunkBytes()
+{
+    uint32_t bytes = gameData.chunkCount * sizeof(Chunk);
+    for (uint16_t i = 0; i < gameData.chunkCount; i++)
+    {
+        bytes += gameData.chunks[i].objectCount * sizeof(Object);
+    }
+    return bytes;
+}
+
+bool IsInResidency(Vector3Int8 chunkPos, Vector3Int8 center)
+{
+    return chunkPos.z == center.z && chunkPos.x >= center.x - STREAM_RESIDENT_RADIUS
+           && chunkPos.x <= center.x + STREAM_RESIDENT_RADIUS && chunkPos.y >= center.y - STREAM_RESIDENT_RADIUS
+           && chunkPos.y <= center.y + STREAM_RESIDENT_RADIUS;
+}
+
+// evicts the least recently used chunks outside the residency square while over the memory budget, or while the
+// fixed chunk and object arrays could not take the next activations
+void EvictChunks(Vector3Int8 center)
+{
+    ObjectPool* pool = &gameData.objectPool;
+    for (;;)
+    {
+        if (GetResidentChunkBytes() <= STREAM_MEMORY_BUDGET
+            && gameData.chunkCount + STREAM_MAX_ACTIVATIONS <= CHUNK_SIZE * CHUNK_SIZE
+            && pool->freeCount >= CHUNK_RECORD_MAX_OBJECTS * STREAM_MAX_ACTIVATIONS)
+        {
+            return;
+        }
+        // chunks holding the player or the dragged object are never evicted, their handles must stay valid
+        uint16_t index;
+        Chunk*   playerChunk  = NULL;
+        Chunk*   draggedChunk = NULL;
+        if (ObjectPool_Resolve(pool, gameData.playerObject, &index))
+        {
+            playerChunk = pool->parentChunks[index];
+        }
+        if (gameData.isDraggingObject && ObjectPool_Resolve(pool, gameData.draggedObject, &index))
+        {
+            draggedChunk = pool->parentChunks[index];
+        }
+        int32_t oldest = -1;
+        for (uint16_t i = 0; i < gameData.chunkCount; i++)
+        {
+            Chunk* chunk = &gameData.chunks[i];
+            if (chunk == playerChunk || chunk == draggedChunk || IsInResidency(chunk->chunkPosition, center)
+                || !ChunkStreamer_CanEvict(chunk->chunkPosition))
+            {
+                continue;
+            }
+            if (oldest < 0 || chunk->lastUsedFrame < gameData.chunks[oldest].lastUsedFrame)
+            {
+                oldest = i;
+            }
+        }
+        if (oldest < 0)
+        {
+            return;
+        }
+        EvictChunk((uint16_t)oldest);
+    }
+}
+
+// runs as an updatable after the mode update, so the frame's despawns are flushed and no chunk list is iterated
+// while chunks come and go
+void StreamChunks()
+{
+    Vector3Int8 camPosChunk =
+        Utils_WorldToChunk(gameData.cameraEntity.position, TEXTURE_SIZE * TEXTURE_SCALE, CHUNK_SIZE);
+    camPosChunk.z       = gameData.currentZPos;
+    Vector2Float motion = { gameData.cameraEntity.position.x - streamCameraPosition.x,
+                            gameData.cameraEntity.position.y - streamCameraPosition.y };
+    streamCameraPosition = gameData.cameraEntity.position;
+    ChunkStreamer_Update(camPosChunk, motion);
+    ActivateStreamedChunks();
+    EvictChunks(camPosChunk);
+    streamFrame++;
 }
 
 void LoadWorldMap(char* worldMap, size_t rows, size_t cols, Chunk* chunks)
 {
-    uint16_t lastId = 0;
+    uint32_t lastId = 0;
+    if (!ChunkStreamer_ReserveIds((uint32_t)(rows * cols), &lastId))
+    {
+        return;
+    }
     for (size_t i = 0; i < rows; i++)
     {
         for (size_t j = 0; j < cols; j++)
@@ -256,38 +608,140 @@ void LoadWorldMap(char* worldMap, size_t rows, size_t cols, Chunk* chunks)
             char       tile = worldMap[i * cols + j];
             Vector3Int pos  = { (int)j, (int)i, 0 };
             // Create object based on tile type
-            Object* obj = &gameData.objects[gameData.objectCount++];
+            Object obj;
             switch (tile)
             {
                 case '0':
-                    *obj = emptyTilePrefab;
+                    obj = emptyTilePrefab;
                     break;
                 case '1':
-                    *obj = wallTilePrefab;
+                    obj = wallTilePrefab;
                     break;
                 case 'p':
-                    *obj = playerPrefab;
+                    obj = playerPrefab;
                     for (size_t k = 0; k < ENTITY_MAX_ITEMS; k++)
                     {
-                        obj->entity.entityItems[k] = NULL;
+                        obj.entity.entityItems[k] = OBJECT_HANDLE_NULL;
                     }
-                    gameData.playerObject = obj;
                     break;
                 case 'r':
-                    *obj = enemyRatPrefab;
+                    obj = enemyRatPrefab;
                     break;
                 case 'i':
-                    *obj = itemSwordPrefab;
+                    obj = itemSwordPrefab;
+                    break;
+                default:
+                    continue;
+            }
+            obj.position = pos;
+            obj.id       = lastId++;
+            if (obj.type == Type::ENTITY)
+            {
+                obj.entity.entityOriginalPosition = { pos.x, pos.y };
+            }
+            ObjectHandle handle = SpawnObject(&obj);
+            if (tile == 'p')
+            {
+                gameData.playerObject = handle;
+            }
+        }
+    }
+}
+
+static double layoutBenchmarkAosMs = 0.0;
+static double layoutBenchmarkSoaMs = 0.0;
+static float  layoutBenchmarkSum   = 0.0f;
+
+// Times the work the visible-chunk pass does per object, once over Object records and once over the pool arrays
+void RunLayoutBenchmark()
+{
+    static Object     aosObjects[LAYOUT_BENCHMARK_OBJECTS];
+    static Object*    aosList[LAYOUT_BENCHMARK_OBJECTS];
+    static ObjectPool soaPool;
+    static uint16_t   soaList[LAYOUT_BENCHMARK_OBJECTS];
+
+    ObjectPool_Initialize(&soaPool);
+    for (uint16_t i = 0; i < LAYOUT_BENCHMARK_OBJECTS; i++)
+    {
+        Object obj = (i % 20 == 0)   ? enemyRatPrefab
+                     : (i % 33 == 0) ? itemSwordPrefab
+                     : (i % 4 == 0)  ? wallTilePrefab
+                                     : emptyTilePrefab;
+        obj.position  = { i % 64, i / 64, 0 };
+        obj.id        = i;
+        aosObjects[i] = obj;
+        aosList[i]    = &aosObjects[i];
+        ObjectPool_Resolve(&soaPool, ObjectPool_Spawn(&soaPool, &obj), &soaList[i]);
+    }
+    // chunk lists are not in memory order, shuffle both lists the same way
+    uint32_t seed = 12345;
+    for (uint16_t i = LAYOUT_BENCHMARK_OBJECTS - 1; i > 0; i--)
+    {
+        seed       = seed * 1664525u + 1013904223u;
+        uint16_t j = (uint16_t)(seed % (i + 1));
+        Object*  a = aosList[i];
+        aosList[i] = aosList[j];
+        aosList[j] = a;
+        uint16_t b = soaList[i];
+        soaList[i] = soaList[j];
+        soaList[j] = b;
+    }
+
+    float  sum   = 0.0f;
+    double start = GetTime();
+    for (uint16_t n = 0; n < LAYOUT_BENCHMARK_ITERATIONS; n++)
+    {
+        for (uint16_t i = 0; i < LAYOUT_BENCHMARK_OBJECTS; i++)
+        {
+            Object* obj = aosList[i];
+            switch (obj->type)
+            {
+                case Type::TILE:
+                case Type::ITEM:
+                    sum += obj->position.x * (float)(TEXTURE_SIZE * TEXTURE_SCALE)
+                           + obj->position.y * (float)(TEXTURE_SIZE * TEXTURE_SCALE) + obj->textureId + obj->layer;
+                    break;
+                case Type::ENTITY:
+                    sum += obj->position.x + obj->position.y + obj->entity.entityMovementDirection.x
+                           + obj->entity.entityState;
                     break;
                 default:
                     break;
             }
-            obj->position                      = pos;
-            obj->id                            = lastId++;
-            obj->entity.entityOriginalPosition = { pos.x, pos.y };
-            AddToChunk(obj);
         }
     }
+    layoutBenchmarkAosMs = (GetTime() - start) * 1000.0 / LAYOUT_BENCHMARK_ITERATIONS;
+
+    start = GetTime();
+    for (uint16_t n = 0; n < LAYOUT_BENCHMARK_ITERATIONS; n++)
+    {
+        for (uint16_t i = 0; i < LAYOUT_BENCHMARK_OBJECTS; i++)
+        {
+            uint16_t index = soaList[i];
+            switch (soaPool.types[index])
+            {
+                case Type::TILE:
+                case Type::ITEM:
+                    sum += soaPool.positions[index].x * (float)(TEXTURE_SIZE * TEXTURE_SCALE)
+                           + soaPool.positions[index].y * (float)(TEXTURE_SIZE * TEXTURE_SCALE)
+                           + soaPool.textureIds[index] + soaPool.layers[index];
+                    break;
+                case Type::ENTITY:
+                {
+                    EntityData* entity = &soaPool.entities[soaPool.dataIndex[index]];
+                    sum += soaPool.positions[index].x + soaPool.positions[index].y
+                           + entity->entityMovementDirection.x + entity->entityState;
+                }
+                break;
+                default:
+                    break;
+            }
+        }
+    }
+    layoutBenchmarkSoaMs = (GetTime() - start) * 1000.0 / LAYOUT_BENCHMARK_ITERATIONS;
+    layoutBenchmarkSum   = sum;
+    LOG_INF("Layout benchmark: Object records %.4f ms, pool arrays %.4f ms per pass", layoutBenchmarkAosMs,
+            layoutBenchmarkSoaMs);
 }
 
 void DrawDebug()
@@ -365,15 +819,15 @@ void DrawDebug()
         {
             // Check if object exists at position
             // If so, delete it
-            Object* objects[MAX_LAYERS];
-            uint8_t objCount = GetObjectsAtPosition(gridPos, objects);
+            uint16_t objects[MAX_LAYERS];
+            uint8_t  objCount = GetObjectsAtPosition(gridPos, objects);
             // Objects objsAtPos = GetObjectsAtPosition(gridPos);
             int topLayer = 0;
             for (uint16_t i = 0; i < objCount; i++)
             {
-                if (objects[i]->layer > topLayer)
+                if (gameData.objectPool.layers[objects[i]] > topLayer)
                 {
-                    topLayer = objects[i]->layer;
+                    topLayer = gameData.objectPool.layers[objects[i]];
                 }
             }
             // Find chunk
@@ -392,15 +846,12 @@ void DrawDebug()
                 // Find object in chunk
                 for (uint16_t j = 0; j < chunk->objectCount; j++)
                 {
-                    if (chunk->objects[j]->position.x == gridPos.x && chunk->objects[j]->position.y == gridPos.y
-                        && chunk->objects[j]->layer == topLayer)
+                    uint16_t index = chunk->objects[j];
+                    if (gameData.objectPool.positions[index].x == gridPos.x
+                        && gameData.objectPool.positions[index].y == gridPos.y
+                        && gameData.objectPool.layers[index] == topLayer)
                     {
-                        // Delete object by shifting array
-                        for (uint16_t k = j; k < chunk->objectCount - 1; k++)
-                        {
-                            chunk->objects[k] = chunk->objects[k + 1];
-                        }
-                        chunk->objectCount--;
+                        DespawnObject(chunk->objects[j]);
                         LOG_INF("Deleted object at layer %d", topLayer);
                         break;
                     }
@@ -413,61 +864,46 @@ void DrawDebug()
             LOG_INF("Selecting object at position");
             // Select top object at position
             // Objects objsAtPos = GetObjectsAtPosition(gridPos);
-            Object* objects[MAX_LAYERS];
-            uint8_t objCount = GetObjectsAtPosition(gridPos, objects);
-            int     topLayer = -1;
+            uint16_t objects[MAX_LAYERS];
+            uint8_t  objCount = GetObjectsAtPosition(gridPos, objects);
+            int      topLayer = -1;
             if (objCount != 0)
             {
                 LOG_INF("No objects at position");
                 for (uint16_t i = 0; i < objCount; i++)
                 {
-                    if (objects[i]->layer > topLayer)
+                    if (gameData.objectPool.layers[objects[i]] > topLayer)
                     {
-                        topLayer                    = objects[i]->layer;
-                        debugData.currentObject     = *objects[i];
+                        topLayer = gameData.objectPool.layers[objects[i]];
+                        ObjectPool_Read(&gameData.objectPool, objects[i], &debugData.currentObject);
                         debugData.selectedTextureId = Texture_GetTextureById(debugData.currentObject.textureId);
                     }
                 }
             }
         }
 
+        // auto assign id, from the world file so it is not taken by an object of an evicted chunk
+        uint32_t placedId = 0;
         if (Input_IsMouseButtonPressed(INPUT_MOUSE_BUTTON_LEFT) && debugData.selectedTextureId != NULL
-            && ImGui::GetIO().WantCaptureMouse == false)
+            && ImGui::GetIO().WantCaptureMouse == false && ChunkStreamer_ReserveIds(1, &placedId))
         {
-            // if (debugData.currentObject.id == -1)
-            // {
-            // auto assign id
-            int maxId = 0;
-            for (uint16_t i = 0; i < gameData.chunkCount; i++)
-            {
-                Chunk* chunk = &gameData.chunks[i];
-                for (uint16_t j = 0; j < chunk->objectCount; j++)
-                {
-                    if (chunk->objects[j]->id > maxId)
-                    {
-                        maxId = chunk->objects[j]->id;
-                    }
-                }
-            }
-            debugData.currentObject.id = maxId + 1;
-            // }
+            debugData.currentObject.id = placedId;
             // Check if object already exists at position
             // If so, replace it
             // Else, add it
             // Objects objsAtPos = GetObjectsAtPosition(gridPos);
-            Object* objects[MAX_LAYERS];
-            uint8_t objCount = GetObjectsAtPosition(gridPos, objects);
+            uint16_t objects[MAX_LAYERS];
+            uint8_t  objCount = GetObjectsAtPosition(gridPos, objects);
             for (uint16_t i = 0; i < objCount; i++)
             {
-                if (objects[i]->layer == debugData.currentObject.layer)
+                if (gameData.objectPool.layers[objects[i]] == debugData.currentObject.layer)
                 {
-                    objects[i] = &debugData.currentObject;
+                    DespawnObject(objects[i]);
                     LOG_INF("Replacing object at layer %d", debugData.currentObject.layer);
-                    return;
+                    break;
                 }
             }
-            gameData.objects[gameData.objectCount++] = debugData.currentObject;
-            AddToChunk(&gameData.objects[gameData.objectCount - 1]);
+            SpawnObject(&debugData.currentObject);
         }
 
         if (Input_IsKeyPressed(INPUT_KEYCODE_UP) && ImGui::GetIO().WantCaptureKeyboard == false)
@@ -524,71 +960,90 @@ void DrawDebug()
         ImGui::Text("Grid Position: (%d, %d)", gridPos.x, gridPos.y);
         ImGui::Text("Chunk Position: (%d, %d, %d)", chunkPos.x, chunkPos.y, chunkPos.z);
 
+        ImGui::Separator();
+        if (ImGui::Button("Run layout benchmark"))
+        {
+            RunLayoutBenchmark();
+        }
+        ImGui::Text("%d objects, per pass: Object records %.4f ms, pool arrays %.4f ms (checksum %.0f)",
+                    LAYOUT_BENCHMARK_OBJECTS, layoutBenchmarkAosMs, layoutBenchmarkSoaMs, layoutBenchmarkSum);
+
+        ImGui::Separator();
+        ChunkStreamStats streamStats = ChunkStreamer_GetStats();
+        ImGui::Text("Resident chunks: %d (%u / %u KB)", gameData.chunkCount, GetResidentChunkBytes() / 1024,
+                    STREAM_MEMORY_BUDGET / 1024);
+        ImGui::Text("Stored chunks: %u, pending loads %u, pending writes %u", streamStats.storedChunks,
+                    streamStats.pendingLoads, streamStats.pendingStores);
+        ImGui::Text("Loads %u, writes %u, evictions %u", streamStats.loads, streamStats.stores, streamEvictions);
+        if (ImGui::Button("Save world"))
+        {
+            SaveWorld();
+        }
+        ImGui::SameLine();
+        ImGui::Text("last save %.2f ms", worldSaveMs);
+
         // display all objects in memory in a list, only display entities
         ImGui::Separator();
 
 
-        ImGui::Text("Objects in Memory:");
-        for (uint16_t i = 0; i < gameData.objectCount; i++)
+        ObjectPool* pool = &gameData.objectPool;
+        ImGui::Text("Objects in Memory: %d / %d", ObjectPool_GetCount(pool), MAX_OBJECT_COUNT);
+        for (uint16_t row = 0; row < pool->entityCount; row++)
         {
-            ImGui::PushID(i);
-            Object* obj = &gameData.objects[i];
-            if (obj->type != Type::ENTITY)
-            {
-                ImGui::PopID();
-                continue;
-            }
+            ImGui::PushID(row);
+            uint16_t    index  = pool->entityOwners[row];
+            EntityData* entity = &pool->entities[row];
             if (ImGui::TreeNode("Entity"))
             {
-                ImGui::Text("Object ID: %d", obj->id);
-                ImGui::Text("Type: %d", (int)obj->type);
-                ImGui::Text("Layer: %d", obj->layer);
-                ImGui::Text("Texture ID: %d", obj->textureId);
-                ImGui::Text("Is Collidable: %d", obj->isCollidable);
-                ImGui::Text("Position: (%d, %d, %d)", obj->position.x, obj->position.y, obj->position.z);
-                if (obj->type == Type::ENTITY)
+                ImGui::Text("Object ID: %u", pool->ids[index]);
+                ImGui::Text("Type: %d", (int)pool->types[index]);
+                ImGui::Text("Layer: %d", pool->layers[index]);
+                ImGui::Text("Texture ID: %d", pool->textureIds[index]);
+                ImGui::Text("Is Collidable: %d", (pool->flags[index] & OBJECT_FLAG_COLLIDABLE) != 0);
+                ImGui::Text("Position: (%d, %d, %d)", pool->positions[index].x, pool->positions[index].y,
+                            pool->positions[index].z);
+                ImGui::Text("Entity Type: %d", (int)entity->entityType);
+                ImGui::Text("Health: %d", entity->entityHealth);
+                ImGui::Text("Experience: %d", entity->entityExperience);
+                ImGui::Text("Level: %d", entity->entityLevel);
+                ImGui::Text("Speed: %d", entity->entitySpeed);
+                ImGui::Text("Damage: %d", entity->entityDamage);
+                if (entity->entityType == EntityType::ENEMY)
                 {
-                    ImGui::Text("Entity Type: %d", (int)obj->entity.entityType);
-                    ImGui::Text("Health: %d", obj->entity.entityHealth);
-                    ImGui::Text("Experience: %d", obj->entity.entityExperience);
-                    ImGui::Text("Level: %d", obj->entity.entityLevel);
-                    ImGui::Text("Speed: %d", obj->entity.entitySpeed);
-                    ImGui::Text("Damage: %d", obj->entity.entityDamage);
-                    if (obj->entity.entityType == EntityType::ENEMY)
+                    switch (entity->entityState)
                     {
-                        // ImGui::Text("Entity State: %d", (int)obj->entity.entityState);
-                        switch (obj->entity.entityState)
-                        {
-                            case EntityState::PATROLLING:
-                                ImGui::Text("Entity State: PATROLLING");
-                                break;
-                            case EntityState::CHASING:
-                                ImGui::Text("Entity State: CHASING");
-                                break;
-                            case EntityState::GOING_BACK:
-                                ImGui::Text("Entity State: GOING_BACK");
-                                break;
-                            default:
-                                ImGui::Text("Entity State: UNKNOWN");
-                                break;
-                        }
-                        if (obj->entity.entityState == EntityState::CHASING && obj->entity.entityTarget != NULL)
-                        {
-                            ImGui::Text("Chasing Target ID: %d", obj->entity.entityTarget->id);
-                        }
-                        ImGui::Text("Original Position: (%d, %d)", obj->entity.entityOriginalPosition.x,
-                                    obj->entity.entityOriginalPosition.y);
-                        ImGui::Text("Patrol Radius: %d", obj->entity.entityPatrolRadius);
+                        case EntityState::PATROLLING:
+                            ImGui::Text("Entity State: PATROLLING");
+                            break;
+                        case EntityState::CHASING:
+                            ImGui::Text("Entity State: CHASING");
+                            break;
+                        case EntityState::GOING_BACK:
+                            ImGui::Text("Entity State: GOING_BACK");
+                            break;
+                        default:
+                            ImGui::Text("Entity State: UNKNOWN");
+                            break;
+                    }
+                    uint16_t target;
+                    if (entity->entityState == EntityState::CHASING
+                        && ObjectPool_Resolve(pool, entity->entityTarget, &target))
+                    {
+                        ImGui::Text("Chasing Target ID: %u", pool->ids[target]);
                     }
-                    if (obj->entity.entityType == EntityType::PLAYER)
+                    ImGui::Text("Original Position: (%d, %d)", entity->entityOriginalPosition.x,
+                                entity->entityOriginalPosition.y);
+                    ImGui::Text("Patrol Radius: %d", entity->entityPatrolRadius);
+                }
+                if (entity->entityType == EntityType::PLAYER)
+                {
+                    ImGui::Text("Items:");
+                    for (uint8_t k = 0; k < ENTITY_MAX_ITEMS; k++)
                     {
-                        ImGui::Text("Items:");
-                        for (uint8_t k = 0; k < ENTITY_MAX_ITEMS; k++)
+                        uint16_t item;
+                        if (ObjectPool_Resolve(pool, entity->entityItems[k], &item))
                         {
-                            if (obj->entity.entityItems[k] != NULL)
-                            {
-                                ImGui::Text("Item %d: %d", k, obj->entity.entityItems[k]->id);
-                            }
+                            ImGui::Text("Item %d: %u", k, pool->ids[item]);
                         }
                     }
                 }
@@ -600,31 +1055,72 @@ void DrawDebug()
         ImGui::End();
     }
 }
-void UpdateObjectChunk(Object* obj)
+bool IsInWrongChunk(uint16_t index)
 {
-    if (obj == NULL)
+    ObjectPool* pool            = &gameData.objectPool;
+    Chunk*      parentChunk     = pool->parentChunks[index];
+    Vector3Int8 currentChunkPos = Utils_GridToChunk(pool->positions[index], CHUNK_SIZE);
+    return parentChunk == NULL || parentChunk->chunkPosition.x != currentChunkPos.x
+           || parentChunk->chunkPosition.y != currentChunkPos.y;
+}
+
+// the move is queued, the object may sit in the chunk list that is being iterated
+void UpdateObjectChunk(uint16_t index)
+{
+    if (IsInWrongChunk(index) && moveQueueCount < MAX_OBJECT_COUNT)
     {
-        LOG_ERR("UpdateObjectChunk called with NULL object!");
-        return;
+        moveQueue[moveQueueCount++] = ObjectPool_GetHandle(&gameData.objectPool, index);
     }
-    Vector3Int8 currentChunkPos = Utils_GridToChunk(obj->position, CHUNK_SIZE);
-    if (obj->parentChunk == NULL || obj->parentChunk->chunkPosition.x != currentChunkPos.x
-        || obj->parentChunk->chunkPosition.y != currentChunkPos.y)
+}
+
+void FlushMovedObjects()
+{
+    for (uint16_t i = 0; i < moveQueueCount; i++)
     {
-        RemoveFromChunk(obj);
-        AddToChunk(obj);
+        // queued twice or already moved, the check is repeated
+        uint16_t index;
+        if (ObjectPool_Resolve(&gameData.objectPool, moveQueue[i], &index) && IsInWrongChunk(index))
+        {
+            RemoveFromChunk(index);
+            AddToChunk(index);
+        }
     }
+    moveQueueCount = 0;
 }
 
-void UpdatePlayer(Object* obj)
+void DrawEntitySprite(uint16_t index, EntityData* entity)
 {
-    if (obj->entity.entityHealth <= 0)
+    ObjectPool* pool = &gameData.objectPool;
+    Sprite      sprite;
+    Sprite_Initialize(&sprite);
+    sprite.currentTexture = Texture_GetTextureById(pool->textureIds[index]);
+    sprite.scale          = TEXTURE_SCALE;
+    sprite.isVisible      = true;
+    sprite.tint           = WHITE;
+    sprite.position       = Utils_GridToWorld(pool->positions[index], TEXTURE_SIZE * TEXTURE_SCALE);
+    if (!Stopwatch_IsElapsed(&entity->entityMovementTimer))
+    {
+        sprite.position.x +=
+            float(-entity->entityMovementDirection.x * Stopwatch_GetPercentRemainingTime(&entity->entityMovementTimer)
+                  * TEXTURE_SIZE * TEXTURE_SCALE);
+        sprite.position.y +=
+            float(-entity->entityMovementDirection.y * Stopwatch_GetPercentRemainingTime(&entity->entityMovementTimer)
+                  * TEXTURE_SIZE * TEXTURE_SCALE);
+    }
+    Sprite_Add(&sprite);
+}
+
+void UpdatePlayer(uint16_t index)
+{
+    EntityData* entity   = ObjectPool_GetEntity(&gameData.objectPool, index);
+    Vector3Int* position = &gameData.objectPool.positions[index];
+    if (entity->entityHealth <= 0)
     {
-        Context_SetMode(&endGameMode);
-        Context_FinishMode();
+        Context_ReplaceMode(&endGameMode);
+        return;
     }
     Camera2D* camera   = Window_GetCamera();
-    Vector2   worldPos = Utils_GridCenterToWorld(obj->position, TEXTURE_SIZE * TEXTURE_SCALE);
+    Vector2   worldPos = Utils_GridCenterToWorld(*position, TEXTURE_SIZE * TEXTURE_SCALE);
     camera->target.x += (worldPos.x - camera->target.x) * DeltaTime_GetDeltaTime() * 2.0f;
     camera->target.y += (worldPos.y - camera->target.y) * DeltaTime_GetDeltaTime() * 2.0f;
     // Example: simple player movement logic
@@ -632,167 +1128,151 @@ void UpdatePlayer(Object* obj)
     int8_t x = (Input_IsKeyDown(INPUT_KEYCODE_D) - Input_IsKeyDown(INPUT_KEYCODE_A));
     if (x * x + y * y <= 1 && (x != 0 || y != 0))
     {
-        if (Stopwatch_IsZero(&obj->entity.entityMovementTimer))
+        if (Stopwatch_IsZero(&entity->entityMovementTimer))
         {
-            if (!CheckCollision({ obj->position.x + x, obj->position.y + y, obj->position.z }))
+            if (!CheckCollision({ position->x + x, position->y + y, position->z }))
             {
-                obj->position.x += x;
-                obj->position.y += y;
-                obj->entity.entityMovementDirection = { x, y };
-                Stopwatch_Start(&obj->entity.entityMovementTimer, Stats_MovementDelay(obj->entity.entitySpeed));
+                position->x += x;
+                position->y += y;
+                entity->entityMovementDirection = { x, y };
+                Stopwatch_Start(&entity->entityMovementTimer, Stats_MovementDelay(entity->entitySpeed));
             }
         }
     }
-
-    Sprite sprite;
-    Sprite_Initialize(&sprite);
-    sprite.currentTexture = Texture_GetTextureById(obj->textureId);
-    sprite.scale          = TEXTURE_SCALE;
-    sprite.isVisible      = true;
-    sprite.tint           = WHITE;
-    sprite.position       = Utils_GridToWorld(obj->position, TEXTURE_SIZE * TEXTURE_SCALE);
-    if (!Stopwatch_IsElapsed(&obj->entity.entityMovementTimer))
-    {
-        sprite.position.x +=
-            float(-obj->entity.entityMovementDirection.x
-                  * Stopwatch_GetPercentRemainingTime(&obj->entity.entityMovementTimer) * TEXTURE_SIZE * TEXTURE_SCALE);
-        sprite.position.y +=
-            float(-obj->entity.entityMovementDirection.y
-                  * Stopwatch_GetPercentRemainingTime(&obj->entity.entityMovementTimer) * TEXTURE_SIZE * TEXTURE_SCALE);
-    }
-    Sprite_Add(&sprite);
+    DrawEntitySprite(index, entity);
 }
 
-void UpdateEnemy(Object* obj)
+void UpdateEnemy(uint16_t index)
 {
-    switch (obj->entity.entityState)
+    ObjectPool* pool     = &gameData.objectPool;
+    EntityData* entity   = ObjectPool_GetEntity(pool, index);
+    Vector3Int* position = &pool->positions[index];
+    switch (entity->entityState)
     {
         case EntityState::PATROLLING:
         {
-            Object* target = NULL;
-            GetClosestEntityInRange(obj, obj->entity.entityChaseRadius, &target);
-            if (target != NULL && target->entity.entityHealth > 0)
+            uint16_t target;
+            if (GetClosestEntityInRange(index, entity->entityChaseRadius, &target)
+                && ObjectPool_GetEntity(pool, target)->entityHealth > 0)
             {
-                obj->entity.entityTarget = target;
-                obj->entity.entityState  = EntityState::CHASING;
+                entity->entityTarget = ObjectPool_GetHandle(pool, target);
+                entity->entityState  = EntityState::CHASING;
                 break;
             }
-            if (!Stopwatch_IsZero(&obj->entity.entityMovementTimer))
+            if (!Stopwatch_IsZero(&entity->entityMovementTimer))
             {
                 break;
             }
-            int16_t     x    = Utils_GetRandomInRange(-(uint16_t)obj->entity.entityPatrolRadius,
-                                                      (uint16_t)obj->entity.entityPatrolRadius);
-            int16_t     y    = Utils_GetRandomInRange(-(uint16_t)obj->entity.entityPatrolRadius,
-                                                      (uint16_t)obj->entity.entityPatrolRadius);
-            Vector2Int8 move = GetMoveTowardsPosition({ obj->position.x, obj->position.y },
-                                                      { obj->position.x + x, obj->position.y + y });
+            int16_t     x    = Utils_GetRandomInRange(-(uint16_t)entity->entityPatrolRadius,
+                                                      (uint16_t)entity->entityPatrolRadius);
+            int16_t     y    = Utils_GetRandomInRange(-(uint16_t)entity->entityPatrolRadius,
+                                                      (uint16_t)entity->entityPatrolRadius);
+            Vector2Int8 move = GetMoveTowardsPosition({ position->x, position->y },
+                                                      { position->x + x, position->y + y });
             if (move.x == 0 && move.y == 0)
             {
                 break;
             }
-            if (CheckCollision({ obj->position.x + move.x, obj->position.y + move.y, obj->position.z }))
+            if (CheckCollision({ position->x + move.x, position->y + move.y, position->z }))
             {
                 break;
             }
-            Vector2Int newPos = { obj->position.x + x, obj->position.y + y };
-            if (!Utils_IsInGridRadius(obj->entity.entityOriginalPosition, newPos, obj->entity.entityPatrolRadius))
+            Vector2Int newPos = { position->x + x, position->y + y };
+            if (!Utils_IsInGridRadius(entity->entityOriginalPosition, newPos, entity->entityPatrolRadius))
             {
-                obj->entity.entityState = EntityState::GOING_BACK;
+                entity->entityState = EntityState::GOING_BACK;
                 break;
             }
-            obj->position.x += move.x;
-            obj->position.y += move.y;
-            obj->entity.entityMovementDirection = { move.x, move.y };
-            Stopwatch_Start(&obj->entity.entityMovementTimer, Stats_MovementDelay(obj->entity.entitySpeed));
+            position->x += move.x;
+            position->y += move.y;
+            entity->entityMovementDirection = { move.x, move.y };
+            Stopwatch_Start(&entity->entityMovementTimer, Stats_MovementDelay(entity->entitySpeed));
         }
         break;
         case EntityState::CHASING:
         {
-            if (obj->entity.entityTarget == NULL)
+            uint16_t target;
+            if (!ObjectPool_Resolve(pool, entity->entityTarget, &target))
             {
-                obj->entity.entityState = EntityState::PATROLLING;
+                entity->entityTarget = OBJECT_HANDLE_NULL;
+                entity->entityState  = EntityState::PATROLLING;
                 break;
             }
-            if (Utils_Vector2DistanceInt({ obj->position.x, obj->position.y },
-                                         { obj->entity.entityTarget->position.x, obj->entity.entityTarget->position.y })
-                <= obj->entity.entityRange)
+            EntityData* targetEntity   = ObjectPool_GetEntity(pool, target);
+            Vector3Int  targetPosition = pool->positions[target];
+            if (Utils_Vector2DistanceInt({ position->x, position->y }, { targetPosition.x, targetPosition.y })
+                <= entity->entityRange)
             {
-                if (Stopwatch_IsZero(&obj->entity.entityAttackTimer))
+                if (Stopwatch_IsZero(&entity->entityAttackTimer))
                 {
-                    // LOG_INF("Enemy %d attacking target %d", obj->id, obj->entity.entityTarget->id);
-                    if (obj->entity.entityTarget->entity.entityHealth <= obj->entity.entityDamage
-                        || obj->entity.entityTarget->entity.entityHealth <= 0)
+                    // LOG_INF("Enemy %d attacking target %d", pool->ids[index], pool->ids[target]);
+                    if (targetEntity->entityHealth <= entity->entityDamage || targetEntity->entityHealth <= 0)
                     {
-                        obj->entity.entityTarget->entity.entityHealth = 0;
-                        obj->entity.entityExperience += obj->entity.entityTarget->entity.entityExperience;
-                        obj->entity.entityState  = EntityState::PATROLLING;
-                        obj->entity.entityTarget = NULL;
+                        targetEntity->entityHealth = 0;
+                        entity->entityExperience += targetEntity->entityExperience;
+                        entity->entityState  = EntityState::PATROLLING;
+                        entity->entityTarget = OBJECT_HANDLE_NULL;
                         break;
                     }
                     else
                     {
-                        obj->entity.entityTarget->entity.entityHealth -= obj->entity.entityDamage;
-                        Stopwatch_Start(&obj->entity.entityAttackTimer,
-                                        Stats_AttackDelay(obj->entity.entityAttackSpeed, obj->entity.entityDexterity));
+                        targetEntity->entityHealth -= entity->entityDamage;
+                        Stopwatch_Start(&entity->entityAttackTimer,
+                                        Stats_AttackDelay(entity->entityAttackSpeed, entity->entityDexterity));
                     }
                 }
                 break;
             }
-            Vector2 sourceWorldPos = Utils_GridCenterToWorld(obj->position, TEXTURE_SIZE * TEXTURE_SCALE);
-            Vector2 targetWorldPos =
-                Utils_GridCenterToWorld(obj->entity.entityTarget->position, TEXTURE_SIZE * TEXTURE_SCALE);
-            float dist = Utils_Vector2Distance(sourceWorldPos, targetWorldPos);
+            Vector2 sourceWorldPos = Utils_GridCenterToWorld(*position, TEXTURE_SIZE * TEXTURE_SCALE);
+            Vector2 targetWorldPos = Utils_GridCenterToWorld(targetPosition, TEXTURE_SIZE * TEXTURE_SCALE);
+            float   dist           = Utils_Vector2Distance(sourceWorldPos, targetWorldPos);
             if (dist > float(5 * TEXTURE_SIZE * TEXTURE_SCALE))
             {
-                obj->entity.entityTarget = NULL;
-                obj->entity.entityState  = EntityState::PATROLLING;
+                entity->entityTarget = OBJECT_HANDLE_NULL;
+                entity->entityState  = EntityState::PATROLLING;
                 break;
             }
-            if (!Utils_IsInGridRadius(obj->entity.entityOriginalPosition, { obj->position.x, obj->position.y },
-                                      obj->entity.entityPatrolRadius + 2))
+            if (!Utils_IsInGridRadius(entity->entityOriginalPosition, { position->x, position->y },
+                                      entity->entityPatrolRadius + 2))
             {
-                obj->entity.entityTarget = NULL;
-                obj->entity.entityState  = EntityState::GOING_BACK;
+                entity->entityTarget = OBJECT_HANDLE_NULL;
+                entity->entityState  = EntityState::GOING_BACK;
                 break;
             }
-            if (!Stopwatch_IsZero(&obj->entity.entityMovementTimer))
+            if (!Stopwatch_IsZero(&entity->entityMovementTimer))
             {
                 break;
             }
             Vector2Int8 dir =
-                GetMoveTowardsPosition({ obj->position.x, obj->position.y },
-                                       { obj->entity.entityTarget->position.x, obj->entity.entityTarget->position.y });
-            if (!CheckCollision({ obj->position.x + dir.x, obj->position.y + dir.y, obj->position.z }))
+                GetMoveTowardsPosition({ position->x, position->y }, { targetPosition.x, targetPosition.y });
+            if (!CheckCollision({ position->x + dir.x, position->y + dir.y, position->z }))
             {
-                obj->position.x += dir.x;
-                obj->position.y += dir.y;
-                obj->entity.entityMovementDirection = { dir.x, dir.y };
-                Stopwatch_Start(&obj->entity.entityMovementTimer, Stats_MovementDelay(obj->entity.entitySpeed));
+                position->x += dir.x;
+                position->y += dir.y;
+                entity->entityMovementDirection = { dir.x, dir.y };
+                Stopwatch_Start(&entity->entityMovementTimer, Stats_MovementDelay(entity->entitySpeed));
             }
         }
         break;
         case EntityState::GOING_BACK:
         {
-            if (obj->position.x == obj->entity.entityOriginalPosition.x
-                && obj->position.y == obj->entity.entityOriginalPosition.y)
+            if (position->x == entity->entityOriginalPosition.x && position->y == entity->entityOriginalPosition.y)
             {
-                obj->entity.entityState = EntityState::PATROLLING;
+                entity->entityState = EntityState::PATROLLING;
                 break;
             }
-            if (!Stopwatch_IsZero(&obj->entity.entityMovementTimer))
+            if (!Stopwatch_IsZero(&entity->entityMovementTimer))
             {
                 break;
             }
-            Vector2Int8 dir =
-                GetMoveTowardsPosition({ obj->position.x, obj->position.y }, obj->entity.entityOriginalPosition);
+            Vector2Int8 dir = GetMoveTowardsPosition({ position->x, position->y }, entity->entityOriginalPosition);
             LOG_INF("Going back dir: (%d, %d)", dir.x, dir.y);
-            if (!CheckCollision({ obj->position.x + dir.x, obj->position.y + dir.y, obj->position.z }))
+            if (!CheckCollision({ position->x + dir.x, position->y + dir.y, position->z }))
             {
-                obj->position.x += dir.x;
-                obj->position.y += dir.y;
-                obj->entity.entityMovementDirection = { dir.x, dir.y };
-                Stopwatch_Start(&obj->entity.entityMovementTimer, Stats_MovementDelay(obj->entity.entitySpeed));
+                position->x += dir.x;
+                position->y += dir.y;
+                entity->entityMovementDirection = { dir.x, dir.y };
+                Stopwatch_Start(&entity->entityMovementTimer, Stats_MovementDelay(entity->entitySpeed));
             }
         }
         break;
@@ -800,26 +1280,10 @@ void UpdateEnemy(Object* obj)
             break;
     }
     // Example: simple enemy AI logic
-    Sprite sprite;
-    Sprite_Initialize(&sprite);
-    sprite.currentTexture = Texture_GetTextureById(obj->textureId);
-    sprite.scale          = TEXTURE_SCALE;
-    sprite.isVisible      = true;
-    sprite.tint           = WHITE;
-    sprite.position       = Utils_GridToWorld(obj->position, TEXTURE_SIZE * TEXTURE_SCALE);
-    if (!Stopwatch_IsElapsed(&obj->entity.entityMovementTimer))
-    {
-        sprite.position.x +=
-            float(-obj->entity.entityMovementDirection.x
-                  * Stopwatch_GetPercentRemainingTime(&obj->entity.entityMovementTimer) * TEXTURE_SIZE * TEXTURE_SCALE);
-        sprite.position.y +=
-            float(-obj->entity.entityMovementDirection.y
-                  * Stopwatch_GetPercentRemainingTime(&obj->entity.entityMovementTimer) * TEXTURE_SIZE * TEXTURE_SCALE);
-    }
-    Sprite_Add(&sprite);
+    DrawEntitySprite(index, entity);
 }
 
-void UpdateProjectile(Object* obj)
+void UpdateProjectile(uint16_t index)
 {
     // // Example: simple movement logic
     // obj->position.x += (int8_t)(obj->projectile.projectileDirection.x * obj->projectile.projectileSpeed);
@@ -832,17 +1296,17 @@ void UpdateProjectile(Object* obj)
     // }
 }
 
-void UpdateEffect(Object* obj)
+void UpdateEffect(uint16_t index)
 {
-    // obj->effect.effectTimeElapsed += DeltaTime_Get();
-    // if (obj->effect.effectTimeElapsed >= obj->effect.effectDuration)
-    // {
-    //     // Mark for deletion or reset
-    //     obj->position.x = -1;  // Example of marking for deletion
-    // }
+    EffectData* effect = ObjectPool_GetEffect(&gameData.objectPool, index);
+    if (Stopwatch_IsElapsed(&effect->effectTimer))
+    {
+        DespawnObject(index);
+        return;
+    }
 }
 
-void UpdateInteractive(Object* obj)
+void UpdateInteractive(uint16_t index)
 {
     // // Example: toggle open state
     // if (obj->interactive.interactiveType == Object::InteractiveType::CHEST)
@@ -851,15 +1315,15 @@ void UpdateInteractive(Object* obj)
     // }
 }
 
-void UpdateItem(Object* obj)
+void UpdateItem(uint16_t index)
 {
     Sprite sprite;
     Sprite_Initialize(&sprite);
-    sprite.currentTexture = Texture_GetTextureById(obj->textureId);
+    sprite.currentTexture = Texture_GetTextureById(gameData.objectPool.textureIds[index]);
     sprite.scale          = TEXTURE_SCALE;
     sprite.isVisible      = true;
     sprite.tint           = WHITE;
-    sprite.position       = Utils_GridToWorld(obj->position, TEXTURE_SIZE * TEXTURE_SCALE);
+    sprite.position       = Utils_GridToWorld(gameData.objectPool.positions[index], TEXTURE_SIZE * TEXTURE_SCALE);
     Sprite_Add(&sprite);
 }
 
@@ -880,11 +1344,13 @@ void UpdateUI()
         // LOG_INF("Text clicked!");
     }
 
-    if (gameData.playerObject == NULL)
+    uint16_t playerIndex;
+    if (!ObjectPool_Resolve(&gameData.objectPool, gameData.playerObject, &playerIndex))
     {
         return;
     }
-    snprintf(buffer, sizeof(buffer), "Player health: %d", gameData.playerObject->entity.entityHealth);
+    EntityData* player = ObjectPool_GetEntity(&gameData.objectPool, playerIndex);
+    snprintf(buffer, sizeof(buffer), "Player health: %d", player->entityHealth);
     text.position   = (Vector2Float){ -540.0f, -240.0f };
     text.buffer     = buffer;
     text.bufferSize = strlen(buffer);
@@ -905,7 +1371,7 @@ void UpdateUI()
                                             8.0f * progressbar.scale };
     progressbar.minValue     = 0.0f;
     progressbar.maxValue     = 100.0f;
-    progressbar.currentValue = (float)gameData.playerObject->entity.entityHealth;
+    progressbar.currentValue = (float)player->entityHealth;
     UI_old_ProgressBar(&progressbar);
 
     ItemSlot itemSlot;
@@ -916,13 +1382,14 @@ void UpdateUI()
         itemSlot.bounds =
             (Rectangle){ itemSlot.position.x, itemSlot.position.y, 8.0f * itemSlot.scale, 8.0f * itemSlot.scale };
         itemSlot.backgroundTexture = Texture_GetTextureByName("Anikki_square_8x8_211");
-        if (gameData.playerObject->entity.entityItems[i] == NULL)
+        uint16_t item;
+        if (!ObjectPool_Resolve(&gameData.objectPool, player->entityItems[i], &item))
         {
             itemSlot.itemTexture = NULL;
         }
         else
         {
-            itemSlot.itemTexture = Texture_GetTextureById(gameData.playerObject->entity.entityItems[i]->textureId);
+            itemSlot.itemTexture = Texture_GetTextureById(gameData.objectPool.textureIds[item]);
         }
         if (UI_old_ItemSlot(&itemSlot))
         {
@@ -939,13 +1406,15 @@ void UpdateUI()
             {
                 LOG_INF("Item slot %d released!", i);
                 // Pick up item if dragging
-                if (gameData.isDraggingObject && gameData.draggedObject != NULL)
+                uint16_t dragged;
+                if (gameData.isDraggingObject
+                    && ObjectPool_Resolve(&gameData.objectPool, gameData.draggedObject, &dragged))
                 {
-                    LOG_INF("Picking up item id %d", gameData.draggedObject->id);
-                    gameData.playerObject->entity.entityItems[i] = gameData.draggedObject;
-                    RemoveFromChunk(gameData.draggedObject);
+                    LOG_INF("Picking up item id %u", gameData.objectPool.ids[dragged]);
+                    player->entityItems[i] = gameData.draggedObject;
+                    RemoveFromChunk(dragged);
                     gameData.isDraggingObject = false;
-                    gameData.draggedObject    = NULL;
+                    gameData.draggedObject    = OBJECT_HANDLE_NULL;
                 }
             }
         }
@@ -954,31 +1423,38 @@ void UpdateUI()
 
 void UpdateDragItems()
 {
+    ObjectPool* pool = &gameData.objectPool;
+    uint16_t    playerIndex;
+    if (!ObjectPool_Resolve(pool, gameData.playerObject, &playerIndex))
+    {
+        return;
+    }
+    Vector2Int playerPos = { pool->positions[playerIndex].x, pool->positions[playerIndex].y };
     if (Input_IsMouseButtonPressed(INPUT_MOUSE_BUTTON_LEFT))
     {
         // LOG_INF("Mouse button down");
         Vector2    mousePos = { (float)(Input_GetMouseX()), (float)(Input_GetMouseY()) };
         Vector2    worldPos = GetScreenToWorld2D(mousePos, *Window_GetCamera());
         Vector3Int gridPos  = Utils_WorldToGrid(worldPos, TEXTURE_SIZE * TEXTURE_SCALE);
-        Object*    objects[MAX_LAYERS];
+        uint16_t   objects[MAX_LAYERS];
         uint8_t    objCount = GetObjectsAtPosition(gridPos, objects);
         if (objCount > 0)
         {
             for (uint16_t i = objCount; i > 0; i--)
             {
-                if (objects[i - 1]->type != Type::ITEM)
+                uint16_t index = objects[i - 1];
+                if (pool->types[index] != Type::ITEM)
                 {
                     continue;  // Skip items
                 }
-                Vector2Int playerPos = { gameData.playerObject->position.x, gameData.playerObject->position.y };
-                Vector2Int objectPos = { objects[i - 1]->position.x, objects[i - 1]->position.y };
+                Vector2Int objectPos = { pool->positions[index].x, pool->positions[index].y };
                 if (Utils_ManhattanDistance(playerPos, objectPos) > 5)
                 {
                     continue;  // Too far away
                 }
-                gameData.draggedObject    = objects[i - 1];  // Drag the topmost object
+                gameData.draggedObject    = ObjectPool_GetHandle(pool, index);  // Drag the topmost object
                 gameData.isDraggingObject = true;
-                LOG_INF("Dragging object id %d", gameData.draggedObject->id);
+                LOG_INF("Dragging object id %u", pool->ids[index]);
                 break;
             }
         }
@@ -986,24 +1462,29 @@ void UpdateDragItems()
     if (Input_IsMouseButtonReleased(INPUT_MOUSE_BUTTON_LEFT))
     {
         // LOG_INF("Mouse button released");
-        if (gameData.isDraggingObject)
+        uint16_t dragged;
+        if (gameData.isDraggingObject && ObjectPool_Resolve(pool, gameData.draggedObject, &dragged))
         {
-            Vector2Int playerPos = { gameData.playerObject->position.x, gameData.playerObject->position.y };
-            Vector2Int objectPos = { gameData.draggedObject->position.x, gameData.draggedObject->position.y };
+            Vector2Int objectPos = { pool->positions[dragged].x, pool->positions[dragged].y };
             if (Utils_ManhattanDistance(playerPos, objectPos) > 5)
             {
-                LOG_INF("Cannot drop object id %d, too far from player", gameData.draggedObject->id);
+                LOG_INF("Cannot drop object id %u, too far from player", pool->ids[dragged]);
                 gameData.isDraggingObject = false;
-                gameData.draggedObject    = NULL;
+                gameData.draggedObject    = OBJECT_HANDLE_NULL;
                 return;  // Too far away
             }
-            LOG_INF("Dropping dragged object id %d", gameData.draggedObject->id);
-            Vector2    mousePos              = { (float)(Input_GetMouseX()), (float)(Input_GetMouseY()) };
-            Vector2    worldPos              = GetScreenToWorld2D(mousePos, *Window_GetCamera());
-            Vector3Int gridPos               = Utils_WorldToGrid(worldPos, TEXTURE_SIZE * TEXTURE_SCALE);
-            gameData.draggedObject->position = gridPos;
-            gameData.isDraggingObject        = false;
-            gameData.draggedObject           = NULL;
+            LOG_INF("Dropping dragged object id %u", pool->ids[dragged]);
+            Vector2    mousePos       = { (float)(Input_GetMouseX()), (float)(Input_GetMouseY()) };
+            Vector2    worldPos       = GetScreenToWorld2D(mousePos, *Window_GetCamera());
+            Vector3Int gridPos        = Utils_WorldToGrid(worldPos, TEXTURE_SIZE * TEXTURE_SCALE);
+            pool->positions[dragged]  = gridPos;
+            gameData.isDraggingObject = false;
+            gameData.draggedObject    = OBJECT_HANDLE_NULL;
+        }
+        else
+        {
+            gameData.isDraggingObject = false;
+            gameData.draggedObject    = OBJECT_HANDLE_NULL;
         }
     }
 }
@@ -1015,21 +1496,41 @@ void MainMode_OnStart()
     Texture_LoadTextureSheet("resources/sprites/Anikki_square_8x8.png", 8, 8, 256);
 
     Window_GetCamera()->target = (Vector2){ 0.0f, 0.0f };
-    LoadWorldMap((char*)worldMap, WORLD_MAP_SIZE, WORLD_MAP_SIZE, gameData.chunks);
-    for (uint16_t i = 0; i < gameData.objectCount; i++)
+    ObjectPool_Initialize(&gameData.objectPool);
+    despawnQueueCount = 0;
+    moveQueueCount    = 0;
+    streamFrame       = 0;
+    streamEvictions   = 0;
+    // a new world is generated straight into the world file, after that it is the only copy and chunks stream in;
+    // the start room is in the corner at the origin, so the player streams in around the camera
+    if (!ChunkStreamer_Initialize(WORLD_FILE, true))
     {
-        Object* obj = &gameData.objects[i];
-        if (obj->type == Type::ENTITY)
+        LoadWorldMap((char*)worldMap, WORLD_MAP_SIZE, WORLD_MAP_SIZE, gameData.chunks);
+    }
+    else if (ChunkStreamer_GetStats().storedChunks == 0)
+    {
+        double start = GetTime();
+        if (!WorldGen_Generate((uint32_t)time(NULL), 0, NULL))
         {
-            Stopwatch_Stop(&obj->entity.entityMovementTimer);
-            Stopwatch_Stop(&obj->entity.entityAttackTimer);
+            LoadWorldMap((char*)worldMap, WORLD_MAP_SIZE, WORLD_MAP_SIZE, gameData.chunks);
         }
+        LOG_INF("Generated a new world in %.2f ms", (GetTime() - start) * 1000.0);
+    }
+    for (uint16_t row = 0; row < gameData.objectPool.entityCount; row++)
+    {
+        Stopwatch_Stop(&gameData.objectPool.entities[row].entityMovementTimer);
+        Stopwatch_Stop(&gameData.objectPool.entities[row].entityAttackTimer);
     }
     Sprite_SetPool(gameData.sprites, SPRITE_MAX_COUNT);
+    streamCameraPosition = { 0.0f, 0.0f };
+    Updatable_Initialize(&streamUpdatable, StreamChunks, "Chunk Streaming");
+    streamUpdatable.phase = UPDATABLE_PHASE_POST_UPDATE;
+    Context_AddUpdatable(&streamUpdatable);
 }
 
 void MainMode_OnPause()
 {
+    streamUpdatable.isEnabled = false;
 }
 
 void MainMode_Update()
@@ -1045,6 +1546,10 @@ void MainMode_Update()
     for (uint16_t i = 0; i < gameData.chunkCount; i++)
     {
         Chunk* chunk = &gameData.chunks[i];
+        if (IsInResidency(chunk->chunkPosition, camPosChunk))
+        {
+            chunk->lastUsedFrame = streamFrame;
+        }
         if (chunk->chunkPosition.x >= camPosChunk.x - 2 && chunk->chunkPosition.x <= camPosChunk.x + 2
             && chunk->chunkPosition.y >= camPosChunk.y - 1 && chunk->chunkPosition.y <= camPosChunk.y + 1
             && chunk->chunkPosition.z == camPosChunk.z)
@@ -1052,62 +1557,66 @@ void MainMode_Update()
             visibleChunks[visibleChunkCount++] = chunk;
         }
     }
+    ObjectPool* pool = &gameData.objectPool;
     for (uint32_t i = 0; i < visibleChunkCount; i++)
     {
         for (uint16_t j = 0; j < visibleChunks[i]->objectCount; j++)
         {
-            switch (visibleChunks[i]->objects[j]->type)
+            uint16_t index = visibleChunks[i]->objects[j];
+            switch (pool->types[index])
             {
                 case Type::TILE:
                 {
                     Sprite sprite;
                     Sprite_Initialize(&sprite);
-                    sprite.currentTexture = Texture_GetTextureById(visibleChunks[i]->objects[j]->textureId);
-                    sprite.position =
-                        Utils_GridToWorld(visibleChunks[i]->objects[j]->position, TEXTURE_SIZE * TEXTURE_SCALE);
-                    sprite.scale     = TEXTURE_SCALE;
-                    sprite.isVisible = true;
-                    sprite.zOrder    = visibleChunks[i]->objects[j]->layer;
+                    sprite.currentTexture = Texture_GetTextureById(pool->textureIds[index]);
+                    sprite.position       = Utils_GridToWorld(pool->positions[index], TEXTURE_SIZE * TEXTURE_SCALE);
+                    sprite.scale          = TEXTURE_SCALE;
+                    sprite.isVisible      = true;
+                    sprite.zOrder         = pool->layers[index];
                     Sprite_Add(&sprite);
                 }
                 break;
                 case Type::ENTITY:
                 {
-                    Object* obj = visibleChunks[i]->objects[j];
-                    if (obj->entity.entityType == EntityType::PLAYER)
+                    EntityData* entity = ObjectPool_GetEntity(pool, index);
+                    if (entity->entityType == EntityType::PLAYER)
                     {
-                        UpdatePlayer(obj);
+                        UpdatePlayer(index);
                     }
-                    else if (obj->entity.entityType == EntityType::ENEMY)
+                    else if (entity->entityType == EntityType::ENEMY)
                     {
-                        UpdateEnemy(obj);
+                        UpdateEnemy(index);
                     }
                 }
                 break;
                 case Type::PROJECTILE:
-                    UpdateProjectile(visibleChunks[i]->objects[j]);
+                    UpdateProjectile(index);
                     // Update projectile logic here
                     break;
                 case Type::EFFECT:
-                    UpdateEffect(visibleChunks[i]->objects[j]);
+                    UpdateEffect(index);
                     // Update effect logic here
                     break;
                 case Type::INTERACTIVE:
-                    UpdateInteractive(visibleChunks[i]->objects[j]);
+                    UpdateInteractive(index);
                     // Update interactive logic here
                     break;
                 case Type::ITEM:
-                    UpdateItem(visibleChunks[i]->objects[j]);
+                    UpdateItem(index);
                     // Update item logic here
                     break;
                 default:
                     break;
             }
-            UpdateObjectChunk(visibleChunks[i]->objects[j]);
+            UpdateObjectChunk(index);
         }
     }
+    FlushMovedObjects();
     UpdateUI();
     UpdateDragItems();
+    FlushDespawnedObjects();
+
     // update camera for sprite rendering
     gameData.cameraEntity.position = Window_GetCamera()->target;
     gameData.cameraEntity.scale    = 1.0f / Window_GetCamera()->zoom;
@@ -1115,11 +1624,21 @@ void MainMode_Update()
 
 void MainMode_OnStop()
 {
-    // SaveChunksToFile(gameData.chunks, gameData.chunkCount);
+    Context_RemoveUpdatable(&streamUpdatable);
+    // loads still in flight are dropped, a chunk they belong to is merged with its stored version when it is evicted
+    double   start      = GetTime();
+    uint16_t chunkCount = gameData.chunkCount;
+    while (gameData.chunkCount > 0)
+    {
+        EvictChunk(gameData.chunkCount - 1);
+    }
+    ChunkStreamer_Deinitialize();
+    LOG_INF("Unloaded %d chunks to %s in %.2f ms", chunkCount, WORLD_FILE, (GetTime() - start) * 1000.0);
     Texture_UnloadTextures();
     Audio_UnloadAudios();
 }
 
 void MainMode_OnResume()
 {
+    streamUpdatable.isEnabled = true;
 }
@@ -4,9 +4,12 @@
 #include "ashes/ash_components.h"
 #include "ashes/ash_context.h"
 #include "ashes/ash_debug.h"
+#include "ashes/ash_ecs.h"
 #include "ashes/ash_io.h"
 #include "ashes/ash_misc.h"
 
+#include <math.h>
+
 #define DIRECTION_SPEED_GROUND 1200.0f
 #define DIRECTION_SPEED_AIR    600.0f
 #define FRICTION_GROUND        600.0f
@@ -16,8 +19,10 @@
 #define PLAYER_MAX_SPEED       200.0f   // maximum speed from controls
 #define PLAYER_MAX_VELOCITY    1000.0f  // maximum speed from physics
 #define PLAYER_JUMP_FORCE      400.0f
+#define SPRITE_MAX             2048
+#define PLATFORM_QUERY_MAX     32
 
-Mode mainMode = MODE_FROM_CLASSNAME(MainMode);
+Mode mainMode = MODE_FROM_CLASSNAME_PRELOADED(MainMode);
 
 struct Player
 {
@@ -41,8 +46,11 @@ struct Platform
 
 struct Map
 {
-    Platform platforms[128];
-    uint8_t  platformCount;
+    Platform     platforms[128];  // hand placed test platforms, editor maps collide through tiles instead
+    uint8_t      platformCount;
+    SpatialHash  platformHash;
+    TileCollider tiles;
+    TileRects    solidRects;  // solid tiles merged into rectangles, for debug drawing and rect based consumers
 };
 
 struct GameData
@@ -55,13 +63,19 @@ struct GameData
 
 TextureData textures[512];
 TextureData texture;
-Sprite      sprites[2048];
+Image       textureImage;
+Sprite*     sprites     = NULL;
 uint16_t    spriteCount = 0;
 
 static TextureData editorTileTextures[MAP_TILESET_COUNT];
 static TextureData editorTileAtlasBase;
+static Image       editorTileAtlasImage;
 static bool        editorTilesLoaded = false;
 
+static EcsComponentId transformComponent = ECS_COMPONENT_INVALID;
+static EcsComponentId spriteComponent    = ECS_COMPONENT_INVALID;
+static EcsQuery*      spriteQuery        = NULL;
+
 void DrawDebug()
 {
     Vector2Float originPoint = { -400, -300 };
@@ -79,32 +93,121 @@ void DrawDebug()
              originPoint.y + 120, 20, WHITE);
     DrawText(TextFormat("Player wallCoyoteTime: %s", Stopwatch_IsRunning(&gameData.player.wallCoyoteTime) ? "true" : "false"), originPoint.x,
              originPoint.y + 150, 20, WHITE);
+    DrawText(TextFormat("Solid tile rects: %u (merged in %.3f ms)", gameData.map.solidRects.rectCount,
+                        gameData.map.solidRects.lastMergeTime * 1000.0),
+             originPoint.x, originPoint.y + 180, 20, WHITE);
+}
+
+/* world area on screen, with a tile of slack for the camera catching up this frame */
+static Rectangle GetCameraView()
+{
+    Camera2D* camera   = Window_GetCamera();
+    Vector2   topLeft  = GetScreenToWorld2D((Vector2){ 0.0f, 0.0f }, *camera);
+    Vector2   botRight = GetScreenToWorld2D((Vector2){ (float)GetScreenWidth(), (float)GetScreenHeight() }, *camera);
+    return (Rectangle){ topLeft.x - TILE_SIZE, topLeft.y - TILE_SIZE, botRight.x - topLeft.x + 2 * TILE_SIZE,
+                        botRight.y - topLeft.y + 2 * TILE_SIZE };
 }
 
 static void DrawEditorTiles()
 {
     if (!g_editorTestMapData.isValid || !editorTilesLoaded)
         return;
+    /* only tiles inside the view become sprites, layer by layer so they keep their draw order */
+    Rectangle  view = GetCameraView();
+    Vector2Int min  = { (int32_t)floorf(view.x / TILE_SIZE), (int32_t)floorf(view.y / TILE_SIZE) };
+    Vector2Int max  = { (int32_t)floorf((view.x + view.width) / TILE_SIZE),
+                        (int32_t)floorf((view.y + view.height) / TILE_SIZE) };
     for (int l = 0; l < MAP_MAX_LAYERS; l++)
     {
-        TileLayer* layer = &g_editorTestMapData.mapData.layers[l];
-        for (int i = 0; i < (int)layer->tileCount && spriteCount < 2047; i++)
+        TileIterator iterator = TileLayer_IterateRect(min, max);
+        Tile         tile;
+        while (spriteCount < SPRITE_MAX - 1
+               && TileLayer_Next(&g_editorTestMapData.mapData.layers[l], &iterator, &tile))
         {
-            Tile* tile = &layer->tiles[i];
-            if (tile->textureId >= MAP_TILESET_COUNT)
+            if (tile.textureId >= MAP_TILESET_COUNT)
                 continue;
             Sprite_Initialize(&sprites[spriteCount]);
-            sprites[spriteCount].currentTexture = &editorTileTextures[tile->textureId];
-            sprites[spriteCount].position.x     = (float)(tile->position.x * TILE_SIZE);
-            sprites[spriteCount].position.y     = (float)(tile->position.y * TILE_SIZE);
+            sprites[spriteCount].currentTexture = &editorTileTextures[tile.textureId];
+            sprites[spriteCount].position.x     = (float)(tile.position.x * TILE_SIZE);
+            sprites[spriteCount].position.y     = (float)(tile.position.y * TILE_SIZE);
             sprites[spriteCount].scale          = 2.0f;
             spriteCount++;
         }
     }
 }
 
+/* sprite transform system: every entity with an Entity2D and a Sprite is resolved to world space into the frame's
+ * sprite list, one linear pass over the query's columns */
+static void UpdateSpriteSystem()
+{
+    PROFILE_ZONE("Sprite System");
+    EcsIterator iterator;
+    Ecs_QueryBegin(spriteQuery, &iterator);
+    while (Ecs_QueryNext(&iterator))
+    {
+        Entity2D* transforms = Ecs_Column(&iterator, Entity2D, transformComponent);
+        Sprite*   source     = Ecs_Column(&iterator, Sprite, spriteComponent);
+        for (uint16_t i = 0; i < iterator.count && spriteCount < SPRITE_MAX; i++)
+        {
+            const Transform2D* world  = Entity2D_GetWorld(&transforms[i]);
+            Sprite*            sprite = &sprites[spriteCount++];
+            *sprite                   = source[i];
+            sprite->position          = Entity2D_TransformPoint(&transforms[i], source[i].position);
+            sprite->scale             = source[i].scale * world->scale;
+            sprite->rotation          = source[i].rotation + world->rotation;
+            sprite->parent            = NULL;
+        }
+    }
+}
+
+static void CreateSpriteEntities()
+{
+    Ecs_Initialize();
+    transformComponent    = Ecs_RegisterComponentType(Entity2D);
+    spriteComponent       = Ecs_RegisterComponentType(Sprite);
+    EcsComponentMask mask = Ecs_ComponentBit(transformComponent) | Ecs_ComponentBit(spriteComponent);
+    spriteQuery           = Ecs_CreateQuery(mask, 0);
+
+    /* the player sprite follows the player body as its child */
+    EcsEntity player = Ecs_CreateEntity(mask);
+    if (player == ECS_ENTITY_NULL)
+    {
+        LOG_ERR("Failed to create the player sprite entity");
+        return;
+    }
+    Entity2D* transform = (Entity2D*)Ecs_GetComponent(player, transformComponent);
+    Entity2D_Initialize(transform);
+    Entity2D_SetParent(transform, &gameData.player.entity);
+    Sprite* sprite = (Sprite*)Ecs_GetComponent(player, spriteComponent);
+    Sprite_Initialize(sprite);
+    sprite->currentTexture = &textures[0];
+    sprite->scale          = 2.0f;
+}
+
+// Earliest hit of the player box against the map tiles and the platforms found around its whole motion.
+static bool CastMap(Rectangle box, Vector2Float delta, SweepHit* hit, void* context)
+{
+    Collider2D* nearby[PLATFORM_QUERY_MAX];
+    uint32_t    nearbyCount = SpatialHash_QueryRect(&gameData.map.platformHash, Sweep_GetBounds(box, delta), nearby,
+                                                    PLATFORM_QUERY_MAX);
+    bool        found       = TileCollider_Sweep(&gameData.map.tiles, box, delta, hit);
+    for (uint32_t i = 0; i < nearbyCount; i++)
+    {
+        SweepHit platformHit;
+        if (Sweep_Rect(box, delta, Collider2D_GetBounds(nearby[i]), &platformHit)
+            && (!found || platformHit.time < hit->time))
+        {
+            *hit          = platformHit;
+            hit->userData = nearby[i];
+            found         = true;
+        }
+    }
+    return found;
+}
+
 void UpdateGame()
 {
+    PROFILE_FUNCTION();
     // get input
     int  directionX = { -Input_IsKeyDown(KEY_A) + Input_IsKeyDown(KEY_D) };
     int  directionY = { -Input_IsKeyDown(KEY_S) + Input_IsKeyDown(KEY_W) };
@@ -244,27 +347,64 @@ void UpdateGame()
         Utils_ClampFloat(gameData.player.velocity.x, -PLAYER_MAX_VELOCITY, PLAYER_MAX_VELOCITY);
 
 
-    gameData.player.entity.position.y += gameData.player.velocity.y * gameData.dt;
-    gameData.player.entity.position.x += gameData.player.velocity.x * gameData.dt;
-
-    // check collisions
+    // sweep the move so a fast fall at a low frame rate stops on the first platform instead of passing through it
     gameData.player.onGround = false;
-    for (uint32_t i = 0; i < gameData.map.platformCount; i++)
+    Rectangle    playerStart = Collider2D_GetBounds(&gameData.player.collider);
+    Rectangle    playerEnd   = playerStart;
+    Vector2Float motion      = { gameData.player.velocity.x * gameData.dt, gameData.player.velocity.y * gameData.dt };
+    SweepHit     hits[SWEEP_MAX_ITERATIONS];
+    uint32_t     hitCount = Sweep_MoveAndSlide(&playerEnd, motion, CastMap, NULL, hits, SWEEP_MAX_ITERATIONS);
+    gameData.player.entity.position.x += playerEnd.x - playerStart.x;
+    gameData.player.entity.position.y += playerEnd.y - playerStart.y;
+    if (hitCount > 0)
+    {
+        gameData.player.velocityBeforeCollision.x = gameData.player.velocity.x;
+        gameData.player.velocityBeforeCollision.y = gameData.player.velocity.y;
+    }
+    for (uint32_t i = 0; i < hitCount; i++)
     {
-        if (Collider2D_CheckCollider(&gameData.player.collider, &gameData.map.platforms[i].collider))
+        if (hits[i].normal.x != 0.0f)
+        {
+            gameData.player.onWall     = hits[i].normal.x < 0.0f ? 1 : -1;
+            gameData.player.velocity.x = 0.0f;
+            Stopwatch_Start(&gameData.player.wallCoyoteTime, 100);
+        }
+        else
         {
-            Vector2Float playerPos    = { gameData.player.entity.position.x, gameData.player.entity.position.y };
-            Vector2Float playerSize   = { gameData.player.collider.size.x, gameData.player.collider.size.y };
-            Vector2Float platformPos  = { gameData.map.platforms[i].entity.position.x,
-                                          gameData.map.platforms[i].entity.position.y };
-            Vector2Float platformSize = { gameData.map.platforms[i].collider.size.x,
-                                          gameData.map.platforms[i].collider.size.y };
-
-            float overlapX = Utils_MinFloat(playerPos.x + playerSize.x, platformPos.x + platformSize.x)
-                             - Utils_MaxFloat(playerPos.x, platformPos.x);
-            float overlapY = Utils_MinFloat(playerPos.y + playerSize.y, platformPos.y + platformSize.y)
-                             - Utils_MaxFloat(playerPos.y, platformPos.y);
+            gameData.player.onGround   = gameData.player.onGround || hits[i].normal.y < 0.0f;
+            gameData.player.velocity.y = 0.0f;
+        }
+    }
 
+    // push out of anything the player already overlapped before the move, only solid tiles and nearby platforms
+    Rectangle   playerBounds = Collider2D_GetBounds(&gameData.player.collider);
+    Rectangle   overlapping[PLATFORM_QUERY_MAX];
+    uint32_t    overlapCount = TileCollider_QueryRect(&gameData.map.tiles, playerBounds, TILECOLLIDER_SOLID,
+                                                      overlapping, PLATFORM_QUERY_MAX);
+    Collider2D* nearby[PLATFORM_QUERY_MAX];
+    uint32_t    nearbyCount  = SpatialHash_QueryRect(&gameData.map.platformHash, playerBounds, nearby,
+                                                     PLATFORM_QUERY_MAX);
+    for (uint32_t i = 0; i < nearbyCount && overlapCount < PLATFORM_QUERY_MAX; i++)
+    {
+        if (Collider2D_CheckCollider(&gameData.player.collider, nearby[i]))
+        {
+            overlapping[overlapCount++] = Collider2D_GetBounds(nearby[i]);
+        }
+    }
+    for (uint32_t i = 0; i < overlapCount; i++)
+    {
+        Vector2Float playerPos    = { gameData.player.entity.position.x, gameData.player.entity.position.y };
+        Vector2Float playerSize   = { gameData.player.collider.size.x, gameData.player.collider.size.y };
+        Vector2Float platformPos  = { overlapping[i].x, overlapping[i].y };
+        Vector2Float platformSize = { overlapping[i].width, overlapping[i].height };
+
+        float overlapX = Utils_MinFloat(playerPos.x + playerSize.x, platformPos.x + platformSize.x)
+                         - Utils_MaxFloat(playerPos.x, platformPos.x);
+        float overlapY = Utils_MinFloat(playerPos.y + playerSize.y, platformPos.y + platformSize.y)
+                         - Utils_MaxFloat(playerPos.y, platformPos.y);
+        // an earlier push can already have moved the player out of this one
+        if (overlapX > 0.0f && overlapY > 0.0f)
+        {
             gameData.player.velocityBeforeCollision.x = gameData.player.velocity.x;
             gameData.player.velocityBeforeCollision.y = gameData.player.velocity.y;
             if (overlapX < overlapY)
@@ -300,20 +440,44 @@ void UpdateGame()
     };
 
     // Update sprites
-    sprites[spriteCount].position.x     = gameData.player.entity.position.x;
-    sprites[spriteCount].position.y     = gameData.player.entity.position.y;
-    sprites[spriteCount].currentTexture = &textures[0];
-    sprites[spriteCount].scale          = 2.0f;
-    spriteCount++;
+    UpdateSpriteSystem();
 
     // Draw debug
     Collider2D_DrawDebug(&gameData.player.collider);
+    TileCollider_DrawDebug(&gameData.map.tiles, GetCameraView(), TILECOLLIDER_ONE_WAY);
+    TileRects_DrawDebug(&gameData.map.solidRects, GetCameraView());
     for (uint32_t i = 0; i < gameData.map.platformCount; i++)
     {
         Collider2D_DrawDebug(&gameData.map.platforms[i].collider);
     }
 }
 
+void MainMode_OnPreload()
+{
+    textureImage = Texture_LoadImage("resources/sprites/font.png");
+    if (g_editorTestMapData.isValid)
+        editorTileAtlasImage = Texture_LoadImage("resources/sprites/tileset.png");
+}
+
+void MainMode_OnPreloadDiscard()
+{
+    Texture_UnloadImage(&textureImage);
+    Texture_UnloadImage(&editorTileAtlasImage);
+}
+
+/* collision reads the editor map in place, so any map size collides */
+static void BuildTileCollider(MapData* map)
+{
+    if (!TileCollider_Initialize(&gameData.map.tiles, (float)TILE_SIZE, MapData_GetCollisionFlags, map))
+        return;
+    if (!TileRects_Initialize(&gameData.map.solidRects, &gameData.map.tiles, TILECOLLIDER_SOLID))
+        return;
+    MapData_MarkSolidCells(map, &gameData.map.solidRects);
+    TileRects_Update(&gameData.map.solidRects);
+    LOG_INF("Merged solid tiles into %u rects in %.3f ms", gameData.map.solidRects.rectCount,
+            gameData.map.solidRects.lastMergeTime * 1000.0);
+}
+
 void MainMode_OnStart()
 {
     editorTilesLoaded          = false;
@@ -327,34 +491,14 @@ void MainMode_OnStart()
 
     if (g_editorTestMapData.isValid)
     {
-        /* Build platforms from editor SOLID / JUMP_PLATFORM tiles */
-        for (int l = 0; l < MAP_MAX_LAYERS; l++)
+        BuildTileCollider(&g_editorTestMapData.mapData);
+        if (g_editorTestMapData.hasPlayerSpawn)
         {
-            TileLayer* layer = &g_editorTestMapData.mapData.layers[l];
-            for (int i = 0; i < (int)layer->tileCount; i++)
-            {
-                Tile* tile = &layer->tiles[i];
-                if ((tile->type == TILE_TYPE_SOLID || tile->type == TILE_TYPE_JUMP_PLATFORM)
-                    && gameData.map.platformCount < 128)
-                {
-                    Platform* p = &gameData.map.platforms[gameData.map.platformCount++];
-                    Entity2D_Initialize(&p->entity);
-                    Collider2D_Initialize(&p->collider);
-                    Sprite_Initialize(&p->sprite);
-                    p->entity.position.x = (float)(tile->position.x * TILE_SIZE);
-                    p->entity.position.y = (float)(tile->position.y * TILE_SIZE);
-                    p->collider.parent   = &p->entity;
-                    p->collider.size     = (Vector2Float){ (float)TILE_SIZE, (float)TILE_SIZE };
-                }
-                if (tile->type == TILE_TYPE_PLAYER_SPAWN)
-                {
-                    gameData.player.entity.position.x = (float)(tile->position.x * TILE_SIZE);
-                    gameData.player.entity.position.y = (float)(tile->position.y * TILE_SIZE);
-                }
-            }
+            gameData.player.entity.position.x = (float)(g_editorTestMapData.playerSpawn.x * TILE_SIZE);
+            gameData.player.entity.position.y = (float)(g_editorTestMapData.playerSpawn.y * TILE_SIZE);
         }
         /* Load tileset for visual rendering */
-        editorTileAtlasBase = Texture_LoadTexture("resources/sprites/tileset.png");
+        editorTileAtlasBase = Texture_LoadTextureFromImage(&editorTileAtlasImage);
         if (Texture_CreateTextureAtlas(editorTileAtlasBase, MAP_TILESET_COLS, MAP_TILESET_ROWS, editorTileTextures))
             editorTilesLoaded = true;
     }
@@ -385,17 +529,20 @@ void MainMode_OnStart()
         gameData.map.platformCount++;
     }
 
-    texture = Texture_LoadTexture("resources/sprites/font.png");
+    SpatialHash_Initialize(&gameData.map.platformHash, (float)(TILE_SIZE * 2), SPATIALHASH_DEFAULT_BUCKETS);
+    for (uint32_t i = 0; i < gameData.map.platformCount; i++)
+    {
+        SpatialHash_Insert(&gameData.map.platformHash, &gameData.map.platforms[i].collider);
+    }
+
+    texture = Texture_LoadTextureFromImage(&textureImage);
     LOG_INF("Loaded texture: %s, width: %d, height: %d", "resources/sprites/player.png", texture.size.x,
             texture.size.y);
     if (!Texture_CreateTextureAtlas(texture, 16, 16, textures))
     {
         LOG_ERR("Failed to create texture atlas");
     }
-    for (uint32_t i = 0; i < 2048; i++)
-    {
-        Sprite_Initialize(&sprites[i]);
-    }
+    CreateSpriteEntities();
 }
 
 void MainMode_OnPause()
@@ -404,7 +551,10 @@ void MainMode_OnPause()
 
 void MainMode_Update()
 {
+    sprites     = FrameArena_AllocArray(Sprite, SPRITE_MAX);
     spriteCount = 0;
+    if (sprites == NULL)
+        return;
     DeltaTime_Update();
     gameData.dt = DeltaTime_GetDeltaTime();
 
@@ -419,17 +569,26 @@ void MainMode_Update()
     camera->target.x    = gameData.player.entity.position.x;
     camera->target.y    = gameData.player.entity.position.y;
 
+    PROFILE_BEGIN("Draw Sprites");
     for (uint16_t i = 0; i < spriteCount; i++)
         Sprite_Draw(&sprites[i]);
+    PROFILE_END();
 
     DrawDebug();
 }
 
 void MainMode_OnStop()
 {
+    Ecs_Deinitialize();
+    spriteQuery = NULL;
+    SpatialHash_Deinitialize(&gameData.map.platformHash);
+    TileRects_Deinitialize(&gameData.map.solidRects);
+    TileCollider_Deinitialize(&gameData.map.tiles);
     if (editorTilesLoaded)
         Texture_UnloadTexture(&editorTileAtlasBase);
+    Texture_UnloadTexture(&texture);
     g_editorTestMapData.isValid = false;
+    MapData_Clear(&g_editorTestMapData.mapData);
 }
 
 void MainMode_OnResume()
@@ -11,5 +11,7 @@ void MainMode_OnPause();
 void MainMode_Update();
 void MainMode_OnStop();
 void MainMode_OnResume();
+void MainMode_OnPreload();
+void MainMode_OnPreloadDiscard();
 
 #endif
@@ -0,0 +1,308 @@
+#include "MapAutosave.h"
+
+#include "MapFile.h"
+#include "ashes/ash_debug.h"
+#include "ashes/ash_file.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <raylib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+struct MapJournalBatch
+{
+    MapJournalRecord* records  = NULL;
+    uint32_t          count    = 0;
+    uint32_t          capacity = 0;
+};
+
+static MapData          autosaveShadow;   // worker only, the map as of the last journaled batch
+static MapJournalBatch  autosavePending;  // filled by the main thread, guarded by autosaveMutex
+static MapJournalBatch  autosaveWriting;  // worker only
+static FILE*            autosaveJournal      = NULL;
+static size_t           autosaveJournalBytes = 0;
+static double           autosaveLastTime     = 0.0;
+static bool             autosaveIsCleared    = false;
+static bool             autosaveIsRunning    = false;
+static bool             autosaveIsStopping   = false;
+static MapAutosaveStats autosaveStats        = {};
+
+static std::thread             autosaveThread;
+static std::mutex              autosaveMutex;
+static std::condition_variable autosaveWake;
+static std::atomic<uint32_t>   autosaveRecords(0);  // written by the worker, read by GetStats
+static std::atomic<uint32_t>   autosaveCompactions(0);
+
+static bool MapAutosave_Exists(const char* fileName)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+        return false;
+    fclose(f);
+    return true;
+}
+
+static uint32_t MapAutosave_Checksum(const MapJournalRecord* record)
+{
+    return File_Fnv1a(FNV_OFFSET, record, offsetof(MapJournalRecord, checksum));
+}
+
+static bool MapAutosave_Apply(MapData* map, const MapJournalRecord* record)
+{
+    if (record->type == MAP_JOURNAL_CLEAR)
+    {
+        MapData_Clear(map);
+        return true;
+    }
+    return TileLayer_SetChunk(&map->layers[record->layer], record->x, record->y, record->textureIds, record->types);
+}
+
+static bool MapAutosave_Reserve(MapJournalBatch* batch, uint32_t count)
+{
+    if (count <= batch->capacity)
+        return true;
+    uint32_t capacity = batch->capacity == 0 ? 64 : batch->capacity;
+    while (capacity < count)
+        capacity *= 2;
+    MapJournalRecord* records = (MapJournalRecord*)realloc(batch->records, capacity * sizeof(MapJournalRecord));
+    if (records == NULL)
+        return false;
+    batch->records  = records;
+    batch->capacity = capacity;
+    return true;
+}
+
+/*
+ * Writes the shadow map as the new autosave and only then starts an empty journal, so a crash at any point leaves
+ * either the old autosave with its journal or the new one. Replaying a journal over an autosave that already holds it
+ * is harmless since every record carries whole chunks.
+ */
+static bool MapAutosave_Compact()
+{
+    if (!MapFile_Save(&autosaveShadow, MAP_AUTOSAVE_FILE))
+    {
+        LOG_ERR("MapAutosave: compaction failed, the journal keeps growing");
+        if (autosaveJournal == NULL)
+            autosaveJournal = fopen(MAP_JOURNAL_FILE, "ab");
+        return false;
+    }
+    if (autosaveJournal != NULL)
+        fclose(autosaveJournal);
+    autosaveJournal      = fopen(MAP_JOURNAL_FILE, "wb");
+    autosaveJournalBytes = 0;
+    autosaveRecords      = 0;
+    autosaveCompactions++;
+    if (autosaveJournal == NULL)
+        LOG_ERR("MapAutosave: cannot open '%s', edits are no longer journaled", MAP_JOURNAL_FILE);
+    return true;
+}
+
+static void MapAutosave_WriteBatch(MapJournalBatch* batch)
+{
+    for (uint32_t i = 0; i < batch->count; i++)
+        batch->records[i].checksum = MapAutosave_Checksum(&batch->records[i]);
+    if (autosaveJournal != NULL)
+    {
+        if (fwrite(batch->records, sizeof(MapJournalRecord), batch->count, autosaveJournal) != batch->count
+            || !File_Sync(autosaveJournal))
+            LOG_ERR("MapAutosave: failed writing '%s'", MAP_JOURNAL_FILE);
+        autosaveJournalBytes += batch->count * sizeof(MapJournalRecord);
+        autosaveRecords += batch->count;
+    }
+    for (uint32_t i = 0; i < batch->count; i++)
+    {
+        if (!MapAutosave_Apply(&autosaveShadow, &batch->records[i]))
+            LOG_ERR("MapAutosave: shadow map out of memory");
+    }
+    batch->count = 0;
+}
+
+static void MapAutosave_Worker()
+{
+    /* the map handed to Start may hold a replayed journal, fold it in before appending to a fresh one */
+    MapAutosave_Compact();
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(autosaveMutex);
+            autosaveWake.wait(lock, [] { return autosavePending.count > 0 || autosaveIsStopping; });
+            if (autosavePending.count == 0)
+                break;
+            MapJournalBatch batch = autosavePending;
+            autosavePending       = autosaveWriting;
+            autosaveWriting       = batch;
+        }
+        MapAutosave_WriteBatch(&autosaveWriting);
+        if (autosaveJournalBytes >= MAP_JOURNAL_COMPACT_AT)
+            MapAutosave_Compact();
+    }
+    if (autosaveJournalBytes > 0)
+        MapAutosave_Compact();
+    if (autosaveJournal != NULL)
+        fclose(autosaveJournal);
+    autosaveJournal = NULL;
+}
+
+/* copies every chunk changed since the last snapshot, the only autosave work the main thread does */
+static void MapAutosave_Snapshot(MapData* map)
+{
+    double   start = GetTime();
+    uint32_t count = autosaveIsCleared ? 1 : 0;
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        for (uint32_t i = 0; i < map->layers[l].chunkCount; i++)
+            count += map->layers[l].chunks[i]->isDirty;
+    }
+    if (count == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(autosaveMutex);
+    if (!MapAutosave_Reserve(&autosavePending, autosavePending.count + count))
+    {
+        LOG_ERR("MapAutosave: out of memory, snapshot skipped");
+        return;
+    }
+    if (autosaveIsCleared)
+    {
+        MapJournalRecord* record = &autosavePending.records[autosavePending.count++];
+        memset(record, 0, sizeof(MapJournalRecord));
+        record->magic     = MAP_JOURNAL_MAGIC;
+        record->type      = MAP_JOURNAL_CLEAR;
+        autosaveIsCleared = false;
+    }
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        for (uint32_t i = 0; i < map->layers[l].chunkCount; i++)
+        {
+            TileChunk* chunk = map->layers[l].chunks[i];
+            if (!chunk->isDirty)
+                continue;
+            MapJournalRecord* record = &autosavePending.records[autosavePending.count++];
+            record->magic            = MAP_JOURNAL_MAGIC;
+            record->type             = MAP_JOURNAL_CHUNK;
+            record->layer            = (uint8_t)l;
+            record->reserved         = 0;
+            record->x                = chunk->position.x;
+            record->y                = chunk->position.y;
+            memcpy(record->textureIds, chunk->textureIds, sizeof(record->textureIds));
+            memcpy(record->types, chunk->types, sizeof(record->types));
+            chunk->isDirty = false;
+        }
+    }
+    autosaveWake.notify_one();
+    autosaveStats.snapshots++;
+    autosaveStats.lastSnapshotTime = GetTime() - start;
+}
+
+/* leaves the map untouched when there is nothing to recover */
+bool MapAutosave_Recover(MapData* map)
+{
+    bool isRecovered = false;
+    if (MapAutosave_Exists(MAP_AUTOSAVE_FILE))
+    {
+        MapFile file;
+        if (MapFile_Open(&file, MAP_AUTOSAVE_FILE))
+        {
+            if (!MapFile_Load(&file, map))
+                LOG_WRN("MapAutosave: '%s' has corrupt chunks, they were skipped", MAP_AUTOSAVE_FILE);
+            MapFile_Close(&file);
+            isRecovered = true;
+        }
+    }
+
+    FILE* journal = fopen(MAP_JOURNAL_FILE, "rb");
+    if (!journal)
+        return isRecovered;
+    MapJournalRecord record;
+    uint32_t         replayed = 0;
+    while (fread(&record, sizeof(record), 1, journal) == 1)
+    {
+        if (record.magic != MAP_JOURNAL_MAGIC || record.checksum != MapAutosave_Checksum(&record)
+            || record.type > MAP_JOURNAL_CLEAR || record.layer >= MAP_MAX_LAYERS)
+        {
+            LOG_WRN("MapAutosave: journal ends in a damaged record, later edits are lost");
+            break;
+        }
+        if (!isRecovered)
+            MapData_Clear(map);
+        isRecovered = true;
+        if (!MapAutosave_Apply(map, &record))
+            break;
+        replayed++;
+    }
+    fclose(journal);
+    if (isRecovered)
+        LOG_INF("MapAutosave: recovered the map, %u journal records replayed", replayed);
+    return isRecovered;
+}
+
+void MapAutosave_Start(MapData* map)
+{
+    if (autosaveIsRunning)
+        return;
+    if (!MapData_Copy(&autosaveShadow, map))
+    {
+        LOG_ERR("MapAutosave: cannot copy the map, autosave is off");
+        return;
+    }
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        for (uint32_t i = 0; i < map->layers[l].chunkCount; i++)
+            map->layers[l].chunks[i]->isDirty = false;
+    }
+    autosaveStats        = MapAutosaveStats();
+    autosaveRecords      = 0;
+    autosaveCompactions  = 0;
+    autosaveJournalBytes = 0;
+    autosaveLastTime     = GetTime();
+    autosaveIsCleared    = false;
+    autosaveIsStopping   = false;
+    autosaveIsRunning    = true;
+    autosaveThread       = std::thread(MapAutosave_Worker);
+}
+
+void MapAutosave_Update(MapData* map)
+{
+    if (!autosaveIsRunning || GetTime() - autosaveLastTime < MAP_AUTOSAVE_INTERVAL)
+        return;
+    autosaveLastTime = GetTime();
+    MapAutosave_Snapshot(map);
+}
+
+void MapAutosave_MarkCleared()
+{
+    autosaveIsCleared = true;
+}
+
+void MapAutosave_Stop(MapData* map)
+{
+    if (!autosaveIsRunning)
+        return;
+    MapAutosave_Snapshot(map);
+    {
+        std::lock_guard<std::mutex> lock(autosaveMutex);
+        autosaveIsStopping = true;
+    }
+    autosaveWake.notify_one();
+    autosaveThread.join();
+    autosaveIsRunning = false;
+
+    MapData_Clear(&autosaveShadow);
+    free(autosavePending.records);
+    free(autosaveWriting.records);
+    autosavePending = MapJournalBatch();
+    autosaveWriting = MapJournalBatch();
+}
+
+MapAutosaveStats MapAutosave_GetStats()
+{
+    MapAutosaveStats stats = autosaveStats;
+    stats.records          = autosaveRecords;
+    stats.compactions      = autosaveCompactions;
+    return stats;
+}
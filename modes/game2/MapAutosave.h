@@ -0,0 +1,54 @@
+#ifndef LIBS_ENGINE_MAPAUTOSAVE_H
+#define LIBS_ENGINE_MAPAUTOSAVE_H
+#include "TileMap.h"
+
+#include <stdint.h>
+
+#define MAP_AUTOSAVE_FILE       "map.autosave.bin"
+#define MAP_JOURNAL_FILE        "map.journal"
+#define MAP_AUTOSAVE_INTERVAL   2.0                 // seconds between snapshots of the dirty chunks
+#define MAP_JOURNAL_COMPACT_AT  (4 * 1024 * 1024)   // journal bytes before it is folded into the autosave
+#define MAP_JOURNAL_MAGIC       0x4C4E524A          // "JRNL" read as a little endian uint32
+
+enum MapJournalType
+{
+    MAP_JOURNAL_CHUNK = 0,  // whole chunk, replaces whatever was there
+    MAP_JOURNAL_CLEAR = 1,  // every layer was emptied
+};
+
+/* one journal entry, a torn write at the tail fails its checksum and ends the replay there */
+struct MapJournalRecord
+{
+    uint32_t magic;
+    uint8_t  type;
+    uint8_t  layer;
+    uint16_t reserved;
+    int32_t  x;  // chunk coordinates
+    int32_t  y;
+    uint16_t textureIds[TILE_CHUNK_CELLS];
+    uint8_t  types[TILE_CHUNK_CELLS];
+    uint32_t checksum;  // FNV-1a of everything above
+};
+
+struct MapAutosaveStats
+{
+    uint32_t snapshots;
+    uint32_t records;      // journal records written since the last compaction
+    uint32_t compactions;
+    double   lastSnapshotTime;  // main thread cost of the last snapshot, in seconds
+};
+
+/*
+ * Crash safety for the editor. Changed chunks are copied out once per interval at the end of a frame and handed to a
+ * worker thread, which appends them to a journal and syncs it before the next batch. The worker also keeps a shadow
+ * copy of the map and, once the journal grows past MAP_JOURNAL_COMPACT_AT, writes the shadow as the autosave map and
+ * starts a new journal. Recovery loads the autosave and replays the journal over it.
+ */
+bool             MapAutosave_Recover(MapData* map);
+void             MapAutosave_Start(MapData* map);
+void             MapAutosave_Update(MapData* map);  // call once per frame, after every edit of the frame
+void             MapAutosave_MarkCleared();         // call after MapData_Clear or a load replaced the map
+void             MapAutosave_Stop(MapData* map);    // journals what is left, compacts and joins the worker
+MapAutosaveStats MapAutosave_GetStats();
+
+#endif  // LIBS_ENGINE_MAPAUTOSAVE_H
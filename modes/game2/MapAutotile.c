@@ -0,0 +1,297 @@
+#include "MapAutotile.h"
+
+#include "MapHistory.h"
+#include "ashes/ash_debug.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static AutotileSet autotileSets[AUTOTILE_MAX_SETS];
+static uint32_t    autotileSetCount = 0;
+static uint8_t     autotileSetOf[AUTOTILE_MAX_TEXTURES];  // set of every texture id, AUTOTILE_SET_NONE if it has none
+static bool        autotileIsLoaded = false;
+
+/* cell offsets in neighbor bit order, y grows downwards */
+static const int8_t autotileOffsets[8][2] = {
+    { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 }, { 1, -1 }, { 1, 1 }, { -1, 1 }, { -1, -1 },
+};
+
+static const struct
+{
+    const char* name;
+    uint8_t     bit;
+} autotileNames[] = {
+    { "N", AUTOTILE_N },   { "E", AUTOTILE_E },   { "S", AUTOTILE_S },   { "W", AUTOTILE_W },
+    { "NE", AUTOTILE_NE }, { "SE", AUTOTILE_SE }, { "SW", AUTOTILE_SW }, { "NW", AUTOTILE_NW },
+};
+
+/* drops the bits a set does not look at, corners only matter when both sides next to them match */
+static uint8_t MapAutotile_Reduce(uint8_t mask, uint8_t neighbors)
+{
+    if (neighbors == 4)
+        return mask & 0x0F;
+    if ((mask & (AUTOTILE_N | AUTOTILE_E)) != (AUTOTILE_N | AUTOTILE_E))
+        mask &= ~AUTOTILE_NE;
+    if ((mask & (AUTOTILE_S | AUTOTILE_E)) != (AUTOTILE_S | AUTOTILE_E))
+        mask &= ~AUTOTILE_SE;
+    if ((mask & (AUTOTILE_S | AUTOTILE_W)) != (AUTOTILE_S | AUTOTILE_W))
+        mask &= ~AUTOTILE_SW;
+    if ((mask & (AUTOTILE_N | AUTOTILE_W)) != (AUTOTILE_N | AUTOTILE_W))
+        mask &= ~AUTOTILE_NW;
+    return mask;
+}
+
+/* "-" for no neighbors, otherwise directions joined by '+', e.g. "N+E+NE" */
+static bool MapAutotile_ParseMask(const char* text, uint8_t* mask)
+{
+    *mask = 0;
+    if (strcmp(text, "-") == 0)
+        return true;
+    while (*text != '\0')
+    {
+        size_t length  = strcspn(text, "+");
+        bool   isKnown = false;
+        for (uint32_t i = 0; i < sizeof(autotileNames) / sizeof(autotileNames[0]) && !isKnown; i++)
+        {
+            if (strlen(autotileNames[i].name) == length && strncmp(text, autotileNames[i].name, length) == 0)
+            {
+                *mask |= autotileNames[i].bit;
+                isKnown = true;
+            }
+        }
+        if (!isKnown)
+            return false;
+        text += length;
+        if (*text == '+')
+            text++;
+    }
+    return true;
+}
+
+static uint32_t MapAutotile_Distance(uint8_t a, uint8_t b)
+{
+    /* a wrong side is worse than a wrong corner */
+    uint32_t distance = 0;
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+        if (((a ^ b) >> bit) & 1)
+            distance += bit < 4 ? 2 : 1;
+    }
+    return distance;
+}
+
+static void MapAutotile_BuildLut(AutotileSet* set, const bool* hasRule, const uint16_t* ruleTextures)
+{
+    for (uint32_t mask = 0; mask < 256; mask++)
+    {
+        uint8_t  reduced      = MapAutotile_Reduce((uint8_t)mask, set->neighbors);
+        uint32_t bestDistance = UINT32_MAX;
+        for (uint32_t rule = 0; rule < 256 && bestDistance > 0; rule++)
+        {
+            uint32_t distance = hasRule[rule] ? MapAutotile_Distance(reduced, (uint8_t)rule) : UINT32_MAX;
+            if (distance < bestDistance)
+            {
+                bestDistance   = distance;
+                set->lut[mask] = ruleTextures[rule];
+            }
+        }
+    }
+}
+
+static uint8_t MapAutotile_SetOf(uint16_t textureId)
+{
+    return textureId < AUTOTILE_MAX_TEXTURES ? autotileSetOf[textureId] : AUTOTILE_SET_NONE;
+}
+
+static uint8_t MapAutotile_GetSet(TileLayer* layer, int32_t x, int32_t y)
+{
+    Tile tile;
+    if (!TileLayer_Get(layer, x, y, &tile))
+        return AUTOTILE_SET_NONE;
+    return MapAutotile_SetOf(tile.textureId);
+}
+
+static void MapAutotile_RetileCell(MapData* map, uint8_t layer, int32_t x, int32_t y)
+{
+    TileLayer* tileLayer = &map->layers[layer];
+    Tile       tile;
+    if (!TileLayer_Get(tileLayer, x, y, &tile))
+        return;
+    uint8_t set = MapAutotile_SetOf(tile.textureId);
+    if (set == AUTOTILE_SET_NONE)
+        return;
+    uint8_t mask = 0;
+    for (uint8_t bit = 0; bit < autotileSets[set].neighbors; bit++)
+    {
+        if (MapAutotile_GetSet(tileLayer, x + autotileOffsets[bit][0], y + autotileOffsets[bit][1]) == set)
+            mask |= (uint8_t)(1 << bit);
+    }
+    uint16_t textureId = autotileSets[set].lut[mask];
+    if (textureId != tile.textureId)
+        MapHistory_SetTile(map, layer, x, y, textureId, tile.type);
+}
+
+/* a set that ended up without rules is dropped, it is always the last one */
+static void MapAutotile_EndSet(AutotileSet* set, const bool* hasRule, const uint16_t* ruleTextures, uint32_t ruleCount)
+{
+    if (set == NULL)
+        return;
+    if (ruleCount > 0)
+        MapAutotile_BuildLut(set, hasRule, ruleTextures);
+    else
+        autotileSetCount--;
+}
+
+/*
+ * Rules file, one set after another, '#' starts a comment:
+ *   set <name> <4|8>
+ *   <mask> <texture id>
+ */
+bool MapAutotile_Load(const char* fileName)
+{
+    FILE* f = fopen(fileName, "r");
+    if (!f)
+    {
+        LOG_ERR("MapAutotile: cannot open '%s' for reading", fileName);
+        return false;
+    }
+    memset(autotileSetOf, AUTOTILE_SET_NONE, sizeof(autotileSetOf));
+    autotileSetCount = 0;
+
+    AutotileSet* set = NULL;
+    bool         hasRule[256];
+    uint16_t     ruleTextures[256];
+    uint32_t     ruleCount  = 0;
+    int          lineNumber = 0;
+    char         line[128];
+    while (fgets(line, sizeof(line), f))
+    {
+        lineNumber++;
+        char word[64];
+        if (sscanf(line, "%63s", word) != 1 || word[0] == '#')
+            continue;
+        if (strcmp(word, "set") == 0)
+        {
+            MapAutotile_EndSet(set, hasRule, ruleTextures, ruleCount);
+            set       = NULL;
+            ruleCount = 0;
+            memset(hasRule, 0, sizeof(hasRule));
+            if (autotileSetCount == AUTOTILE_MAX_SETS)
+            {
+                LOG_WRN("MapAutotile: more than %d sets in '%s'", AUTOTILE_MAX_SETS, fileName);
+                break;
+            }
+            int neighbors;
+            set          = &autotileSets[autotileSetCount++];
+            set->name[0] = '\0';
+            if (sscanf(line, "set %31s %d", set->name, &neighbors) != 2 || (neighbors != 4 && neighbors != 8))
+            {
+                LOG_WRN("MapAutotile: '%s' line %d, expected 'set <name> <4|8>'", fileName, lineNumber);
+                neighbors = 4;
+            }
+            set->neighbors = (uint8_t)neighbors;
+            continue;
+        }
+
+        unsigned int textureId;
+        uint8_t      mask;
+        if (set == NULL || sscanf(line, "%63s %u", word, &textureId) != 2 || textureId >= AUTOTILE_MAX_TEXTURES
+            || !MapAutotile_ParseMask(word, &mask))
+        {
+            LOG_WRN("MapAutotile: '%s' line %d ignored", fileName, lineNumber);
+            continue;
+        }
+        uint8_t index = (uint8_t)(set - autotileSets);
+        if (autotileSetOf[textureId] != AUTOTILE_SET_NONE && autotileSetOf[textureId] != index)
+            LOG_WRN("MapAutotile: texture %u is in more than one set, '%s' keeps it", textureId, set->name);
+        mask                     = MapAutotile_Reduce(mask, set->neighbors);
+        hasRule[mask]            = true;
+        ruleTextures[mask]       = (uint16_t)textureId;
+        autotileSetOf[textureId] = index;
+        ruleCount++;
+    }
+    MapAutotile_EndSet(set, hasRule, ruleTextures, ruleCount);
+    fclose(f);
+    autotileIsLoaded = autotileSetCount > 0;
+    LOG_INF("MapAutotile: %u sets loaded from '%s'", autotileSetCount, fileName);
+    return autotileIsLoaded;
+}
+
+bool MapAutotile_IsLoaded()
+{
+    return autotileIsLoaded;
+}
+
+void MapAutotile_UpdateCell(MapData* map, uint8_t layer, int32_t x, int32_t y)
+{
+    MapAutotile_UpdateRect(map, layer, (Vector2Int){ x, y }, (Vector2Int){ x, y });
+}
+
+void MapAutotile_UpdateRect(MapData* map, uint8_t layer, Vector2Int min, Vector2Int max)
+{
+    if (!autotileIsLoaded)
+        return;
+    for (int32_t y = min.y - 1; y <= max.y + 1; y++)
+    {
+        for (int32_t x = min.x - 1; x <= max.x + 1; x++)
+            MapAutotile_RetileCell(map, layer, x, y);
+    }
+}
+
+/*
+ * Each chunk is classified once into a grid with a one cell border, the border coming from the neighboring chunks,
+ * and every mask is then read from that grid. Retiling never moves a cell to another set, so chunks can be rewritten
+ * in place while later chunks still look at them. Changed cells go through the history as one command.
+ */
+uint32_t MapAutotile_RetileMap(MapData* map)
+{
+    if (!autotileIsLoaded)
+        return 0;
+    MapHistory_Begin();
+    uint32_t retiled = 0;
+    uint8_t  sets[TILE_CHUNK_SIZE + 2][TILE_CHUNK_SIZE + 2];
+    for (uint8_t l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        TileLayer* layer = &map->layers[l];
+        for (uint32_t i = 0; i < layer->chunkCount; i++)
+        {
+            TileChunk* chunk = layer->chunks[i];
+            if (chunk->tileCount == 0)
+                continue;
+            int32_t baseX = chunk->position.x * TILE_CHUNK_SIZE;
+            int32_t baseY = chunk->position.y * TILE_CHUNK_SIZE;
+            for (int32_t y = -1; y <= TILE_CHUNK_SIZE; y++)
+            {
+                for (int32_t x = -1; x <= TILE_CHUNK_SIZE; x++)
+                {
+                    bool isInside = x >= 0 && y >= 0 && x < TILE_CHUNK_SIZE && y < TILE_CHUNK_SIZE;
+                    sets[y + 1][x + 1] =
+                        isInside ? MapAutotile_SetOf(chunk->textureIds[(y << TILE_CHUNK_SHIFT) | x])
+                                 : MapAutotile_GetSet(layer, baseX + x, baseY + y);
+                }
+            }
+            for (int32_t y = 0; y < TILE_CHUNK_SIZE; y++)
+            {
+                for (int32_t x = 0; x < TILE_CHUNK_SIZE; x++)
+                {
+                    uint8_t set = sets[y + 1][x + 1];
+                    if (set == AUTOTILE_SET_NONE)
+                        continue;
+                    uint8_t mask = 0;
+                    for (uint8_t bit = 0; bit < 8; bit++)
+                    {
+                        if (sets[y + 1 + autotileOffsets[bit][1]][x + 1 + autotileOffsets[bit][0]] == set)
+                            mask |= (uint8_t)(1 << bit);
+                    }
+                    uint32_t cell      = (y << TILE_CHUNK_SHIFT) | x;
+                    uint16_t textureId = autotileSets[set].lut[mask];
+                    if (chunk->textureIds[cell] != textureId
+                        && MapHistory_SetTile(map, l, baseX + x, baseY + y, textureId, (TileType)chunk->types[cell]))
+                        retiled++;
+                }
+            }
+        }
+    }
+    MapHistory_End();
+    return retiled;
+}
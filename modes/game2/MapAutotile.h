@@ -0,0 +1,43 @@
+#ifndef LIBS_ENGINE_MAPAUTOTILE_H
+#define LIBS_ENGINE_MAPAUTOTILE_H
+#include "TileMap.h"
+
+#include <stdint.h>
+
+#define AUTOTILE_RULES_FILE   "resources/autotile.txt"
+#define AUTOTILE_MAX_SETS     16
+#define AUTOTILE_MAX_TEXTURES 4096  // texture ids at or above this never take part in autotiling
+#define AUTOTILE_SET_NONE     0xFF
+
+/* neighbor bits, set when the neighbor belongs to the same set */
+enum AutotileNeighbor
+{
+    AUTOTILE_N  = 1 << 0,
+    AUTOTILE_E  = 1 << 1,
+    AUTOTILE_S  = 1 << 2,
+    AUTOTILE_W  = 1 << 3,
+    AUTOTILE_NE = 1 << 4,
+    AUTOTILE_SE = 1 << 5,
+    AUTOTILE_SW = 1 << 6,
+    AUTOTILE_NW = 1 << 7,
+};
+
+/*
+ * A set maps neighbor masks to texture ids. Every texture named by a rule belongs to the set, so any of them can be
+ * painted and the set picks the variant. The table covers all 256 masks: 4 neighbor sets ignore the corner bits,
+ * 8 neighbor sets ignore a corner unless both sides next to it are set, and masks without a rule take the closest rule.
+ */
+struct AutotileSet
+{
+    char     name[32];
+    uint8_t  neighbors;  // 4 or 8
+    uint16_t lut[256];
+};
+
+bool     MapAutotile_Load(const char* fileName);
+bool     MapAutotile_IsLoaded();
+void     MapAutotile_UpdateCell(MapData* map, uint8_t layer, int32_t x, int32_t y);  // the cell and its 8 neighbors
+void     MapAutotile_UpdateRect(MapData* map, uint8_t layer, Vector2Int min, Vector2Int max);  // and a cell around it
+uint32_t MapAutotile_RetileMap(MapData* map);  // whole map in one pass, one MapHistory command
+
+#endif  // LIBS_ENGINE_MAPAUTOTILE_H
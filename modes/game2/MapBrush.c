@@ -0,0 +1,224 @@
+#include "MapBrush.h"
+
+#include "MapHistory.h"
+#include "ashes/ash_debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* row segment still to be scanned by the flood fill, dy is the direction it was found in */
+struct MapFillSpan
+{
+    int32_t x1;
+    int32_t x2;
+    int32_t y;
+    int32_t dy;
+};
+
+struct MapFillStack
+{
+    MapFillSpan* spans    = NULL;
+    uint32_t     count    = 0;
+    uint32_t     capacity = 0;
+};
+
+struct MapFillTarget
+{
+    TileLayer* layer;
+    Vector2Int min;
+    Vector2Int max;
+    uint16_t   textureId;
+    uint8_t    type;
+};
+
+static bool MapBrush_IsValidRect(Vector2Int min, Vector2Int max)
+{
+    if (min.x > max.x || min.y > max.y)
+        return false;
+    int64_t cells = ((int64_t)max.x - min.x + 1) * ((int64_t)max.y - min.y + 1);
+    if (cells > MAP_BRUSH_MAX_CELLS)
+    {
+        LOG_WRN("MapBrush: %lld cells is more than the %d a brush accepts", (long long)cells, MAP_BRUSH_MAX_CELLS);
+        return false;
+    }
+    return true;
+}
+
+static bool MapBrush_Push(MapFillStack* stack, int32_t x1, int32_t x2, int32_t y, int32_t dy)
+{
+    if (stack->count == stack->capacity)
+    {
+        uint32_t     capacity = stack->capacity == 0 ? 256 : stack->capacity * 2;
+        MapFillSpan* spans    = (MapFillSpan*)realloc(stack->spans, capacity * sizeof(MapFillSpan));
+        if (spans == NULL)
+            return false;
+        stack->spans    = spans;
+        stack->capacity = capacity;
+    }
+    stack->spans[stack->count++] = { x1, x2, y, dy };
+    return true;
+}
+
+static bool MapBrush_IsTarget(MapFillTarget* target, int32_t x, int32_t y)
+{
+    if (x < target->min.x || x > target->max.x || y < target->min.y || y > target->max.y)
+        return false;
+    Tile tile;
+    if (!TileLayer_Get(target->layer, x, y, &tile))
+        return target->textureId == TILE_TEXTURE_NONE;
+    return tile.textureId == target->textureId && (uint8_t)tile.type == target->type;
+}
+
+bool MapBrush_Line(MapData* map, uint8_t layer, Vector2Int from, Vector2Int to, uint16_t textureId, TileType type)
+{
+    int32_t dx    = abs(to.x - from.x);
+    int32_t dy    = -abs(to.y - from.y);
+    int32_t stepX = from.x < to.x ? 1 : -1;
+    int32_t stepY = from.y < to.y ? 1 : -1;
+    int32_t error = dx + dy;
+    for (;;)
+    {
+        if (!MapHistory_SetTile(map, layer, from.x, from.y, textureId, type))
+            return false;
+        if (from.x == to.x && from.y == to.y)
+            return true;
+        int32_t error2 = error * 2;
+        if (error2 >= dy)
+        {
+            error += dy;
+            from.x += stepX;
+        }
+        if (error2 <= dx)
+        {
+            error += dx;
+            from.y += stepY;
+        }
+    }
+}
+
+/* row by row, so each row lands in the history as a single run */
+bool MapBrush_FillRect(MapData* map, uint8_t layer, Vector2Int min, Vector2Int max, uint16_t textureId, TileType type)
+{
+    if (!MapBrush_IsValidRect(min, max))
+        return false;
+    bool isFilled = true;
+    for (int32_t y = min.y; y <= max.y && isFilled; y++)
+    {
+        for (int32_t x = min.x; x <= max.x && isFilled; x++)
+            isFilled = MapHistory_SetTile(map, layer, x, y, textureId, type);
+    }
+    return isFilled;
+}
+
+/*
+ * Span based fill: every pop scans one row segment, fills the matching cells left to right and pushes the segments
+ * above and below it. Filled cells stop matching, so no visited set is needed, and each cell is read a small constant
+ * number of times.
+ */
+uint32_t MapBrush_FloodFill(MapData* map, uint8_t layer, Vector2Int start, Vector2Int min, Vector2Int max,
+                            uint16_t textureId, TileType type)
+{
+    MapFillTarget target = { &map->layers[layer], min, max, TILE_TEXTURE_NONE, TILE_TYPE_EMPTY };
+    Tile          tile;
+    if (TileLayer_Get(target.layer, start.x, start.y, &tile))
+    {
+        target.textureId = tile.textureId;
+        target.type      = (uint8_t)tile.type;
+    }
+    uint8_t newType = textureId == TILE_TEXTURE_NONE ? (uint8_t)TILE_TYPE_EMPTY : (uint8_t)type;
+    if ((target.textureId == textureId && target.type == newType) || !MapBrush_IsTarget(&target, start.x, start.y))
+        return 0;
+
+    MapFillStack stack;
+    uint32_t     filled = 0;
+    bool         isOk   = MapBrush_Push(&stack, start.x, start.x, start.y, 1)
+                && MapBrush_Push(&stack, start.x, start.x, start.y - 1, -1);
+    while (isOk && stack.count > 0)
+    {
+        MapFillSpan span = stack.spans[--stack.count];
+        int32_t     x1   = span.x1;
+        int32_t     x    = x1;
+        if (MapBrush_IsTarget(&target, x, span.y))
+        {
+            while (MapBrush_IsTarget(&target, x - 1, span.y))
+                x--;
+            for (int32_t fillX = x; fillX < x1; fillX++, filled++)
+                MapHistory_SetTile(map, layer, fillX, span.y, textureId, type);
+            if (x < x1)
+                isOk = MapBrush_Push(&stack, x, x1 - 1, span.y - span.dy, -span.dy);
+        }
+        while (isOk && x1 <= span.x2)
+        {
+            for (; MapBrush_IsTarget(&target, x1, span.y); x1++, filled++)
+                MapHistory_SetTile(map, layer, x1, span.y, textureId, type);
+            if (x1 > x)
+                isOk = MapBrush_Push(&stack, x, x1 - 1, span.y + span.dy, span.dy);
+            if (isOk && x1 - 1 > span.x2)
+                isOk = MapBrush_Push(&stack, span.x2 + 1, x1 - 1, span.y - span.dy, -span.dy);
+            for (x1++; x1 < span.x2 && !MapBrush_IsTarget(&target, x1, span.y); x1++)
+                ;
+            x = x1;
+        }
+    }
+    free(stack.spans);
+    if (!isOk)
+        LOG_ERR("MapBrush: flood fill ran out of memory after %u cells", filled);
+    return filled;
+}
+
+/* walks only the chunks under the rectangle, the clipboard starts out empty so missing chunks cost nothing */
+bool MapBrush_Copy(MapData* map, uint8_t layer, Vector2Int min, Vector2Int max, MapClipboard* clipboard)
+{
+    if (!MapBrush_IsValidRect(min, max))
+        return false;
+    int32_t   width      = max.x - min.x + 1;
+    int32_t   height     = max.y - min.y + 1;
+    size_t    cells      = (size_t)width * height;
+    uint16_t* textureIds = (uint16_t*)realloc(clipboard->textureIds, cells * sizeof(uint16_t));
+    if (textureIds != NULL)
+        clipboard->textureIds = textureIds;
+    uint8_t* types = (uint8_t*)realloc(clipboard->types, cells);
+    if (types != NULL)
+        clipboard->types = types;
+    if (textureIds == NULL || types == NULL)
+    {
+        LOG_ERR("MapBrush: out of memory copying %d x %d cells", width, height);
+        MapClipboard_Free(clipboard);
+        return false;
+    }
+    memset(clipboard->textureIds, 0xFF, cells * sizeof(uint16_t));
+    memset(clipboard->types, 0, cells);
+    clipboard->width  = width;
+    clipboard->height = height;
+
+    TileIterator iterator = TileLayer_IterateRect(min, max);
+    Tile         tile;
+    while (TileLayer_Next(&map->layers[layer], &iterator, &tile))
+    {
+        size_t cell                 = (size_t)(tile.position.y - min.y) * width + (tile.position.x - min.x);
+        clipboard->textureIds[cell] = tile.textureId;
+        clipboard->types[cell]      = (uint8_t)tile.type;
+    }
+    return true;
+}
+
+/* the whole rectangle is pasted, empty clipboard cells erase what they land on */
+bool MapBrush_Paste(MapData* map, uint8_t layer, Vector2Int origin, const MapClipboard* clipboard)
+{
+    bool isPasted = true;
+    for (int32_t y = 0; y < clipboard->height && isPasted; y++)
+    {
+        const uint16_t* textureIds = clipboard->textureIds + (size_t)y * clipboard->width;
+        const uint8_t*  types      = clipboard->types + (size_t)y * clipboard->width;
+        for (int32_t x = 0; x < clipboard->width && isPasted; x++)
+            isPasted = MapHistory_SetTile(map, layer, origin.x + x, origin.y + y, textureIds[x], (TileType)types[x]);
+    }
+    return isPasted;
+}
+
+void MapClipboard_Free(MapClipboard* clipboard)
+{
+    free(clipboard->textureIds);
+    free(clipboard->types);
+    *clipboard = MapClipboard();
+}
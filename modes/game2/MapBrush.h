@@ -0,0 +1,33 @@
+#ifndef LIBS_ENGINE_MAPBRUSH_H
+#define LIBS_ENGINE_MAPBRUSH_H
+#include "TileMap.h"
+
+#include <stdint.h>
+
+#define MAP_BRUSH_MAX_CELLS (4 * 1024 * 1024)  // largest rectangle a copy or fill accepts
+
+/* dense copy of a rectangle of one layer, empty cells hold TILE_TEXTURE_NONE */
+struct MapClipboard
+{
+    uint16_t* textureIds = NULL;
+    uint8_t*  types      = NULL;
+    int32_t   width      = 0;
+    int32_t   height     = 0;
+};
+
+/*
+ * Bulk edits for the editor, all recorded through MapHistory. The caller groups them into commands with
+ * MapHistory_Begin and MapHistory_End, so follow up edits such as autotiling undo together with the brush. The line
+ * brush joins the cells a stroke passed between two frames. A textureId of TILE_TEXTURE_NONE erases. Rectangles are
+ * inclusive cell ranges.
+ */
+bool     MapBrush_Line(MapData* map, uint8_t layer, Vector2Int from, Vector2Int to, uint16_t textureId, TileType type);
+bool     MapBrush_FillRect(MapData* map, uint8_t layer, Vector2Int min, Vector2Int max, uint16_t textureId,
+                           TileType type);
+uint32_t MapBrush_FloodFill(MapData* map, uint8_t layer, Vector2Int start, Vector2Int min, Vector2Int max,
+                            uint16_t textureId, TileType type);  // stays inside min..max, returns the cells filled
+bool     MapBrush_Copy(MapData* map, uint8_t layer, Vector2Int min, Vector2Int max, MapClipboard* clipboard);
+bool     MapBrush_Paste(MapData* map, uint8_t layer, Vector2Int origin, const MapClipboard* clipboard);
+void     MapClipboard_Free(MapClipboard* clipboard);
+
+#endif  // LIBS_ENGINE_MAPBRUSH_H
@@ -1,6 +1,11 @@
 #include "MapEditorMode.h"
 
 #include "MainMode.h"
+#include "MapAutosave.h"
+#include "MapAutotile.h"
+#include "MapBrush.h"
+#include "MapFile.h"
+#include "MapHistory.h"
 #include "ashes/ash_components.h"
 #include "ashes/ash_context.h"
 #include "ashes/ash_debug.h"
@@ -28,32 +33,61 @@
 #define ZOOM_MIN           0.1f
 #define ZOOM_MAX           10.0f
 #define ZOOM_STEP          0.15f
-#define MAP_SAVE_FILE      "map.txt"
+#define MAP_SAVE_FILE      "map.bin"
+#define MAP_TEXT_FILE      "map.txt"
+#define MAP_STREAM_CHUNKS  32  // chunks outside the view copied per frame while a loaded map streams in
 #define GRID_COLOR         ((Color){ 45, 45, 45, 255 })
+#define SELECTION_COLOR    ((Color){ 255, 220, 80, 255 })
 
-Mode              mapEditorMode       = MODE_FROM_CLASSNAME(MapEditorMode);
+enum BrushTool
+{
+    BRUSH_TOOL_PAINT = 0,  // line stamped from the previous frame's cell, so fast drags leave no gaps
+    BRUSH_TOOL_RECT,
+    BRUSH_TOOL_FILL,
+    BRUSH_TOOL_SELECT,
+};
+
+Mode              mapEditorMode       = MODE_FROM_CLASSNAME_PRELOADED(MapEditorMode);
 EditorTestMapData g_editorTestMapData = {};
 
-static Drawable drawables[DRAWABLE_MAX];
+static Drawable* drawables    = NULL;
 static size_t   drawableCount = 0;
 
 static TextureData tileTextures[TILESET_COUNT];
 static TextureData tileAtlasBase;
+static Image       tileAtlasImage;
 
 static TextureData fontTextures[FONT_GLYPH_COUNT];
 static TextureData fontAtlasBase;
+static Image       fontAtlasImage;
 
 static Entity2D cameraEntity;
 
+static Updatable autosaveUpdatable;
+
+static MapFile mapStream;  // open from a load until every chunk of the file is in data.mapData
+
+static TileCollider mapTiles;
+static TileRects    solidRects;  // kept merged while editing, MapHistory marks the chunks each edit touches
+
 struct EditorData
 {
-    MapData  mapData;
-    uint8_t  activeLayer  = 0;
-    int32_t  selectedTile = -1;
-    TileType tileType     = TILE_TYPE_SOLID;
-    bool     showTypes    = false;
-    bool     showGrid     = true;
-    bool     isErasing    = false;
+    MapData      mapData;
+    MapClipboard clipboard;
+    uint8_t      activeLayer  = 0;
+    int32_t      selectedTile = -1;
+    TileType     tileType     = TILE_TYPE_SOLID;
+    BrushTool    brushTool    = BRUSH_TOOL_PAINT;
+    Vector2Int   lastCell     = { 0, 0 };  // cell painted last frame while the button is held
+    Vector2Int   dragStart    = { 0, 0 };  // corner the rectangle and select tools were pressed on
+    Vector2Int   selectionMin = { 0, 0 };
+    Vector2Int   selectionMax = { 0, 0 };
+    bool         isDragging   = false;
+    bool         hasSelection = false;
+    bool         showTypes    = false;
+    bool         showGrid     = true;
+    bool         isErasing    = false;
+    bool         isAutotiling = true;
 } data;
 
 static Vector4Float g_texturePaneBounds = { 0, 0, 0, 0 };
@@ -66,53 +100,17 @@ void HandleTilePlacement();
 void HandleKeyboardShortcuts();
 void DrawTexturePane();
 void DrawInfoPane();
-void EraseTileAt(Vector3Int gridPos);
-void PlaceTileAt(Vector3Int gridPos);
 void SaveMap(const char* filename);
 void LoadMap(const char* filename);
 void TestInMainMode();
-
-void EraseTileAt(Vector3Int gridPos)
-{
-    TileLayer* layer = &data.mapData.layers[data.activeLayer];
-    for (uint16_t i = 0; i < layer->tileCount; i++)
-    {
-        if (layer->tiles[i].position.x == gridPos.x && layer->tiles[i].position.y == gridPos.y)
-        {
-            layer->tiles[i] = layer->tiles[--layer->tileCount];
-            return;
-        }
-    }
-}
-
-void PlaceTileAt(Vector3Int gridPos)
-{
-    if (data.selectedTile < 0)
-        return;
-    TileLayer* layer = &data.mapData.layers[data.activeLayer];
-    for (uint16_t i = 0; i < layer->tileCount; i++)
-    {
-        if (layer->tiles[i].position.x == gridPos.x && layer->tiles[i].position.y == gridPos.y)
-        {
-            layer->tiles[i].textureId = (uint16_t)data.selectedTile;
-            layer->tiles[i].type      = data.tileType;
-            return;
-        }
-    }
-    if (layer->tileCount < MAP_MAX_TILES)
-    {
-        Tile* tile       = &layer->tiles[layer->tileCount++];
-        tile->position.x = gridPos.x;
-        tile->position.y = gridPos.y;
-        tile->textureId  = (uint16_t)data.selectedTile;
-        tile->type       = data.tileType;
-    }
-    else
-    {
-        LOG_ERR("MapEditor: layer %d is full", data.activeLayer);
-    }
-}
-
+void DrawSelection();
+void GetVisibleCells(Vector2Int* min, Vector2Int* max);
+void RetileAround(Vector2Int a, Vector2Int b);
+void UpdateAutosave();
+void RebuildSolidRects();
+void LoadMapRect(Vector2Int min, Vector2Int max);
+void StreamMap();
+void FinishMapStream();
 
 void HandleCameraInput()
 {
@@ -165,16 +163,35 @@ void DrawGrid()
         DrawLineEx((Vector2){ (float)startX, (float)y }, (Vector2){ (float)endX, (float)y }, thickness, GRID_COLOR);
 }
 
+/* cell range on screen, with a tile of slack around the edges */
+void GetVisibleCells(Vector2Int* min, Vector2Int* max)
+{
+    Camera2D*    cam      = Window_GetCamera();
+    Vector2Float startPos = Utils_ScreenToWorld2D((Vector2Float){ 0.0f, 0.0f }, *cam);
+    Vector2Float endPos =
+        Utils_ScreenToWorld2D((Vector2Float){ (float)Window_GetWidth(), (float)Window_GetHeight() }, *cam);
+    Vector3Int startCell = Utils_WorldToGrid(startPos, TILE_SIZE);
+    Vector3Int endCell   = Utils_WorldToGrid(endPos, TILE_SIZE);
+    *min                 = (Vector2Int){ startCell.x - 1, startCell.y - 1 };
+    *max                 = (Vector2Int){ endCell.x + 1, endCell.y + 1 };
+}
+
 void DrawWorldTiles()
 {
-    // Camera2D camera = *Window_GetCamera();
+    PROFILE_FUNCTION();
+    /* only the chunks under the view are visited */
+    Vector2Int minCell;
+    Vector2Int maxCell;
+    GetVisibleCells(&minCell, &maxCell);
 
     for (uint8_t l = 0; l < MAP_MAX_LAYERS; l++)
     {
-        TileLayer* layer = &data.mapData.layers[l];
-        for (uint16_t i = 0; i < layer->tileCount; i++)
+        TileLayer*   layer    = &data.mapData.layers[l];
+        TileIterator iterator = TileLayer_IterateRect(minCell, maxCell);
+        Tile         current;
+        Tile*        tile     = &current;
+        while (drawables != NULL && drawableCount < DRAWABLE_MAX && TileLayer_Next(layer, &iterator, tile))
         {
-            Tile*   tile                  = &layer->tiles[i];
             Sprite* sprite                = &drawables[drawableCount].sprite;
             drawables[drawableCount].type = DRAWABLE_SPRITE;
             drawableCount++;
@@ -212,10 +229,28 @@ void DrawWorldTiles()
     }
 }
 
+/* fixes up the autotiled cells in the rectangle spanned by a and b and the ring of cells around it */
+void RetileAround(Vector2Int a, Vector2Int b)
+{
+    if (!data.isAutotiling)
+        return;
+    Vector2Int min = { a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y };
+    Vector2Int max = { a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y };
+    MapAutotile_UpdateRect(&data.mapData, data.activeLayer, min, max);
+}
+
 void HandleTilePlacement()
 {
+    /* everything painted while the button is held is undone as one stroke */
+    if (Input_IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+        MapHistory_End();
     if (UI_IsMouseOverBounds(g_texturePaneBounds) || UI_IsMouseOverBounds(g_infoPaneBounds))
+    {
+        /* a rectangle released over a pane is dropped */
+        if (Input_IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            data.isDragging = false;
         return;
+    }
 
     Camera2D     camera = *Window_GetCamera();
     Vector2Float mouseWorldPos =
@@ -223,7 +258,7 @@ void HandleTilePlacement()
     Vector3Int gridPos = Utils_WorldToGrid(mouseWorldPos, TILE_SIZE);
 
     /* Ghost preview */
-    if (data.selectedTile >= 0 && !data.isErasing)
+    if (data.selectedTile >= 0 && !data.isErasing && drawables != NULL && drawableCount < DRAWABLE_MAX)
     {
         Sprite* ghost                 = &drawables[drawableCount].sprite;
         drawables[drawableCount].type = DRAWABLE_SPRITE;
@@ -236,15 +271,84 @@ void HandleTilePlacement()
         ghost->tint           = (Color){ 255, 255, 255, 130 };
     }
 
-    if (Input_IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+    Vector2Int cell      = { gridPos.x, gridPos.y };
+    uint16_t   textureId = data.isErasing ? TILE_TEXTURE_NONE : (uint16_t)data.selectedTile;
+    bool       canPaint  = data.isErasing || data.selectedTile >= 0;
+    switch (data.brushTool)
     {
-        if (data.isErasing)
-            EraseTileAt(gridPos);
-        else if (data.selectedTile >= 0)
-            PlaceTileAt(gridPos);
+        case BRUSH_TOOL_PAINT:
+            if (Input_IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+            {
+                MapHistory_Begin();
+                data.lastCell = cell;
+            }
+            if (Input_IsMouseButtonDown(MOUSE_BUTTON_LEFT) && canPaint)
+            {
+                if (!MapBrush_Line(&data.mapData, data.activeLayer, data.lastCell, cell, textureId, data.tileType))
+                    LOG_ERR("MapEditor: cannot place tile on layer %d", data.activeLayer);
+                RetileAround(data.lastCell, cell);
+                data.lastCell = cell;
+            }
+            break;
+        case BRUSH_TOOL_FILL:
+            if (Input_IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && canPaint)
+            {
+                /* bounded by the view, an empty map would otherwise fill forever */
+                Vector2Int minCell;
+                Vector2Int maxCell;
+                GetVisibleCells(&minCell, &maxCell);
+                MapHistory_Begin();
+                uint32_t filled = MapBrush_FloodFill(&data.mapData, data.activeLayer, cell, minCell, maxCell,
+                                                     textureId, data.tileType);
+                if (filled > 0)
+                    RetileAround(minCell, maxCell);
+                MapHistory_End();
+                LOG_INF("MapEditor: filled %u cells", filled);
+            }
+            break;
+        case BRUSH_TOOL_RECT:
+        case BRUSH_TOOL_SELECT:
+            if (Input_IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+            {
+                data.dragStart  = cell;
+                data.isDragging = true;
+            }
+            if (data.isDragging)
+            {
+                data.selectionMin.x = data.dragStart.x < cell.x ? data.dragStart.x : cell.x;
+                data.selectionMin.y = data.dragStart.y < cell.y ? data.dragStart.y : cell.y;
+                data.selectionMax.x = data.dragStart.x > cell.x ? data.dragStart.x : cell.x;
+                data.selectionMax.y = data.dragStart.y > cell.y ? data.dragStart.y : cell.y;
+                data.hasSelection   = true;
+            }
+            if (data.isDragging && Input_IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            {
+                data.isDragging = false;
+                if (data.brushTool == BRUSH_TOOL_RECT && canPaint)
+                {
+                    LoadMapRect(data.selectionMin, data.selectionMax);
+                    MapHistory_Begin();
+                    MapBrush_FillRect(&data.mapData, data.activeLayer, data.selectionMin, data.selectionMax,
+                                      textureId, data.tileType);
+                    RetileAround(data.selectionMin, data.selectionMax);
+                    MapHistory_End();
+                    data.hasSelection = false;
+                }
+            }
+            break;
     }
 }
 
+void DrawSelection()
+{
+    if (!data.hasSelection || (data.brushTool != BRUSH_TOOL_RECT && data.brushTool != BRUSH_TOOL_SELECT))
+        return;
+    Rectangle rect = { (float)(data.selectionMin.x * TILE_SIZE), (float)(data.selectionMin.y * TILE_SIZE),
+                       (float)((data.selectionMax.x - data.selectionMin.x + 1) * TILE_SIZE),
+                       (float)((data.selectionMax.y - data.selectionMin.y + 1) * TILE_SIZE) };
+    DrawRectangleLinesEx(rect, 2.0f / Window_GetCamera()->zoom, SELECTION_COLOR);
+}
+
 void DrawTexturePane()
 {
     Camera2D* cam = Window_GetCamera();
@@ -282,6 +386,8 @@ void DrawInfoPane()
 {
     Camera2D*          camera      = Window_GetCamera();
     static const char* typeNames[] = { "EMPTY", "SOLID", "JUMP", "PSPAWN", "ESPAWN" };
+    static const char* toolNames[] = { "TOOL:  PAINT  (B)", "TOOL:  RECT   (R)", "TOOL:  FILL   (F)",
+                                       "TOOL:  SELECT (S)" };
 
     char layer[32];
     snprintf(layer, sizeof(layer), "LAYER: %d  (PGUP/PGDN)", data.activeLayer);
@@ -291,6 +397,12 @@ void DrawInfoPane()
     snprintf(tile, sizeof(tile), "TILE:  %-1d", data.selectedTile);
     char zoom[32];
     snprintf(zoom, sizeof(zoom), "ZOOM:  %2.2fx  (WHEEL)", camera->zoom);
+    MapHistoryStats historyStats = MapHistory_GetStats();
+    char            history[32];
+    snprintf(history, sizeof(history), "UNDO:  %u/%u  %uKB", historyStats.undoCount,
+             historyStats.undoCount + historyStats.redoCount, historyStats.usedBytes / 1024);
+    char rects[32];
+    snprintf(rects, sizeof(rects), "RECTS: %u  %.2fMS", solidRects.rectCount, solidRects.lastMergeTime * 1000.0);
 
     UI_Begin(UI_GetBounds(AnchorTopLeft, { 0.0, 0.0, 0.3, 0.3 }));
     UI_Frame();
@@ -301,11 +413,18 @@ void DrawInfoPane()
     UI_Text(type, 1.0, fontTextures);
     UI_Text(tile, 1.0, fontTextures);
     UI_Text(zoom, 1.0, fontTextures);
+    UI_Text(history, 1.0, fontTextures);
+    UI_Text(rects, 1.0, fontTextures);
     UI_Text(data.isErasing ? "MODE:  ERASE  (E)" : "MODE:  DRAW   (E)", 1.0, fontTextures);
+    UI_Text(toolNames[data.brushTool], 1.0, fontTextures);
     UI_Text(data.showTypes ? "TYPES: ON  (T)" : "TYPES: OFF (T)", 1.0, fontTextures);
     UI_Text(data.showGrid ? "GRID:  ON  (G)" : "GRID:  OFF (G)", 1.0, fontTextures);
+    UI_Text(data.isAutotiling ? "AUTO:  ON  (A)" : "AUTO:  OFF (A)", 1.0, fontTextures);
     UI_Text("F2:SAVE  F3:LOAD  F9:CLR", 1.0, fontTextures);
-    UI_Text("F5:TEST  (PAN:RMB)", 1.0, fontTextures);
+    UI_Text("F5:TEST  F6:RETILE", 1.0, fontTextures);
+    UI_Text("PAN:RMB", 1.0, fontTextures);
+    UI_Text("^Z:UNDO  ^Y:REDO", 1.0, fontTextures);
+    UI_Text("^C:COPY  ^V:PASTE", 1.0, fontTextures);
     UI_End();
 }
 
@@ -317,6 +436,8 @@ void HandleKeyboardShortcuts()
         data.showGrid = !data.showGrid;
     if (Input_IsKeyPressed(KEY_E))
         data.isErasing = !data.isErasing;
+    if (Input_IsKeyPressed(KEY_A))
+        data.isAutotiling = !data.isAutotiling;
 
     if (Input_IsKeyPressed(KEY_ONE))
         data.tileType = TILE_TYPE_EMPTY;
@@ -340,95 +461,112 @@ void HandleKeyboardShortcuts()
         LoadMap(MAP_SAVE_FILE);
     if (Input_IsKeyPressed(KEY_F5))
         TestInMainMode();
+    if (Input_IsKeyPressed(KEY_F6))
+    {
+        /* the whole map is retiled, so it has to be resident; the retile undoes as one command */
+        FinishMapStream();
+        double   start   = GetTime();
+        uint32_t retiled = MapAutotile_RetileMap(&data.mapData);
+        LOG_INF("MapEditor: retiled %u cells in %.2f ms", retiled, (GetTime() - start) * 1000.0);
+    }
     if (Input_IsKeyPressed(KEY_F9))
     {
-        for (int l = 0; l < MAP_MAX_LAYERS; l++)
-            data.mapData.layers[l].tileCount = 0;
+        FinishMapStream();
+        MapHistory_ClearMap(&data.mapData);
+        MapAutosave_MarkCleared();
     }
-}
 
-void SaveMap(const char* filename)
-{
-    FILE* f = fopen(filename, "w");
-    if (!f)
+    bool isControlDown = Input_IsKeyDown(KEY_LEFT_CONTROL) || Input_IsKeyDown(KEY_RIGHT_CONTROL);
+    bool isShiftDown   = Input_IsKeyDown(KEY_LEFT_SHIFT) || Input_IsKeyDown(KEY_RIGHT_SHIFT);
+    if (isControlDown && Input_IsKeyPressed(KEY_Z))
     {
-        LOG_ERR("MapEditor: cannot open '%s' for writing", filename);
-        return;
+        if (isShiftDown)
+            MapHistory_Redo(&data.mapData);
+        else
+            MapHistory_Undo(&data.mapData);
     }
-    fprintf(f, "VER 1\n");
-    fprintf(f, "TILESIZE %d\n", TILE_SIZE);
-    fprintf(f, "LAYERS %d\n", MAP_MAX_LAYERS);
-    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    if (isControlDown && Input_IsKeyPressed(KEY_Y))
+        MapHistory_Redo(&data.mapData);
+
+    if (isControlDown && Input_IsKeyPressed(KEY_C) && data.hasSelection)
     {
-        TileLayer* layer = &data.mapData.layers[l];
-        fprintf(f, "LAYER %d\n", l);
-        fprintf(f, "COUNT %d\n", (int)layer->tileCount);
-        for (int i = 0; i < (int)layer->tileCount; i++)
-        {
-            Tile* tile = &layer->tiles[i];
-            fprintf(f, "%d %d %d %d\n", tile->position.x, tile->position.y, (int)tile->textureId, (int)tile->type);
-        }
+        LoadMapRect(data.selectionMin, data.selectionMax);
+        if (MapBrush_Copy(&data.mapData, data.activeLayer, data.selectionMin, data.selectionMax, &data.clipboard))
+            LOG_INF("MapEditor: copied %d x %d cells", data.clipboard.width, data.clipboard.height);
+    }
+    if (isControlDown && Input_IsKeyPressed(KEY_V) && data.clipboard.width > 0)
+    {
+        Vector2Float mouseWorldPos = Utils_ScreenToWorld2D(
+            (Vector2Float){ (float)Input_GetMouseX(), (float)Input_GetMouseY() }, *Window_GetCamera());
+        Vector3Int gridPos = Utils_WorldToGrid(mouseWorldPos, TILE_SIZE);
+        Vector2Int origin  = { gridPos.x, gridPos.y };
+        LoadMapRect(origin, (Vector2Int){ origin.x + data.clipboard.width - 1, origin.y + data.clipboard.height - 1 });
+        MapHistory_Begin();
+        MapBrush_Paste(&data.mapData, data.activeLayer, origin, &data.clipboard);
+        RetileAround(origin, (Vector2Int){ origin.x + data.clipboard.width - 1, origin.y + data.clipboard.height - 1 });
+        MapHistory_End();
     }
-    fclose(f);
-    LOG_INF("MapEditor: saved to '%s'", filename);
+    if (isControlDown)
+        return;
+    if (Input_IsKeyPressed(KEY_B))
+        data.brushTool = BRUSH_TOOL_PAINT;
+    if (Input_IsKeyPressed(KEY_R))
+        data.brushTool = BRUSH_TOOL_RECT;
+    if (Input_IsKeyPressed(KEY_F))
+        data.brushTool = BRUSH_TOOL_FILL;
+    if (Input_IsKeyPressed(KEY_S))
+        data.brushTool = BRUSH_TOOL_SELECT;
 }
 
+void SaveMap(const char* filename)
+{
+    /* the whole map has to be resident, and the old file unmapped before it is rewritten */
+    FinishMapStream();
+    if (MapFile_Save(&data.mapData, filename))
+        MapFile_ExportText(&data.mapData, MAP_TEXT_FILE);
+}
+
+/* only the view is copied right away, the rest of the file streams in over the next frames */
 void LoadMap(const char* filename)
 {
-    FILE* f = fopen(filename, "r");
-    if (!f)
+    MapFile_Close(&mapStream);
+    MapHistory_Reset();
+    MapAutosave_MarkCleared();
+    MapData_Clear(&data.mapData);
+    if (MapFile_Open(&mapStream, filename))
     {
-        LOG_ERR("MapEditor: cannot open '%s' for reading", filename);
-        return;
+        LOG_INF("MapEditor: loading '%s', %u chunks", filename, mapStream.header->chunkCount);
+        StreamMap();
     }
-    for (int l = 0; l < MAP_MAX_LAYERS; l++)
-        data.mapData.layers[l].tileCount = 0;
-
-    char line[128];
-    int  currentLayer = -1;
-    while (fgets(line, sizeof(line), f))
+    else
     {
-        int layerIdx;
-        if (sscanf(line, "LAYER %d", &layerIdx) == 1)
-        {
-            currentLayer = layerIdx;
-            continue;
-        }
-        if (currentLayer >= 0 && currentLayer < MAP_MAX_LAYERS)
-        {
-            int x, y, texId, type;
-            if (sscanf(line, "%d %d %d %d", &x, &y, &texId, &type) == 4)
-            {
-                TileLayer* layer = &data.mapData.layers[currentLayer];
-                if (layer->tileCount < MAP_MAX_TILES)
-                {
-                    Tile* tile       = &layer->tiles[layer->tileCount++];
-                    tile->position.x = x;
-                    tile->position.y = y;
-                    tile->textureId  = (uint16_t)texId;
-                    tile->type       = (TileType)type;
-                }
-            }
-        }
+        /* maps saved before the binary format only exist as text */
+        MapFile_ImportText(&data.mapData, MAP_TEXT_FILE);
     }
-    fclose(f);
-    LOG_INF("MapEditor: loaded from '%s'", filename);
+    RebuildSolidRects();
 }
 
 void TestInMainMode()
 {
+    FinishMapStream();
     g_editorTestMapData.isValid        = true;
     g_editorTestMapData.hasPlayerSpawn = false;
-    g_editorTestMapData.mapData        = data.mapData;
+    if (!MapData_Copy(&g_editorTestMapData.mapData, &data.mapData))
+    {
+        g_editorTestMapData.isValid = false;
+        return;
+    }
 
     for (int l = 0; l < MAP_MAX_LAYERS && !g_editorTestMapData.hasPlayerSpawn; l++)
     {
-        TileLayer* layer = &g_editorTestMapData.mapData.layers[l];
-        for (int i = 0; i < (int)layer->tileCount; i++)
+        TileLayer*   layer    = &g_editorTestMapData.mapData.layers[l];
+        TileIterator iterator = TileLayer_Iterate();
+        Tile         tile;
+        while (TileLayer_Next(layer, &iterator, &tile))
         {
-            if (layer->tiles[i].type == TILE_TYPE_PLAYER_SPAWN)
+            if (tile.type == TILE_TYPE_PLAYER_SPAWN)
             {
-                g_editorTestMapData.playerSpawn    = layer->tiles[i].position;
+                g_editorTestMapData.playerSpawn    = tile.position;
                 g_editorTestMapData.hasPlayerSpawn = true;
                 break;
             }
@@ -437,14 +575,81 @@ void TestInMainMode()
     Context_SetMode(&mainMode);
 }
 
+void UpdateAutosave()
+{
+    /* a snapshot of a half streamed map would recover as a map missing the rest */
+    if (mapStream.header == NULL)
+        MapAutosave_Update(&data.mapData);
+}
+
+/* makes sure a range about to be edited or copied holds what the file has there, edits outside the view need it */
+void LoadMapRect(Vector2Int min, Vector2Int max)
+{
+    if (mapStream.header == NULL)
+        return;
+    Vector2Int from = { min.x < max.x ? min.x : max.x, min.y < max.y ? min.y : max.y };
+    Vector2Int to   = { min.x > max.x ? min.x : max.x, min.y > max.y ? min.y : max.y };
+    /* one cell of slack for the autotile ring around the edit */
+    if (!MapFile_LoadRect(&mapStream, &data.mapData, (Vector2Int){ from.x - 1, from.y - 1 },
+                          (Vector2Int){ to.x + 1, to.y + 1 }))
+        LOG_WRN("MapEditor: corrupt chunks were skipped");
+}
+
+/* visible chunks first, then a few more each frame until the whole file is in */
+void StreamMap()
+{
+    if (mapStream.header == NULL)
+        return;
+    Vector2Int min;
+    Vector2Int max;
+    GetVisibleCells(&min, &max);
+    LoadMapRect(min, max);
+    if (MapFile_LoadRemaining(&mapStream, &data.mapData, MAP_STREAM_CHUNKS) == 0)
+        FinishMapStream();
+}
+
+void FinishMapStream()
+{
+    if (mapStream.header == NULL)
+        return;
+    MapFile_LoadRemaining(&mapStream, &data.mapData, UINT32_MAX);
+    LOG_INF("MapEditor: map streamed in, %u chunks", mapStream.loadedCount);
+    MapFile_Close(&mapStream);
+    RebuildSolidRects();
+}
+
+/* merges the whole map again, for loads that replace it without going through MapHistory */
+void RebuildSolidRects()
+{
+    TileRects_Deinitialize(&solidRects);
+    if (!TileRects_Initialize(&solidRects, &mapTiles, TILECOLLIDER_SOLID))
+        return;
+    MapData_MarkSolidCells(&data.mapData, &solidRects);
+    TileRects_Update(&solidRects);
+    LOG_INF("MapEditor: merged solid tiles into %u rects in %.3f ms", solidRects.rectCount,
+            solidRects.lastMergeTime * 1000.0);
+}
+
+void MapEditorMode_OnPreload()
+{
+    tileAtlasImage = Texture_LoadImage("resources/sprites/tileset.png");
+    fontAtlasImage = Texture_LoadImage("resources/sprites/Anikki_square_8x8.png");
+}
+
+void MapEditorMode_OnPreloadDiscard()
+{
+    Texture_UnloadImage(&tileAtlasImage);
+    Texture_UnloadImage(&fontAtlasImage);
+}
+
 void MapEditorMode_OnStart()
 {
-    tileAtlasBase = Texture_LoadTexture("resources/sprites/tileset.png");
+    tileAtlasBase = Texture_LoadTextureFromImage(&tileAtlasImage);
     LOG_INF("MapEditor: tile atlas %dx%d", tileAtlasBase.size.x, tileAtlasBase.size.y);
     if (!Texture_CreateTextureAtlas(tileAtlasBase, TILESET_ATLAS_COLS, TILESET_ATLAS_ROWS, tileTextures))
         LOG_ERR("MapEditor: failed to create tile atlas");
 
-    fontAtlasBase = Texture_LoadTexture("resources/sprites/Anikki_square_8x8.png");
+    fontAtlasBase = Texture_LoadTextureFromImage(&fontAtlasImage);
     if (!Texture_CreateTextureAtlas(fontAtlasBase, FONT_ATLAS_COLS, FONT_ATLAS_ROWS, fontTextures))
         LOG_ERR("MapEditor: failed to create font atlas");
 
@@ -458,12 +663,27 @@ void MapEditorMode_OnStart()
     cameraEntity.position.y = camera->target.y;
     cameraEntity.scale      = 1.0f / camera->zoom;
 
-    UI_Initialize(drawables, (size_t*)&drawableCount, DRAWABLE_MAX);
+    UI_Initialize();
     UI_SetParentEntity(&cameraEntity);
+
+    if (!MapAutotile_IsLoaded() && !MapAutotile_Load(AUTOTILE_RULES_FILE))
+        data.isAutotiling = false;
+
+    MapHistory_Reset();
+    MapAutosave_Recover(&data.mapData);
+    MapAutosave_Start(&data.mapData);
+    TileCollider_Initialize(&mapTiles, (float)TILE_SIZE, MapData_GetCollisionFlags, &data.mapData);
+    RebuildSolidRects();
+    MapHistory_SetTileRects(&solidRects);
+    Updatable_Initialize(&autosaveUpdatable, UpdateAutosave, "Map Autosave");
+    autosaveUpdatable.phase = UPDATABLE_PHASE_POST_UPDATE;
+    Context_AddUpdatable(&autosaveUpdatable);
 }
 
 void MapEditorMode_OnPause()
 {
+    /* a test play runs on top of the editor, the map does not change until it comes back */
+    autosaveUpdatable.isEnabled = false;
 }
 
 void DrawTest()
@@ -565,7 +785,9 @@ void MapEditorMode_Update()
     cameraEntity.position.y = Window_GetCamera()->target.y;
     cameraEntity.scale      = 1.0f / Window_GetCamera()->zoom;
 
+    drawables     = FrameArena_AllocArray(Drawable, DRAWABLE_MAX);
     drawableCount = 0;
+    UI_SetDrawableArray(drawables, &drawableCount, DRAWABLE_MAX);
     DeltaTime_Update();
 
     // uint32_t screenW = Window_GetWidth();
@@ -573,8 +795,10 @@ void MapEditorMode_Update()
     // texPane.position = (Vector2Float){ (float)screenW - TEX_PANE_W, 0.0f };
     // texPane.size     = (Vector2Float){ TEX_PANE_W, (float)screenH };
 
+    StreamMap();
     HandleTilePlacement();
     HandleKeyboardShortcuts();
+    TileRects_Update(&solidRects);
 
 
     DrawGrid();
@@ -584,16 +808,30 @@ void MapEditorMode_Update()
     DrawInfoPane();
 
 
+    PROFILE_BEGIN("Draw Drawables");
     for (size_t i = 0; i < drawableCount; i++)
         Drawable_Draw(&drawables[i]);
+    PROFILE_END();
+    DrawSelection();
 
     HandleCameraInput();
 }
 
 void MapEditorMode_OnStop()
 {
+    Context_RemoveUpdatable(&autosaveUpdatable);
+    FinishMapStream();
+    MapHistory_Reset();
+    MapHistory_SetTileRects(NULL);
+    TileRects_Deinitialize(&solidRects);
+    TileCollider_Deinitialize(&mapTiles);
+    MapClipboard_Free(&data.clipboard);
+    MapAutosave_Stop(&data.mapData);
+    Texture_UnloadTexture(&tileAtlasBase);
+    Texture_UnloadTexture(&fontAtlasBase);
 }
 
 void MapEditorMode_OnResume()
 {
+    autosaveUpdatable.isEnabled = true;
 }
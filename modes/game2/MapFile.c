@@ -0,0 +1,391 @@
+#include "MapFile.h"
+
+#include "ashes/ash_debug.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(sizeof(MapFileHeader) == 32, "MapFileHeader layout changed");
+static_assert(sizeof(MapFileLayer) == 8, "MapFileLayer layout changed");
+static_assert(sizeof(MapFileChunkEntry) == 20, "MapFileChunkEntry layout changed");
+static_assert(sizeof(MapFileChunk) % MAP_FILE_PAYLOAD_ALIGN == 0, "chunk payloads must keep their alignment");
+
+static uint32_t MapFile_TableChecksum(const MapFileHeader* header, const MapFileLayer* layers,
+                                      const MapFileChunkEntry* entries)
+{
+    uint32_t hash = File_Fnv1a(FNV_OFFSET, header, offsetof(MapFileHeader, tableChecksum));
+    hash          = File_Fnv1a(hash, layers, header->layerCount * sizeof(MapFileLayer));
+    return File_Fnv1a(hash, entries, header->chunkCount * sizeof(MapFileChunkEntry));
+}
+
+static int MapFile_CompareChunks(const void* a, const void* b)
+{
+    const TileChunk* chunkA = *(const TileChunk* const*)a;
+    const TileChunk* chunkB = *(const TileChunk* const*)b;
+    if (chunkA->position.y != chunkB->position.y)
+        return chunkA->position.y < chunkB->position.y ? -1 : 1;
+    if (chunkA->position.x != chunkB->position.x)
+        return chunkA->position.x < chunkB->position.x ? -1 : 1;
+    return 0;
+}
+
+bool MapFile_Save(const MapData* map, const char* fileName)
+{
+    MapFileHeader header;
+    MapFileLayer  layers[MAP_MAX_LAYERS];
+    memset(&header, 0, sizeof(header));
+    header.magic      = MAP_FILE_MAGIC;
+    header.version    = MAP_FILE_VERSION;
+    header.headerSize = sizeof(MapFileHeader);
+    header.tileSize   = TILE_SIZE;
+    header.chunkSize  = TILE_CHUNK_SIZE;
+    header.layerCount = MAP_MAX_LAYERS;
+
+    uint32_t capacity = 0;
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+        capacity += map->layers[l].chunkCount;
+    const TileChunk**  chunks  = (const TileChunk**)malloc((capacity + 1) * sizeof(TileChunk*));
+    MapFileChunkEntry* entries = (MapFileChunkEntry*)malloc((capacity + 1) * sizeof(MapFileChunkEntry));
+    if (chunks == NULL || entries == NULL)
+    {
+        LOG_ERR("MapFile: Save() failed, out of memory");
+        free(chunks);
+        free(entries);
+        return false;
+    }
+
+    /* emptied chunks stay allocated in the editor, they are dropped here */
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        const TileLayer* layer = &map->layers[l];
+        layers[l].firstChunk   = header.chunkCount;
+        for (uint32_t i = 0; i < layer->chunkCount; i++)
+        {
+            if (layer->chunks[i]->tileCount > 0)
+                chunks[header.chunkCount++] = layer->chunks[i];
+        }
+        layers[l].chunkCount = header.chunkCount - layers[l].firstChunk;
+        qsort(chunks + layers[l].firstChunk, layers[l].chunkCount, sizeof(TileChunk*), MapFile_CompareChunks);
+    }
+
+    /* offsets are uint32 on disk, a map that does not fit is refused before the old file is touched */
+    size_t   tableEnd = sizeof(MapFileHeader) + sizeof(layers) + header.chunkCount * sizeof(MapFileChunkEntry);
+    uint64_t fileSize = (((uint64_t)tableEnd + MAP_FILE_PAYLOAD_ALIGN - 1) & ~(uint64_t)(MAP_FILE_PAYLOAD_ALIGN - 1))
+                      + (uint64_t)header.chunkCount * sizeof(MapFileChunk);
+    if (fileSize > UINT32_MAX)
+    {
+        LOG_ERR("MapFile: Save() failed, %u chunks need %llu bytes, the format stops at 4 GB", header.chunkCount,
+                (unsigned long long)fileSize);
+        free(chunks);
+        free(entries);
+        return false;
+    }
+    header.payloadOffset = (uint32_t)((tableEnd + MAP_FILE_PAYLOAD_ALIGN - 1) & ~(size_t)(MAP_FILE_PAYLOAD_ALIGN - 1));
+    header.fileSize      = header.payloadOffset + header.chunkCount * (uint32_t)sizeof(MapFileChunk);
+    for (uint32_t i = 0; i < header.chunkCount; i++)
+    {
+        MapFileChunk payload;
+        memcpy(payload.textureIds, chunks[i]->textureIds, sizeof(payload.textureIds));
+        memcpy(payload.types, chunks[i]->types, sizeof(payload.types));
+        entries[i].x         = chunks[i]->position.x;
+        entries[i].y         = chunks[i]->position.y;
+        entries[i].offset    = header.payloadOffset + i * (uint32_t)sizeof(MapFileChunk);
+        entries[i].tileCount = chunks[i]->tileCount;
+        entries[i].reserved  = 0;
+        entries[i].checksum  = File_Fnv1a(FNV_OFFSET, &payload, sizeof(payload));
+    }
+    header.tableChecksum = MapFile_TableChecksum(&header, layers, entries);
+
+    /* written next to the target and moved over it once it is on disk, a failed save leaves the old map intact */
+    char  tempName[FILENAME_MAX];
+    int   nameLength = snprintf(tempName, sizeof(tempName), "%s.tmp", fileName);
+    FILE* f          = nameLength > 0 && nameLength < (int)sizeof(tempName) ? fopen(tempName, "wb") : NULL;
+    if (!f)
+    {
+        LOG_ERR("MapFile: cannot open '%s.tmp' for writing", fileName);
+        free(chunks);
+        free(entries);
+        return false;
+    }
+    static const uint8_t padding[MAP_FILE_PAYLOAD_ALIGN] = {};
+    size_t               paddingSize                     = header.payloadOffset - tableEnd;
+    bool isWritten = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(layers, sizeof(layers), 1, f) == 1
+                     && fwrite(entries, sizeof(MapFileChunkEntry), header.chunkCount, f) == header.chunkCount
+                     && fwrite(padding, 1, paddingSize, f) == paddingSize;
+    for (uint32_t i = 0; i < header.chunkCount && isWritten; i++)
+    {
+        isWritten = fwrite(chunks[i]->textureIds, sizeof(chunks[i]->textureIds), 1, f) == 1
+                    && fwrite(chunks[i]->types, sizeof(chunks[i]->types), 1, f) == 1;
+    }
+    isWritten = isWritten && File_Sync(f);
+    isWritten = fclose(f) == 0 && isWritten;
+    free(chunks);
+    free(entries);
+    if (!isWritten || !File_Replace(tempName, fileName))
+    {
+        LOG_ERR("MapFile: failed writing '%s'", fileName);
+        remove(tempName);
+        return false;
+    }
+    LOG_INF("MapFile: saved %u chunks to '%s'", header.chunkCount, fileName);
+    return true;
+}
+
+/* only the header and tables are read here, chunk payloads stay on disk until they are asked for */
+bool MapFile_Open(MapFile* file, const char* fileName)
+{
+    *file = MapFile();
+    if (!MappedFile_Open(&file->mapped, fileName))
+    {
+        LOG_ERR("MapFile: cannot map '%s'", fileName);
+        return false;
+    }
+    const MapFileHeader* header = (const MapFileHeader*)file->mapped.data;
+    const char*          error  = NULL;
+    if (file->mapped.size < sizeof(MapFileHeader) || header->magic != MAP_FILE_MAGIC)
+        error = "not a map file";
+    else if (header->version == 0 || header->version > MAP_FILE_VERSION)
+        error = "unsupported version";
+    else if (header->headerSize < sizeof(MapFileHeader) || header->fileSize != file->mapped.size)
+        error = "truncated";
+    else if (header->chunkSize != TILE_CHUNK_SIZE || header->tileSize != TILE_SIZE)
+        error = "different tile or chunk size";
+    else if (header->layerCount > MAP_MAX_LAYERS)
+        error = "too many layers";
+    else if (header->headerSize + header->layerCount * sizeof(MapFileLayer)
+                 + (size_t)header->chunkCount * sizeof(MapFileChunkEntry)
+             > header->payloadOffset)
+        error = "chunk table overlaps payloads";
+    else if ((size_t)header->payloadOffset + (size_t)header->chunkCount * sizeof(MapFileChunk) > header->fileSize)
+        error = "truncated";
+    if (error == NULL)
+    {
+        file->header  = header;
+        file->layers  = (const MapFileLayer*)(file->mapped.data + header->headerSize);
+        file->entries = (const MapFileChunkEntry*)(file->layers + header->layerCount);
+        if (MapFile_TableChecksum(header, file->layers, file->entries) != header->tableChecksum)
+            error = "chunk table checksum mismatch";
+    }
+    for (uint32_t l = 0; error == NULL && l < header->layerCount; l++)
+    {
+        if ((uint64_t)file->layers[l].firstChunk + file->layers[l].chunkCount > header->chunkCount)
+            error = "layer points outside the chunk table";
+    }
+    for (uint32_t i = 0; error == NULL && i < header->chunkCount; i++)
+    {
+        if (file->entries[i].offset % MAP_FILE_PAYLOAD_ALIGN != 0
+            || (uint64_t)file->entries[i].offset + sizeof(MapFileChunk) > header->fileSize)
+            error = "chunk payload outside the file";
+    }
+    if (error == NULL)
+    {
+        file->chunkFlags = (uint8_t*)calloc(header->chunkCount + 1, 1);
+        if (file->chunkFlags == NULL)
+            error = "out of memory";
+    }
+    if (error != NULL)
+    {
+        LOG_ERR("MapFile: cannot open '%s', %s", fileName, error);
+        MapFile_Close(file);
+        return false;
+    }
+    return true;
+}
+
+void MapFile_Close(MapFile* file)
+{
+    MappedFile_Close(&file->mapped);
+    free(file->chunkFlags);
+    *file = MapFile();
+}
+
+static const MapFileChunk* MapFile_GetPayload(MapFile* file, uint32_t index)
+{
+    const MapFileChunkEntry* entry   = &file->entries[index];
+    const MapFileChunk*      payload = (const MapFileChunk*)(file->mapped.data + entry->offset);
+    if (!(file->chunkFlags[index] & MAP_FILE_CHUNK_VERIFIED))
+    {
+        if (File_Fnv1a(FNV_OFFSET, payload, sizeof(MapFileChunk)) != entry->checksum)
+        {
+            LOG_ERR("MapFile: chunk %d, %d is corrupt", entry->x, entry->y);
+            return NULL;
+        }
+        file->chunkFlags[index] |= MAP_FILE_CHUNK_VERIFIED;
+    }
+    return payload;
+}
+
+/* copies one chunk unless it was copied before, a corrupt chunk also counts as loaded so it is only reported once */
+static bool MapFile_LoadEntry(MapFile* file, MapData* map, uint32_t layer, uint32_t index)
+{
+    if (file->chunkFlags[index] & MAP_FILE_CHUNK_LOADED)
+        return true;
+    file->chunkFlags[index] |= MAP_FILE_CHUNK_LOADED;
+    file->loadedCount++;
+    const MapFileChunk* payload = MapFile_GetPayload(file, index);
+    return payload != NULL
+           && TileLayer_SetChunk(&map->layers[layer], file->entries[index].x, file->entries[index].y,
+                                 payload->textureIds, payload->types);
+}
+
+/* first entry of a layer at or after (chunkX, chunkY) in (y, x) order */
+static uint32_t MapFile_LowerBound(const MapFile* file, uint32_t layer, int32_t chunkX, int32_t chunkY)
+{
+    uint32_t first = file->layers[layer].firstChunk;
+    uint32_t count = file->layers[layer].chunkCount;
+    while (count > 0)
+    {
+        uint32_t                 half  = count / 2;
+        const MapFileChunkEntry* entry = &file->entries[first + half];
+        if (entry->y < chunkY || (entry->y == chunkY && entry->x < chunkX))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+const MapFileChunk* MapFile_GetChunk(MapFile* file, uint32_t layer, int32_t chunkX, int32_t chunkY)
+{
+    if (file->header == NULL || layer >= file->header->layerCount)
+        return NULL;
+    uint32_t index = MapFile_LowerBound(file, layer, chunkX, chunkY);
+    uint32_t end   = file->layers[layer].firstChunk + file->layers[layer].chunkCount;
+    if (index == end || file->entries[index].x != chunkX || file->entries[index].y != chunkY)
+        return NULL;
+    return MapFile_GetPayload(file, index);
+}
+
+bool MapFile_Load(MapFile* file, MapData* map)
+{
+    MapData_Clear(map);
+    if (file->header == NULL)
+        return false;
+    bool isValid = true;
+    for (uint32_t l = 0; l < file->header->layerCount; l++)
+    {
+        uint32_t end = file->layers[l].firstChunk + file->layers[l].chunkCount;
+        for (uint32_t i = file->layers[l].firstChunk; i < end; i++)
+            isValid = MapFile_LoadEntry(file, map, l, i) && isValid;
+    }
+    return isValid;
+}
+
+/*
+ * Copies the chunks overlapping a cell range (inclusive) into the map. Chunks this MapFile already copied are
+ * skipped, so calling it every frame for the visible range only pays for chunks that newly came into view and never
+ * overwrites edits made since. Every chunk row is one binary search plus a walk, so the cost follows the chunks
+ * touched and not the file size.
+ */
+bool MapFile_LoadRect(MapFile* file, MapData* map, Vector2Int min, Vector2Int max)
+{
+    if (file->header == NULL)
+        return false;
+    int32_t minChunkX = min.x >> TILE_CHUNK_SHIFT;
+    int32_t maxChunkX = max.x >> TILE_CHUNK_SHIFT;
+    bool    isValid   = true;
+    for (uint32_t l = 0; l < file->header->layerCount; l++)
+    {
+        uint32_t end = file->layers[l].firstChunk + file->layers[l].chunkCount;
+        for (int32_t chunkY = min.y >> TILE_CHUNK_SHIFT; chunkY <= (max.y >> TILE_CHUNK_SHIFT); chunkY++)
+        {
+            for (uint32_t i = MapFile_LowerBound(file, l, minChunkX, chunkY);
+                 i < end && file->entries[i].y == chunkY && file->entries[i].x <= maxChunkX; i++)
+                isValid = MapFile_LoadEntry(file, map, l, i) && isValid;
+        }
+    }
+    return isValid;
+}
+
+/* copies up to maxChunks chunks not loaded yet, in file order, and returns how many are still left */
+uint32_t MapFile_LoadRemaining(MapFile* file, MapData* map, uint32_t maxChunks)
+{
+    if (file->header == NULL)
+        return 0;
+    for (uint32_t copied = 0; file->nextChunk < file->header->chunkCount && copied < maxChunks; file->nextChunk++)
+    {
+        uint32_t index = file->nextChunk;
+        if (file->chunkFlags[index] & MAP_FILE_CHUNK_LOADED)
+            continue;
+        uint32_t l = 0;
+        while (l < file->header->layerCount
+               && (index < file->layers[l].firstChunk
+                   || index >= file->layers[l].firstChunk + file->layers[l].chunkCount))
+            l++;
+        if (l == file->header->layerCount)
+        {
+            /* no layer owns it, nothing to copy but it must not keep the file looking unfinished */
+            file->chunkFlags[index] |= MAP_FILE_CHUNK_LOADED;
+            file->loadedCount++;
+            continue;
+        }
+        MapFile_LoadEntry(file, map, l, index);  // failures were already logged
+        copied++;
+    }
+    return file->header->chunkCount - file->loadedCount;
+}
+
+bool MapFile_ExportText(const MapData* map, const char* fileName)
+{
+    FILE* f = fopen(fileName, "w");
+    if (!f)
+    {
+        LOG_ERR("MapFile: cannot open '%s' for writing", fileName);
+        return false;
+    }
+    fprintf(f, "VER 1\n");
+    fprintf(f, "TILESIZE %d\n", TILE_SIZE);
+    fprintf(f, "LAYERS %d\n", MAP_MAX_LAYERS);
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        TileLayer* layer = (TileLayer*)&map->layers[l];  // unbounded iteration does not touch the lookup cache
+        fprintf(f, "LAYER %d\n", l);
+        fprintf(f, "COUNT %d\n", (int)layer->tileCount);
+        TileIterator iterator = TileLayer_Iterate();
+        Tile         tile;
+        while (TileLayer_Next(layer, &iterator, &tile))
+            fprintf(f, "%d %d %d %d\n", tile.position.x, tile.position.y, (int)tile.textureId, (int)tile.type);
+    }
+    fclose(f);
+    LOG_INF("MapFile: exported text to '%s'", fileName);
+    return true;
+}
+
+bool MapFile_ImportText(MapData* map, const char* fileName)
+{
+    FILE* f = fopen(fileName, "r");
+    if (!f)
+    {
+        LOG_ERR("MapFile: cannot open '%s' for reading", fileName);
+        return false;
+    }
+    MapData_Clear(map);
+
+    char line[128];
+    int  currentLayer = -1;
+    while (fgets(line, sizeof(line), f))
+    {
+        int layerIdx;
+        if (sscanf(line, "LAYER %d", &layerIdx) == 1)
+        {
+            currentLayer = layerIdx;
+            continue;
+        }
+        if (currentLayer >= 0 && currentLayer < MAP_MAX_LAYERS)
+        {
+            int x, y, texId, type;
+            if (sscanf(line, "%d %d %d %d", &x, &y, &texId, &type) == 4)
+                TileLayer_Set(&map->layers[currentLayer], x, y, (uint16_t)texId, (TileType)type);
+        }
+    }
+    fclose(f);
+    LOG_INF("MapFile: imported text from '%s'", fileName);
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef LIBS_ENGINE_MAPFILE_H
+#define LIBS_ENGINE_MAPFILE_H
+#include "TileMap.h"
+#include "ashes/ash_file.h"
+
+#include <stdint.h>
+
+#define MAP_FILE_MAGIC         0x50414D41  // "AMAP" read as a little endian uint32
+#define MAP_FILE_VERSION       1
+#define MAP_FILE_PAYLOAD_ALIGN 64
+#define MAP_FILE_CHUNK_VERIFIED 1  // MapFile::chunkFlags, payload checksum matched
+#define MAP_FILE_CHUNK_LOADED   2  // copied into a map, later loads of the same MapFile skip it
+
+/*
+ * Binary map layout, little endian, every offset is from the start of the file:
+ *   MapFileHeader
+ *   MapFileLayer[layerCount]
+ *   MapFileChunkEntry[chunkCount]  grouped by layer, sorted by (y, x) inside a layer
+ *   MapFileChunk[chunkCount]       starting at payloadOffset
+ * The header and tables are covered by tableChecksum, each payload by the checksum in its entry.
+ */
+struct MapFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;  // lets newer versions grow the header without breaking older readers
+    uint16_t tileSize;
+    uint16_t chunkSize;
+    uint16_t layerCount;
+    uint16_t reserved;
+    uint32_t chunkCount;
+    uint32_t payloadOffset;
+    uint32_t fileSize;
+    uint32_t tableChecksum;
+};
+
+struct MapFileLayer
+{
+    uint32_t firstChunk;  // index into the chunk table
+    uint32_t chunkCount;
+};
+
+struct MapFileChunkEntry
+{
+    int32_t  x;  // chunk coordinates
+    int32_t  y;
+    uint32_t offset;
+    uint16_t tileCount;
+    uint16_t reserved;
+    uint32_t checksum;
+};
+
+/* same cell layout as TileChunk so it can be used straight from the mapping */
+struct MapFileChunk
+{
+    uint16_t textureIds[TILE_CHUNK_CELLS];
+    uint8_t  types[TILE_CHUNK_CELLS];
+};
+
+struct MapFile
+{
+    MappedFile               mapped;
+    const MapFileHeader*     header   = NULL;
+    const MapFileLayer*      layers   = NULL;
+    const MapFileChunkEntry* entries  = NULL;
+    uint8_t*                 chunkFlags  = NULL;  // MAP_FILE_CHUNK_ flags, checksums are only checked on first use
+    uint32_t                 loadedCount = 0;
+    uint32_t                 nextChunk   = 0;  // where MapFile_LoadRemaining carries on
+};
+
+bool                MapFile_Save(const MapData* map, const char* fileName);
+bool                MapFile_Open(MapFile* file, const char* fileName);
+void                MapFile_Close(MapFile* file);
+const MapFileChunk* MapFile_GetChunk(MapFile* file, uint32_t layer, int32_t chunkX, int32_t chunkY);
+bool                MapFile_Load(MapFile* file, MapData* map);
+bool                MapFile_LoadRect(MapFile* file, MapData* map, Vector2Int min, Vector2Int max);
+uint32_t            MapFile_LoadRemaining(MapFile* file, MapData* map, uint32_t maxChunks);
+
+/* line based text form, kept for diffing maps and as a fallback for maps saved before the binary format */
+bool MapFile_ExportText(const MapData* map, const char* fileName);
+bool MapFile_ImportText(MapData* map, const char* fileName);
+
+#endif  // LIBS_ENGINE_MAPFILE_H
@@ -0,0 +1,313 @@
+#include "MapHistory.h"
+
+#include "ashes/ash_debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAP_HISTORY_MASK ((uint64_t)MAP_HISTORY_BYTES - 1)
+
+/* positions only ever grow, the byte they refer to is position & MAP_HISTORY_MASK */
+struct MapHistoryCommand
+{
+    uint64_t start;
+    uint64_t end;
+};
+
+static uint8_t*          historyBytes       = NULL;
+static uint64_t          historyHead        = 0;  // start of the oldest command kept
+static uint64_t          historyTail        = 0;  // end of the newest command, or of the open one
+static MapHistoryCommand historyCommands[MAP_HISTORY_MAX_COMMANDS];
+static uint32_t          historyFirst       = 0;  // oldest command in historyCommands
+static uint32_t          historyCount       = 0;  // commands kept, undone ones too until something new is recorded
+static uint32_t          historyCurrent     = 0;  // commands applied, the next undo is historyCurrent - 1
+static bool              historyIsOpen      = false;
+static bool              historyIsLost      = false;  // the open command outgrew the ring and is not recorded
+static uint64_t          historyStart       = 0;      // start of the open command
+static uint64_t          historyRunAt       = 0;      // header of the run being extended
+static MapHistoryRun     historyRun;
+static bool              historyHasRun      = false;
+static uint64_t*         historyRuns        = NULL;  // scratch for walking a command backwards
+static uint32_t          historyRunCapacity = 0;
+static TileRects*        historyRects       = NULL;  // merged solid tiles kept in step with every edit
+
+static void MapHistory_Write(uint64_t position, const void* data, size_t size)
+{
+    size_t offset = (size_t)(position & MAP_HISTORY_MASK);
+    size_t first  = size < MAP_HISTORY_BYTES - offset ? size : MAP_HISTORY_BYTES - offset;
+    memcpy(historyBytes + offset, data, first);
+    memcpy(historyBytes, (const uint8_t*)data + first, size - first);
+}
+
+static void MapHistory_Read(uint64_t position, void* data, size_t size)
+{
+    size_t offset = (size_t)(position & MAP_HISTORY_MASK);
+    size_t first  = size < MAP_HISTORY_BYTES - offset ? size : MAP_HISTORY_BYTES - offset;
+    memcpy(data, historyBytes + offset, first);
+    memcpy((uint8_t*)data + first, historyBytes, size - first);
+}
+
+static void MapHistory_DropOldest()
+{
+    historyHead  = historyCommands[historyFirst].end;
+    historyFirst = (historyFirst + 1) % MAP_HISTORY_MAX_COMMANDS;
+    historyCount--;
+    historyCurrent--;
+}
+
+/* makes room for size more bytes of the open command, dropping old commands; false once it cannot fit at all */
+static bool MapHistory_Reserve(size_t size)
+{
+    if (historyIsLost)
+        return false;
+    while (historyTail + size - historyHead > MAP_HISTORY_BYTES)
+    {
+        if (historyCount == 0)
+        {
+            LOG_WRN("MapHistory: edit is larger than the history, it cannot be undone");
+            historyIsLost = true;
+            historyHasRun = false;
+            historyTail   = historyStart;
+            return false;
+        }
+        MapHistory_DropOldest();
+    }
+    return true;
+}
+
+static void MapHistory_Record(uint8_t layer, int32_t x, int32_t y, const MapHistoryCell* cell)
+{
+    if (historyBytes == NULL)
+    {
+        historyBytes = (uint8_t*)malloc(MAP_HISTORY_BYTES);
+        if (historyBytes == NULL)
+        {
+            LOG_ERR("MapHistory: out of memory, undo is off");
+            return;
+        }
+    }
+    if (historyTail == historyStart && !historyHasRun)
+    {
+        /* the first change of a command ends the redo chain */
+        uint32_t last = (historyFirst + historyCurrent - 1) % MAP_HISTORY_MAX_COMMANDS;
+        historyCount  = historyCurrent;
+        historyTail   = historyCount == 0 ? historyHead : historyCommands[last].end;
+        historyStart  = historyTail;
+    }
+    if (historyHasRun && historyRun.layer == layer && historyRun.y == y && historyRun.x + historyRun.count == x
+        && historyRun.count < UINT16_MAX)
+    {
+        if (!MapHistory_Reserve(sizeof(MapHistoryCell)))
+            return;
+        MapHistory_Write(historyTail, cell, sizeof(MapHistoryCell));
+        historyTail += sizeof(MapHistoryCell);
+        historyRun.count++;
+        MapHistory_Write(historyRunAt, &historyRun, sizeof(MapHistoryRun));
+        return;
+    }
+    if (!MapHistory_Reserve(sizeof(MapHistoryRun) + sizeof(MapHistoryCell)))
+        return;
+    historyRun.x        = x;
+    historyRun.y        = y;
+    historyRun.count    = 1;
+    historyRun.layer    = layer;
+    historyRun.reserved = 0;
+    historyRunAt        = historyTail;
+    historyHasRun       = true;
+    MapHistory_Write(historyTail, &historyRun, sizeof(MapHistoryRun));
+    MapHistory_Write(historyTail + sizeof(MapHistoryRun), cell, sizeof(MapHistoryCell));
+    historyTail += sizeof(MapHistoryRun) + sizeof(MapHistoryCell);
+}
+
+static bool MapHistory_ApplyCell(MapData* map, const MapHistoryRun* run, int32_t x, uint16_t textureId, uint8_t type)
+{
+    TileLayer* layer = &map->layers[run->layer];
+    if (historyRects != NULL)
+        TileRects_MarkDirty(historyRects, x, run->y);
+    if (textureId == TILE_TEXTURE_NONE)
+    {
+        TileLayer_Erase(layer, x, run->y);
+        return true;
+    }
+    return TileLayer_Set(layer, x, run->y, textureId, (TileType)type);
+}
+
+void MapHistory_Begin()
+{
+    MapHistory_End();
+    historyIsOpen = true;
+    historyIsLost = false;
+    historyHasRun = false;
+    historyStart  = historyTail;
+}
+
+void MapHistory_End()
+{
+    if (!historyIsOpen)
+        return;
+    historyIsOpen = false;
+    historyHasRun = false;
+    if (historyIsLost || historyTail == historyStart)
+        return;
+    if (historyCount == MAP_HISTORY_MAX_COMMANDS)
+        MapHistory_DropOldest();
+    MapHistoryCommand* command = &historyCommands[(historyFirst + historyCount) % MAP_HISTORY_MAX_COMMANDS];
+    command->start             = historyStart;
+    command->end               = historyTail;
+    historyCount++;
+    historyCurrent = historyCount;
+}
+
+bool MapHistory_SetTile(MapData* map, uint8_t layer, int32_t x, int32_t y, uint16_t textureId, TileType type)
+{
+    MapHistoryCell cell;
+    Tile           tile;
+    bool           isOpen = historyIsOpen;
+    if (TileLayer_Get(&map->layers[layer], x, y, &tile))
+    {
+        cell.oldTextureId = tile.textureId;
+        cell.oldType      = (uint8_t)tile.type;
+    }
+    else
+    {
+        cell.oldTextureId = TILE_TEXTURE_NONE;
+        cell.oldType      = TILE_TYPE_EMPTY;
+    }
+    cell.newTextureId = textureId;
+    cell.newType      = textureId == TILE_TEXTURE_NONE ? (uint8_t)TILE_TYPE_EMPTY : (uint8_t)type;
+    if (cell.oldTextureId == cell.newTextureId && cell.oldType == cell.newType)
+        return true;
+
+    if (textureId == TILE_TEXTURE_NONE)
+        TileLayer_Erase(&map->layers[layer], x, y);
+    else if (!TileLayer_Set(&map->layers[layer], x, y, textureId, type))
+        return false;
+    if (historyRects != NULL)
+        TileRects_MarkDirty(historyRects, x, y);
+    if (!isOpen)
+        MapHistory_Begin();
+    MapHistory_Record(layer, x, y, &cell);
+    if (!isOpen)
+        MapHistory_End();
+    return true;
+}
+
+/* records every tile as erased before dropping the chunks, so an accidental clear is one undo away */
+bool MapHistory_ClearMap(MapData* map)
+{
+    MapHistory_Begin();
+    for (uint8_t l = 0; l < MAP_MAX_LAYERS && !historyIsLost; l++)
+    {
+        TileIterator iterator = TileLayer_Iterate();
+        Tile         tile;
+        while (TileLayer_Next(&map->layers[l], &iterator, &tile) && !historyIsLost)
+        {
+            MapHistoryCell cell = { tile.textureId, TILE_TEXTURE_NONE, (uint8_t)tile.type, TILE_TYPE_EMPTY };
+            MapHistory_Record(l, tile.position.x, tile.position.y, &cell);
+        }
+    }
+    if (historyRects != NULL)
+        MapData_MarkSolidCells(map, historyRects);
+    bool isRecorded = !historyIsLost;
+    MapHistory_End();
+    MapData_Clear(map);
+    return isRecorded;
+}
+
+bool MapHistory_Undo(MapData* map)
+{
+    MapHistory_End();
+    if (historyCurrent == 0)
+        return false;
+    const MapHistoryCommand* command =
+        &historyCommands[(historyFirst + historyCurrent - 1) % MAP_HISTORY_MAX_COMMANDS];
+
+    /* runs only link forwards, collect them first so later changes are undone before earlier ones */
+    uint32_t      runCount = 0;
+    MapHistoryRun run;
+    for (uint64_t position = command->start; position < command->end;)
+    {
+        if (runCount == historyRunCapacity)
+        {
+            uint32_t  capacity = historyRunCapacity == 0 ? 256 : historyRunCapacity * 2;
+            uint64_t* runs     = (uint64_t*)realloc(historyRuns, capacity * sizeof(uint64_t));
+            if (runs == NULL)
+            {
+                LOG_ERR("MapHistory: out of memory, undo failed");
+                return false;
+            }
+            historyRuns        = runs;
+            historyRunCapacity = capacity;
+        }
+        historyRuns[runCount++] = position;
+        MapHistory_Read(position, &run, sizeof(run));
+        position += sizeof(MapHistoryRun) + run.count * sizeof(MapHistoryCell);
+    }
+    for (uint32_t r = runCount; r-- > 0;)
+    {
+        MapHistory_Read(historyRuns[r], &run, sizeof(run));
+        uint64_t cellAt = historyRuns[r] + sizeof(MapHistoryRun);
+        for (uint32_t i = 0; i < run.count; i++, cellAt += sizeof(MapHistoryCell))
+        {
+            MapHistoryCell cell;
+            MapHistory_Read(cellAt, &cell, sizeof(cell));
+            MapHistory_ApplyCell(map, &run, run.x + (int32_t)i, cell.oldTextureId, cell.oldType);
+        }
+    }
+    historyCurrent--;
+    return true;
+}
+
+bool MapHistory_Redo(MapData* map)
+{
+    MapHistory_End();
+    if (historyCurrent == historyCount)
+        return false;
+    const MapHistoryCommand* command = &historyCommands[(historyFirst + historyCurrent) % MAP_HISTORY_MAX_COMMANDS];
+    for (uint64_t position = command->start; position < command->end;)
+    {
+        MapHistoryRun run;
+        MapHistory_Read(position, &run, sizeof(run));
+        position += sizeof(MapHistoryRun);
+        for (uint32_t i = 0; i < run.count; i++, position += sizeof(MapHistoryCell))
+        {
+            MapHistoryCell cell;
+            MapHistory_Read(position, &cell, sizeof(cell));
+            MapHistory_ApplyCell(map, &run, run.x + (int32_t)i, cell.newTextureId, cell.newType);
+        }
+    }
+    historyCurrent++;
+    return true;
+}
+
+void MapHistory_Reset()
+{
+    free(historyBytes);
+    free(historyRuns);
+    historyBytes       = NULL;
+    historyRuns        = NULL;
+    historyRunCapacity = 0;
+    historyHead        = 0;
+    historyTail        = 0;
+    historyStart       = 0;
+    historyFirst       = 0;
+    historyCount       = 0;
+    historyCurrent     = 0;
+    historyIsOpen      = false;
+    historyIsLost      = false;
+    historyHasRun      = false;
+}
+
+void MapHistory_SetTileRects(TileRects* rects)
+{
+    historyRects = rects;
+}
+
+MapHistoryStats MapHistory_GetStats()
+{
+    MapHistoryStats stats;
+    stats.undoCount = historyCurrent;
+    stats.redoCount = historyCount - historyCurrent;
+    stats.usedBytes = (uint32_t)(historyTail - historyHead);
+    return stats;
+}
@@ -0,0 +1,53 @@
+#ifndef LIBS_ENGINE_MAPHISTORY_H
+#define LIBS_ENGINE_MAPHISTORY_H
+#include "TileMap.h"
+
+#include <stdint.h>
+
+#define MAP_HISTORY_BYTES        (8 * 1024 * 1024)  // ring size, a power of two, oldest commands are dropped past it
+#define MAP_HISTORY_MAX_COMMANDS 1024
+
+/*
+ * A command is a list of runs, each run a header followed by one MapHistoryCell per cell. Consecutive cells of a row
+ * on the same layer share a run, so a stroke along a row or a filled rectangle costs 6 bytes a cell.
+ */
+struct MapHistoryRun
+{
+    int32_t  x;  // first cell of the run
+    int32_t  y;
+    uint16_t count;
+    uint8_t  layer;
+    uint8_t  reserved;
+};
+
+struct MapHistoryCell
+{
+    uint16_t oldTextureId;  // TILE_TEXTURE_NONE for an empty cell
+    uint16_t newTextureId;
+    uint8_t  oldType;
+    uint8_t  newType;
+};
+
+struct MapHistoryStats
+{
+    uint32_t undoCount;  // commands that can be undone
+    uint32_t redoCount;
+    uint32_t usedBytes;
+};
+
+/*
+ * Undo and redo for the editor. Every edit made between Begin and End becomes one command, so a stroke held down
+ * over many frames undoes at once. Undo and redo cost as much as the cells the command changed.
+ */
+void            MapHistory_Begin();
+void            MapHistory_End();
+bool            MapHistory_SetTile(MapData* map, uint8_t layer, int32_t x, int32_t y, uint16_t textureId,
+                                   TileType type);  // TILE_TEXTURE_NONE erases
+bool            MapHistory_ClearMap(MapData* map);  // empties every layer as one command
+bool            MapHistory_Undo(MapData* map);
+bool            MapHistory_Redo(MapData* map);
+void            MapHistory_Reset();  // forgets every command and frees the ring
+void            MapHistory_SetTileRects(TileRects* rects);  // every cell edited, undone or redone is marked in rects
+MapHistoryStats MapHistory_GetStats();
+
+#endif  // LIBS_ENGINE_MAPHISTORY_H
@@ -19,8 +19,8 @@
 
 Mode menuMode = MODE_FROM_CLASSNAME(MenuMode);
 
-static Drawable drawables[DRAWABLE_MAX];
-static size_t  drawableCount = 0;
+static Drawable* drawables    = NULL;
+static size_t   drawableCount = 0;
 
 static TextureData fontTextures[FONT_GLYPH_COUNT];
 static TextureData fontAtlasBase;
@@ -43,7 +43,7 @@ void MenuMode_OnStart()
     cameraEntity.position.y = camera->target.y;
     cameraEntity.scale      = 1.0f / camera->zoom;
 
-    UI_Initialize(drawables, (size_t*)&drawableCount, DRAWABLE_MAX);
+    UI_Initialize();
 }
 
 void MenuMode_OnPause()
@@ -56,7 +56,9 @@ void MenuMode_Update()
     cameraEntity.position.y = Window_GetCamera()->target.y;
     cameraEntity.scale      = 1.0f / Window_GetCamera()->zoom;
 
+    drawables     = FrameArena_AllocArray(Drawable, DRAWABLE_MAX);
     drawableCount = 0;
+    UI_SetDrawableArray(drawables, &drawableCount, DRAWABLE_MAX);
     DeltaTime_Update();
 
     UI_Begin((Vector4Float){ -640.0f, -360.0f, 1280.0f, 720.0f });
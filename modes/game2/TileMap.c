@@ -0,0 +1,336 @@
+#include "TileMap.h"
+
+#include "ashes/ash_debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE_BUCKETS_MIN 64
+
+static uint32_t TileLayer_Hash(int32_t chunkX, int32_t chunkY)
+{
+    return ((uint32_t)chunkX * 73856093u) ^ ((uint32_t)chunkY * 19349663u);
+}
+
+static uint32_t TileLayer_FindChunk(TileLayer* layer, int32_t chunkX, int32_t chunkY)
+{
+    if (layer->lastChunk != TILE_CHUNK_NONE && layer->chunks[layer->lastChunk]->position.x == chunkX
+        && layer->chunks[layer->lastChunk]->position.y == chunkY)
+        return layer->lastChunk;
+    if (layer->buckets == NULL)
+        return TILE_CHUNK_NONE;
+    for (uint32_t bucket = TileLayer_Hash(chunkX, chunkY) & layer->bucketMask;;
+         bucket = (bucket + 1) & layer->bucketMask)
+    {
+        uint32_t index = layer->buckets[bucket];
+        if (index == TILE_CHUNK_NONE)
+            return TILE_CHUNK_NONE;
+        if (layer->chunks[index]->position.x == chunkX && layer->chunks[index]->position.y == chunkY)
+        {
+            layer->lastChunk = index;
+            return index;
+        }
+    }
+}
+
+/* rebuilds the buckets at twice the size, chunks never leave a layer except through TileLayer_Clear */
+static bool TileLayer_GrowBuckets(TileLayer* layer)
+{
+    uint32_t  bucketCount = layer->buckets == NULL ? TILE_BUCKETS_MIN : (layer->bucketMask + 1) * 2;
+    uint32_t* buckets     = (uint32_t*)malloc(bucketCount * sizeof(uint32_t));
+    if (buckets == NULL)
+        return false;
+    memset(buckets, 0xFF, bucketCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < layer->chunkCount; i++)
+    {
+        Vector2Int position = layer->chunks[i]->position;
+        uint32_t   bucket   = TileLayer_Hash(position.x, position.y) & (bucketCount - 1);
+        while (buckets[bucket] != TILE_CHUNK_NONE)
+            bucket = (bucket + 1) & (bucketCount - 1);
+        buckets[bucket] = i;
+    }
+    free(layer->buckets);
+    layer->buckets    = buckets;
+    layer->bucketMask = bucketCount - 1;
+    return true;
+}
+
+static uint32_t TileLayer_CreateChunk(TileLayer* layer, int32_t chunkX, int32_t chunkY)
+{
+    /* keep the load factor at or below one half so probe sequences stay short */
+    if (layer->buckets == NULL || (layer->chunkCount + 1) * 2 > layer->bucketMask + 1)
+    {
+        if (!TileLayer_GrowBuckets(layer))
+            return TILE_CHUNK_NONE;
+    }
+    if (layer->chunkCount == layer->chunkCapacity)
+    {
+        uint32_t    capacity = layer->chunkCapacity == 0 ? 16 : layer->chunkCapacity * 2;
+        TileChunk** chunks   = (TileChunk**)realloc(layer->chunks, capacity * sizeof(TileChunk*));
+        if (chunks == NULL)
+            return TILE_CHUNK_NONE;
+        layer->chunks        = chunks;
+        layer->chunkCapacity = capacity;
+    }
+    TileChunk* chunk = (TileChunk*)malloc(sizeof(TileChunk));
+    if (chunk == NULL)
+        return TILE_CHUNK_NONE;
+    chunk->position.x = chunkX;
+    chunk->position.y = chunkY;
+    chunk->tileCount  = 0;
+    chunk->isDirty    = true;
+    memset(chunk->textureIds, 0xFF, sizeof(chunk->textureIds));
+    memset(chunk->types, 0, sizeof(chunk->types));
+
+    uint32_t index  = layer->chunkCount++;
+    uint32_t bucket = TileLayer_Hash(chunkX, chunkY) & layer->bucketMask;
+    while (layer->buckets[bucket] != TILE_CHUNK_NONE)
+        bucket = (bucket + 1) & layer->bucketMask;
+    layer->buckets[bucket] = index;
+    layer->chunks[index]   = chunk;
+    layer->lastChunk       = index;
+    return index;
+}
+
+bool TileLayer_Set(TileLayer* layer, int32_t x, int32_t y, uint16_t textureId, TileType type)
+{
+    int32_t  chunkX = x >> TILE_CHUNK_SHIFT;
+    int32_t  chunkY = y >> TILE_CHUNK_SHIFT;
+    uint32_t index  = TileLayer_FindChunk(layer, chunkX, chunkY);
+    if (index == TILE_CHUNK_NONE)
+        index = TileLayer_CreateChunk(layer, chunkX, chunkY);
+    if (index == TILE_CHUNK_NONE)
+    {
+        LOG_ERR("TileLayer: out of memory for chunk %d, %d", chunkX, chunkY);
+        return false;
+    }
+    TileChunk* chunk = layer->chunks[index];
+    uint32_t   cell  = ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) | (x & TILE_CHUNK_MASK);
+    if (chunk->textureIds[cell] == TILE_TEXTURE_NONE)
+    {
+        chunk->tileCount++;
+        layer->tileCount++;
+    }
+    chunk->textureIds[cell] = textureId;
+    chunk->types[cell]      = (uint8_t)type;
+    chunk->isDirty          = true;
+    return true;
+}
+
+/* returns false when the cell was already empty, emptied chunks stay allocated until the layer is cleared */
+bool TileLayer_Erase(TileLayer* layer, int32_t x, int32_t y)
+{
+    uint32_t index = TileLayer_FindChunk(layer, x >> TILE_CHUNK_SHIFT, y >> TILE_CHUNK_SHIFT);
+    if (index == TILE_CHUNK_NONE)
+        return false;
+    TileChunk* chunk = layer->chunks[index];
+    uint32_t   cell  = ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) | (x & TILE_CHUNK_MASK);
+    if (chunk->textureIds[cell] == TILE_TEXTURE_NONE)
+        return false;
+    chunk->textureIds[cell] = TILE_TEXTURE_NONE;
+    chunk->types[cell]      = TILE_TYPE_EMPTY;
+    chunk->isDirty          = true;
+    chunk->tileCount--;
+    layer->tileCount--;
+    return true;
+}
+
+bool TileLayer_Get(TileLayer* layer, int32_t x, int32_t y, Tile* tile)
+{
+    uint32_t index = TileLayer_FindChunk(layer, x >> TILE_CHUNK_SHIFT, y >> TILE_CHUNK_SHIFT);
+    if (index == TILE_CHUNK_NONE)
+        return false;
+    TileChunk* chunk = layer->chunks[index];
+    uint32_t   cell  = ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) | (x & TILE_CHUNK_MASK);
+    if (chunk->textureIds[cell] == TILE_TEXTURE_NONE)
+        return false;
+    tile->position.x = x;
+    tile->position.y = y;
+    tile->textureId  = chunk->textureIds[cell];
+    tile->type       = (TileType)chunk->types[cell];
+    return true;
+}
+
+void TileLayer_Clear(TileLayer* layer)
+{
+    for (uint32_t i = 0; i < layer->chunkCount; i++)
+        free(layer->chunks[i]);
+    free(layer->chunks);
+    free(layer->buckets);
+    *layer = TileLayer();
+}
+
+bool TileLayer_Copy(TileLayer* destination, const TileLayer* source)
+{
+    TileLayer_Clear(destination);
+    if (source->chunkCount == 0)
+        return true;
+    destination->chunks  = (TileChunk**)malloc(source->chunkCount * sizeof(TileChunk*));
+    destination->buckets = (uint32_t*)malloc((source->bucketMask + 1) * sizeof(uint32_t));
+    if (destination->chunks == NULL || destination->buckets == NULL)
+    {
+        LOG_ERR("TileLayer: Copy() failed, out of memory");
+        TileLayer_Clear(destination);
+        return false;
+    }
+    destination->chunkCapacity = source->chunkCount;
+    for (uint32_t i = 0; i < source->chunkCount; i++)
+    {
+        destination->chunks[i] = (TileChunk*)malloc(sizeof(TileChunk));
+        if (destination->chunks[i] == NULL)
+        {
+            LOG_ERR("TileLayer: Copy() failed, out of memory");
+            TileLayer_Clear(destination);
+            return false;
+        }
+        memcpy(destination->chunks[i], source->chunks[i], sizeof(TileChunk));
+        destination->chunkCount++;
+    }
+    memcpy(destination->buckets, source->buckets, (source->bucketMask + 1) * sizeof(uint32_t));
+    destination->bucketMask = source->bucketMask;
+    destination->tileCount  = source->tileCount;
+    return true;
+}
+
+/* replaces a whole chunk at once, used by loaders that already hold the cells in chunk layout */
+bool TileLayer_SetChunk(TileLayer* layer, int32_t chunkX, int32_t chunkY, const uint16_t* textureIds,
+                        const uint8_t* types)
+{
+    uint32_t index = TileLayer_FindChunk(layer, chunkX, chunkY);
+    if (index == TILE_CHUNK_NONE)
+        index = TileLayer_CreateChunk(layer, chunkX, chunkY);
+    if (index == TILE_CHUNK_NONE)
+    {
+        LOG_ERR("TileLayer: out of memory for chunk %d, %d", chunkX, chunkY);
+        return false;
+    }
+    TileChunk* chunk = layer->chunks[index];
+    memcpy(chunk->textureIds, textureIds, sizeof(chunk->textureIds));
+    memcpy(chunk->types, types, sizeof(chunk->types));
+    uint16_t tileCount = 0;
+    for (uint32_t cell = 0; cell < TILE_CHUNK_CELLS; cell++)
+        tileCount += chunk->textureIds[cell] != TILE_TEXTURE_NONE;
+    layer->tileCount = layer->tileCount - chunk->tileCount + tileCount;
+    chunk->tileCount = tileCount;
+    chunk->isDirty   = true;
+    return true;
+}
+
+TileIterator TileLayer_Iterate()
+{
+    TileIterator iterator;
+    memset(&iterator, 0, sizeof(iterator));
+    return iterator;
+}
+
+/* only chunks overlapping the range are looked up, so the cost follows the range and not the layer */
+TileIterator TileLayer_IterateRect(Vector2Int min, Vector2Int max)
+{
+    TileIterator iterator;
+    memset(&iterator, 0, sizeof(iterator));
+    iterator.min             = min;
+    iterator.max             = max;
+    iterator.chunkPosition.x = min.x >> TILE_CHUNK_SHIFT;
+    iterator.chunkPosition.y = min.y >> TILE_CHUNK_SHIFT;
+    iterator.isBounded       = true;
+    return iterator;
+}
+
+bool TileLayer_Next(TileLayer* layer, TileIterator* iterator, Tile* tile)
+{
+    for (;;)
+    {
+        if (iterator->cell == 0)
+        {
+            if (!iterator->isBounded)
+            {
+                if (iterator->chunkIndex >= layer->chunkCount)
+                    return false;
+                iterator->current = layer->chunks[iterator->chunkIndex];
+            }
+            else
+            {
+                if (iterator->chunkPosition.y > (iterator->max.y >> TILE_CHUNK_SHIFT))
+                    return false;
+                uint32_t index    = TileLayer_FindChunk(layer, iterator->chunkPosition.x, iterator->chunkPosition.y);
+                iterator->current = index == TILE_CHUNK_NONE ? NULL : layer->chunks[index];
+            }
+        }
+        TileChunk* chunk = iterator->current;
+        while (chunk != NULL && chunk->tileCount > 0 && iterator->cell < TILE_CHUNK_CELLS)
+        {
+            uint32_t cell = iterator->cell++;
+            if (chunk->textureIds[cell] == TILE_TEXTURE_NONE)
+                continue;
+            int32_t x = (chunk->position.x << TILE_CHUNK_SHIFT) + (int32_t)(cell & TILE_CHUNK_MASK);
+            int32_t y = (chunk->position.y << TILE_CHUNK_SHIFT) + (int32_t)(cell >> TILE_CHUNK_SHIFT);
+            if (iterator->isBounded
+                && (x < iterator->min.x || x > iterator->max.x || y < iterator->min.y || y > iterator->max.y))
+                continue;
+            tile->position.x = x;
+            tile->position.y = y;
+            tile->textureId  = chunk->textureIds[cell];
+            tile->type       = (TileType)chunk->types[cell];
+            return true;
+        }
+        /* chunk done, move on to the next one */
+        iterator->cell = 0;
+        if (!iterator->isBounded)
+        {
+            iterator->chunkIndex++;
+        }
+        else if (++iterator->chunkPosition.x > (iterator->max.x >> TILE_CHUNK_SHIFT))
+        {
+            iterator->chunkPosition.x = iterator->min.x >> TILE_CHUNK_SHIFT;
+            iterator->chunkPosition.y++;
+        }
+    }
+}
+
+void MapData_Clear(MapData* map)
+{
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+        TileLayer_Clear(&map->layers[l]);
+}
+
+bool MapData_Copy(MapData* destination, const MapData* source)
+{
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        if (!TileLayer_Copy(&destination->layers[l], &source->layers[l]))
+            return false;
+    }
+    return true;
+}
+
+/* TILECOLLIDER_ flags of a cell over every layer, so a TileCollider reads the map without a copy of it */
+uint8_t MapData_GetCollisionFlags(int32_t cellX, int32_t cellY, void* map)
+{
+    uint8_t flags = TILECOLLIDER_EMPTY;
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        Tile tile;
+        if (!TileLayer_Get(&((MapData*)map)->layers[l], cellX, cellY, &tile))
+            continue;
+        if (tile.type == TILE_TYPE_SOLID)
+            flags |= TILECOLLIDER_SOLID;
+        else if (tile.type == TILE_TYPE_JUMP_PLATFORM)
+            flags |= TILECOLLIDER_ONE_WAY;
+    }
+    return flags;
+}
+
+/* queues every chunk holding a SOLID tile for merging, after a whole map was loaded */
+void MapData_MarkSolidCells(MapData* map, TileRects* rects)
+{
+    for (int l = 0; l < MAP_MAX_LAYERS; l++)
+    {
+        TileIterator iterator = TileLayer_Iterate();
+        Tile         tile;
+        while (TileLayer_Next(&map->layers[l], &iterator, &tile))
+        {
+            if (tile.type == TILE_TYPE_SOLID)
+                TileRects_MarkDirty(rects, tile.position.x, tile.position.y);
+        }
+    }
+}
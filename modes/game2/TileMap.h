@@ -0,0 +1,88 @@
+#ifndef LIBS_ENGINE_TILEMAP_H
+#define LIBS_ENGINE_TILEMAP_H
+#include "ashes/ash_components.h"
+#include "ashes/ash_misc.h"
+
+#include <stdint.h>
+
+#define MAP_MAX_LAYERS    4
+#define TILE_SIZE         32
+#define TILE_CHUNK_SHIFT  4
+#define TILE_CHUNK_SIZE   (1 << TILE_CHUNK_SHIFT)  // cells per chunk side
+#define TILE_CHUNK_MASK   (TILE_CHUNK_SIZE - 1)
+#define TILE_CHUNK_CELLS  (TILE_CHUNK_SIZE * TILE_CHUNK_SIZE)
+#define TILE_CHUNK_NONE   0xFFFFFFFF
+#define TILE_TEXTURE_NONE 0xFFFF  // texture id of an empty cell
+
+enum TileType
+{
+    TILE_TYPE_EMPTY         = 0,
+    TILE_TYPE_SOLID         = 1,
+    TILE_TYPE_JUMP_PLATFORM = 2,
+    TILE_TYPE_PLAYER_SPAWN  = 3,
+    TILE_TYPE_ENEMY_SPAWN   = 4,
+};
+
+struct Tile
+{
+    Vector2Int position;
+    uint16_t   textureId;
+    TileType   type;
+};
+
+/* dense block of cells, allocated the first time one of its cells is painted */
+struct TileChunk
+{
+    Vector2Int position;  // chunk coordinates, cell coordinates >> TILE_CHUNK_SHIFT
+    uint16_t   textureIds[TILE_CHUNK_CELLS];
+    uint8_t    types[TILE_CHUNK_CELLS];
+    uint16_t   tileCount;
+    bool       isDirty;  // changed since the autosave last copied it
+};
+
+/* sparse layer, chunks are found through an open addressing hash on their position so get/set stay O(1) */
+struct TileLayer
+{
+    TileChunk** chunks        = NULL;             // in creation order
+    uint32_t    chunkCount    = 0;
+    uint32_t    chunkCapacity = 0;
+    uint32_t*   buckets       = NULL;             // chunk index or TILE_CHUNK_NONE, linear probing
+    uint32_t    bucketMask    = 0;                // bucket count - 1, the count is a power of two
+    uint32_t    lastChunk     = TILE_CHUNK_NONE;  // paint strokes mostly stay inside one chunk
+    uint32_t    tileCount     = 0;
+};
+
+/* walks the tiles of a layer chunk by chunk, either all of them or the ones inside a cell range */
+struct TileIterator
+{
+    Vector2Int min;  // cell range, inclusive, only used when isBounded
+    Vector2Int max;
+    Vector2Int chunkPosition;
+    uint32_t   chunkIndex;
+    uint32_t   cell;
+    TileChunk* current;
+    bool       isBounded;
+};
+
+struct MapData
+{
+    TileLayer layers[MAP_MAX_LAYERS];
+};
+
+bool         TileLayer_Set(TileLayer* layer, int32_t x, int32_t y, uint16_t textureId, TileType type);
+bool         TileLayer_Erase(TileLayer* layer, int32_t x, int32_t y);
+bool         TileLayer_Get(TileLayer* layer, int32_t x, int32_t y, Tile* tile);
+void         TileLayer_Clear(TileLayer* layer);
+bool         TileLayer_Copy(TileLayer* destination, const TileLayer* source);
+bool         TileLayer_SetChunk(TileLayer* layer, int32_t chunkX, int32_t chunkY, const uint16_t* textureIds,
+                                const uint8_t* types);
+TileIterator TileLayer_Iterate();
+TileIterator TileLayer_IterateRect(Vector2Int min, Vector2Int max);
+bool         TileLayer_Next(TileLayer* layer, TileIterator* iterator, Tile* tile);
+
+void    MapData_Clear(MapData* map);
+bool    MapData_Copy(MapData* destination, const MapData* source);
+uint8_t MapData_GetCollisionFlags(int32_t cellX, int32_t cellY, void* map);  // TileCollider cell callback
+void    MapData_MarkSolidCells(MapData* map, TileRects* rects);
+
+#endif  // LIBS_ENGINE_TILEMAP_H
@@ -27,8 +27,8 @@
 
 Mode uiTestMode = MODE_FROM_CLASSNAME(UITestMode);
 
-static Drawable drawables[DRAWABLE_MAX];
-static size_t  drawableCount = 0;
+static Drawable* drawables    = NULL;
+static size_t   drawableCount = 0;
 
 static TextureData tileTextures[TILESET_COUNT];
 static TextureData tileAtlasBase;
@@ -119,7 +119,7 @@ void UITestMode_OnStart()
     cameraEntity.position.y = camera->target.y;
     cameraEntity.scale      = 1.0f / camera->zoom;
 
-    UI_Initialize(drawables, (size_t*)&drawableCount, DRAWABLE_MAX);
+    UI_Initialize();
 
     Sprite_Initialize(&testSprite);
     testSprite.currentTexture = &tileTextures[0];
@@ -136,7 +136,9 @@ void UITestMode_Update()
     cameraEntity.position.y = Window_GetCamera()->target.y;
     cameraEntity.scale      = 1.0f / Window_GetCamera()->zoom;
 
+    drawables     = FrameArena_AllocArray(Drawable, DRAWABLE_MAX);
     drawableCount = 0;
+    UI_SetDrawableArray(drawables, &drawableCount, DRAWABLE_MAX);
     DeltaTime_Update();
 
     UITestExampleGUI();
@@ -0,0 +1,669 @@
+#include "ChunkStreamer.h"
+
+#include "ashes/ash_debug.h"
+#include "ashes/ash_file.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define STREAM_FILE_MAGIC   0x4B4E4843  // "CHNK"
+#define STREAM_FILE_VERSION 4
+#define STREAM_INDEX_MIN    256
+#define STREAM_SLOT_NONE    0xFFFFFFFF
+#define STREAM_SLOT_LZ      0x01  // slot data is Lz compressed
+#define STREAM_SLOT_DATA    (CHUNK_RECORD_MAX_OBJECTS * sizeof(Object))
+#define STREAM_SLOT_SIZE    (sizeof(StreamSlotHeader) + STREAM_SLOT_DATA)
+
+enum StreamChunkState : uint8_t
+{
+    STREAM_CHUNK_ON_DISK = 0,
+    STREAM_CHUNK_LOADING,
+    STREAM_CHUNK_RESIDENT,
+};
+
+enum StreamJobType : uint8_t
+{
+    STREAM_JOB_LOAD = 0,
+    STREAM_JOB_STORE,
+    STREAM_JOB_MERGE,   // store that first joins the record with the stored chunk it was never loaded with
+    STREAM_JOB_HEADER,  // rewrites the file header, the slot field carries the next object id
+};
+
+// record sizes are checked on open, a changed Object layout makes old world files unreadable
+typedef struct StreamFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t slotSize;
+    uint32_t objectSize;
+    uint32_t nextId;  // first object id never handed out in this world
+} StreamFileHeader;
+
+// every slot is one bulk write, this header followed by the objects, raw or compressed when that is smaller
+typedef struct StreamSlotHeader
+{
+    Vector3Int8 chunkPosition;
+    uint8_t     flags;
+    uint16_t    objectCount;
+    uint16_t    carriedCount;
+    uint32_t    dataSize;
+} StreamSlotHeader;
+
+// slot in the world file of every chunk ever stored, only touched by the main thread
+typedef struct StreamIndexEntry
+{
+    uint32_t key;  // packed chunk position, 0 for an empty bucket
+    uint32_t slot;
+    uint8_t  state;
+} StreamIndexEntry;
+
+typedef struct StreamJob
+{
+    uint8_t      type;
+    uint32_t     slot;
+    ChunkRecord* record;  // write back copy for stores, buffer the worker fills for loads
+} StreamJob;
+
+static FILE*             streamFile       = NULL;
+static StreamIndexEntry* streamIndex      = NULL;
+static uint32_t          streamIndexMask  = 0;
+static uint32_t          streamIndexCount = 0;
+static uint32_t          streamSlotCount  = 0;
+static uint32_t          streamLoading    = 0;
+static uint32_t          streamNextId     = 0;
+static bool              streamIsLz       = false;
+static uint8_t*          streamScratch    = NULL;  // worker only, one slot plus the compression bound
+static ChunkRecord*      streamMerged     = NULL;  // worker only, the stored chunk a merge reads into
+
+static std::thread             streamThread;
+static std::mutex              streamMutex;
+static std::condition_variable streamWake;   // worker waits for jobs
+static std::condition_variable streamSpace;  // main thread waits for room in the job queue
+static StreamJob               streamJobs[STREAM_QUEUE_SIZE];
+static uint32_t                streamJobHead  = 0;
+static uint32_t                streamJobCount = 0;
+static uint32_t                streamJobsBusy = 0;  // queued plus the one the worker is running
+static std::condition_variable streamIdle;          // Flush waits for the worker to run out of jobs
+static ChunkRecord*            streamResults[STREAM_MAX_PENDING_LOADS];
+static uint32_t                streamResultCount = 0;
+static bool                    streamIsRunning   = false;
+static std::atomic<uint32_t>   streamStores(0);
+static std::atomic<uint32_t>   streamLoads(0);
+static std::atomic<uint32_t>   streamPendingStores(0);
+
+static uint32_t ChunkStreamer_Key(Vector3Int8 position)
+{
+    return (1u << 24) | ((uint32_t)(uint8_t)position.z << 16) | ((uint32_t)(uint8_t)position.y << 8)
+           | (uint32_t)(uint8_t)position.x;
+}
+
+static uint64_t ChunkStreamer_SlotOffset(uint32_t slot)
+{
+    return sizeof(StreamFileHeader) + (uint64_t)slot * STREAM_SLOT_SIZE;
+}
+
+// fseek only takes a long, which is 32 bits on Windows
+static bool ChunkStreamer_Seek(FILE* file, uint64_t offset, int origin)
+{
+#if defined(_WIN32)
+    return _fseeki64(file, (int64_t)offset, origin) == 0;
+#else
+    return fseeko(file, (off_t)offset, origin) == 0;
+#endif
+}
+
+static uint64_t ChunkStreamer_Tell(FILE* file)
+{
+#if defined(_WIN32)
+    return (uint64_t)_ftelli64(file);
+#else
+    return (uint64_t)ftello(file);
+#endif
+}
+
+static StreamIndexEntry* ChunkStreamer_Find(Vector3Int8 position)
+{
+    if (streamIndex == NULL)
+    {
+        return NULL;
+    }
+    uint32_t key = ChunkStreamer_Key(position);
+    for (uint32_t bucket = (key * 2654435761u) & streamIndexMask;; bucket = (bucket + 1) & streamIndexMask)
+    {
+        if (streamIndex[bucket].key == key)
+        {
+            return &streamIndex[bucket];
+        }
+        if (streamIndex[bucket].key == 0)
+        {
+            return NULL;
+        }
+    }
+}
+
+static StreamIndexEntry* ChunkStreamer_Insert(Vector3Int8 position)
+{
+    // keep the load factor at or below one half
+    if (streamIndex == NULL || (streamIndexCount + 1) * 2 > streamIndexMask + 1)
+    {
+        uint32_t          bucketCount = streamIndex == NULL ? STREAM_INDEX_MIN : (streamIndexMask + 1) * 2;
+        StreamIndexEntry* index       = (StreamIndexEntry*)calloc(bucketCount, sizeof(StreamIndexEntry));
+        if (index == NULL)
+        {
+            LOG_ERR("ChunkStreamer: out of memory for the chunk index");
+            return NULL;
+        }
+        for (uint32_t i = 0; streamIndex != NULL && i <= streamIndexMask; i++)
+        {
+            if (streamIndex[i].key == 0)
+            {
+                continue;
+            }
+            uint32_t bucket = (streamIndex[i].key * 2654435761u) & (bucketCount - 1);
+            while (index[bucket].key != 0)
+            {
+                bucket = (bucket + 1) & (bucketCount - 1);
+            }
+            index[bucket] = streamIndex[i];
+        }
+        free(streamIndex);
+        streamIndex     = index;
+        streamIndexMask = bucketCount - 1;
+    }
+    uint32_t key    = ChunkStreamer_Key(position);
+    uint32_t bucket = (key * 2654435761u) & streamIndexMask;
+    while (streamIndex[bucket].key != 0)
+    {
+        bucket = (bucket + 1) & streamIndexMask;
+    }
+    streamIndex[bucket].key   = key;
+    streamIndex[bucket].slot  = STREAM_SLOT_NONE;
+    streamIndex[bucket].state = STREAM_CHUNK_ON_DISK;
+    streamIndexCount++;
+    return &streamIndex[bucket];
+}
+
+// blocks only when the I/O thread is a whole queue behind, loads are capped well below the queue size
+static void ChunkStreamer_PushJob(uint8_t type, uint32_t slot, ChunkRecord* record)
+{
+    std::unique_lock<std::mutex> lock(streamMutex);
+    streamSpace.wait(lock, [] { return streamJobCount < STREAM_QUEUE_SIZE; });
+    StreamJob* job = &streamJobs[(streamJobHead + streamJobCount) % STREAM_QUEUE_SIZE];
+    job->type      = type;
+    job->slot      = slot;
+    job->record    = record;
+    streamJobCount++;
+    streamJobsBusy++;
+    streamWake.notify_one();
+}
+
+static void ChunkStreamer_WriteSlot(uint32_t slot, const ChunkRecord* record)
+{
+    StreamSlotHeader* header = (StreamSlotHeader*)streamScratch;
+    uint8_t*          data   = streamScratch + sizeof(StreamSlotHeader);
+    size_t            size   = (record->objectCount + record->carriedCount) * sizeof(Object);
+    header->chunkPosition    = record->chunkPosition;
+    header->flags            = 0;
+    header->objectCount      = record->objectCount;
+    header->carriedCount     = record->carriedCount;
+    size_t compressedSize    = 0;
+    if (streamIsLz)
+    {
+        compressedSize = Lz_Compress((const uint8_t*)record->objects, size, data, LZ_BOUND(STREAM_SLOT_DATA));
+    }
+    if (compressedSize != 0 && compressedSize < size)
+    {
+        header->flags |= STREAM_SLOT_LZ;
+        header->dataSize = (uint32_t)compressedSize;
+    }
+    else
+    {
+        memcpy(data, record->objects, size);
+        header->dataSize = (uint32_t)size;
+    }
+    if (!ChunkStreamer_Seek(streamFile, ChunkStreamer_SlotOffset(slot), SEEK_SET)
+        || fwrite(streamScratch, sizeof(StreamSlotHeader) + header->dataSize, 1, streamFile) != 1)
+    {
+        LOG_ERR("ChunkStreamer: failed to write chunk (%d, %d, %d)", record->chunkPosition.x, record->chunkPosition.y,
+                record->chunkPosition.z);
+    }
+}
+
+// an unreadable chunk comes back empty, so it is not requested forever
+static void ChunkStreamer_ReadSlot(uint32_t slot, ChunkRecord* record)
+{
+    StreamSlotHeader header;
+    uint8_t*         data   = streamScratch;
+    bool             isRead = ChunkStreamer_Seek(streamFile, ChunkStreamer_SlotOffset(slot), SEEK_SET)
+                  && fread(&header, sizeof(header), 1, streamFile) == 1
+                  && header.objectCount + header.carriedCount <= CHUNK_RECORD_MAX_OBJECTS
+                  && header.dataSize <= STREAM_SLOT_DATA
+                  && (header.dataSize == 0 || fread(data, header.dataSize, 1, streamFile) == 1);
+    if (isRead)
+    {
+        size_t size = (header.objectCount + header.carriedCount) * sizeof(Object);
+        if (header.flags & STREAM_SLOT_LZ)
+        {
+            isRead = Lz_Decompress(data, header.dataSize, (uint8_t*)record->objects, size) == size;
+        }
+        else
+        {
+            isRead = header.dataSize == size;
+            memcpy(record->objects, data, isRead ? size : 0);
+        }
+    }
+    if (!isRead)
+    {
+        LOG_ERR("ChunkStreamer: failed to read chunk (%d, %d, %d)", record->chunkPosition.x, record->chunkPosition.y,
+                record->chunkPosition.z);
+        record->objectCount  = 0;
+        record->carriedCount = 0;
+        return;
+    }
+    record->objectCount  = header.objectCount;
+    record->carriedCount = header.carriedCount;
+}
+
+// the stored objects were never loaded, so none of them is in the record; chunk objects stay ahead of carried ones
+static void ChunkStreamer_MergeSlot(uint32_t slot, const ChunkRecord* record)
+{
+    ChunkRecord* merged   = streamMerged;
+    merged->chunkPosition = record->chunkPosition;
+    merged->reserved      = 0;
+    ChunkStreamer_ReadSlot(slot, merged);
+    int objectRoom   = CHUNK_MAX_OBJECTS - merged->objectCount;
+    int totalRoom    = CHUNK_RECORD_MAX_OBJECTS - merged->objectCount - merged->carriedCount;
+    int objectCount  = record->objectCount;
+    int carriedCount = record->carriedCount;
+    objectCount      = objectCount < objectRoom ? objectCount : (objectRoom < totalRoom ? objectRoom : totalRoom);
+    objectCount      = objectCount > 0 ? objectCount : 0;
+    carriedCount     = carriedCount < totalRoom - objectCount ? carriedCount : totalRoom - objectCount;
+    if (objectCount < record->objectCount || carriedCount < record->carriedCount)
+    {
+        LOG_WRN("ChunkStreamer: chunk (%d, %d, %d) is full, %d objects were not merged", record->chunkPosition.x,
+                record->chunkPosition.y, record->chunkPosition.z,
+                record->objectCount + record->carriedCount - objectCount - carriedCount);
+    }
+    Object* carried = merged->objects + merged->objectCount;
+    memmove(carried + objectCount, carried, merged->carriedCount * sizeof(Object));
+    memcpy(carried, record->objects, objectCount * sizeof(Object));
+    memcpy(carried + objectCount + merged->carriedCount, record->objects + record->objectCount,
+           carriedCount * sizeof(Object));
+    merged->objectCount  = (uint16_t)(merged->objectCount + objectCount);
+    merged->carriedCount = (uint16_t)(merged->carriedCount + carriedCount);
+    ChunkStreamer_WriteSlot(slot, merged);
+}
+
+static bool ChunkStreamer_WriteHeader(uint32_t nextId)
+{
+    StreamFileHeader header = { STREAM_FILE_MAGIC, STREAM_FILE_VERSION, 0, STREAM_SLOT_SIZE, sizeof(Object), nextId };
+    if (!ChunkStreamer_Seek(streamFile, 0, SEEK_SET) || fwrite(&header, sizeof(header), 1, streamFile) != 1)
+    {
+        LOG_ERR("ChunkStreamer: failed to write the file header");
+        return false;
+    }
+    return true;
+}
+
+static void ChunkStreamer_Worker()
+{
+    for (;;)
+    {
+        StreamJob job;
+        {
+            std::unique_lock<std::mutex> lock(streamMutex);
+            streamWake.wait(lock, [] { return streamJobCount > 0 || !streamIsRunning; });
+            if (streamJobCount == 0)
+            {
+                return;
+            }
+            job           = streamJobs[streamJobHead];
+            streamJobHead = (streamJobHead + 1) % STREAM_QUEUE_SIZE;
+            streamJobCount--;
+            streamSpace.notify_one();
+        }
+        if (job.type == STREAM_JOB_HEADER)
+        {
+            ChunkStreamer_WriteHeader(job.slot);
+        }
+        else if (job.type != STREAM_JOB_LOAD)
+        {
+            if (job.type == STREAM_JOB_MERGE)
+            {
+                ChunkStreamer_MergeSlot(job.slot, job.record);
+            }
+            else
+            {
+                ChunkStreamer_WriteSlot(job.slot, job.record);
+            }
+            free(job.record);
+            streamStores++;
+            streamPendingStores--;
+        }
+        else
+        {
+            ChunkStreamer_ReadSlot(job.slot, job.record);
+            streamLoads++;
+        }
+        std::lock_guard<std::mutex> lock(streamMutex);
+        if (job.type == STREAM_JOB_LOAD)
+        {
+            streamResults[streamResultCount++] = job.record;
+        }
+        if (--streamJobsBusy == 0)
+        {
+            streamIdle.notify_all();
+        }
+    }
+}
+
+static bool ChunkStreamer_OpenFile(const char* fileName)
+{
+    StreamFileHeader expected = { STREAM_FILE_MAGIC, STREAM_FILE_VERSION, 0, STREAM_SLOT_SIZE, sizeof(Object), 0 };
+    StreamFileHeader header;
+    streamFile = fopen(fileName, "r+b");
+    if (streamFile != NULL)
+    {
+        if (fread(&header, sizeof(header), 1, streamFile) == 1
+            && memcmp(&header, &expected, offsetof(StreamFileHeader, nextId)) == 0)
+        {
+            streamNextId = header.nextId;
+            return true;
+        }
+        LOG_WRN("ChunkStreamer: '%s' is not a chunk file of this version, starting a new world", fileName);
+        fclose(streamFile);
+    }
+    streamFile = fopen(fileName, "w+b");
+    if (streamFile == NULL || !ChunkStreamer_WriteHeader(0))
+    {
+        LOG_ERR("ChunkStreamer: cannot create '%s'", fileName);
+        return false;
+    }
+    fflush(streamFile);
+    return true;
+}
+
+// reads the small header of every slot to rebuild the index, object data is left on disk
+bool ChunkStreamer_Initialize(const char* fileName, bool isCompressed)
+{
+    streamNextId  = 0;
+    streamScratch = (uint8_t*)malloc(sizeof(StreamSlotHeader) + LZ_BOUND(STREAM_SLOT_DATA));
+    streamMerged  = (ChunkRecord*)malloc(sizeof(ChunkRecord));
+    if (streamScratch == NULL || streamMerged == NULL || !ChunkStreamer_OpenFile(fileName))
+    {
+        free(streamScratch);
+        free(streamMerged);
+        streamScratch = NULL;
+        streamMerged  = NULL;
+        return false;
+    }
+    streamIsLz = isCompressed;
+    ChunkStreamer_Seek(streamFile, 0, SEEK_END);
+    uint64_t size   = ChunkStreamer_Tell(streamFile);
+    streamSlotCount = (uint32_t)((size - sizeof(StreamFileHeader) + STREAM_SLOT_SIZE - 1) / STREAM_SLOT_SIZE);
+    for (uint32_t slot = 0; slot < streamSlotCount; slot++)
+    {
+        StreamSlotHeader header;
+        if (!ChunkStreamer_Seek(streamFile, ChunkStreamer_SlotOffset(slot), SEEK_SET)
+            || fread(&header, sizeof(header), 1, streamFile) != 1)
+        {
+            LOG_WRN("ChunkStreamer: slot %u is unreadable, skipped", slot);
+            continue;
+        }
+        StreamIndexEntry* entry = ChunkStreamer_Find(header.chunkPosition);
+        if (entry == NULL)
+        {
+            entry = ChunkStreamer_Insert(header.chunkPosition);
+        }
+        if (entry == NULL)
+        {
+            fclose(streamFile);
+            streamFile = NULL;
+            return false;
+        }
+        entry->slot = slot;
+    }
+    streamLoading     = 0;
+    streamJobHead     = 0;
+    streamJobCount    = 0;
+    streamJobsBusy    = 0;
+    streamResultCount = 0;
+    streamIsRunning   = true;
+    streamThread      = std::thread(ChunkStreamer_Worker);
+    LOG_INF("ChunkStreamer: %u chunks in '%s'", streamIndexCount, fileName);
+    return true;
+}
+
+void ChunkStreamer_Deinitialize()
+{
+    if (streamFile == NULL)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        streamIsRunning = false;
+        streamWake.notify_one();
+    }
+    // the worker drains the queue before it exits, so every write back lands; finished loads nobody popped are dropped
+    streamThread.join();
+    for (uint32_t i = 0; i < streamResultCount; i++)
+    {
+        free(streamResults[i]);
+    }
+    streamResultCount = 0;
+    fclose(streamFile);
+    streamFile = NULL;
+    free(streamScratch);
+    streamScratch = NULL;
+    free(streamMerged);
+    streamMerged = NULL;
+    free(streamIndex);
+    streamIndex      = NULL;
+    streamIndexMask  = 0;
+    streamIndexCount = 0;
+}
+
+void ChunkStreamer_Flush()
+{
+    std::unique_lock<std::mutex> lock(streamMutex);
+    streamIdle.wait(lock, [] { return streamJobsBusy == 0; });
+}
+
+static void ChunkStreamer_Request(int x, int y, int z)
+{
+    if (x < INT8_MIN || x > INT8_MAX || y < INT8_MIN || y > INT8_MAX || streamLoading >= STREAM_MAX_PENDING_LOADS)
+    {
+        return;
+    }
+    Vector3Int8       position = { (int8_t)x, (int8_t)y, (int8_t)z };
+    StreamIndexEntry* entry    = ChunkStreamer_Find(position);
+    // chunks that were never stored have nothing to load
+    if (entry == NULL || entry->state != STREAM_CHUNK_ON_DISK || entry->slot == STREAM_SLOT_NONE)
+    {
+        return;
+    }
+    ChunkRecord* record = (ChunkRecord*)malloc(sizeof(ChunkRecord));
+    if (record == NULL)
+    {
+        LOG_ERR("ChunkStreamer: out of memory loading chunk (%d, %d, %d)", x, y, z);
+        return;
+    }
+    record->chunkPosition = position;
+    entry->state          = STREAM_CHUNK_LOADING;
+    streamLoading++;
+    ChunkStreamer_PushJob(STREAM_JOB_LOAD, entry->slot, record);
+}
+
+// queues the residency square first, then the band ahead of the camera so crossing a border finds it loaded
+void ChunkStreamer_Update(Vector3Int8 center, Vector2Float motion)
+{
+    if (streamFile == NULL)
+    {
+        return;
+    }
+    for (int y = center.y - STREAM_RESIDENT_RADIUS; y <= center.y + STREAM_RESIDENT_RADIUS; y++)
+    {
+        for (int x = center.x - STREAM_RESIDENT_RADIUS; x <= center.x + STREAM_RESIDENT_RADIUS; x++)
+        {
+            ChunkStreamer_Request(x, y, center.z);
+        }
+    }
+    int stepX = motion.x > 0.0f ? 1 : (motion.x < 0.0f ? -1 : 0);
+    int stepY = motion.y > 0.0f ? 1 : (motion.y < 0.0f ? -1 : 0);
+    for (int distance = STREAM_RESIDENT_RADIUS + 1; distance <= STREAM_RESIDENT_RADIUS + STREAM_PREFETCH_CHUNKS;
+         distance++)
+    {
+        for (int offset = -STREAM_RESIDENT_RADIUS; offset <= STREAM_RESIDENT_RADIUS; offset++)
+        {
+            if (stepX != 0)
+            {
+                ChunkStreamer_Request(center.x + stepX * distance, center.y + offset, center.z);
+            }
+            if (stepY != 0)
+            {
+                ChunkStreamer_Request(center.x + offset, center.y + stepY * distance, center.z);
+            }
+        }
+    }
+}
+
+// a load the caller has no room for stays queued, so its objects are never dropped
+bool ChunkStreamer_PopLoaded(ChunkRecord* outRecord, uint32_t freeObjects)
+{
+    ChunkRecord* record = NULL;
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        if (streamResultCount == 0)
+        {
+            return false;
+        }
+        record = streamResults[streamResultCount - 1];
+        if ((uint32_t)(record->objectCount + record->carriedCount) > freeObjects)
+        {
+            return false;
+        }
+        streamResultCount--;
+    }
+    memcpy(outRecord, record,
+           offsetof(ChunkRecord, objects) + (record->objectCount + record->carriedCount) * sizeof(Object));
+    free(record);
+    streamLoading--;
+    StreamIndexEntry* entry = ChunkStreamer_Find(outRecord->chunkPosition);
+    if (entry != NULL)
+    {
+        entry->state = STREAM_CHUNK_RESIDENT;
+    }
+    return true;
+}
+
+// a chunk with a load in flight must stay, or the load would bring back the state before the eviction
+bool ChunkStreamer_CanEvict(Vector3Int8 position)
+{
+    StreamIndexEntry* entry = ChunkStreamer_Find(position);
+    return entry == NULL || entry->state != STREAM_CHUNK_LOADING;
+}
+
+static StreamIndexEntry* ChunkStreamer_GetEntry(Vector3Int8 position)
+{
+    StreamIndexEntry* entry = ChunkStreamer_Find(position);
+    return entry != NULL ? entry : ChunkStreamer_Insert(position);
+}
+
+// queues a copy of the record, so the caller may reuse it right away
+static void ChunkStreamer_Write(StreamIndexEntry* entry, const ChunkRecord* record, uint8_t type)
+{
+    size_t       size = offsetof(ChunkRecord, objects) + (record->objectCount + record->carriedCount) * sizeof(Object);
+    ChunkRecord* copy = (ChunkRecord*)malloc(size);
+    if (copy == NULL)
+    {
+        LOG_ERR("ChunkStreamer: out of memory, chunk (%d, %d, %d) was not written back", record->chunkPosition.x,
+                record->chunkPosition.y, record->chunkPosition.z);
+        return;
+    }
+    memcpy(copy, record, size);
+    if (entry->slot == STREAM_SLOT_NONE)
+    {
+        entry->slot = streamSlotCount++;
+    }
+    streamPendingStores++;
+    ChunkStreamer_PushJob(type, entry->slot, copy);
+}
+
+// a resident chunk the game created over a stored one that was not loaded holds only the objects that came in since
+static bool ChunkStreamer_IsUnloaded(const StreamIndexEntry* entry)
+{
+    return entry->state != STREAM_CHUNK_RESIDENT && entry->slot != STREAM_SLOT_NONE;
+}
+
+// writes a chunk that stays resident, for saving the whole world without unloading it; a chunk whose stored
+// version was never loaded is refused, merging it now would store its objects twice once it is evicted
+bool ChunkStreamer_Store(const ChunkRecord* record)
+{
+    StreamIndexEntry* entry = streamFile != NULL ? ChunkStreamer_GetEntry(record->chunkPosition) : NULL;
+    if (entry == NULL || ChunkStreamer_IsUnloaded(entry))
+    {
+        return false;
+    }
+    entry->state = STREAM_CHUNK_RESIDENT;
+    ChunkStreamer_Write(entry, record, STREAM_JOB_STORE);
+    return true;
+}
+
+// a chunk whose stored version was never loaded is merged with it on the I/O thread instead of overwriting it
+void ChunkStreamer_Evict(const ChunkRecord* record, bool isDirty)
+{
+    StreamIndexEntry* entry = streamFile != NULL ? ChunkStreamer_GetEntry(record->chunkPosition) : NULL;
+    if (entry == NULL)
+    {
+        return;
+    }
+    bool isUnloaded = ChunkStreamer_IsUnloaded(entry);
+    entry->state    = STREAM_CHUNK_ON_DISK;
+    if (isDirty || entry->slot == STREAM_SLOT_NONE)
+    {
+        ChunkStreamer_Write(entry, record, isUnloaded ? STREAM_JOB_MERGE : STREAM_JOB_STORE);
+    }
+}
+
+// ids are never reused, an id still held by an evicted chunk stays taken; without a world file the counter only
+// lives in memory. UINT32_MAX is never handed out, records store an id plus one.
+bool ChunkStreamer_ReserveIds(uint32_t count, uint32_t* outFirstId)
+{
+    if (count > UINT32_MAX - streamNextId)
+    {
+        LOG_ERR("ChunkStreamer: out of object ids, %u are taken", streamNextId);
+        return false;
+    }
+    *outFirstId = streamNextId;
+    streamNextId += count;
+    if (streamFile != NULL)
+    {
+        ChunkStreamer_PushJob(STREAM_JOB_HEADER, streamNextId, NULL);
+    }
+    return true;
+}
+
+uint32_t ChunkStreamer_HashRecord(const ChunkRecord* record)
+{
+    return File_Fnv1a(FNV_OFFSET, record,
+                      offsetof(ChunkRecord, objects) + (record->objectCount + record->carriedCount) * sizeof(Object));
+}
+
+ChunkStreamStats ChunkStreamer_GetStats()
+{
+    ChunkStreamStats stats;
+    stats.storedChunks  = streamSlotCount;
+    stats.pendingLoads  = streamLoading;
+    stats.pendingStores = streamPendingStores.load();
+    stats.loads         = streamLoads.load();
+    stats.stores        = streamStores.load();
+    return stats;
+}
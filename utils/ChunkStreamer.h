@@ -0,0 +1,55 @@
+#ifndef UTILS_CHUNKSTREAMER_H
+#define UTILS_CHUNKSTREAMER_H
+#include "Structs.h"
+
+#include <stdint.h>
+
+#define STREAM_RESIDENT_RADIUS   2             // chunks kept loaded around the camera, in every direction
+#define STREAM_PREFETCH_CHUNKS   2             // extra chunks requested ahead of the camera while it moves
+#define STREAM_MEMORY_BUDGET     (512 * 1024)  // bytes of resident chunk data before LRU eviction starts
+#define STREAM_MAX_ACTIVATIONS   2             // loaded chunks turned into live objects per frame
+#define STREAM_MAX_PENDING_LOADS 32
+#define STREAM_QUEUE_SIZE        512  // I/O jobs in flight, loads and write backs together
+#define CHUNK_RECORD_MAX_OBJECTS (CHUNK_MAX_OBJECTS + 64)  // chunk objects plus the items its entities carry
+
+/*
+ * Relocatable form of a chunk. Objects are stored by value and every handle field holds the id of the object it
+ * pointed at plus one (0 stays null), since pool slots do not survive a reload. Carried objects are not part of
+ * any chunk, they follow the chunk objects.
+ */
+struct ChunkRecord
+{
+    Vector3Int8 chunkPosition;
+    uint8_t     reserved;
+    uint16_t    objectCount;
+    uint16_t    carriedCount;
+    Object      objects[CHUNK_RECORD_MAX_OBJECTS];
+};
+
+struct ChunkStreamStats
+{
+    uint32_t storedChunks;  // chunks the world file knows about
+    uint32_t pendingLoads;
+    uint32_t pendingStores;
+    uint32_t loads;
+    uint32_t stores;
+};
+
+/*
+ * Keeps the chunks around the camera resident and the rest of the world on disk. All file access happens on a
+ * background I/O thread, the main thread only queues requests and turns finished loads into objects a few chunks
+ * per frame. Eviction policy stays with the game, which knows what its objects cost.
+ */
+bool             ChunkStreamer_Initialize(const char* fileName, bool isCompressed);
+void             ChunkStreamer_Deinitialize();  // waits for the queued write backs
+void             ChunkStreamer_Flush();         // waits until every queued job has finished
+void             ChunkStreamer_Update(Vector3Int8 center, Vector2Float motion);
+bool             ChunkStreamer_PopLoaded(ChunkRecord* outRecord, uint32_t freeObjects);
+bool             ChunkStreamer_CanEvict(Vector3Int8 position);
+bool             ChunkStreamer_Store(const ChunkRecord* record);
+void             ChunkStreamer_Evict(const ChunkRecord* record, bool isDirty);
+bool             ChunkStreamer_ReserveIds(uint32_t count, uint32_t* outFirstId);
+uint32_t         ChunkStreamer_HashRecord(const ChunkRecord* record);  // tells a changed chunk from a loaded one
+ChunkStreamStats ChunkStreamer_GetStats();
+
+#endif  // UTILS_CHUNKSTREAMER_H
@@ -0,0 +1,246 @@
+#include "ObjectPool.h"
+
+#include "ashes/ash_debug.h"
+
+#include <string.h>
+
+static_assert((1u << OBJECT_HANDLE_INDEX_BITS) >= MAX_OBJECT_COUNT, "object handle index bits too small");
+
+typedef struct ObjectTable
+{
+    uint8_t*  rows;
+    uint16_t* owners;
+    uint16_t* count;
+    uint16_t  capacity;
+    size_t    stride;
+} ObjectTable;
+
+// tiles carry no extra data and have no table
+static bool ObjectPool_GetTable(ObjectPool* pool, uint8_t type, ObjectTable* outTable)
+{
+    switch (type)
+    {
+        case Type::ENTITY:
+            *outTable = { (uint8_t*)pool->entities, pool->entityOwners, &pool->entityCount, MAX_ENTITY_COUNT,
+                          sizeof(EntityData) };
+            return true;
+        case Type::PROJECTILE:
+            *outTable = { (uint8_t*)pool->projectiles, pool->projectileOwners, &pool->projectileCount,
+                          MAX_PROJECTILE_COUNT, sizeof(ProjectileData) };
+            return true;
+        case Type::EFFECT:
+            *outTable = { (uint8_t*)pool->effects, pool->effectOwners, &pool->effectCount, MAX_EFFECT_COUNT,
+                          sizeof(EffectData) };
+            return true;
+        case Type::INTERACTIVE:
+            *outTable = { (uint8_t*)pool->interactives, pool->interactiveOwners, &pool->interactiveCount,
+                          MAX_INTERACTIVE_COUNT, sizeof(InteractiveData) };
+            return true;
+        case Type::ITEM:
+            *outTable = { (uint8_t*)pool->items, pool->itemOwners, &pool->itemCount, MAX_ITEM_COUNT,
+                          sizeof(ItemData) };
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void* ObjectPool_GetRow(ObjectPool* pool, uint16_t index, uint8_t type)
+{
+    ObjectTable table;
+    if (index >= MAX_OBJECT_COUNT || pool->types[index] != type || pool->dataIndex[index] == OBJECT_DATA_NONE
+        || !ObjectPool_GetTable(pool, type, &table))
+    {
+        return NULL;
+    }
+    return table.rows + pool->dataIndex[index] * table.stride;
+}
+
+static ObjectHandle ObjectPool_MakeHandle(ObjectPool* pool, uint16_t index)
+{
+    return (pool->generations[index] << OBJECT_HANDLE_INDEX_BITS) | index;
+}
+
+static bool ObjectPool_IsLive(ObjectPool* pool, uint16_t index)
+{
+    uint16_t slot = pool->liveSlot[index];
+    return slot < pool->liveCount && pool->live[slot] == index;
+}
+
+void ObjectPool_Initialize(ObjectPool* pool)
+{
+    // generations start at 1, so no valid handle is ever OBJECT_HANDLE_NULL
+    for (uint16_t i = 0; i < MAX_OBJECT_COUNT; i++)
+    {
+        pool->generations[i]  = 1;
+        pool->freeList[i]     = (uint16_t)(MAX_OBJECT_COUNT - 1 - i);
+        pool->liveSlot[i]     = 0;
+        pool->dataIndex[i]    = OBJECT_DATA_NONE;
+        pool->parentChunks[i] = NULL;
+    }
+    pool->freeCount        = MAX_OBJECT_COUNT;
+    pool->liveCount        = 0;
+    pool->entityCount      = 0;
+    pool->projectileCount  = 0;
+    pool->effectCount      = 0;
+    pool->interactiveCount = 0;
+    pool->itemCount        = 0;
+}
+
+// frees every live object but keeps the generations, so handles from before the clear stay invalid
+void ObjectPool_Clear(ObjectPool* pool)
+{
+    while (pool->liveCount != 0)
+    {
+        ObjectPool_Free(pool, ObjectPool_MakeHandle(pool, pool->live[pool->liveCount - 1]));
+    }
+}
+
+ObjectHandle ObjectPool_Spawn(ObjectPool* pool, const Object* object)
+{
+    if (pool->freeCount == 0)
+    {
+        LOG_ERR("ObjectPool: Spawn() failed, all %d objects in use", MAX_OBJECT_COUNT);
+        return OBJECT_HANDLE_NULL;
+    }
+    ObjectTable table;
+    bool        hasTable = ObjectPool_GetTable(pool, object->type, &table);
+    if (hasTable && *table.count >= table.capacity)
+    {
+        LOG_ERR("ObjectPool: Spawn() failed, table for type %d is full", object->type);
+        return OBJECT_HANDLE_NULL;
+    }
+    uint16_t index              = pool->freeList[--pool->freeCount];
+    pool->liveSlot[index]       = pool->liveCount;
+    pool->live[pool->liveCount] = index;
+    pool->liveCount++;
+
+    pool->positions[index]    = object->position;
+    pool->types[index]        = object->type;
+    pool->flags[index]        = object->isCollidable ? OBJECT_FLAG_COLLIDABLE : 0;
+    pool->layers[index]       = object->layer;
+    pool->textureIds[index]   = object->textureId;
+    pool->ids[index]          = object->id;
+    pool->parentChunks[index] = NULL;
+    pool->dataIndex[index]    = OBJECT_DATA_NONE;
+    if (hasTable)
+    {
+        // every union member starts at the same address, the table stride picks the right size
+        uint16_t row = (*table.count)++;
+        memcpy(table.rows + row * table.stride, &object->entity, table.stride);
+        table.owners[row]      = index;
+        pool->dataIndex[index] = row;
+    }
+    return ObjectPool_MakeHandle(pool, index);
+}
+
+bool ObjectPool_Free(ObjectPool* pool, ObjectHandle handle)
+{
+    uint16_t index;
+    if (!ObjectPool_Resolve(pool, handle, &index))
+    {
+        LOG_WRN("ObjectPool: Free() called with a stale or invalid handle 0x%08x", handle);
+        return false;
+    }
+    ObjectTable table;
+    if (pool->dataIndex[index] != OBJECT_DATA_NONE && ObjectPool_GetTable(pool, pool->types[index], &table))
+    {
+        // move the last row into the hole and point its owner at the new row
+        uint16_t row  = pool->dataIndex[index];
+        uint16_t last = --(*table.count);
+        if (row != last)
+        {
+            memcpy(table.rows + row * table.stride, table.rows + last * table.stride, table.stride);
+            table.owners[row]                  = table.owners[last];
+            pool->dataIndex[table.owners[row]] = row;
+        }
+        pool->dataIndex[index] = OBJECT_DATA_NONE;
+    }
+    // swap the last live slot into the hole to keep the live list dense
+    uint16_t slot        = pool->liveSlot[index];
+    uint16_t last        = pool->live[pool->liveCount - 1];
+    pool->live[slot]     = last;
+    pool->liveSlot[last] = slot;
+    pool->liveCount--;
+    pool->parentChunks[index] = NULL;
+    pool->generations[index]  = (pool->generations[index] + 1) & OBJECT_HANDLE_GEN_MASK;
+    if (pool->generations[index] == 0)
+    {
+        pool->generations[index] = 1;
+    }
+    pool->freeList[pool->freeCount++] = index;
+    return true;
+}
+
+bool ObjectPool_Resolve(ObjectPool* pool, ObjectHandle handle, uint16_t* outIndex)
+{
+    uint16_t index = (uint16_t)(handle & OBJECT_HANDLE_INDEX_MASK);
+    if (handle == OBJECT_HANDLE_NULL || index >= MAX_OBJECT_COUNT
+        || pool->generations[index] != (handle >> OBJECT_HANDLE_INDEX_BITS) || !ObjectPool_IsLive(pool, index))
+    {
+        return false;
+    }
+    *outIndex = index;
+    return true;
+}
+
+ObjectHandle ObjectPool_GetHandle(ObjectPool* pool, uint16_t index)
+{
+    if (index >= MAX_OBJECT_COUNT || !ObjectPool_IsLive(pool, index))
+    {
+        return OBJECT_HANDLE_NULL;
+    }
+    return ObjectPool_MakeHandle(pool, index);
+}
+
+// gathers a slot back into a full Object, for the editor and for saving
+void ObjectPool_Read(ObjectPool* pool, uint16_t index, Object* outObject)
+{
+    memset(outObject, 0, sizeof(Object));
+    outObject->id           = pool->ids[index];
+    outObject->type         = pool->types[index];
+    outObject->layer        = pool->layers[index];
+    outObject->textureId    = pool->textureIds[index];
+    outObject->isCollidable = (pool->flags[index] & OBJECT_FLAG_COLLIDABLE) != 0;
+    outObject->position     = pool->positions[index];
+    ObjectTable table;
+    if (pool->dataIndex[index] != OBJECT_DATA_NONE && ObjectPool_GetTable(pool, pool->types[index], &table))
+    {
+        memcpy(&outObject->entity, table.rows + pool->dataIndex[index] * table.stride, table.stride);
+    }
+}
+
+uint16_t ObjectPool_GetCount(ObjectPool* pool)
+{
+    return pool->liveCount;
+}
+
+uint16_t ObjectPool_GetLiveIndex(ObjectPool* pool, uint16_t position)
+{
+    return pool->live[position];
+}
+
+EntityData* ObjectPool_GetEntity(ObjectPool* pool, uint16_t index)
+{
+    return (EntityData*)ObjectPool_GetRow(pool, index, Type::ENTITY);
+}
+
+ProjectileData* ObjectPool_GetProjectile(ObjectPool* pool, uint16_t index)
+{
+    return (ProjectileData*)ObjectPool_GetRow(pool, index, Type::PROJECTILE);
+}
+
+EffectData* ObjectPool_GetEffect(ObjectPool* pool, uint16_t index)
+{
+    return (EffectData*)ObjectPool_GetRow(pool, index, Type::EFFECT);
+}
+
+InteractiveData* ObjectPool_GetInteractive(ObjectPool* pool, uint16_t index)
+{
+    return (InteractiveData*)ObjectPool_GetRow(pool, index, Type::INTERACTIVE);
+}
+
+ItemData* ObjectPool_GetItem(ObjectPool* pool, uint16_t index)
+{
+    return (ItemData*)ObjectPool_GetRow(pool, index, Type::ITEM);
+}
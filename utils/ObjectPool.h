@@ -0,0 +1,23 @@
+#ifndef UTILS_OBJECTPOOL_H
+#define UTILS_OBJECTPOOL_H
+#include "Structs.h"
+
+#include <stdint.h>
+
+void         ObjectPool_Initialize(ObjectPool* pool);
+void         ObjectPool_Clear(ObjectPool* pool);
+ObjectHandle ObjectPool_Spawn(ObjectPool* pool, const Object* object);
+bool         ObjectPool_Free(ObjectPool* pool, ObjectHandle handle);
+bool         ObjectPool_Resolve(ObjectPool* pool, ObjectHandle handle, uint16_t* outIndex);
+ObjectHandle ObjectPool_GetHandle(ObjectPool* pool, uint16_t index);
+void         ObjectPool_Read(ObjectPool* pool, uint16_t index, Object* outObject);
+uint16_t     ObjectPool_GetCount(ObjectPool* pool);
+uint16_t     ObjectPool_GetLiveIndex(ObjectPool* pool, uint16_t position);
+
+EntityData*      ObjectPool_GetEntity(ObjectPool* pool, uint16_t index);
+ProjectileData*  ObjectPool_GetProjectile(ObjectPool* pool, uint16_t index);
+EffectData*      ObjectPool_GetEffect(ObjectPool* pool, uint16_t index);
+InteractiveData* ObjectPool_GetInteractive(ObjectPool* pool, uint16_t index);
+ItemData*        ObjectPool_GetItem(ObjectPool* pool, uint16_t index);
+
+#endif  // UTILS_OBJECTPOOL_H
@@ -15,7 +15,6 @@ Object emptyTilePrefab = {
     .textureId    = TEX_ID_EMPTY_TILE,
     .isCollidable = false,
     .position     = { 0, 0, 0 },
-    .parentChunk = NULL,
 };
 
 Object wallTilePrefab = {
@@ -25,7 +24,6 @@ Object wallTilePrefab = {
     .textureId    = TEX_ID_WALL_TILE,
     .isCollidable = true,
     .position     = { 0, 0, 0 },
-    .parentChunk = NULL,
 };
 
 Object playerPrefab = {
@@ -35,7 +33,6 @@ Object playerPrefab = {
     .textureId    = TEX_ID_PLAYER,
     .isCollidable = true,
     .position     = { 0, 0, 0 },
-    .parentChunk = NULL,
     .entity       = {
         .entityType            = EntityType::PLAYER,
         .entityHealth          = 100,
@@ -61,7 +58,6 @@ Object enemyRatPrefab = {
     .textureId    = TEX_ID_ENEMY_RAT,
     .isCollidable = true,
     .position     = { 0, 0, 0 },
-    .parentChunk = NULL,
     .entity       = {
         .entityType            = EntityType::ENEMY,
         .entityHealth          = 50,
@@ -92,7 +88,6 @@ Object itemSwordPrefab = {
     .textureId    = TEX_ID_ITEM_SWORD,
     .isCollidable = false,
     .position     = { 0, 0, 0 },
-    .parentChunk = NULL,
     .item         = {
         .itemId = 1,
     },
@@ -13,9 +13,23 @@
 #define TEXTURE_SIZE      8
 #define TEXTURE_MAX_COUNT 1024
 #define SPRITE_MAX_COUNT  256
-#define MAX_OBJECT_COUNT  4096
+#define MAX_OBJECT_COUNT  16384  // the residency square at its fullest, see MainMode.c
 #define ENTITY_MAX_ITEMS  8
 
+#define MAX_ENTITY_COUNT      512
+#define MAX_PROJECTILE_COUNT  512
+#define MAX_EFFECT_COUNT      512
+#define MAX_INTERACTIVE_COUNT 256
+#define MAX_ITEM_COUNT        512
+
+#define OBJECT_FLAG_COLLIDABLE 0x01
+#define OBJECT_DATA_NONE       0xFFFF
+
+#define OBJECT_HANDLE_NULL       0
+#define OBJECT_HANDLE_INDEX_BITS 14  // enough for MAX_OBJECT_COUNT slots, the rest is the generation
+#define OBJECT_HANDLE_INDEX_MASK ((1u << OBJECT_HANDLE_INDEX_BITS) - 1)
+#define OBJECT_HANDLE_GEN_MASK   ((1u << (32 - OBJECT_HANDLE_INDEX_BITS)) - 1)
+
 enum Type : uint8_t
 {
     TILE = 0,
@@ -47,95 +61,145 @@ enum EntityState : uint8_t
     GOING_BACK,
 };
 
-struct Chunk;
+// index in the object pool plus the generation of the slot, so a handle to a freed object never resolves
+typedef uint32_t ObjectHandle;
+
+struct EntityData
+{
+    // for PLAYER, ENEMY
+    uint8_t      entityType;
+    uint16_t     entityHealth;
+    uint32_t     entityExperience;
+    uint8_t      entityLevel;
+    uint16_t     entitySpeed;
+    uint32_t     entityDamage;
+    uint16_t     entityAttackSpeed;
+    uint16_t     entityArmor;
+    uint16_t     entityStrength;
+    uint16_t     entityDexterity;
+    uint16_t     entityVitality;
+    uint16_t     entityEnergy;
+    ObjectHandle entityItems[ENTITY_MAX_ITEMS];
+    uint16_t     entityRange;
+
+    EntityState entityState;
+    Vector2Int  entityOriginalPosition;
+    uint16_t    entityPatrolRadius;
+    uint16_t    entityChaseRadius;
+
+    Vector2Int8 entityMovementDirection;
+    Stopwatch   entityMovementTimer;
+    Stopwatch   entityAttackTimer;
+
+    ObjectHandle entityTarget;
+};
+
+struct ProjectileData
+{
+    float   projectileSpeed;
+    Vector2 projectileDestination;
+};
+
+struct EffectData
+{
+    uint8_t   effectType;
+    uint16_t  effectDuration;
+    Stopwatch effectTimer;
+};
+
+struct InteractiveData
+{
+    uint8_t interactiveType;
+    uint8_t state;
+};
+
+struct ItemData
+{
+    uint8_t itemId;
+};
+
+// full description of one object, used by prefabs and the editor. Live objects are split up by ObjectPool.
 struct Object
 {
-    uint16_t   id;
+    uint32_t   id;
     uint8_t    type;
     uint16_t   layer;
     uint32_t   textureId;
     bool       isCollidable;
     Vector3Int position;  // global world position
-    Chunk*     parentChunk;
     union
     {
-        struct
-        {
-            // for PLAYER, ENEMY
-            uint8_t  entityType;
-            uint16_t entityHealth;
-            uint32_t entityExperience;
-            uint8_t  entityLevel;
-            uint16_t entitySpeed;
-            uint32_t entityDamage;
-            uint16_t entityAttackSpeed;
-            uint16_t entityArmor;
-            uint16_t entityStrength;
-            uint16_t entityDexterity;
-            uint16_t entityVitality;
-            uint16_t entityEnergy;
-            Object*  entityItems[ENTITY_MAX_ITEMS];
-            uint16_t entityRange;
-
-            EntityState entityState;
-            Vector2Int  entityOriginalPosition;
-            uint16_t    entityPatrolRadius;
-            uint16_t    entityChaseRadius;
-
-            Vector2Int8 entityMovementDirection;
-            Stopwatch   entityMovementTimer;
-            Stopwatch   entityAttackTimer;
-
-            Object* entityTarget;
-        } entity;
-        struct
-        {
-            // for PROJECTILE
-            float   projectileSpeed;
-            Vector2 projectileDestination;
-        } projectile;
-        struct
-        {
-            // for EFFECT
-            uint8_t   effectType;
-            uint16_t  effectDuration;
-            Stopwatch effectTimer;
-        } effect;
-        struct
-        {
-            // for INTERACTIVE
-            uint8_t interactiveType;
-            uint8_t state;
-        } interactive;
-        struct
-        {
-            // for ITEM
-            uint8_t itemId;
-        } item;
+        EntityData      entity;
+        ProjectileData  projectile;
+        EffectData      effect;
+        InteractiveData interactive;
+        ItemData        item;
     };
 };
 
 struct Chunk
 {
     Vector3Int8 chunkPosition;
-    Object*     objects[CHUNK_MAX_OBJECTS];
+    uint16_t    objects[CHUNK_MAX_OBJECTS];  // object pool slots
     uint16_t    objectCount;
+    bool        isDirty;        // objects came or went since it was loaded, written back when it is evicted
+    uint32_t    packedHash;     // ChunkStreamer_HashRecord of the chunk as it was loaded or last stored
+    uint32_t    lastUsedFrame;  // last frame it was inside the residency square, for LRU eviction
+};
+
+/*
+ * Structure of arrays object storage. Every slot has its hot fields (position, type, flags, layer, texture) in
+ * dense arrays; type specific data lives in per type tables joined to the slot by dataIndex/owners.
+ */
+struct ObjectPool
+{
+    Vector3Int positions[MAX_OBJECT_COUNT];
+    uint8_t    types[MAX_OBJECT_COUNT];
+    uint8_t    flags[MAX_OBJECT_COUNT];
+    uint16_t   layers[MAX_OBJECT_COUNT];
+    uint32_t   textureIds[MAX_OBJECT_COUNT];
+
+    uint32_t ids[MAX_OBJECT_COUNT];
+    Chunk*   parentChunks[MAX_OBJECT_COUNT];
+    uint16_t dataIndex[MAX_OBJECT_COUNT];  // row in the table of the slot type, OBJECT_DATA_NONE for tiles
+
+    EntityData      entities[MAX_ENTITY_COUNT];
+    uint16_t        entityOwners[MAX_ENTITY_COUNT];
+    uint16_t        entityCount;
+    ProjectileData  projectiles[MAX_PROJECTILE_COUNT];
+    uint16_t        projectileOwners[MAX_PROJECTILE_COUNT];
+    uint16_t        projectileCount;
+    EffectData      effects[MAX_EFFECT_COUNT];
+    uint16_t        effectOwners[MAX_EFFECT_COUNT];
+    uint16_t        effectCount;
+    InteractiveData interactives[MAX_INTERACTIVE_COUNT];
+    uint16_t        interactiveOwners[MAX_INTERACTIVE_COUNT];
+    uint16_t        interactiveCount;
+    ItemData        items[MAX_ITEM_COUNT];
+    uint16_t        itemOwners[MAX_ITEM_COUNT];
+    uint16_t        itemCount;
+
+    uint32_t generations[MAX_OBJECT_COUNT];  // bumped every time the slot is freed
+    uint16_t freeList[MAX_OBJECT_COUNT];     // stack of free slot indices
+    uint16_t freeCount;
+    uint16_t live[MAX_OBJECT_COUNT];      // dense list of live slot indices
+    uint16_t liveSlot[MAX_OBJECT_COUNT];  // position of each live slot inside live
+    uint16_t liveCount;
 };
 
 struct GameData
 {
     Sprite      sprites[SPRITE_MAX_COUNT];
-    Object      objects[MAX_OBJECT_COUNT];
+    ObjectPool  objectPool;
     TextureData textures[TEXTURE_MAX_COUNT];
-    uint16_t    objectCount;
     Chunk       chunks[CHUNK_SIZE * CHUNK_SIZE];
     uint16_t    chunkCount;
     // uint16_t spriteCount;
-    int      currentZPos;
-    Entity2D cameraEntity;
-    Object*  playerObject;
-    Object*  draggedObject;
-    bool     isDraggingObject;
+    int          currentZPos;
+    Entity2D     cameraEntity;
+    ObjectHandle playerObject;
+    ObjectHandle draggedObject;
+    bool         isDraggingObject;
 };
 
 struct DebugData
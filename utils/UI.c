@@ -26,15 +26,19 @@ static Color     toggleHover       = { 80, 100, 140, 255 };
 static Color     toggleActiveHover = { 130, 170, 240, 255 };
 static Color     separatorColor    = { 100, 100, 100, 200 };
 
-void UI_Initialize(Drawable* drawableArray, size_t* drawableArraySize, size_t drawableArrayMaxSize)
+void UI_Initialize()
+{
+    for (uint16_t i = 0; i < UI_MAX_WIDGETS; i++)
+        uiState.tileGridSelected[i] = -1;
+}
+
+// drawable lists usually come from the frame arena, so this is called every frame before the first UI_Begin
+void UI_SetDrawableArray(Drawable* drawableArray, size_t* drawableArraySize, size_t drawableArrayMaxSize)
 {
-    assert(drawableArray != NULL);
     assert(drawableArraySize != NULL);
     uiState.drawableArray        = drawableArray;
     uiState.drawableArraySize    = drawableArraySize;
-    uiState.drawableArrayMaxSize = drawableArrayMaxSize;
-    for (uint16_t i = 0; i < UI_MAX_WIDGETS; i++)
-        uiState.tileGridSelected[i] = -1;
+    uiState.drawableArrayMaxSize = drawableArray != NULL ? drawableArrayMaxSize : 0;
 }
 
 void UI_SetParentEntity(Entity2D* entity)
@@ -621,6 +625,22 @@ static void DrawSeparatorItem(int childId, Vector4Float childBounds, UI_CenterTy
     PushShape(line);
 }
 
+static UI_TileGridLayout* GetTileGridLayout(uint16_t wid, float width, int cols)
+{
+    UI_TileGridLayout* layout = &uiState.tileGridLayout[wid];
+    float              zoom   = Window_GetCamera()->zoom;
+    if (layout->width == width && layout->cols == cols && layout->zoom == zoom)
+        return layout;
+    layout->width    = width;
+    layout->cols     = cols;
+    layout->zoom     = zoom;
+    layout->cellSize = width / cols;
+    Sprite_Initialize(&layout->cellSprite);
+    layout->cellSprite.scale = (layout->cellSize - 1.0f / zoom) / 16.0f;
+    return layout;
+}
+
+// only the rows inside the frame are visited, so the cost follows the frame height and not the texture count
 static void DrawTileGridItem(int childId, Vector4Float childBounds, UI_CenterType childCenter, float scrollY)
 {
     (void)scrollY;
@@ -631,11 +651,16 @@ static void DrawTileGridItem(int childId, Vector4Float childBounds, UI_CenterTyp
     uint16_t     wid          = uiState.item[childId].tileGrid.widgetId;
     int          selectedTile = uiState.tileGridSelected[wid];
 
-    float cellSize    = childBounds.w / cols;
-    int   rows        = (textureCount + cols - 1) / cols;
-    float totalHeight = rows * cellSize;
+    UI_TileGridLayout* layout      = GetTileGridLayout(wid, childBounds.w, cols);
+    float              cellSize    = layout->cellSize;
+    int                rows        = (textureCount + cols - 1) / cols;
+    float              totalHeight = rows * cellSize;
 
+    // clamped every frame, the frame may have grown or the texture count shrunk since the last scroll
     float gridScroll = uiState.scrollOffset[wid];
+    float maxScroll  = totalHeight - childBounds.h;
+    if (maxScroll < 0)
+        maxScroll = 0;
 
     Vector2Float mp        = GetMouseWorldPos();
     Rectangle    frameRect = { childBounds.x, childBounds.y, childBounds.w, childBounds.h };
@@ -643,54 +668,41 @@ static void DrawTileGridItem(int childId, Vector4Float childBounds, UI_CenterTyp
 
     float wheel = GetMouseWheelMove();
     if (hovered && wheel != 0.0f)
-    {
         gridScroll -= wheel * cellSize * 2.0f;
-        float maxScroll = totalHeight - childBounds.h;
-        if (maxScroll < 0)
-            maxScroll = 0;
-        if (gridScroll < 0)
-            gridScroll = 0;
-        if (gridScroll > maxScroll)
-            gridScroll = maxScroll;
-        uiState.scrollOffset[wid] = gridScroll;
-    }
-
-    for (int i = 0; i < textureCount; i++)
+    if (gridScroll > maxScroll)
+        gridScroll = maxScroll;
+    if (gridScroll < 0)
+        gridScroll = 0;
+    uiState.scrollOffset[wid] = gridScroll;
+
+    int firstRow = (int)(gridScroll / cellSize);
+    int lastRow  = (int)((gridScroll + childBounds.h) / cellSize);
+    if (lastRow > rows - 1)
+        lastRow = rows - 1;
+    for (int row = firstRow; row <= lastRow; row++)
     {
-        int row = i / cols;
-        int col = i % cols;
-
-        float bx = childBounds.x + col * cellSize;
         float by = childBounds.y + row * cellSize - gridScroll;
-
-        if (by + cellSize < childBounds.y || by > childBounds.y + childBounds.h)
-            continue;
-
-        Sprite sprite;
-        Sprite_Initialize(&sprite);
-        sprite.currentTexture = &textures[i];
-        sprite.scale          = (cellSize - 1.0f / Window_GetCamera()->zoom) / 16.0f;
-        sprite.position.x     = bx;
-        sprite.position.y     = by;
-        sprite.isVisible      = true;
-
-        if (i == selectedTile)
-            sprite.tint = (Color){ 120, 200, 255, 255 };
-
-        PushSprite(sprite);
-
-        if (hovered && Input_IsMouseButtonPressed(INPUT_MOUSE_BUTTON_LEFT))
+        for (int col = 0, i = row * cols; col < cols && i < textureCount; col++, i++)
         {
-            Rectangle cellRect = { bx, by, cellSize, cellSize };
-            if (PointInRect(mp, cellRect))
-            {
-                if (i == selectedTile)
-                    uiState.tileGridSelected[wid] = -1;
-                else
-                    uiState.tileGridSelected[wid] = i;
-            }
+            Sprite sprite         = layout->cellSprite;
+            sprite.currentTexture = &textures[i];
+            sprite.position.x     = childBounds.x + col * cellSize;
+            sprite.position.y     = by;
+            if (i == selectedTile)
+                sprite.tint = (Color){ 120, 200, 255, 255 };
+            PushSprite(sprite);
         }
     }
+
+    // the clicked cell comes straight from the mouse position
+    if (hovered && Input_IsMouseButtonPressed(INPUT_MOUSE_BUTTON_LEFT))
+    {
+        int col = (int)((mp.x - childBounds.x) / cellSize);
+        int row = (int)((mp.y - childBounds.y + gridScroll) / cellSize);
+        int i   = row * cols + col;
+        if (col >= 0 && col < cols && row >= 0 && i < textureCount)
+            uiState.tileGridSelected[wid] = i == selectedTile ? -1 : i;
+    }
 }
 
 static bool IsChildRenderable(UI_StackType type)
@@ -741,6 +753,7 @@ bool UI_IsMouseOverBounds(Vector4Float bounds)
 
 void UI_End()
 {
+    PROFILE_FUNCTION();
     if (uiState.itemCount == 0)
         return;
 
@@ -66,6 +66,16 @@ struct UI_TileGridData
     uint16_t     widgetId;
 };
 
+// cell geometry of a tile grid, kept until its width, column count or the camera zoom changes
+struct UI_TileGridLayout
+{
+    float  width;
+    int    cols;
+    float  zoom;
+    float  cellSize;
+    Sprite cellSprite;  // every visible cell is a copy with its texture and position filled in
+};
+
 struct UI_ButtonData
 {
     const char*  text;
@@ -142,6 +152,8 @@ struct UI_State
     int   tileGridSelected[UI_MAX_WIDGETS];
     float scrollOffset[UI_MAX_WIDGETS];
 
+    UI_TileGridLayout tileGridLayout[UI_MAX_WIDGETS];
+
     Drawable* drawableArray;
     size_t*   drawableArraySize;
     size_t    drawableArrayMaxSize;
@@ -149,7 +161,8 @@ struct UI_State
     Vector4Float bounds;
 };
 
-void UI_Initialize(Drawable* drawableArray, size_t* drawableArraySize, size_t drawableArrayMaxSize);
+void UI_Initialize();
+void UI_SetDrawableArray(Drawable* drawableArray, size_t* drawableArraySize, size_t drawableArrayMaxSize);
 void UI_SetParentEntity(Entity2D* entity);
 
 void UI_Begin(Vector4Float bounds);
@@ -0,0 +1,363 @@
+#include "WorldGen.h"
+
+#include "Prefabs.h"
+#include "ashes/ash_debug.h"
+
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define WORLDGEN_WIDTH       (WORLDGEN_CHUNKS_X * CHUNK_SIZE)
+#define WORLDGEN_HEIGHT      (WORLDGEN_CHUNKS_Y * CHUNK_SIZE)
+#define WORLDGEN_LEAF_MIN    12  // smallest BSP leaf, a split never leaves less on either side
+#define WORLDGEN_LEAF_MAX    32  // leaves larger than this are split again
+#define WORLDGEN_ROOM_MIN    5
+#define WORLDGEN_CAVE_FILL   55  // percent of cells that start out as rock
+#define WORLDGEN_CAVE_STEPS  4
+#define WORLDGEN_APRON       (WORLDGEN_CAVE_STEPS + 1)  // each step is exact one cell less far out
+#define WORLDGEN_GRID        (CHUNK_SIZE + WORLDGEN_APRON * 2)
+#define WORLDGEN_ROOM_NONE   UINT32_MAX
+#define WORLDGEN_SALT_LAYOUT 0x4C41594Fu
+#define WORLDGEN_SALT_CAVE   0x43415645u
+#define WORLDGEN_SALT_SPAWN  0x53504157u
+
+static_assert(WORLDGEN_CHUNKS_X <= INT8_MAX + 1 && WORLDGEN_CHUNKS_Y <= INT8_MAX + 1, "chunk positions are 8 bits");
+static_assert(WORLDGEN_LEAF_MAX >= WORLDGEN_LEAF_MIN * 2, "a leaf too large to keep must be splittable");
+
+// chance per thousand open cells, rolled in order, the first hit wins
+typedef struct WorldGenSpawn
+{
+    const Object* prefab;
+    uint32_t      chance;
+} WorldGenSpawn;
+
+static const WorldGenSpawn worldGenSpawns[] = {
+    { &enemyRatPrefab, 12 },
+    { &itemSwordPrefab, 3 },
+};
+
+static WorldGenLayout worldGenLayout;  // too big for the stack
+
+static uint32_t WorldGen_Hash(uint32_t seed, int32_t x, int32_t y, uint32_t salt)
+{
+    uint32_t hash = seed ^ (salt * 0x9E3779B9u);
+    hash          = (hash ^ ((uint32_t)x * 0x85EBCA6Bu)) * 0xC2B2AE35u;
+    hash          = (hash ^ (hash >> 15) ^ ((uint32_t)y * 0x27D4EB2Fu)) * 0x165667B1u;
+    hash ^= hash >> 13;
+    hash *= 0x2C1B3C6Du;
+    return hash ^ (hash >> 16);
+}
+
+// xorshift, only the layout is drawn from a sequence, everything per cell is hashed from its position
+static uint32_t WorldGen_Next(uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static int32_t WorldGen_Range(uint32_t* state, int32_t min, int32_t max)
+{
+    return min + (int32_t)(WorldGen_Next(state) % (uint32_t)(max - min + 1));
+}
+
+static Vector2Int WorldGen_Center(const WorldGenRect* rect)
+{
+    return { rect->x + rect->width / 2, rect->y + rect->height / 2 };
+}
+
+static bool WorldGen_Contains(const WorldGenRect* rect, int32_t x, int32_t y)
+{
+    return x >= rect->x && y >= rect->y && x < rect->x + rect->width && y < rect->y + rect->height;
+}
+
+static uint32_t WorldGen_AddRoom(WorldGenLayout* layout, uint32_t* rng, WorldGenRect leaf)
+{
+    if (layout->roomCount == WORLDGEN_MAX_ROOMS)
+    {
+        return WORLDGEN_ROOM_NONE;
+    }
+    WorldGenRect* room = &layout->rooms[layout->roomCount];
+    room->width        = WorldGen_Range(rng, WORLDGEN_ROOM_MIN, leaf.width - 2);
+    room->height       = WorldGen_Range(rng, WORLDGEN_ROOM_MIN, leaf.height - 2);
+    room->x            = WorldGen_Range(rng, leaf.x + 1, leaf.x + leaf.width - 1 - room->width);
+    room->y            = WorldGen_Range(rng, leaf.y + 1, leaf.y + leaf.height - 1 - room->height);
+    return layout->roomCount++;
+}
+
+// an L shaped corridor between the centers of two rooms, a one cell wide rect for each leg
+static void WorldGen_Join(WorldGenLayout* layout, uint32_t* rng, uint32_t a, uint32_t b)
+{
+    if (a == WORLDGEN_ROOM_NONE || b == WORLDGEN_ROOM_NONE || layout->corridorCount + 2 > WORLDGEN_MAX_CORRIDORS)
+    {
+        return;
+    }
+    Vector2Int from = WorldGen_Center(&layout->rooms[a]);
+    Vector2Int to   = WorldGen_Center(&layout->rooms[b]);
+    Vector2Int bend = (WorldGen_Next(rng) & 1) ? (Vector2Int){ to.x, from.y } : (Vector2Int){ from.x, to.y };
+    Vector2Int legs[2][2] = { { from, bend }, { bend, to } };
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        Vector2Int    p0       = legs[i][0];
+        Vector2Int    p1       = legs[i][1];
+        WorldGenRect* corridor = &layout->corridors[layout->corridorCount++];
+        corridor->x            = p0.x < p1.x ? p0.x : p1.x;
+        corridor->y            = p0.y < p1.y ? p0.y : p1.y;
+        corridor->width        = abs(p1.x - p0.x) + 1;
+        corridor->height       = abs(p1.y - p0.y) + 1;
+    }
+}
+
+// splits until every leaf holds one room, then joins the two halves of every split with a corridor; returns a room
+// of the area, the first half is always split first so room 0 ends up in the top left corner of the world
+static uint32_t WorldGen_Split(WorldGenLayout* layout, uint32_t* rng, WorldGenRect area)
+{
+    bool isWide = area.width > WORLDGEN_LEAF_MAX;
+    bool isTall = area.height > WORLDGEN_LEAF_MAX;
+    if (!isWide && !isTall)
+    {
+        return WorldGen_AddRoom(layout, rng, area);
+    }
+    WorldGenRect first  = area;
+    WorldGenRect second = area;
+    if (isWide && (!isTall || (WorldGen_Next(rng) & 1)))
+    {
+        first.width = WorldGen_Range(rng, WORLDGEN_LEAF_MIN, area.width - WORLDGEN_LEAF_MIN);
+        second.x += first.width;
+        second.width -= first.width;
+    }
+    else
+    {
+        first.height = WorldGen_Range(rng, WORLDGEN_LEAF_MIN, area.height - WORLDGEN_LEAF_MIN);
+        second.y += first.height;
+        second.height -= first.height;
+    }
+    uint32_t a = WorldGen_Split(layout, rng, first);
+    uint32_t b = WorldGen_Split(layout, rng, second);
+    WorldGen_Join(layout, rng, a, b);
+    if (a == WORLDGEN_ROOM_NONE || b == WORLDGEN_ROOM_NONE)
+    {
+        return a == WORLDGEN_ROOM_NONE ? b : a;
+    }
+    return (WorldGen_Next(rng) & 1) ? a : b;
+}
+
+void WorldGen_BuildLayout(uint32_t seed, WorldGenLayout* layout)
+{
+    uint32_t rng          = WorldGen_Hash(seed, 0, 0, WORLDGEN_SALT_LAYOUT) | 1;
+    layout->seed          = seed;
+    layout->roomCount     = 0;
+    layout->corridorCount = 0;
+    // the outermost ring of cells stays rock
+    WorldGen_Split(layout, &rng, { 1, 1, WORLDGEN_WIDTH - 2, WORLDGEN_HEIGHT - 2 });
+    Vector2Int start = WorldGen_Center(&layout->rooms[0]);
+    layout->start    = { start.x, start.y, 0 };
+}
+
+static bool WorldGen_IsBorder(int32_t x, int32_t y)
+{
+    return x <= 0 || y <= 0 || x >= WORLDGEN_WIDTH - 1 || y >= WORLDGEN_HEIGHT - 1;
+}
+
+// rock is 1, open ground 0; the grid covers the chunk plus an apron wide enough that the caves come out the same
+// as in the chunks next to it
+static void WorldGen_BuildGrid(const WorldGenLayout* layout, int32_t originX, int32_t originY,
+                               uint8_t grid[WORLDGEN_GRID][WORLDGEN_GRID])
+{
+    uint8_t next[WORLDGEN_GRID][WORLDGEN_GRID];
+    for (int32_t y = 0; y < WORLDGEN_GRID; y++)
+    {
+        for (int32_t x = 0; x < WORLDGEN_GRID; x++)
+        {
+            int32_t worldX = originX + x;
+            int32_t worldY = originY + y;
+            grid[y][x]     = WorldGen_IsBorder(worldX, worldY)
+                         || WorldGen_Hash(layout->seed, worldX, worldY, WORLDGEN_SALT_CAVE) % 100 < WORLDGEN_CAVE_FILL;
+        }
+    }
+    // a cell is rock when most of the 3x3 block around it is, the outer ring of the grid keeps its noise
+    for (uint32_t step = 0; step < WORLDGEN_CAVE_STEPS; step++)
+    {
+        memcpy(next, grid, sizeof(next));
+        for (int32_t y = 1; y < WORLDGEN_GRID - 1; y++)
+        {
+            for (int32_t x = 1; x < WORLDGEN_GRID - 1; x++)
+            {
+                uint32_t rock = grid[y - 1][x - 1] + grid[y - 1][x] + grid[y - 1][x + 1] + grid[y][x - 1] + grid[y][x]
+                                + grid[y][x + 1] + grid[y + 1][x - 1] + grid[y + 1][x] + grid[y + 1][x + 1];
+                next[y][x] = rock >= 5;
+            }
+        }
+        memcpy(grid, next, sizeof(next));
+    }
+    // rooms and corridors are carved through the caves, only the parts under the grid are visited
+    for (uint32_t i = 0; i < layout->roomCount + layout->corridorCount; i++)
+    {
+        const WorldGenRect* rect =
+            i < layout->roomCount ? &layout->rooms[i] : &layout->corridors[i - layout->roomCount];
+        int32_t minX = rect->x > originX ? rect->x - originX : 0;
+        int32_t minY = rect->y > originY ? rect->y - originY : 0;
+        int32_t maxX = rect->x + rect->width - originX;
+        int32_t maxY = rect->y + rect->height - originY;
+        maxX         = maxX < WORLDGEN_GRID ? maxX : WORLDGEN_GRID;
+        maxY         = maxY < WORLDGEN_GRID ? maxY : WORLDGEN_GRID;
+        if (minX >= maxX)
+        {
+            continue;
+        }
+        for (int32_t y = minY; y < maxY; y++)
+        {
+            memset(&grid[y][minX], 0, maxX - minX);
+        }
+    }
+    for (int32_t y = 0; y < WORLDGEN_GRID; y++)
+    {
+        for (int32_t x = 0; x < WORLDGEN_GRID; x++)
+        {
+            grid[y][x] |= WorldGen_IsBorder(originX + x, originY + y);
+        }
+    }
+}
+
+static const Object* WorldGen_RollSpawn(const WorldGenLayout* layout, int32_t x, int32_t y)
+{
+    if (x == layout->start.x && y == layout->start.y)
+    {
+        return &playerPrefab;
+    }
+    // the start room is left empty
+    if (WorldGen_Contains(&layout->rooms[0], x, y))
+    {
+        return NULL;
+    }
+    uint32_t roll = WorldGen_Hash(layout->seed, x, y, WORLDGEN_SALT_SPAWN) % 1000;
+    for (size_t i = 0; i < sizeof(worldGenSpawns) / sizeof(worldGenSpawns[0]); i++)
+    {
+        if (roll < worldGenSpawns[i].chance)
+        {
+            return worldGenSpawns[i].prefab;
+        }
+        roll -= worldGenSpawns[i].chance;
+    }
+    return NULL;
+}
+
+// a cell without a tile is open ground, so open cells only get an object for a spawn and rock only gets a wall where
+// it touches open ground; the floor and the solid rock between caves cost nothing. Ids are left 0, they are handed
+// out once every chunk is generated.
+void WorldGen_GenerateChunk(const WorldGenLayout* layout, Vector3Int8 chunkPosition, ChunkRecord* record)
+{
+    uint8_t grid[WORLDGEN_GRID][WORLDGEN_GRID];
+    int32_t baseX = chunkPosition.x * CHUNK_SIZE;
+    int32_t baseY = chunkPosition.y * CHUNK_SIZE;
+    WorldGen_BuildGrid(layout, baseX - WORLDGEN_APRON, baseY - WORLDGEN_APRON, grid);
+
+    record->chunkPosition = chunkPosition;
+    record->reserved      = 0;
+    record->objectCount   = 0;
+    record->carriedCount  = 0;
+    for (int32_t y = WORLDGEN_APRON; y < WORLDGEN_APRON + CHUNK_SIZE; y++)
+    {
+        for (int32_t x = WORLDGEN_APRON; x < WORLDGEN_APRON + CHUNK_SIZE; x++)
+        {
+            int32_t       worldX = baseX + x - WORLDGEN_APRON;
+            int32_t       worldY = baseY + y - WORLDGEN_APRON;
+            const Object* prefab = NULL;
+            if (grid[y][x] == 0)
+            {
+                prefab = WorldGen_RollSpawn(layout, worldX, worldY);
+            }
+            else if (!grid[y - 1][x - 1] || !grid[y - 1][x] || !grid[y - 1][x + 1] || !grid[y][x - 1]
+                     || !grid[y][x + 1] || !grid[y + 1][x - 1] || !grid[y + 1][x] || !grid[y + 1][x + 1])
+            {
+                prefab = &wallTilePrefab;
+            }
+            if (prefab == NULL)
+            {
+                continue;
+            }
+            Object* obj   = &record->objects[record->objectCount];
+            *obj          = *prefab;
+            obj->id       = 0;
+            obj->position = { worldX, worldY, 0 };
+            if (obj->type == Type::ENTITY)
+            {
+                obj->entity.entityOriginalPosition = { worldX, worldY };
+            }
+            record->objectCount++;
+        }
+    }
+}
+
+bool WorldGen_Generate(uint32_t seed, uint32_t threadCount, WorldGenStats* outStats)
+{
+    const uint32_t chunkCount = WORLDGEN_CHUNKS_X * WORLDGEN_CHUNKS_Y;
+    ChunkRecord*   records    = (ChunkRecord*)malloc(chunkCount * sizeof(ChunkRecord));
+    if (records == NULL)
+    {
+        LOG_ERR("WorldGen: out of memory for %u chunks", chunkCount);
+        return false;
+    }
+    WorldGen_BuildLayout(seed, &worldGenLayout);
+
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    threadCount = threadCount < 1 ? 1 : (threadCount > WORLDGEN_MAX_THREADS ? WORLDGEN_MAX_THREADS : threadCount);
+    // chunks are handed out one at a time, which thread runs one has no effect on what it holds
+    std::atomic<uint32_t> nextChunk(0);
+    auto                  worker = [&nextChunk, records, chunkCount]() {
+        for (uint32_t i = nextChunk++; i < chunkCount; i = nextChunk++)
+        {
+            Vector3Int8 position = { (int8_t)(i % WORLDGEN_CHUNKS_X), (int8_t)(i / WORLDGEN_CHUNKS_X), 0 };
+            WorldGen_GenerateChunk(&worldGenLayout, position, &records[i]);
+        }
+    };
+    std::thread threads[WORLDGEN_MAX_THREADS];
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        threads[i] = std::thread(worker);
+    }
+    worker();
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        threads[i].join();
+    }
+
+    // ids go out in chunk order once the object count is known, so none are reserved for cells that stayed empty
+    uint32_t objectCount = 0;
+    for (uint32_t i = 0; i < chunkCount; i++)
+    {
+        objectCount += records[i].objectCount;
+    }
+    uint32_t nextId;
+    if (!ChunkStreamer_ReserveIds(objectCount, &nextId))
+    {
+        free(records);
+        return false;
+    }
+    // the index of the streamer belongs to the main thread, stores go in chunk order so the file is the same too
+    for (uint32_t i = 0; i < chunkCount; i++)
+    {
+        for (uint16_t j = 0; j < records[i].objectCount; j++)
+        {
+            records[i].objects[j].id = nextId++;
+        }
+        ChunkStreamer_Evict(&records[i], true);
+    }
+    free(records);
+    ChunkStreamer_Flush();
+    if (outStats != NULL)
+    {
+        outStats->chunkCount  = chunkCount;
+        outStats->roomCount   = worldGenLayout.roomCount;
+        outStats->objectCount = objectCount;
+        outStats->threadCount = threadCount;
+    }
+    LOG_INF("WorldGen: seed %u, %u chunks, %u rooms, %u objects on %u threads", seed, chunkCount,
+            worldGenLayout.roomCount, objectCount, threadCount);
+    return true;
+}
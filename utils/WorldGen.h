@@ -0,0 +1,52 @@
+#ifndef UTILS_WORLDGEN_H
+#define UTILS_WORLDGEN_H
+#include "ChunkStreamer.h"
+#include "Structs.h"
+
+#include <stdint.h>
+
+#define WORLDGEN_CHUNKS_X      12  // world size in chunks
+#define WORLDGEN_CHUNKS_Y      12
+#define WORLDGEN_MAX_ROOMS     256
+#define WORLDGEN_MAX_CORRIDORS (WORLDGEN_MAX_ROOMS * 2)
+#define WORLDGEN_MAX_THREADS   16
+
+// top left cell and size, in world cells
+struct WorldGenRect
+{
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+};
+
+// everything that crosses chunk borders, built once from the seed before any chunk is generated
+struct WorldGenLayout
+{
+    uint32_t     seed;
+    uint32_t     roomCount;
+    uint32_t     corridorCount;
+    Vector3Int   start;  // player spawn, center of the first room
+    WorldGenRect rooms[WORLDGEN_MAX_ROOMS];
+    WorldGenRect corridors[WORLDGEN_MAX_CORRIDORS];
+};
+
+struct WorldGenStats
+{
+    uint32_t chunkCount;
+    uint32_t roomCount;
+    uint32_t objectCount;
+    uint32_t threadCount;
+};
+
+/*
+ * Builds a new world from a seed: cellular automata caves, BSP rooms joined by corridors, walls where rock meets
+ * open ground and spawns rolled from the prefab table. Each cell is a pure function of the seed, its position and
+ * the layout, so chunks are generated in parallel and the world comes out the same for any thread count. Chunks
+ * are handed to the ChunkStreamer in chunk order and stream in like any stored chunk.
+ */
+void WorldGen_BuildLayout(uint32_t seed, WorldGenLayout* layout);
+void WorldGen_GenerateChunk(const WorldGenLayout* layout, Vector3Int8 chunkPosition, ChunkRecord* record);
+bool WorldGen_Generate(uint32_t seed, uint32_t threadCount, WorldGenStats* outStats);  // 0 threads uses every core
+
+#endif  // UTILS_WORLDGEN_H